@@ -45,8 +45,8 @@ struct ContractorConfig final : storage::IOConfig
     ContractorConfig()
         : IOConfig({".osrm.ebg", ".osrm.ebg_nodes", ".osrm.properties"},
                    {},
-                   {".osrm.hsgr", ".osrm.enw"}),
-          requested_num_threads(0)
+                   {".osrm.hsgr", ".osrm.enw", ".osrm.hl"}),
+          requested_num_threads(0), rank_ordered_layout(false), hub_labels(false)
     {
     }
 
@@ -66,6 +66,14 @@ struct ContractorConfig final : storage::IOConfig
 
     unsigned requested_num_threads;
 
+    // Store the adjacency lists of the query graph ordered by their level in the hierarchy
+    // instead of by node ID. Improves cache locality of queries on large graphs.
+    bool rank_ordered_layout;
+
+    // Also derive hub labels from the contracted graph. They answer distance queries of the HL
+    // algorithm with a label intersection instead of a search, but need a lot more space.
+    bool hub_labels;
+
     // DEPRECATED to be removed in v6.0
     // A percentage of vertices that will be contracted for the hierarchy.
     // Offers a trade-off between preprocessing and query time.
@@ -4,6 +4,7 @@
 #include "contractor/serialization.hpp"
 
 #include <unordered_map>
+#include <vector>
 
 namespace osrm
 {
@@ -52,6 +53,58 @@ inline void writeGraph(const boost::filesystem::path &path,
         serialization::write(writer, "/ch/metrics/" + pair.first, pair.second);
     }
 }
+
+// reads .osrm.hl file
+template <typename HubLabelsT>
+inline void readHubLabels(const boost::filesystem::path &path,
+                          std::unordered_map<std::string, std::vector<HubLabelsT>> &metrics,
+                          std::uint32_t &connectivity_checksum)
+{
+    static_assert(std::is_same<HubLabels, HubLabelsT>::value ||
+                      std::is_same<HubLabelsView, HubLabelsT>::value,
+                  "labels must be of type HubLabels<>");
+
+    const auto fingerprint = storage::tar::FileReader::VerifyFingerprint;
+    storage::tar::FileReader reader{path, fingerprint};
+
+    reader.ReadInto("/hl/connectivity_checksum", connectivity_checksum);
+
+    for (auto &pair : metrics)
+    {
+        const auto prefix = "/hl/metrics/" + pair.first + "/exclude";
+        pair.second.resize(reader.ReadElementCount64(prefix));
+        for (const auto index : util::irange<std::size_t>(0, pair.second.size()))
+        {
+            serialization::read(reader, prefix + "/" + std::to_string(index), pair.second[index]);
+        }
+    }
+}
+
+// writes .osrm.hl file
+template <typename HubLabelsT>
+inline void writeHubLabels(const boost::filesystem::path &path,
+                           const std::unordered_map<std::string, std::vector<HubLabelsT>> &metrics,
+                           const std::uint32_t connectivity_checksum)
+{
+    static_assert(std::is_same<HubLabels, HubLabelsT>::value ||
+                      std::is_same<HubLabelsView, HubLabelsT>::value,
+                  "labels must be of type HubLabels<>");
+    const auto fingerprint = storage::tar::FileWriter::GenerateFingerprint;
+    storage::tar::FileWriter writer{path, fingerprint};
+
+    writer.WriteElementCount64("/hl/connectivity_checksum", 1);
+    writer.WriteFrom("/hl/connectivity_checksum", connectivity_checksum);
+
+    for (const auto &pair : metrics)
+    {
+        const auto prefix = "/hl/metrics/" + pair.first + "/exclude";
+        writer.WriteElementCount64(prefix, pair.second.size());
+        for (const auto index : util::irange<std::size_t>(0, pair.second.size()))
+        {
+            serialization::write(writer, prefix + "/" + std::to_string(index), pair.second[index]);
+        }
+    }
+}
 }
 }
 }
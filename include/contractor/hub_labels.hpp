@@ -0,0 +1,254 @@
+#ifndef OSRM_CONTRACTOR_HUB_LABELS_HPP
+#define OSRM_CONTRACTOR_HUB_LABELS_HPP
+
+#include "contractor/query_graph.hpp"
+
+#include "storage/shared_memory_ownership.hpp"
+#include "storage/tar_fwd.hpp"
+
+#include "util/typedefs.hpp"
+#include "util/vector_view.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace osrm
+{
+namespace contractor
+{
+namespace detail
+{
+template <storage::Ownership Ownership> class HubLabelSet;
+}
+
+namespace serialization
+{
+template <storage::Ownership Ownership>
+void read(storage::tar::FileReader &reader,
+          const std::string &name,
+          detail::HubLabelSet<Ownership> &label_set);
+
+template <storage::Ownership Ownership>
+void write(storage::tar::FileWriter &writer,
+           const std::string &name,
+           const detail::HubLabelSet<Ownership> &label_set);
+}
+
+// The label of a node: the shortest distances from (forward) or to (backward) the node over
+// each hub in its search space. Hubs are sorted by ID, the other arrays are parallel to them.
+// The hubs of a stored label are decoded into a buffer, see HubLabelSet::GetLabel.
+struct HubLabel
+{
+    const NodeID *hubs;
+    const EdgeWeight *weights;
+    const EdgeDuration *durations;
+    const EdgeDistance *distances;
+    std::size_t size;
+};
+
+// Calls callback(lhs_index, rhs_index) for every hub that is in both labels.
+//
+// Blocks of four hubs are compared against all rotations of a block of the other label at
+// once, the remainder is merged one hub at a time.
+template <typename Callback>
+void intersectHubLabels(const HubLabel &lhs, const HubLabel &rhs, Callback &&callback)
+{
+    std::size_t lhs_index = 0;
+    std::size_t rhs_index = 0;
+
+#if defined(__SSE2__)
+    while (lhs_index + 4 <= lhs.size && rhs_index + 4 <= rhs.size)
+    {
+        const auto lhs_block =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs.hubs + lhs_index));
+        const auto rhs_block =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(rhs.hubs + rhs_index));
+
+        auto equal = _mm_cmpeq_epi32(lhs_block, rhs_block);
+        equal = _mm_or_si128(
+            equal,
+            _mm_cmpeq_epi32(lhs_block, _mm_shuffle_epi32(rhs_block, _MM_SHUFFLE(0, 3, 2, 1))));
+        equal = _mm_or_si128(
+            equal,
+            _mm_cmpeq_epi32(lhs_block, _mm_shuffle_epi32(rhs_block, _MM_SHUFFLE(1, 0, 3, 2))));
+        equal = _mm_or_si128(
+            equal,
+            _mm_cmpeq_epi32(lhs_block, _mm_shuffle_epi32(rhs_block, _MM_SHUFFLE(2, 1, 0, 3))));
+
+        const auto mask = _mm_movemask_ps(_mm_castsi128_ps(equal));
+        if (mask != 0)
+        {
+            for (std::size_t lhs_offset = 0; lhs_offset < 4; ++lhs_offset)
+            {
+                if ((mask & (1 << lhs_offset)) == 0)
+                    continue;
+
+                const auto hub = lhs.hubs[lhs_index + lhs_offset];
+                std::size_t rhs_offset = 0;
+                while (rhs.hubs[rhs_index + rhs_offset] != hub)
+                    ++rhs_offset;
+                BOOST_ASSERT(rhs_offset < 4);
+                callback(lhs_index + lhs_offset, rhs_index + rhs_offset);
+            }
+        }
+
+        const auto lhs_last = lhs.hubs[lhs_index + 3];
+        const auto rhs_last = rhs.hubs[rhs_index + 3];
+        if (lhs_last <= rhs_last)
+            lhs_index += 4;
+        if (rhs_last <= lhs_last)
+            rhs_index += 4;
+    }
+#endif
+
+    while (lhs_index < lhs.size && rhs_index < rhs.size)
+    {
+        const auto lhs_hub = lhs.hubs[lhs_index];
+        const auto rhs_hub = rhs.hubs[rhs_index];
+        if (lhs_hub < rhs_hub)
+        {
+            ++lhs_index;
+        }
+        else if (rhs_hub < lhs_hub)
+        {
+            ++rhs_index;
+        }
+        else
+        {
+            callback(lhs_index++, rhs_index++);
+        }
+    }
+}
+
+// The hubs of a label are delta coded in blocks of HUB_BLOCK_SIZE hubs. A block is the first
+// hub, the bit width of the gaps between its hubs and the gaps minus one, packed LSB first into
+// 32 bit words. A width of zero means that the hubs of the block are consecutive.
+const constexpr std::size_t HUB_BLOCK_SIZE = 32;
+
+// Appends the blocks of the sorted hubs to words
+void encodeHubs(const NodeID *hubs, const std::size_t size, std::vector<std::uint32_t> &words);
+
+// Decodes size hubs from the blocks starting at words
+inline void decodeHubs(const std::uint32_t *words, const std::size_t size, NodeID *hubs)
+{
+    for (std::size_t begin = 0; begin < size; begin += HUB_BLOCK_SIZE)
+    {
+        const auto end = std::min(begin + HUB_BLOCK_SIZE, size);
+        NodeID hub = *words++;
+        const auto width = *words++;
+        BOOST_ASSERT(width <= 32);
+        const std::uint64_t mask = (std::uint64_t{1} << width) - 1;
+
+        hubs[begin] = hub;
+        std::uint64_t buffer = 0;
+        std::uint32_t buffered_bits = 0;
+        for (auto index = begin + 1; index < end; ++index)
+        {
+            if (buffered_bits < width)
+            {
+                buffer |= std::uint64_t{*words++} << buffered_bits;
+                buffered_bits += 32;
+            }
+            hub += static_cast<NodeID>(buffer & mask) + 1;
+            buffer >>= width;
+            buffered_bits -= width;
+            hubs[index] = hub;
+        }
+    }
+}
+
+namespace detail
+{
+// Labels of all nodes in one direction, stored back to back. The hubs are compressed with
+// encodeHubs, the weights, durations and distances are stored as parallel plain arrays.
+template <storage::Ownership Ownership> class HubLabelSet
+{
+    template <typename T> using Vector = util::ViewOrVector<T, Ownership>;
+
+  public:
+    HubLabelSet() = default;
+
+    HubLabelSet(Vector<std::uint64_t> offsets_,
+                Vector<std::uint64_t> hub_offsets_,
+                Vector<std::uint32_t> packed_hubs_,
+                Vector<EdgeWeight> weights_,
+                Vector<EdgeDuration> durations_,
+                Vector<EdgeDistance> distances_)
+        : offsets(std::move(offsets_)), hub_offsets(std::move(hub_offsets_)),
+          packed_hubs(std::move(packed_hubs_)), weights(std::move(weights_)),
+          durations(std::move(durations_)), distances(std::move(distances_))
+    {
+        BOOST_ASSERT(!offsets.empty());
+        BOOST_ASSERT(hub_offsets.size() == offsets.size());
+        BOOST_ASSERT(hub_offsets.back() == packed_hubs.size());
+        BOOST_ASSERT(offsets.back() == weights.size());
+        BOOST_ASSERT(weights.size() == durations.size());
+        BOOST_ASSERT(weights.size() == distances.size());
+    }
+
+    std::size_t GetNumberOfNodes() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+    std::size_t GetNumberOfEntries() const { return weights.size(); }
+
+    // The hubs of the label are decoded into hub_buffer, the label is valid as long as it is
+    HubLabel GetLabel(const NodeID node, std::vector<NodeID> &hub_buffer) const
+    {
+        BOOST_ASSERT(node < GetNumberOfNodes());
+        const auto begin = offsets[node];
+        const auto size = static_cast<std::size_t>(offsets[node + 1] - begin);
+        hub_buffer.resize(size);
+        decodeHubs(packed_hubs.data() + hub_offsets[node], size, hub_buffer.data());
+        return HubLabel{hub_buffer.data(),
+                        weights.data() + begin,
+                        durations.data() + begin,
+                        distances.data() + begin,
+                        size};
+    }
+
+    friend void serialization::read<Ownership>(storage::tar::FileReader &reader,
+                                               const std::string &name,
+                                               HubLabelSet &label_set);
+    friend void serialization::write<Ownership>(storage::tar::FileWriter &writer,
+                                                const std::string &name,
+                                                const HubLabelSet &label_set);
+
+  private:
+    Vector<std::uint64_t> offsets;
+    Vector<std::uint64_t> hub_offsets;
+    Vector<std::uint32_t> packed_hubs;
+    Vector<EdgeWeight> weights;
+    Vector<EdgeDuration> durations;
+    Vector<EdgeDistance> distances;
+};
+
+// Forward and backward labels of one exclude class. The shortest path from s to t goes over
+// the common hub of the forward label of s and the backward label of t with the smallest sum.
+template <storage::Ownership Ownership> struct HubLabels
+{
+    HubLabelSet<Ownership> forward;
+    HubLabelSet<Ownership> backward;
+};
+}
+
+using HubLabelSet = detail::HubLabelSet<storage::Ownership::Container>;
+using HubLabelSetView = detail::HubLabelSet<storage::Ownership::View>;
+using HubLabels = detail::HubLabels<storage::Ownership::Container>;
+using HubLabelsView = detail::HubLabels<storage::Ownership::View>;
+
+// Derives pruned hub labels from the contracted graph, only using the edges of the filter
+HubLabels computeHubLabels(const QueryGraph &graph, const std::vector<bool> &edge_filter);
+
+} // namespace contractor
+} // namespace osrm
+
+#endif // OSRM_CONTRACTOR_HUB_LABELS_HPP
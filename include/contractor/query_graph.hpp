@@ -3,18 +3,363 @@
 
 #include "contractor/query_edge.hpp"
 
-#include "util/static_graph.hpp"
+#include "storage/shared_memory_ownership.hpp"
+#include "storage/tar_fwd.hpp"
+
+#include "util/exception.hpp"
+#include "util/exception_utils.hpp"
+#include "util/integer_range.hpp"
 #include "util/typedefs.hpp"
+#include "util/vector_view.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace osrm
 {
 namespace contractor
 {
-
 namespace detail
 {
+template <storage::Ownership Ownership> class QueryGraph;
+}
+
+namespace serialization
+{
+template <storage::Ownership Ownership>
+void read(storage::tar::FileReader &reader,
+          const std::string &name,
+          detail::QueryGraph<Ownership> &graph);
+
 template <storage::Ownership Ownership>
-using QueryGraph = util::StaticGraph<typename QueryEdge::EdgeData, Ownership>;
+void write(storage::tar::FileWriter &writer,
+           const std::string &name,
+           const detail::QueryGraph<Ownership> &graph);
+}
+
+namespace query_graph_details
+{
+struct NodeArrayEntry
+{
+    // index of the first edge
+    EdgeID first_edge;
+};
+
+// Everything a search reads to relax an edge. Kept apart from the rest of the edge data so
+// that scanning the adjacency of a node touches as few cache lines as possible.
+struct EdgeArrayEntry
+{
+    NodeID target : 30;
+    std::uint32_t forward : 1;
+    std::uint32_t backward : 1;
+    EdgeWeight weight;
+};
+static_assert(sizeof(EdgeArrayEntry) == 8, "EdgeArrayEntry is not packed");
+
+// Only needed to unpack shortcuts and to annotate the final path
+struct EdgeDataEntry
+{
+    NodeID turn_id : 31;
+    std::uint32_t shortcut : 1;
+    EdgeWeight duration;
+    EdgeDistance distance;
+};
+
+// The two edges a shortcut was built from, both are adjacent to its middle node. Stored as
+// offsets into the adjacency of the middle node to keep the table small.
+struct ShortcutChildrenEntry
+{
+    // edge between the middle node and the node the shortcut is stored at
+    std::uint16_t source_child;
+    // edge between the middle node and the target of the shortcut
+    std::uint16_t target_child;
+};
+
+// Largest node ID that fits into EdgeArrayEntry::target
+constexpr NodeID MAX_NODE_ID = (1u << 30) - 1;
+// Marks shortcuts whose children need to be searched for when unpacking
+constexpr std::uint16_t INVALID_CHILD_OFFSET = std::numeric_limits<std::uint16_t>::max();
+}
+
+namespace detail
+{
+// Contracted graph as used by the CH queries.
+//
+// Edges are stored in two parallel arrays: target, weight and direction flags are read by every
+// relaxation, while the shortcut middle node, duration and distance only when a path is
+// unpacked. Optionally the adjacency lists are not laid out in node ID order but in the order
+// given to Reorder, so that nodes that are settled together by most queries have their edges
+// next to each other. Node IDs are not changed by this, all nodes are looked up through an
+// additional index then.
+//
+// For shortcuts the graph can store the two edges they consist of, which lets path unpacking
+// descend into a shortcut without searching the adjacency of its end points.
+template <storage::Ownership Ownership> class QueryGraph
+{
+    template <typename T> using Vector = util::ViewOrVector<T, Ownership>;
+
+  public:
+    using InputEdge = QueryEdge;
+    using EdgeData = QueryEdge::EdgeData;
+    using NodeIterator = NodeID;
+    using EdgeIterator = EdgeID;
+    using EdgeRange = util::range<EdgeIterator>;
+    using NodeArrayEntry = query_graph_details::NodeArrayEntry;
+    using EdgeArrayEntry = query_graph_details::EdgeArrayEntry;
+    using EdgeDataEntry = query_graph_details::EdgeDataEntry;
+    using ShortcutChildrenEntry = query_graph_details::ShortcutChildrenEntry;
+
+    QueryGraph() : number_of_nodes(0), number_of_edges(0) {}
+
+    // Expects the edges to be sorted by source
+    template <typename ContainerT>
+    QueryGraph(const std::uint32_t number_of_nodes_, const ContainerT &edges)
+        : number_of_nodes(number_of_nodes_), number_of_edges(edges.size())
+    {
+        BOOST_ASSERT(std::is_sorted(edges.begin(), edges.end()));
+
+        node_array.reserve(number_of_nodes + 1);
+        edge_array.reserve(number_of_edges);
+        edge_data.reserve(number_of_edges);
+
+        auto iter = edges.begin();
+        for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+        {
+            node_array.push_back(NodeArrayEntry{static_cast<EdgeID>(edge_array.size())});
+            for (; iter != edges.end() && iter->source == node; ++iter)
+            {
+                if (iter->target > query_graph_details::MAX_NODE_ID)
+                {
+                    throw util::exception("Node ID " + std::to_string(iter->target) +
+                                          " is too large for the query graph" + SOURCE_REF);
+                }
+                edge_array.push_back(
+                    {iter->target, iter->data.forward, iter->data.backward, iter->data.weight});
+                edge_data.push_back({iter->data.turn_id,
+                                     iter->data.shortcut,
+                                     iter->data.duration,
+                                     iter->data.distance});
+            }
+        }
+        node_array.push_back(NodeArrayEntry{static_cast<EdgeID>(edge_array.size())});
+        BOOST_ASSERT(iter == edges.end());
+    }
+
+    QueryGraph(Vector<NodeArrayEntry> node_array_,
+               Vector<NodeID> node_to_position_,
+               Vector<EdgeArrayEntry> edge_array_,
+               Vector<EdgeDataEntry> edge_data_,
+               Vector<ShortcutChildrenEntry> shortcut_children_)
+        : node_array(std::move(node_array_)), node_to_position(std::move(node_to_position_)),
+          edge_array(std::move(edge_array_)), edge_data(std::move(edge_data_)),
+          shortcut_children(std::move(shortcut_children_))
+    {
+        BOOST_ASSERT(!node_array.empty());
+        BOOST_ASSERT(edge_array.size() == edge_data.size());
+        BOOST_ASSERT(shortcut_children.empty() || shortcut_children.size() == edge_array.size());
+
+        number_of_nodes = static_cast<decltype(number_of_nodes)>(node_array.size() - 1);
+        number_of_edges = static_cast<decltype(number_of_edges)>(node_array.back().first_edge);
+        BOOST_ASSERT(node_to_position.empty() || node_to_position.size() == number_of_nodes);
+        BOOST_ASSERT(number_of_edges <= edge_array.size());
+    }
+
+    unsigned GetNumberOfNodes() const { return number_of_nodes; }
+
+    unsigned GetNumberOfEdges() const { return number_of_edges; }
+
+    unsigned GetOutDegree(const NodeIterator n) const { return EndEdges(n) - BeginEdges(n); }
+
+    // True if the adjacency lists are not stored in node ID order
+    bool IsReordered() const { return !node_to_position.empty(); }
+
+    bool HasShortcutChildren() const { return !shortcut_children.empty(); }
+
+    NodeIterator GetTarget(const EdgeIterator e) const { return edge_array[e].target; }
+
+    EdgeWeight GetEdgeWeight(const EdgeIterator e) const { return edge_array[e].weight; }
+
+    bool IsForwardEdge(const EdgeIterator e) const { return edge_array[e].forward; }
+
+    bool IsBackwardEdge(const EdgeIterator e) const { return edge_array[e].backward; }
+
+    EdgeData GetEdgeData(const EdgeIterator e) const
+    {
+        const auto &edge = edge_array[e];
+        const auto &data = edge_data[e];
+        return EdgeData{data.turn_id,
+                        static_cast<bool>(data.shortcut),
+                        edge.weight,
+                        data.duration,
+                        data.distance,
+                        static_cast<bool>(edge.forward),
+                        static_cast<bool>(edge.backward)};
+    }
+
+    // Returns the edge between the middle node of the shortcut and the node it is stored at,
+    // and the edge between the middle node and the target of the shortcut. Both are
+    // SPECIAL_EDGEID if they are not known and need to be searched for.
+    std::pair<EdgeIterator, EdgeIterator> GetShortcutChildren(const EdgeIterator e) const
+    {
+        BOOST_ASSERT(edge_data[e].shortcut);
+        if (shortcut_children.empty() ||
+            shortcut_children[e].source_child == query_graph_details::INVALID_CHILD_OFFSET)
+        {
+            return {SPECIAL_EDGEID, SPECIAL_EDGEID};
+        }
+
+        const auto middle_edges = BeginEdges(edge_data[e].turn_id);
+        return {middle_edges + shortcut_children[e].source_child,
+                middle_edges + shortcut_children[e].target_child};
+    }
+
+    void SetShortcutChildren(Vector<ShortcutChildrenEntry> shortcut_children_)
+    {
+        BOOST_ASSERT(shortcut_children_.empty() || shortcut_children_.size() == number_of_edges);
+        shortcut_children = std::move(shortcut_children_);
+    }
+
+    EdgeIterator BeginEdges(const NodeIterator n) const
+    {
+        return node_array[GetPosition(n)].first_edge;
+    }
+
+    EdgeIterator EndEdges(const NodeIterator n) const
+    {
+        return node_array[GetPosition(n) + 1].first_edge;
+    }
+
+    EdgeRange GetAdjacentEdgeRange(const NodeIterator n) const
+    {
+        return util::irange(BeginEdges(n), EndEdges(n));
+    }
+
+    // searches for a specific edge
+    EdgeIterator FindEdge(const NodeIterator from, const NodeIterator to) const
+    {
+        for (const auto edge : GetAdjacentEdgeRange(from))
+        {
+            if (to == GetTarget(edge))
+            {
+                return edge;
+            }
+        }
+        return SPECIAL_EDGEID;
+    }
+
+    template <typename FilterFunction>
+    EdgeIterator
+    FindSmallestEdge(const NodeIterator from, const NodeIterator to, FilterFunction &&filter) const
+    {
+        EdgeIterator smallest_edge = SPECIAL_EDGEID;
+        EdgeWeight smallest_weight = INVALID_EDGE_WEIGHT;
+        for (const auto edge : GetAdjacentEdgeRange(from))
+        {
+            if (GetTarget(edge) == to && GetEdgeWeight(edge) < smallest_weight &&
+                std::forward<FilterFunction>(filter)(GetEdgeData(edge)))
+            {
+                smallest_edge = edge;
+                smallest_weight = GetEdgeWeight(edge);
+            }
+        }
+        return smallest_edge;
+    }
+
+    EdgeIterator FindEdgeInEitherDirection(const NodeIterator from, const NodeIterator to) const
+    {
+        EdgeIterator tmp = FindEdge(from, to);
+        return (SPECIAL_EDGEID != tmp ? tmp : FindEdge(to, from));
+    }
+
+    EdgeIterator
+    FindEdgeIndicateIfReverse(const NodeIterator from, const NodeIterator to, bool &result) const
+    {
+        EdgeIterator current_iterator = FindEdge(from, to);
+        if (SPECIAL_EDGEID == current_iterator)
+        {
+            current_iterator = FindEdge(to, from);
+            if (SPECIAL_EDGEID != current_iterator)
+            {
+                result = true;
+            }
+        }
+        return current_iterator;
+    }
+
+    // Stores the adjacency lists in the given order of nodes. Returns the new ID of every edge
+    // indexed by its old ID, which is needed to update data that is indexed by edge ID.
+    std::vector<EdgeID> Reorder(const std::vector<NodeID> &order)
+    {
+        BOOST_ASSERT(order.size() == number_of_nodes);
+
+        Vector<NodeArrayEntry> new_node_array;
+        Vector<NodeID> new_node_to_position(number_of_nodes);
+        Vector<EdgeArrayEntry> new_edge_array;
+        Vector<EdgeDataEntry> new_edge_data;
+        Vector<ShortcutChildrenEntry> new_shortcut_children;
+        new_node_array.reserve(number_of_nodes + 1);
+        new_edge_array.reserve(number_of_edges);
+        new_edge_data.reserve(number_of_edges);
+        new_shortcut_children.reserve(shortcut_children.size());
+
+        std::vector<EdgeID> old_to_new_edge(number_of_edges, SPECIAL_EDGEID);
+        for (const auto position : util::irange<NodeID>(0, number_of_nodes))
+        {
+            const auto node = order[position];
+            new_node_to_position[node] = position;
+            new_node_array.push_back(NodeArrayEntry{static_cast<EdgeID>(new_edge_array.size())});
+            for (const auto edge : GetAdjacentEdgeRange(node))
+            {
+                old_to_new_edge[edge] = new_edge_array.size();
+                new_edge_array.push_back(edge_array[edge]);
+                new_edge_data.push_back(edge_data[edge]);
+                // offsets are relative to the adjacency of a node and stay valid
+                if (!shortcut_children.empty())
+                    new_shortcut_children.push_back(shortcut_children[edge]);
+            }
+        }
+        new_node_array.push_back(NodeArrayEntry{static_cast<EdgeID>(new_edge_array.size())});
+        BOOST_ASSERT(new_edge_array.size() == number_of_edges);
+
+        node_array = std::move(new_node_array);
+        node_to_position = std::move(new_node_to_position);
+        edge_array = std::move(new_edge_array);
+        edge_data = std::move(new_edge_data);
+        shortcut_children = std::move(new_shortcut_children);
+
+        return old_to_new_edge;
+    }
+
+    friend void serialization::read<Ownership>(storage::tar::FileReader &reader,
+                                               const std::string &name,
+                                               QueryGraph<Ownership> &graph);
+    friend void serialization::write<Ownership>(storage::tar::FileWriter &writer,
+                                                const std::string &name,
+                                                const QueryGraph<Ownership> &graph);
+
+  private:
+    NodeID GetPosition(const NodeIterator n) const
+    {
+        return node_to_position.empty() ? n : node_to_position[n];
+    }
+
+    NodeIterator number_of_nodes;
+    EdgeIterator number_of_edges;
+
+    Vector<NodeArrayEntry> node_array;
+    // empty if the adjacency lists are stored in node ID order
+    Vector<NodeID> node_to_position;
+    Vector<EdgeArrayEntry> edge_array;
+    Vector<EdgeDataEntry> edge_data;
+    // empty if the children of shortcuts are not stored
+    Vector<ShortcutChildrenEntry> shortcut_children;
+};
 }
 
 using QueryGraph = detail::QueryGraph<storage::Ownership::Container>;
@@ -22,4 +367,4 @@ using QueryGraphView = detail::QueryGraph<storage::Ownership::View>;
 }
 }
 
-#endif // QUERYEDGE_HPP
+#endif // OSRM_CONTRACTOR_QUERY_GRAPH_HPP
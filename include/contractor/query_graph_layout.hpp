@@ -0,0 +1,31 @@
+#ifndef OSRM_CONTRACTOR_QUERY_GRAPH_LAYOUT_HPP
+#define OSRM_CONTRACTOR_QUERY_GRAPH_LAYOUT_HPP
+
+#include "contractor/query_graph.hpp"
+
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+// Orders all nodes by their level in the hierarchy, highest first. The level of a node is the
+// length of the longest upward path that ends in it, so nodes of the same level are settled
+// at about the same time by every search and the top of the hierarchy, which is part of almost
+// all search spaces, ends up in one contiguous block.
+std::vector<NodeID> computeRankOrder(const QueryGraph &graph);
+
+// Lays out the adjacency lists of the graph in rank order and moves the edge filters along
+void reorderByRank(QueryGraph &graph, std::vector<std::vector<bool>> &edge_filters);
+
+// Stores for every shortcut the two edges the queries unpack it into. These are the edges the
+// search of the unpacking code would find in every one of the edge filters. Shortcuts for which
+// the filters disagree or whose children are not addressable keep being searched for.
+void storeShortcutChildren(QueryGraph &graph,
+                           const std::vector<std::vector<bool>> &edge_filters);
+
+} // namespace contractor
+} // namespace osrm
+
+#endif // OSRM_CONTRACTOR_QUERY_GRAPH_LAYOUT_HPP
@@ -2,6 +2,7 @@
 #define OSRM_CONTRACTOR_SERIALIZATION_HPP
 
 #include "contractor/contracted_metric.hpp"
+#include "contractor/hub_labels.hpp"
 
 #include "util/serialization.hpp"
 
@@ -15,12 +16,82 @@ namespace contractor
 namespace serialization
 {
 
+template <storage::Ownership Ownership>
+void write(storage::tar::FileWriter &writer,
+           const std::string &name,
+           const detail::QueryGraph<Ownership> &graph)
+{
+    storage::serialization::write(writer, name + "/node_array", graph.node_array);
+    storage::serialization::write(writer, name + "/node_to_position", graph.node_to_position);
+    storage::serialization::write(writer, name + "/edge_array", graph.edge_array);
+    storage::serialization::write(writer, name + "/edge_data", graph.edge_data);
+    storage::serialization::write(writer, name + "/shortcut_children", graph.shortcut_children);
+}
+
+template <storage::Ownership Ownership>
+void read(storage::tar::FileReader &reader,
+          const std::string &name,
+          detail::QueryGraph<Ownership> &graph)
+{
+    storage::serialization::read(reader, name + "/node_array", graph.node_array);
+    storage::serialization::read(reader, name + "/node_to_position", graph.node_to_position);
+    storage::serialization::read(reader, name + "/edge_array", graph.edge_array);
+    storage::serialization::read(reader, name + "/edge_data", graph.edge_data);
+    storage::serialization::read(reader, name + "/shortcut_children", graph.shortcut_children);
+    graph.number_of_nodes = graph.node_array.size() - 1;
+    graph.number_of_edges = graph.edge_array.size();
+}
+
+template <storage::Ownership Ownership>
+void write(storage::tar::FileWriter &writer,
+           const std::string &name,
+           const detail::HubLabelSet<Ownership> &label_set)
+{
+    storage::serialization::write(writer, name + "/offsets", label_set.offsets);
+    storage::serialization::write(writer, name + "/hub_offsets", label_set.hub_offsets);
+    storage::serialization::write(writer, name + "/packed_hubs", label_set.packed_hubs);
+    storage::serialization::write(writer, name + "/weights", label_set.weights);
+    storage::serialization::write(writer, name + "/durations", label_set.durations);
+    storage::serialization::write(writer, name + "/distances", label_set.distances);
+}
+
+template <storage::Ownership Ownership>
+void read(storage::tar::FileReader &reader,
+          const std::string &name,
+          detail::HubLabelSet<Ownership> &label_set)
+{
+    storage::serialization::read(reader, name + "/offsets", label_set.offsets);
+    storage::serialization::read(reader, name + "/hub_offsets", label_set.hub_offsets);
+    storage::serialization::read(reader, name + "/packed_hubs", label_set.packed_hubs);
+    storage::serialization::read(reader, name + "/weights", label_set.weights);
+    storage::serialization::read(reader, name + "/durations", label_set.durations);
+    storage::serialization::read(reader, name + "/distances", label_set.distances);
+}
+
+template <storage::Ownership Ownership>
+void write(storage::tar::FileWriter &writer,
+           const std::string &name,
+           const detail::HubLabels<Ownership> &labels)
+{
+    write(writer, name + "/forward", labels.forward);
+    write(writer, name + "/backward", labels.backward);
+}
+
+template <storage::Ownership Ownership>
+void read(storage::tar::FileReader &reader,
+          const std::string &name,
+          detail::HubLabels<Ownership> &labels)
+{
+    read(reader, name + "/forward", labels.forward);
+    read(reader, name + "/backward", labels.backward);
+}
+
 template <storage::Ownership Ownership>
 void write(storage::tar::FileWriter &writer,
            const std::string &name,
            const detail::ContractedMetric<Ownership> &metric)
 {
-    util::serialization::write(writer, name + "/contracted_graph", metric.graph);
+    write(writer, name + "/contracted_graph", metric.graph);
 
     writer.WriteElementCount64(name + "/exclude", metric.edge_filter.size());
     for (const auto index : util::irange<std::size_t>(0, metric.edge_filter.size()))
@@ -36,7 +107,7 @@ void read(storage::tar::FileReader &reader,
           const std::string &name,
           detail::ContractedMetric<Ownership> &metric)
 {
-    util::serialization::read(reader, name + "/contracted_graph", metric.graph);
+    read(reader, name + "/contracted_graph", metric.graph);
 
     metric.edge_filter.resize(reader.ReadElementCount64(name + "/exclude"));
     for (const auto index : util::irange<std::size_t>(0, metric.edge_filter.size()))
@@ -24,16 +24,25 @@ struct Algorithm final
 {
 };
 }
+// Hub Labels on top of a Contraction Hierarchy
+namespace hl
+{
+struct Algorithm final
+{
+};
+}
 
 // Algorithm names
 template <typename AlgorithmT> const char *name();
 template <> inline const char *name<ch::Algorithm>() { return "CH"; }
 template <> inline const char *name<mld::Algorithm>() { return "MLD"; }
+template <> inline const char *name<hl::Algorithm>() { return "HL"; }
 
 // Algorithm identifier
 template <typename AlgorithmT> const char *identifier();
 template <> inline const char *identifier<ch::Algorithm>() { return "ch"; }
 template <> inline const char *identifier<mld::Algorithm>() { return "mld"; }
+template <> inline const char *identifier<hl::Algorithm>() { return "hl"; }
 
 template <typename AlgorithmT> struct HasAlternativePathSearch final : std::false_type
 {
@@ -50,6 +59,9 @@ template <typename AlgorithmT> struct HasMapMatching final : std::false_type
 template <typename AlgorithmT> struct HasManyToManySearch final : std::false_type
 {
 };
+template <typename AlgorithmT> struct HasOneToAllSearch final : std::false_type
+{
+};
 template <typename AlgorithmT> struct SupportsDistanceAnnotationType final : std::false_type
 {
 };
@@ -76,6 +88,9 @@ template <> struct HasMapMatching<ch::Algorithm> final : std::true_type
 template <> struct HasManyToManySearch<ch::Algorithm> final : std::true_type
 {
 };
+template <> struct HasOneToAllSearch<ch::Algorithm> final : std::true_type
+{
+};
 template <> struct SupportsDistanceAnnotationType<ch::Algorithm> final : std::true_type
 {
 };
@@ -102,6 +117,9 @@ template <> struct HasMapMatching<mld::Algorithm> final : std::true_type
 template <> struct HasManyToManySearch<mld::Algorithm> final : std::true_type
 {
 };
+template <> struct HasOneToAllSearch<mld::Algorithm> final : std::true_type
+{
+};
 template <> struct SupportsDistanceAnnotationType<mld::Algorithm> final : std::false_type
 {
 };
@@ -111,6 +129,35 @@ template <> struct HasGetTileTurns<mld::Algorithm> final : std::true_type
 template <> struct HasExcludeFlags<mld::Algorithm> final : std::true_type
 {
 };
+
+// Hub Labels only answer many-to-many queries, everything else uses the CH of the dataset
+template <> struct HasAlternativePathSearch<hl::Algorithm> final : std::true_type
+{
+};
+template <> struct HasShortestPathSearch<hl::Algorithm> final : std::true_type
+{
+};
+template <> struct HasDirectShortestPathSearch<hl::Algorithm> final : std::true_type
+{
+};
+template <> struct HasMapMatching<hl::Algorithm> final : std::true_type
+{
+};
+template <> struct HasManyToManySearch<hl::Algorithm> final : std::true_type
+{
+};
+template <> struct HasOneToAllSearch<hl::Algorithm> final : std::true_type
+{
+};
+template <> struct SupportsDistanceAnnotationType<hl::Algorithm> final : std::true_type
+{
+};
+template <> struct HasGetTileTurns<hl::Algorithm> final : std::true_type
+{
+};
+template <> struct HasExcludeFlags<hl::Algorithm> final : std::true_type
+{
+};
 }
 }
 }
@@ -0,0 +1,190 @@
+#ifndef ENGINE_API_ISOCHRONE_API_HPP
+#define ENGINE_API_ISOCHRONE_API_HPP
+
+#include "engine/api/base_api.hpp"
+#include "engine/api/isochrone_parameters.hpp"
+
+#include "engine/api/json_factory.hpp"
+#include "engine/phantom_node.hpp"
+#include "engine/routing_algorithms/isochrone.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace api
+{
+
+class IsochroneAPI final : public BaseAPI
+{
+  public:
+    IsochroneAPI(const datafacade::BaseDataFacade &facade_,
+                 const IsochroneParameters &parameters_)
+        : BaseAPI(facade_, parameters_), parameters(parameters_)
+    {
+    }
+
+    // Expects the reachable nodes sorted by duration, as returned by the one-to-all search
+    void MakeResponse(const PhantomNode &source_phantom,
+                      const std::vector<routing_algorithms::ReachableNode> &reachable_nodes,
+                      util::json::Object &response) const
+    {
+        BOOST_ASSERT(parameters.coordinates.size() == 1);
+        BOOST_ASSERT(std::is_sorted(reachable_nodes.begin(),
+                                    reachable_nodes.end(),
+                                    [](const auto &lhs, const auto &rhs) {
+                                        return lhs.duration < rhs.duration;
+                                    }));
+
+        util::json::Array waypoints;
+        waypoints.values.push_back(BaseAPI::MakeWaypoint(source_phantom));
+
+        std::vector<util::Coordinate> coordinates;
+        // offsets into coordinates, one past the last coordinate of each edge
+        std::vector<std::size_t> edge_ends;
+        edge_ends.reserve(reachable_nodes.size());
+
+        util::json::Array edges;
+        edges.values.reserve(reachable_nodes.size());
+        for (const auto &reachable : reachable_nodes)
+        {
+            const auto begin = coordinates.size();
+            const auto geometry_index = facade.GetGeometryIndex(reachable.node);
+            if (geometry_index.forward)
+            {
+                for (const auto node : facade.GetUncompressedForwardGeometry(geometry_index.id))
+                    coordinates.push_back(facade.GetCoordinateOfNode(node));
+            }
+            else
+            {
+                for (const auto node : facade.GetUncompressedReverseGeometry(geometry_index.id))
+                    coordinates.push_back(facade.GetCoordinateOfNode(node));
+            }
+            edge_ends.push_back(coordinates.size());
+
+            util::json::Object edge;
+            // the source edge is entered before the snapped location
+            edge.values["duration"] = std::max(0, reachable.duration) / 10.;
+            edge.values["geometry"] =
+                json::makeGeoJSONGeometry(coordinates.begin() + begin, coordinates.end());
+            edges.values.push_back(std::move(edge));
+        }
+
+        response.values["code"] = "Ok";
+        response.values["waypoints"] = std::move(waypoints);
+        response.values["edges"] = std::move(edges);
+
+        if (parameters.polygons)
+        {
+            util::json::Array polygons;
+            auto band_end = reachable_nodes.begin();
+            for (const auto contour : parameters.contours)
+            {
+                band_end = std::upper_bound(band_end,
+                                            reachable_nodes.end(),
+                                            static_cast<EdgeDuration>(contour * 10.),
+                                            [](const EdgeDuration duration, const auto &node) {
+                                                return duration < node.duration;
+                                            });
+                const auto number_of_edges = std::distance(reachable_nodes.begin(), band_end);
+                const auto number_of_coordinates =
+                    number_of_edges == 0 ? 0 : edge_ends[number_of_edges - 1];
+
+                util::json::Object polygon;
+                polygon.values["contour"] = contour;
+                polygon.values["geometry"] = MakeOutline(
+                    coordinates.begin(), coordinates.begin() + number_of_coordinates);
+                polygons.values.push_back(std::move(polygon));
+            }
+            response.values["polygons"] = std::move(polygons);
+        }
+    }
+
+    const IsochroneParameters &parameters;
+
+  private:
+    // GeoJSON polygon of the convex hull around all coordinates (Andrew's monotone chain)
+    template <typename Iter> util::json::Object MakeOutline(Iter begin, Iter end) const
+    {
+        std::vector<util::Coordinate> points(begin, end);
+        std::sort(points.begin(), points.end(), [](const auto &lhs, const auto &rhs) {
+            return std::tie(lhs.lon, lhs.lat) < std::tie(rhs.lon, rhs.lat);
+        });
+        points.erase(std::unique(points.begin(), points.end()), points.end());
+
+        // z component of (first - origin) x (second - origin), positive for a left turn
+        const auto cross = [](const util::Coordinate &origin,
+                              const util::Coordinate &first,
+                              const util::Coordinate &second) {
+            const auto lon = [](const util::Coordinate &coordinate) {
+                return static_cast<std::int64_t>(static_cast<std::int32_t>(coordinate.lon));
+            };
+            const auto lat = [](const util::Coordinate &coordinate) {
+                return static_cast<std::int64_t>(static_cast<std::int32_t>(coordinate.lat));
+            };
+            return (lon(first) - lon(origin)) * (lat(second) - lat(origin)) -
+                   (lat(first) - lat(origin)) * (lon(second) - lon(origin));
+        };
+
+        std::vector<util::Coordinate> hull;
+        if (points.size() < 3)
+        {
+            hull = points;
+        }
+        else
+        {
+            hull.resize(2 * points.size());
+            std::size_t size = 0;
+            // lower hull
+            for (std::size_t index = 0; index < points.size(); ++index)
+            {
+                while (size >= 2 && cross(hull[size - 2], hull[size - 1], points[index]) <= 0)
+                    --size;
+                hull[size++] = points[index];
+            }
+            // upper hull
+            for (std::size_t index = points.size() - 1, lower_size = size + 1; index > 0;
+                 --index)
+            {
+                while (size >= lower_size &&
+                       cross(hull[size - 2], hull[size - 1], points[index - 1]) <= 0)
+                    --size;
+                hull[size++] = points[index - 1];
+            }
+            // the first point is repeated at the end which closes the ring
+            hull.resize(size);
+        }
+
+        util::json::Array ring;
+        ring.values.reserve(hull.size() + 1);
+        std::transform(hull.begin(),
+                       hull.end(),
+                       std::back_inserter(ring.values),
+                       &json::detail::coordinateToLonLat);
+        if (hull.size() < 3 && !hull.empty())
+        {
+            ring.values.push_back(json::detail::coordinateToLonLat(hull.front()));
+        }
+
+        util::json::Array rings;
+        rings.values.push_back(std::move(ring));
+
+        util::json::Object geojson;
+        geojson.values["type"] = "Polygon";
+        geojson.values["coordinates"] = std::move(rings);
+        return geojson;
+    }
+};
+
+} // ns api
+} // ns engine
+} // ns osrm
+
+#endif
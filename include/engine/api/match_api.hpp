@@ -12,6 +12,11 @@
 
 #include "util/integer_range.hpp"
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <vector>
+
 namespace osrm
 {
 namespace engine
@@ -34,16 +39,36 @@ class MatchAPI final : public RouteAPI
                       util::json::Object &response) const
     {
         auto number_of_routes = sub_matchings.size();
-        util::json::Array routes;
-        routes.values.reserve(number_of_routes);
         BOOST_ASSERT(sub_matchings.size() == sub_routes.size());
-        for (auto index : util::irange<std::size_t>(0UL, sub_matchings.size()))
-        {
+
+        // Routes of the sub matchings are assembled independently of each other
+        std::vector<util::json::Object> route_objects(number_of_routes);
+        const auto assemble_route = [&](const std::size_t index) {
             auto route = MakeRoute(sub_routes[index].segment_end_coordinates,
                                    sub_routes[index].unpacked_path_segments,
                                    sub_routes[index].source_traversed_in_reverse,
                                    sub_routes[index].target_traversed_in_reverse);
             route.values["confidence"] = sub_matchings[index].confidence;
+            route_objects[index] = std::move(route);
+        };
+        if (number_of_routes > 1)
+        {
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(0, number_of_routes, 1),
+                              [&](const tbb::blocked_range<std::size_t> &range) {
+                                  for (auto index = range.begin(); index != range.end(); ++index)
+                                      assemble_route(index);
+                              });
+        }
+        else
+        {
+            for (auto index : util::irange<std::size_t>(0UL, number_of_routes))
+                assemble_route(index);
+        }
+
+        util::json::Array routes;
+        routes.values.reserve(number_of_routes);
+        for (auto &route : route_objects)
+        {
             routes.values.push_back(std::move(route));
         }
         response.values["tracepoints"] = MakeTracepoints(sub_matchings);
@@ -86,6 +111,12 @@ class MatchAPI final : public RouteAPI
             for (auto point_index : util::irange(
                      0u, static_cast<unsigned>(sub_matchings[sub_matching_index].indices.size())))
             {
+                // the frontier of a matching session is not a point of this request
+                if (sub_matchings[sub_matching_index].indices[point_index] ==
+                    map_matching::INVALID_TRACE_INDEX)
+                {
+                    continue;
+                }
                 // tidied_to_original: index of the input coordinate that a tidied coordinate
                 // corresponds to.
                 // sub_matching indices: index of the coordinate passed to map matching plugin that
@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "engine/api/route_parameters.hpp"
 
+#include <string>
 #include <vector>
 
 namespace osrm
@@ -44,6 +45,9 @@ namespace api
  *
  * Holds member attributes:
  *  - timestamps: timestamp(s) for the corresponding input coordinate(s)
+ *  - session: if not empty, the coordinates extend the trace matched by the previous requests
+ *    of the session, which then may consist of a single coordinate. Not supported together
+ *    with tidy and waypoints.
  *
  * \see OSRM, Coordinate, Hint, Bearing, RouteParame, RouteParameters, TableParameters,
  *      NearestParameters, TripParameters, MatchParameters and TileParameters
@@ -88,6 +92,7 @@ struct MatchParameters : public RouteParameters
     GapsType gaps;
     bool tidy;
     std::vector<std::size_t> waypoints;
+    std::string session;
 
     bool IsValid() const
     {
@@ -95,8 +100,14 @@ struct MatchParameters : public RouteParameters
             std::all_of(waypoints.begin(), waypoints.end(), [this](const auto &w) {
                 return w < coordinates.size();
             });
-        return RouteParameters::IsValid() &&
-               (timestamps.empty() || timestamps.size() == coordinates.size()) && valid_waypoints;
+        // a single new point extends the trace of a session
+        const auto valid_coordinates =
+            RouteParameters::IsValid() ||
+            (!session.empty() && coordinates.size() == 1 && BaseParameters::IsValid());
+        const auto valid_session = session.empty() || (!tidy && waypoints.empty());
+        return valid_coordinates &&
+               (timestamps.empty() || timestamps.size() == coordinates.size()) &&
+               valid_waypoints && valid_session;
     }
 };
 }
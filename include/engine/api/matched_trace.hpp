@@ -0,0 +1,46 @@
+#ifndef ENGINE_API_MATCHED_TRACE_HPP
+#define ENGINE_API_MATCHED_TRACE_HPP
+
+#include "util/coordinate.hpp"
+#include "util/typedefs.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace api
+{
+
+/**
+ * Compact result of a trace matched in a batch, not formatted as JSON.
+ *
+ * The matched points of sub-matching i are the entries [sub_matching_offsets[i],
+ * sub_matching_offsets[i + 1]) of indices, nodes and locations. A trace that could not be
+ * matched has no sub-matchings.
+ *
+ * Holds member attributes:
+ *  - confidences: confidence of every sub-matching
+ *  - sub_matching_offsets: offsets of the sub-matchings, one more than there are sub-matchings
+ *  - indices: index of the trace coordinate of every matched point
+ *  - nodes: edge-based node every point was matched to, the forward one if the point was
+ *    matched to both directions of a road
+ *  - locations: location on the road every point was matched to
+ *
+ * \see OSRM, MatchParameters
+ */
+struct MatchedTrace
+{
+    std::vector<float> confidences;
+    std::vector<std::uint32_t> sub_matching_offsets;
+    std::vector<std::uint32_t> indices;
+    std::vector<NodeID> nodes;
+    std::vector<util::Coordinate> locations;
+};
+}
+}
+}
+
+#endif
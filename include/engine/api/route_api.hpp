@@ -26,6 +26,9 @@
 #include "util/integer_range.hpp"
 #include "util/json_util.hpp"
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include <iterator>
 #include <vector>
 
@@ -38,6 +41,10 @@ namespace api
 
 class RouteAPI : public BaseAPI
 {
+    // Routes with fewer legs are assembled sequentially, as the overhead of scheduling the legs
+    // outweighs the assembly of a few legs
+    static constexpr std::size_t MIN_LEGS_FOR_PARALLEL_ASSEMBLY = 8;
+
   public:
     RouteAPI(const datafacade::BaseDataFacade &facade_, const RouteParameters &parameters_)
         : BaseAPI(facade_, parameters_), parameters(parameters_)
@@ -56,6 +63,13 @@ class RouteAPI : public BaseAPI
             if (!route.is_valid())
                 continue;
 
+            if (route.unpacked_path_segments.empty() && !route.leg_totals.empty())
+            {
+                BOOST_ASSERT(!NeedsUnpackedPath());
+                jsRoutes.values.push_back(MakeRoute(route.leg_totals));
+                continue;
+            }
+
             jsRoutes.values.push_back(MakeRoute(route.segment_end_coordinates,
                                                 route.unpacked_path_segments,
                                                 route.source_traversed_in_reverse,
@@ -68,6 +82,16 @@ class RouteAPI : public BaseAPI
         response.values["code"] = "Ok";
     }
 
+    // Steps, geometries and annotations are assembled from the unpacked path. Without them a
+    // route only consists of the totals of its legs, which searches can provide from the packed
+    // path alone.
+    bool NeedsUnpackedPath() const
+    {
+        return parameters.steps || parameters.annotations ||
+               parameters.annotations_type != RouteParameters::AnnotationsType::None ||
+               parameters.overview != RouteParameters::OverviewType::False;
+    }
+
   protected:
     template <typename ForwardIter>
     util::json::Value MakeGeometry(ForwardIter begin, ForwardIter end) const
@@ -100,19 +124,39 @@ class RouteAPI : public BaseAPI
         return annotations_store;
     }
 
+    // Route without steps, geometry and annotations. The leg summary is left empty as it is only
+    // computed together with the steps.
+    util::json::Object MakeRoute(const std::vector<LegTotals> &leg_totals) const
+    {
+        std::vector<guidance::RouteLeg> legs;
+        legs.reserve(leg_totals.size());
+        for (const auto &totals : leg_totals)
+        {
+            legs.push_back(guidance::RouteLeg{std::round(totals.distance * 10.) / 10.,
+                                              totals.duration / 10.,
+                                              totals.weight / facade.GetWeightMultiplier(),
+                                              {},
+                                              {}});
+        }
+
+        auto route = guidance::assembleRoute(legs);
+        return json::makeRoute(route,
+                               json::makeRouteLegs(std::move(legs), {}, {}),
+                               boost::none,
+                               facade.GetWeightName());
+    }
+
     util::json::Object MakeRoute(const std::vector<PhantomNodes> &segment_end_coordinates,
                                  const std::vector<std::vector<PathData>> &unpacked_path_segments,
                                  const std::vector<bool> &source_traversed_in_reverse,
                                  const std::vector<bool> &target_traversed_in_reverse) const
     {
-        std::vector<guidance::RouteLeg> legs;
-        std::vector<guidance::LegGeometry> leg_geometries;
         auto number_of_legs = segment_end_coordinates.size();
-        legs.reserve(number_of_legs);
-        leg_geometries.reserve(number_of_legs);
+        std::vector<guidance::RouteLeg> legs(number_of_legs);
+        std::vector<guidance::LegGeometry> leg_geometries(number_of_legs);
 
-        for (auto idx : util::irange<std::size_t>(0UL, number_of_legs))
-        {
+        // Legs are assembled independently of each other, see the note on roundabouts below
+        const auto assemble_leg = [&](const std::size_t idx) {
             const auto &phantoms = segment_end_coordinates[idx];
             const auto &path_data = unpacked_path_segments[idx];
 
@@ -196,8 +240,22 @@ class RouteAPI : public BaseAPI
                 leg_geometry = guidance::resyncGeometry(std::move(leg_geometry), leg.steps);
             }
 
-            leg_geometries.push_back(std::move(leg_geometry));
-            legs.push_back(std::move(leg));
+            leg_geometries[idx] = std::move(leg_geometry);
+            legs[idx] = std::move(leg);
+        };
+
+        if (number_of_legs >= MIN_LEGS_FOR_PARALLEL_ASSEMBLY)
+        {
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(0, number_of_legs),
+                              [&](const tbb::blocked_range<std::size_t> &range) {
+                                  for (auto idx = range.begin(); idx != range.end(); ++idx)
+                                      assemble_leg(idx);
+                              });
+        }
+        else
+        {
+            for (auto idx : util::irange<std::size_t>(0UL, number_of_legs))
+                assemble_leg(idx);
         }
 
         auto route = guidance::assembleRoute(legs);
@@ -9,6 +9,9 @@ namespace engine
 {
 
 using DataFacadeBase = datafacade::ContiguousInternalMemoryDataFacadeBase;
+
+// The routing algorithms take the concrete facade so that its final accessors bind statically
+// and inline into the search loops. The virtual interfaces are only used by the plugins.
 template <typename AlgorithmT>
 using DataFacade = datafacade::ContiguousInternalMemoryDataFacade<AlgorithmT>;
 }
@@ -1,6 +1,7 @@
 #ifndef OSRM_ENGINE_DATAFACADE_ALGORITHM_DATAFACADE_HPP
 #define OSRM_ENGINE_DATAFACADE_ALGORITHM_DATAFACADE_HPP
 
+#include "contractor/hub_labels.hpp"
 #include "contractor/query_edge.hpp"
 #include "customizer/edge_based_graph.hpp"
 #include "extractor/edge_based_edge.hpp"
@@ -12,6 +13,9 @@
 #include "util/filtered_graph.hpp"
 #include "util/integer_range.hpp"
 
+#include <utility>
+#include <vector>
+
 namespace osrm
 {
 namespace engine
@@ -22,6 +26,7 @@ namespace datafacade
 // Namespace local aliases for algorithms
 using CH = routing_algorithms::ch::Algorithm;
 using MLD = routing_algorithms::mld::Algorithm;
+using HL = routing_algorithms::hl::Algorithm;
 
 template <typename AlgorithmT> class AlgorithmDataFacade;
 
@@ -40,7 +45,18 @@ template <> class AlgorithmDataFacade<CH>
 
     virtual NodeID GetTarget(const EdgeID e) const = 0;
 
-    virtual const EdgeData &GetEdgeData(const EdgeID e) const = 0;
+    // Only reads the part of the edge that is needed to relax it
+    virtual EdgeWeight GetEdgeWeight(const EdgeID e) const = 0;
+
+    virtual bool IsForwardEdge(const EdgeID e) const = 0;
+
+    virtual bool IsBackwardEdge(const EdgeID e) const = 0;
+
+    virtual EdgeData GetEdgeData(const EdgeID e) const = 0;
+
+    // The edges a shortcut consists of: the one at the node the shortcut is stored at and the
+    // one at its target. SPECIAL_EDGEID if they are not stored in the dataset.
+    virtual std::pair<EdgeID, EdgeID> GetShortcutChildren(const EdgeID e) const = 0;
 
     virtual EdgeRange GetAdjacentEdgeRange(const NodeID node) const = 0;
 
@@ -99,6 +115,19 @@ template <> class AlgorithmDataFacade<MLD>
     // searches for a specific edge
     virtual EdgeID FindEdge(const NodeID from, const NodeID to) const = 0;
 };
+
+template <> class AlgorithmDataFacade<HL>
+{
+  public:
+    // distances from the node to the hubs of its search space, the hubs are decoded into the
+    // buffer and the label is only valid while the buffer is
+    virtual contractor::HubLabel GetForwardLabel(const NodeID node,
+                                                 std::vector<NodeID> &hub_buffer) const = 0;
+
+    // distances from the hubs of its search space to the node
+    virtual contractor::HubLabel GetBackwardLabel(const NodeID node,
+                                                  std::vector<NodeID> &hub_buffer) const = 0;
+};
 }
 }
 }
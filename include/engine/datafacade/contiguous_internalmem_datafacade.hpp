@@ -20,10 +20,13 @@
 #include <boost/assert.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -50,6 +53,46 @@ class ContiguousInternalMemoryAlgorithmDataFacade<CH> : public datafacade::Algor
     // allocator that keeps the allocation data
     std::shared_ptr<ContiguousBlockAllocator> allocator;
 
+    // computed on first use, the graph of a facade never changes
+    mutable std::once_flag upward_order_flag;
+    mutable std::vector<NodeID> upward_order;
+
+    // Kahn's algorithm over the edges, which are stored at the lower ranked node
+    void ComputeUpwardOrder() const
+    {
+        const auto number_of_nodes = m_query_graph.GetNumberOfNodes();
+
+        std::vector<std::uint32_t> in_degree(number_of_nodes, 0);
+        for (NodeID node = 0; node < number_of_nodes; ++node)
+        {
+            for (const auto edge : m_query_graph.GetAdjacentEdgeRange(node))
+            {
+                const auto to = m_query_graph.GetTarget(edge);
+                if (to != node)
+                    in_degree[to]++;
+            }
+        }
+
+        upward_order.reserve(number_of_nodes);
+        for (NodeID node = 0; node < number_of_nodes; ++node)
+        {
+            if (in_degree[node] == 0)
+                upward_order.push_back(node);
+        }
+
+        for (std::size_t index = 0; index < upward_order.size(); ++index)
+        {
+            const auto node = upward_order[index];
+            for (const auto edge : m_query_graph.GetAdjacentEdgeRange(node))
+            {
+                const auto to = m_query_graph.GetTarget(edge);
+                if (to != node && --in_degree[to] == 0)
+                    upward_order.push_back(to);
+            }
+        }
+        BOOST_ASSERT(upward_order.size() == number_of_nodes);
+    }
+
   public:
     ContiguousInternalMemoryAlgorithmDataFacade(
         std::shared_ptr<ContiguousBlockAllocator> allocator_,
@@ -80,11 +123,31 @@ class ContiguousInternalMemoryAlgorithmDataFacade<CH> : public datafacade::Algor
 
     NodeID GetTarget(const EdgeID e) const override final { return m_query_graph.GetTarget(e); }
 
-    const EdgeData &GetEdgeData(const EdgeID e) const override final
+    EdgeWeight GetEdgeWeight(const EdgeID e) const override final
+    {
+        return m_query_graph.GetEdgeWeight(e);
+    }
+
+    bool IsForwardEdge(const EdgeID e) const override final
+    {
+        return m_query_graph.IsForwardEdge(e);
+    }
+
+    bool IsBackwardEdge(const EdgeID e) const override final
+    {
+        return m_query_graph.IsBackwardEdge(e);
+    }
+
+    EdgeData GetEdgeData(const EdgeID e) const override final
     {
         return m_query_graph.GetEdgeData(e);
     }
 
+    std::pair<EdgeID, EdgeID> GetShortcutChildren(const EdgeID e) const override final
+    {
+        return m_query_graph.GetShortcutChildren(e);
+    }
+
     EdgeRange GetAdjacentEdgeRange(const NodeID node) const override final
     {
         return m_query_graph.GetAdjacentEdgeRange(node);
@@ -113,6 +176,22 @@ class ContiguousInternalMemoryAlgorithmDataFacade<CH> : public datafacade::Algor
     {
         return m_query_graph.FindSmallestEdge(from, to, filter);
     }
+
+    // Used by the routing algorithms, which always see this facade and not the interface. The
+    // filter is inlined into the edge scan instead of being called through std::function.
+    template <typename FilterFunction>
+    EdgeID FindSmallestEdge(const NodeID from, const NodeID to, FilterFunction &&filter) const
+    {
+        return m_query_graph.FindSmallestEdge(from, to, std::forward<FilterFunction>(filter));
+    }
+
+    // An order of all nodes such that every node comes before the nodes its edges point to,
+    // from the lowest to the highest contracted node. It is computed once per facade.
+    const std::vector<NodeID> &GetUpwardOrder() const
+    {
+        std::call_once(upward_order_flag, [this] { ComputeUpwardOrder(); });
+        return upward_order;
+    }
 };
 
 /**
@@ -169,6 +248,15 @@ class ContiguousInternalMemoryDataFacadeBase : public BaseDataFacade
     // allocator that keeps the allocation data
     std::shared_ptr<ContiguousBlockAllocator> allocator;
 
+    // unique per facade object of the process, see GetGeneration
+    const std::uint64_t generation;
+
+    static std::uint64_t NextGeneration()
+    {
+        static std::atomic<std::uint64_t> next_generation{0};
+        return next_generation++;
+    }
+
     void InitializeInternalPointers(const storage::SharedDataIndex &index,
                                     const std::string &metric_name,
                                     const std::size_t exclude_index)
@@ -222,7 +310,7 @@ class ContiguousInternalMemoryDataFacadeBase : public BaseDataFacade
     ContiguousInternalMemoryDataFacadeBase(std::shared_ptr<ContiguousBlockAllocator> allocator_,
                                            const std::string &metric_name,
                                            const std::size_t exclude_index)
-        : allocator(std::move(allocator_))
+        : allocator(std::move(allocator_)), generation(NextGeneration())
     {
         InitializeInternalPointers(allocator->GetIndex(), metric_name, exclude_index);
     }
@@ -430,8 +518,25 @@ class ContiguousInternalMemoryDataFacadeBase : public BaseDataFacade
             input_coordinate, bearing, bearing_range, approach);
     }
 
+    std::vector<std::pair<PhantomNode, PhantomNode>>
+    NearestPhantomNodesWithAlternativeFromBigComponent(
+        const std::vector<util::Coordinate> &input_coordinates,
+        const std::vector<boost::optional<double>> &max_distances,
+        const std::vector<boost::optional<Bearing>> &bearings,
+        const std::vector<boost::optional<Approach>> &approaches) const override final
+    {
+        BOOST_ASSERT(m_geospatial_query.get());
+
+        return m_geospatial_query->NearestPhantomNodesWithAlternativeFromBigComponent(
+            input_coordinates, max_distances, bearings, approaches);
+    }
+
     std::uint32_t GetCheckSum() const override final { return m_check_sum; }
 
+    // Facades are created for every dataset and exclude class and never change their data, so
+    // results cached for one generation stay valid as long as it is in use.
+    std::uint64_t GetGeneration() const { return generation; }
+
     GeometryID GetGeometryIndex(const NodeID id) const override final
     {
         return edge_based_node_data.GetGeometryID(id);
@@ -454,7 +559,12 @@ class ContiguousInternalMemoryDataFacadeBase : public BaseDataFacade
 
     bool ExcludeNode(const NodeID id) const override final
     {
-        return (edge_based_node_data.GetClassData(id) & exclude_mask) > 0;
+        return ExcludeClasses(edge_based_node_data.GetClassData(id));
+    }
+
+    bool ExcludeClasses(const extractor::ClassData class_data) const override final
+    {
+        return (class_data & exclude_mask) > 0;
     }
 
     std::vector<std::string> GetClasses(const extractor::ClassData class_data) const override final
@@ -663,14 +773,20 @@ template <> class ContiguousInternalMemoryAlgorithmDataFacade<MLD> : public Algo
         InitializeInternalPointers(allocator->GetIndex(), metric_name, exclude_index);
     }
 
-    const partitioner::MultiLevelPartitionView &GetMultiLevelPartition() const override
+    const partitioner::MultiLevelPartitionView &GetMultiLevelPartition() const override final
     {
         return mld_partition;
     }
 
-    const partitioner::CellStorageView &GetCellStorage() const override { return mld_cell_storage; }
+    const partitioner::CellStorageView &GetCellStorage() const override final
+    {
+        return mld_cell_storage;
+    }
 
-    const customizer::CellMetricView &GetCellMetric() const override { return mld_cell_metric; }
+    const customizer::CellMetricView &GetCellMetric() const override final
+    {
+        return mld_cell_metric;
+    }
 
     // search graph access
     unsigned GetNumberOfNodes() const override final { return query_graph.GetNumberOfNodes(); }
@@ -748,6 +864,62 @@ class ContiguousInternalMemoryDataFacade<MLD> final
     {
     }
 };
+
+template <> class ContiguousInternalMemoryAlgorithmDataFacade<HL> : public AlgorithmDataFacade<HL>
+{
+  private:
+    contractor::HubLabelsView m_labels;
+
+    // allocator that keeps the allocation data
+    std::shared_ptr<ContiguousBlockAllocator> allocator;
+
+  public:
+    ContiguousInternalMemoryAlgorithmDataFacade(
+        std::shared_ptr<ContiguousBlockAllocator> allocator_,
+        const std::string &metric_name,
+        std::size_t exclude_index)
+        : allocator(std::move(allocator_))
+    {
+        InitializeInternalPointers(allocator->GetIndex(), metric_name, exclude_index);
+    }
+
+    void InitializeInternalPointers(const storage::SharedDataIndex &index,
+                                    const std::string &metric_name,
+                                    const std::size_t exclude_index)
+    {
+        m_labels = make_hub_labels_view(
+            index, "/hl/metrics/" + metric_name + "/exclude/" + std::to_string(exclude_index));
+    }
+
+    contractor::HubLabel GetForwardLabel(const NodeID node,
+                                         std::vector<NodeID> &hub_buffer) const override final
+    {
+        return m_labels.forward.GetLabel(node, hub_buffer);
+    }
+
+    contractor::HubLabel GetBackwardLabel(const NodeID node,
+                                          std::vector<NodeID> &hub_buffer) const override final
+    {
+        return m_labels.backward.GetLabel(node, hub_buffer);
+    }
+};
+
+// Hub labels are stored next to the contracted graph, which is used for all queries that need
+// the path and not only its length.
+template <>
+class ContiguousInternalMemoryDataFacade<HL> final
+    : public ContiguousInternalMemoryDataFacade<CH>,
+      public ContiguousInternalMemoryAlgorithmDataFacade<HL>
+{
+  public:
+    ContiguousInternalMemoryDataFacade(std::shared_ptr<ContiguousBlockAllocator> allocator,
+                                       const std::string &metric_name,
+                                       const std::size_t exclude_index)
+        : ContiguousInternalMemoryDataFacade<CH>(allocator, metric_name, exclude_index),
+          ContiguousInternalMemoryAlgorithmDataFacade<HL>(allocator, metric_name, exclude_index)
+    {
+    }
+};
 }
 }
 }
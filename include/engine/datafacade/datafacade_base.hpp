@@ -4,6 +4,7 @@
 // Exposes all data access interfaces to the algorithms via base class ptr
 
 #include "engine/approach.hpp"
+#include "engine/bearing.hpp"
 #include "engine/phantom_node.hpp"
 
 #include "contractor/query_edge.hpp"
@@ -31,6 +32,7 @@
 
 #include "osrm/coordinate.hpp"
 
+#include <boost/optional.hpp>
 #include <boost/range/adaptor/reversed.hpp>
 #include <boost/range/any_range.hpp>
 #include <cstddef>
@@ -116,6 +118,9 @@ class BaseDataFacade
 
     virtual bool ExcludeNode(const NodeID id) const = 0;
 
+    // True if nodes with the classes are excluded
+    virtual bool ExcludeClasses(const extractor::ClassData class_data) const = 0;
+
     virtual std::vector<std::string> GetClasses(const extractor::ClassData class_data) const = 0;
 
     virtual std::vector<RTreeLeaf> GetEdgesInBox(const util::Coordinate south_west,
@@ -175,6 +180,14 @@ class BaseDataFacade
                                                       const int bearing,
                                                       const int bearing_range,
                                                       const Approach approach) const = 0;
+    // Snaps many coordinates at once, max_distances, bearings and approaches are empty or have
+    // one entry per coordinate
+    virtual std::vector<std::pair<PhantomNode, PhantomNode>>
+    NearestPhantomNodesWithAlternativeFromBigComponent(
+        const std::vector<util::Coordinate> &input_coordinates,
+        const std::vector<boost::optional<double>> &max_distances,
+        const std::vector<boost::optional<Bearing>> &bearings,
+        const std::vector<boost::optional<Approach>> &approaches) const = 0;
 
     virtual bool HasLaneData(const EdgeID id) const = 0;
     virtual util::guidance::LaneTupleIdPair GetLaneData(const EdgeID id) const = 0;
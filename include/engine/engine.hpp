@@ -1,7 +1,9 @@
 #ifndef ENGINE_HPP
 #define ENGINE_HPP
 
+#include "engine/api/isochrone_parameters.hpp"
 #include "engine/api/match_parameters.hpp"
+#include "engine/api/matched_trace.hpp"
 #include "engine/api/nearest_parameters.hpp"
 #include "engine/api/route_parameters.hpp"
 #include "engine/api/table_parameters.hpp"
@@ -9,6 +11,9 @@
 #include "engine/api/trip_parameters.hpp"
 #include "engine/datafacade_provider.hpp"
 #include "engine/engine_config.hpp"
+#include "engine/matching_session_store.hpp"
+#include "engine/phantom_node_cache.hpp"
+#include "engine/plugins/isochrone.hpp"
 #include "engine/plugins/match.hpp"
 #include "engine/plugins/nearest.hpp"
 #include "engine/plugins/table.hpp"
@@ -16,12 +21,21 @@
 #include "engine/plugins/trip.hpp"
 #include "engine/plugins/viaroute.hpp"
 #include "engine/routing_algorithms.hpp"
+#include "engine/search_context_statistics.hpp"
 #include "engine/status.hpp"
 
 #include "util/json_container.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <string>
+#include <thread>
+#include <vector>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
 
 namespace osrm
 {
@@ -43,18 +57,48 @@ class EngineInterface
     virtual Status Match(const api::MatchParameters &parameters,
                          util::json::Object &result) const = 0;
     virtual Status Tile(const api::TileParameters &parameters, std::string &result) const = 0;
+    virtual Status MatchBatch(const std::vector<api::MatchParameters> &traces,
+                              std::vector<api::MatchedTrace> &results) const = 0;
+    virtual Status Isochrone(const api::IsochroneParameters &parameters,
+                             util::json::Object &result) const = 0;
+    virtual SearchContextStatistics GetSearchContextStatistics() const = 0;
 };
 
 template <typename Algorithm> class Engine final : public EngineInterface
 {
   public:
     explicit Engine(const EngineConfig &config)
-        : route_plugin(config.max_locations_viaroute, config.max_alternatives),            //
-          table_plugin(config.max_locations_distance_table),                               //
+        : search_engine_pool(config.search_context_pool_size > 0
+                                 ? config.search_context_pool_size
+                                 : std::max(1u, std::thread::hardware_concurrency()),
+                             config.use_dense_query_heaps,
+                             config.use_parallel_bidirectional_search),                    //
+          batch_arena(static_cast<int>(search_engine_pool.GetStatistics().size)),          //
+          search_space_cache(config.search_space_cache_size > 0
+                                 ? std::make_unique<routing_algorithms::SearchSpaceCache>(
+                                       std::size_t{config.search_space_cache_size} << 20)
+                                 : nullptr),                                               //
+          phantom_node_cache(config.phantom_node_cache_size > 0
+                                 ? std::make_unique<PhantomNodeCache>(
+                                       std::size_t{config.phantom_node_cache_size} << 20)
+                                 : nullptr),                                               //
+          matching_sessions(config.max_matching_sessions > 0
+                                ? std::make_unique<MatchingSessionStore>(
+                                      config.max_matching_sessions,
+                                      std::chrono::seconds(config.matching_session_ttl))
+                                : nullptr),                                                //
+          route_plugin(config.max_locations_viaroute,
+                       config.max_alternatives,
+                       config.max_alternatives_search_time,
+                       phantom_node_cache.get()),                                          //
+          table_plugin(config.max_locations_distance_table, phantom_node_cache.get()),     //
           nearest_plugin(config.max_results_nearest),                                      //
-          trip_plugin(config.max_locations_trip),                                          //
-          match_plugin(config.max_locations_map_matching, config.max_radius_map_matching), //
-          tile_plugin()                                                                    //
+          trip_plugin(config.max_locations_trip, phantom_node_cache.get()),                //
+          match_plugin(config.max_locations_map_matching,
+                       config.max_radius_map_matching,
+                       matching_sessions.get()),                                           //
+          tile_plugin(),                                                                   //
+          isochrone_plugin(config.max_duration_isochrone)                                  //
 
     {
         if (config.use_shared_memory)
@@ -80,6 +124,16 @@ template <typename Algorithm> class Engine final : public EngineInterface
                                 << routing_algorithms::name<Algorithm>();
             facade_provider = std::make_unique<ImmutableProvider<Algorithm>>(config.storage_config);
         }
+
+        if (config.prewarm_search_contexts)
+        {
+            const auto facade = facade_provider->Get(api::BaseParameters{});
+            search_engine_pool.Prewarm([&facade](SearchEngineData<Algorithm> &context) {
+                PrewarmContext(context, *facade);
+            });
+            util::Log() << "Allocated the heaps of " << search_engine_pool.GetStatistics().size
+                        << " search contexts";
+        }
     }
 
     Engine(Engine &&) noexcept = delete;
@@ -123,13 +177,81 @@ template <typename Algorithm> class Engine final : public EngineInterface
         return tile_plugin.HandleRequest(GetAlgorithms(params), params, result);
     }
 
+    // Every trace borrows a search context of the pool, so the batch is matched on as many
+    // threads as there are contexts and concurrent requests are served in between. The traces
+    // are already matched in parallel, they do not borrow helper contexts.
+    Status MatchBatch(const std::vector<api::MatchParameters> &traces,
+                      std::vector<api::MatchedTrace> &results) const override final
+    {
+        results.clear();
+        results.resize(traces.size());
+        if (!routing_algorithms::HasMapMatching<Algorithm>::value)
+        {
+            return Status::Error;
+        }
+
+        // the arena has a slot per search context, so no thread waits for one to get free
+        batch_arena.execute([&] {
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(0, traces.size()),
+                              [&](const tbb::blocked_range<std::size_t> &range) {
+                                  for (auto index = range.begin(); index != range.end(); ++index)
+                                  {
+                                      const RoutingAlgorithms<Algorithm> algorithms{
+                                          search_engine_pool.Borrow(),
+                                          facade_provider->Get(traces[index]),
+                                          nullptr,
+                                          search_space_cache.get()};
+                                      match_plugin.HandleBatchTrace(
+                                          algorithms, traces[index], results[index]);
+                                  }
+                              });
+        });
+        return Status::Ok;
+    }
+
+    Status Isochrone(const api::IsochroneParameters &params,
+                     util::json::Object &result) const override final
+    {
+        return isochrone_plugin.HandleRequest(GetAlgorithms(params), params, result);
+    }
+
+    SearchContextStatistics GetSearchContextStatistics() const override final
+    {
+        return search_engine_pool.GetStatistics();
+    }
+
   private:
+    // Allocates the heaps of the point to point and the many-to-many searches
+    static void PrewarmContext(SearchEngineData<routing_algorithms::ch::Algorithm> &context,
+                               const DataFacade<routing_algorithms::ch::Algorithm> &facade)
+    {
+        context.InitializeOrClearFirstHeaps(facade.GetNumberOfNodes());
+        context.InitializeOrClearManyToManyHeaps(facade.GetNumberOfNodes());
+    }
+
+    static void PrewarmContext(SearchEngineData<routing_algorithms::mld::Algorithm> &context,
+                               const DataFacade<routing_algorithms::mld::Algorithm> &facade)
+    {
+        context.InitializeOrClearFirstHeaps(facade.GetNumberOfNodes(),
+                                            facade.GetMaxBorderNodeID() + 1);
+        context.InitializeOrClearManyToManyHeaps(facade.GetNumberOfNodes(),
+                                                 facade.GetMaxBorderNodeID() + 1);
+    }
+
     template <typename ParametersT> auto GetAlgorithms(const ParametersT &params) const
     {
-        return RoutingAlgorithms<Algorithm>{heaps, facade_provider->Get(params)};
+        return RoutingAlgorithms<Algorithm>{search_engine_pool.Borrow(),
+                                            facade_provider->Get(params),
+                                            &search_engine_pool,
+                                            search_space_cache.get()};
     }
     std::unique_ptr<DataFacadeProvider<Algorithm>> facade_provider;
-    mutable SearchEngineData<Algorithm> heaps;
+    mutable SearchEnginePool<Algorithm> search_engine_pool;
+    // runs the threads of MatchBatch, at most as many as there are search contexts
+    mutable tbb::task_arena batch_arena;
+    const std::unique_ptr<routing_algorithms::SearchSpaceCache> search_space_cache;
+    const std::unique_ptr<PhantomNodeCache> phantom_node_cache;
+    const std::unique_ptr<MatchingSessionStore> matching_sessions;
 
     const plugins::ViaRoutePlugin route_plugin;
     const plugins::TablePlugin table_plugin;
@@ -137,6 +259,7 @@ template <typename Algorithm> class Engine final : public EngineInterface
     const plugins::TripPlugin trip_plugin;
     const plugins::MatchPlugin match_plugin;
     const plugins::TilePlugin tile_plugin;
+    const plugins::IsochronePlugin isochrone_plugin;
 };
 }
 }
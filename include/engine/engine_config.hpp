@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <boost/filesystem/path.hpp>
 
+#include <iosfwd>
 #include <string>
 
 namespace osrm
@@ -53,9 +54,48 @@ namespace engine
  *  - Match
  *  - Nearest
  *
+ * The Isochrone service is constrained by the maximum contour in seconds (-1 for unlimited).
+ *
  * In addition, shared memory can be used for datasets loaded with osrm-datastore.
  *
- * You can chose between three algorithms:
+ * CH query heaps index nodes in a hash map by default. With use_dense_query_heaps every
+ * search context uses arrays of the size of the graph instead, which costs a few bytes per
+ * node and heap but makes lookups and clearing between queries much cheaper.
+ *
+ * Each request borrows one search context holding its query heaps. At most
+ * search_context_pool_size requests are served in parallel, further requests wait until a
+ * context is returned. The default of 0 creates one context per hardware thread. Heaps are
+ * allocated by the first request that needs them, with prewarm_search_contexts the heaps of
+ * all contexts are allocated when the engine is started instead.
+ *
+ * With use_parallel_bidirectional_search MLD routes between different top level cells run the
+ * forward and the reverse search on two threads. This lowers the latency of long routes at the
+ * cost of one more core and an array of the overlay size per search context.
+ *
+ * Alternative routes evaluate their candidates on idle search contexts of the pool in parallel.
+ * After max_alternatives_search_time milliseconds no further candidates are evaluated and the
+ * best alternatives found so far are returned, by default the search time is unlimited.
+ *
+ * With CH the backward search spaces of distance table targets can be kept in a cache of
+ * search_space_cache_size MiB shared by all requests, so frequent destinations are only
+ * searched again after they were evicted as least recently used. Disabled by default.
+ *
+ * Route, table and trip requests snap coordinates without hints to the road network with an
+ * R-tree query. With phantom_node_cache_size set, the results are kept in a cache of that many
+ * MiB, so repeated coordinates are snapped from memory. Disabled by default.
+ *
+ * Match requests with a session id extend the trace matched by the previous requests of the
+ * session, so live traces only send their new points. At most max_matching_sessions sessions
+ * are kept, they expire after matching_session_ttl seconds without requests. Disabled by
+ * default.
+ *
+ * The leaves of the R-tree are mapped from the .fileIndex file and read from disk by the first
+ * queries that need them. With storage_config.load_rtree_leaves they are copied into process
+ * memory when the data is loaded (osrm-datastore --load-rtree-leaves does the same for shared
+ * memory). With use_mmap, storage_config.rtree_leaves_preload reads the mapped leaves ahead of
+ * the first queries. The config is invalid if it is set without use_mmap.
+ *
+ * You can chose between four algorithms:
  *  - Algorithm::CH
  *      Contraction Hierarchies, extremely fast queries but slow pre-processing. The default right
  * now.
@@ -65,6 +105,9 @@ namespace engine
  * queries.
  *  - Algorithm::MLD
  *      Multi Level Dijkstra, moderately fast in both pre-processing and query.
+ *  - Algorithm::HL
+ *      Hub Labels computed from the CH data by osrm-contract --hub-labels. Distance tables are
+ * answered from the labels alone, all other queries use CH.
  *
  * \see OSRM, StorageConfig
  */
@@ -76,7 +119,8 @@ struct EngineConfig final
     {
         CH,
         CoreCH, // Deprecated, will be removed in v6.0
-        MLD
+        MLD,
+        HL
     };
 
     storage::StorageConfig storage_config;
@@ -86,14 +130,27 @@ struct EngineConfig final
     int max_locations_map_matching = -1;
     double max_radius_map_matching = -1.0;
     int max_results_nearest = -1;
+    double max_duration_isochrone = -1.0;
     int max_alternatives = 3; // set an arbitrary upper bound; can be adjusted by user
+    int max_alternatives_search_time = -1; // in milliseconds
     bool use_shared_memory = true;
     boost::filesystem::path memory_file;
     bool use_mmap = true;
+    bool use_dense_query_heaps = false;
+    bool use_parallel_bidirectional_search = false;
+    unsigned search_context_pool_size = 0;
+    bool prewarm_search_contexts = false;
+    unsigned search_space_cache_size = 0; // in MiB
+    unsigned phantom_node_cache_size = 0;  // in MiB
+    unsigned max_matching_sessions = 0;
+    unsigned matching_session_ttl = 300; // in seconds
     Algorithm algorithm = Algorithm::CH;
     std::string verbosity;
     std::string dataset_name;
 };
+
+// Parses the name of an algorithm as given on the command line of the tools, case insensitive
+std::istream &operator>>(std::istream &in, EngineConfig::Algorithm &algorithm);
 }
 }
 
@@ -2,19 +2,31 @@
 #define GEOSPATIAL_QUERY_HPP
 
 #include "engine/approach.hpp"
+#include "engine/bearing.hpp"
 #include "engine/phantom_node.hpp"
 #include "util/bearing.hpp"
 #include "util/coordinate_calculation.hpp"
+#include "util/hilbert_value.hpp"
+#include "util/integer_range.hpp"
 #include "util/rectangle.hpp"
+#include "util/rtree_segment_attributes.hpp"
 #include "util/typedefs.hpp"
 #include "util/web_mercator.hpp"
 
 #include "osrm/coordinate.hpp"
 
+#include <boost/optional.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <iterator>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -66,6 +78,9 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
             [this, max_distance, input_coordinate](const std::size_t,
                                                    const CandidateSegment &segment) {
                 return CheckSegmentDistance(input_coordinate, segment, max_distance);
+            },
+            [this, use_all_edges](const util::RTreeSegmentAttributes &attributes) {
+                return HasAdmissibleSegments(attributes, use_all_edges);
             });
 
         return MakePhantomNodes(input_coordinate, results);
@@ -96,6 +111,9 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
             [this, max_distance, input_coordinate](const std::size_t,
                                                    const CandidateSegment &segment) {
                 return CheckSegmentDistance(input_coordinate, segment, max_distance);
+            },
+            [this, use_all_edges](const util::RTreeSegmentAttributes &attributes) {
+                return HasAdmissibleSegments(attributes, use_all_edges);
             });
 
         return MakePhantomNodes(input_coordinate, results);
@@ -122,6 +140,9 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
             },
             [max_results](const std::size_t num_results, const CandidateSegment &) {
                 return num_results >= max_results;
+            },
+            [this](const util::RTreeSegmentAttributes &attributes) {
+                return HasAdmissibleSegments(attributes);
             });
 
         return MakePhantomNodes(input_coordinate, results);
@@ -152,6 +173,9 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                                                                 const CandidateSegment &segment) {
                 return num_results >= max_results ||
                        CheckSegmentDistance(input_coordinate, segment, max_distance);
+            },
+            [this](const util::RTreeSegmentAttributes &attributes) {
+                return HasAdmissibleSegments(attributes);
             });
 
         return MakePhantomNodes(input_coordinate, results);
@@ -172,6 +196,9 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
             },
             [max_results](const std::size_t num_results, const CandidateSegment &) {
                 return num_results >= max_results;
+            },
+            [this](const util::RTreeSegmentAttributes &attributes) {
+                return HasAdmissibleSegments(attributes);
             });
 
         return MakePhantomNodes(input_coordinate, results);
@@ -195,6 +222,9 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                                                                 const CandidateSegment &segment) {
                 return num_results >= max_results ||
                        CheckSegmentDistance(input_coordinate, segment, max_distance);
+            },
+            [this](const util::RTreeSegmentAttributes &attributes) {
+                return HasAdmissibleSegments(attributes);
             });
 
         return MakePhantomNodes(input_coordinate, results);
@@ -235,6 +265,10 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                 const std::size_t num_results, const CandidateSegment &segment) {
                 return (num_results > 0 && has_big_component) ||
                        CheckSegmentDistance(input_coordinate, segment, max_distance);
+            },
+            [this, &has_big_component, &has_small_component](
+                const util::RTreeSegmentAttributes &attributes) {
+                return HasAdmissibleSegments(attributes, has_small_component, has_big_component);
             });
 
         if (results.size() == 0)
@@ -280,6 +314,10 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
             },
             [&has_big_component](const std::size_t num_results, const CandidateSegment &) {
                 return num_results > 0 && has_big_component;
+            },
+            [this, &has_big_component, &has_small_component](
+                const util::RTreeSegmentAttributes &attributes) {
+                return HasAdmissibleSegments(attributes, has_small_component, has_big_component);
             });
 
         if (results.size() == 0)
@@ -337,6 +375,10 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
             },
             [&has_big_component](const std::size_t num_results, const CandidateSegment &) {
                 return num_results > 0 && has_big_component;
+            },
+            [this, &has_big_component, &has_small_component](
+                const util::RTreeSegmentAttributes &attributes) {
+                return HasAdmissibleSegments(attributes, has_small_component, has_big_component);
             });
 
         if (results.size() == 0)
@@ -397,6 +439,10 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                 const std::size_t num_results, const CandidateSegment &segment) {
                 return (num_results > 0 && has_big_component) ||
                        CheckSegmentDistance(input_coordinate, segment, max_distance);
+            },
+            [this, &has_big_component, &has_small_component](
+                const util::RTreeSegmentAttributes &attributes) {
+                return HasAdmissibleSegments(attributes, has_small_component, has_big_component);
             });
 
         if (results.size() == 0)
@@ -409,6 +455,83 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                               MakePhantomNode(input_coordinate, results.back()).phantom_node);
     }
 
+    // Snaps all coordinates like NearestPhantomNodeWithAlternativeFromBigComponent, with the
+    // radius, bearing and approach of each coordinate. The parameter vectors are either empty or
+    // have one entry per coordinate.
+    //
+    // The coordinates are snapped in the order of their Hilbert values, and the sorted sequence
+    // is split into blocks that are snapped in parallel. So consecutive queries of a thread are
+    // close to each other and find the upper tree nodes and the leaves they visit in the cache.
+    std::vector<std::pair<PhantomNode, PhantomNode>>
+    NearestPhantomNodesWithAlternativeFromBigComponent(
+        const std::vector<util::Coordinate> &input_coordinates,
+        const std::vector<boost::optional<double>> &max_distances,
+        const std::vector<boost::optional<Bearing>> &bearings,
+        const std::vector<boost::optional<Approach>> &approaches) const
+    {
+        BOOST_ASSERT(max_distances.empty() || max_distances.size() == input_coordinates.size());
+        BOOST_ASSERT(bearings.empty() || bearings.size() == input_coordinates.size());
+        BOOST_ASSERT(approaches.empty() || approaches.size() == input_coordinates.size());
+
+        std::vector<std::pair<std::uint64_t, std::size_t>> hilbert_order(input_coordinates.size());
+        for (const auto index : util::irange<std::size_t>(0, input_coordinates.size()))
+        {
+            hilbert_order[index] = {util::GetHilbertCode(input_coordinates[index]), index};
+        }
+        tbb::parallel_sort(hilbert_order.begin(), hilbert_order.end());
+
+        std::vector<std::pair<PhantomNode, PhantomNode>> phantom_node_pairs(
+            input_coordinates.size());
+        // a block of coordinates is snapped by a single thread, small batches stay on the
+        // calling thread
+        constexpr std::size_t COORDINATES_PER_BLOCK = 32;
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, hilbert_order.size(), COORDINATES_PER_BLOCK),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                for (const auto position : util::irange(range.begin(), range.end()))
+                {
+                    const auto index = hilbert_order[position].second;
+                    const auto approach = !approaches.empty() && approaches[index]
+                                              ? *approaches[index]
+                                              : Approach::UNRESTRICTED;
+                    const auto &input_coordinate = input_coordinates[index];
+                    const auto has_max_distance = !max_distances.empty() && max_distances[index];
+                    const auto has_bearing = !bearings.empty() && bearings[index];
+
+                    auto &phantom_node_pair = phantom_node_pairs[index];
+                    if (has_bearing && has_max_distance)
+                    {
+                        phantom_node_pair = NearestPhantomNodeWithAlternativeFromBigComponent(
+                            input_coordinate,
+                            *max_distances[index],
+                            bearings[index]->bearing,
+                            bearings[index]->range,
+                            approach);
+                    }
+                    else if (has_bearing)
+                    {
+                        phantom_node_pair = NearestPhantomNodeWithAlternativeFromBigComponent(
+                            input_coordinate,
+                            bearings[index]->bearing,
+                            bearings[index]->range,
+                            approach);
+                    }
+                    else if (has_max_distance)
+                    {
+                        phantom_node_pair = NearestPhantomNodeWithAlternativeFromBigComponent(
+                            input_coordinate, *max_distances[index], approach);
+                    }
+                    else
+                    {
+                        phantom_node_pair = NearestPhantomNodeWithAlternativeFromBigComponent(
+                            input_coordinate, approach);
+                    }
+                }
+            });
+
+        return phantom_node_pairs;
+    }
+
   private:
     std::vector<PhantomNodeWithDistance>
     MakePhantomNodes(const util::Coordinate input_coordinate,
@@ -580,6 +703,27 @@ template <typename RTreeT, typename DataFacadeT> class GeospatialQuery
                max_distance;
     }
 
+    // False if none of the segments with the aggregated attributes can pass HasValidEdge and
+    // CheckSegmentExclude, the R-tree skips their subtree
+    bool HasAdmissibleSegments(const util::RTreeSegmentAttributes &attributes,
+                               const bool use_all_edges = false) const
+    {
+        return (use_all_edges || attributes.HasFlag(util::RTreeSegmentAttributes::STARTPOINT)) &&
+               !datafacade.ExcludeClasses(attributes.common_classes);
+    }
+
+    // Same for the searches with an alternative from a big component, once they found a segment
+    // of a tiny component they only accept segments of big components.
+    bool HasAdmissibleSegments(const util::RTreeSegmentAttributes &attributes,
+                               const bool has_small_component,
+                               const bool has_big_component) const
+    {
+        return HasAdmissibleSegments(attributes) &&
+               (!has_small_component ||
+                (!has_big_component &&
+                 attributes.HasFlag(util::RTreeSegmentAttributes::BIG_COMPONENT)));
+    }
+
     std::pair<bool, bool> CheckSegmentExclude(const CandidateSegment &segment) const
     {
         std::pair<bool, bool> valid = {true, true};
@@ -67,9 +67,19 @@ struct PathData
     bool is_left_hand_driving;
 };
 
+// Weight, duration and distance of a leg from the source to the target phantom node
+struct LegTotals
+{
+    EdgeWeight weight;
+    EdgeDuration duration;
+    EdgeDistance distance;
+};
+
 struct InternalRouteResult
 {
     std::vector<std::vector<PathData>> unpacked_path_segments;
+    // Only set by searches that do not unpack the path, unpacked_path_segments is empty then
+    std::vector<LegTotals> leg_totals;
     std::vector<PhantomNodes> segment_end_coordinates;
     std::vector<bool> source_traversed_in_reverse;
     std::vector<bool> target_traversed_in_reverse;
@@ -2,13 +2,16 @@
 #define HIDDEN_MARKOV_MODEL
 
 #include "util/integer_range.hpp"
+#include "util/vector_view.hpp"
 
 #include <boost/assert.hpp>
 #include <boost/math/constants/constants.hpp>
 
+#include <algorithm>
 #include <cmath>
-
+#include <cstdint>
 #include <limits>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -48,59 +51,146 @@ struct TransitionLogProbability
     double operator()(const double d_t) const { return -log_beta - d_t / beta; }
 };
 
-template <class CandidateLists> struct HiddenMarkovModel
+// Columns of one value for all trace points, stored back to back in one array. Column t
+// spans [offsets[t], offsets[t + 1]) and is accessed as a view.
+template <typename T> class HiddenMarkovModelColumns
 {
-    std::vector<std::vector<double>> viterbi;
-    std::vector<std::vector<bool>> viterbi_reachable;
-    std::vector<std::vector<std::pair<unsigned, unsigned>>> parents;
-    std::vector<std::vector<float>> path_distances;
-    std::vector<std::vector<bool>> pruned;
-    std::vector<bool> breakage;
+  public:
+    HiddenMarkovModelColumns(std::vector<T> &values, const std::vector<std::size_t> &offsets)
+        : values(values), offsets(offsets)
+    {
+    }
+
+    util::vector_view<T> operator[](const std::size_t t) const
+    {
+        BOOST_ASSERT(t + 1 < offsets.size());
+        return util::vector_view<T>(values.data() + offsets[t], offsets[t + 1] - offsets[t]);
+    }
+
+    std::size_t size() const { return offsets.size() - 1; }
+
+  private:
+    std::vector<T> &values;
+    const std::vector<std::size_t> &offsets;
+};
 
+// Arrays of a hidden Markov model, kept by the search context of a thread. A model resizes
+// them for its trace and they are reused by the next one, so once they fit the longest trace
+// matching does not allocate anymore. A model with more than max_retained_states states shrinks
+// them back when it is done, a single huge trace does not pin its memory in every context.
+//
+// Viterbi values are sums of log probabilities over the whole sub-matching, they stay double.
+// Emission log probabilities and path distances are only summed up per transition, float is
+// precise enough for them. Flags are bytes instead of bits so they can be accessed as views.
+struct HiddenMarkovModelStorage
+{
+    // about 100 trace points with 100 candidates each, at 26 bytes per state 0.25 MiB of arrays
+    static constexpr std::size_t DEFAULT_MAX_RETAINED_STATES = 10000;
+
+    std::size_t max_retained_states = DEFAULT_MAX_RETAINED_STATES;
+
+    std::vector<std::size_t> offsets;
+    std::vector<double> viterbi;
+    std::vector<std::pair<unsigned, unsigned>> parents;
+    std::vector<float> path_distances;
+    std::vector<float> emission_log_probabilities;
+    std::vector<std::uint8_t> viterbi_reachable;
+    std::vector<std::uint8_t> pruned;
+    std::vector<std::uint8_t> breakage;
+
+    std::size_t GetMemoryUsage() const
+    {
+        return offsets.capacity() * sizeof(std::size_t) + viterbi.capacity() * sizeof(double) +
+               parents.capacity() * sizeof(std::pair<unsigned, unsigned>) +
+               (path_distances.capacity() + emission_log_probabilities.capacity()) *
+                   sizeof(float) +
+               viterbi_reachable.capacity() + pruned.capacity() + breakage.capacity();
+    }
+
+    // Releases the arrays of a model with more states than retained and keeps the capacity
+    // for max_retained_states, the contents are reset by the next model anyway
+    void Shrink()
+    {
+        if (viterbi.capacity() <= max_retained_states)
+            return;
+
+        shrink(offsets, max_retained_states + 1);
+        shrink(viterbi, max_retained_states);
+        shrink(parents, max_retained_states);
+        shrink(path_distances, max_retained_states);
+        shrink(emission_log_probabilities, max_retained_states);
+        shrink(viterbi_reachable, max_retained_states);
+        shrink(pruned, max_retained_states);
+        shrink(breakage, max_retained_states);
+    }
+
+  private:
+    template <typename T> static void shrink(std::vector<T> &values, const std::size_t capacity)
+    {
+        if (values.capacity() <= capacity)
+            return;
+
+        std::vector<T> shrunk;
+        shrunk.reserve(capacity);
+        values.swap(shrunk);
+    }
+};
+
+template <class CandidateLists> struct HiddenMarkovModel
+{
     const CandidateLists &candidates_list;
-    const std::vector<std::vector<double>> &emission_log_probabilities;
 
-    HiddenMarkovModel(const CandidateLists &candidates_list,
-                      const std::vector<std::vector<double>> &emission_log_probabilities)
-        : breakage(candidates_list.size()), candidates_list(candidates_list),
-          emission_log_probabilities(emission_log_probabilities)
+    HiddenMarkovModelColumns<double> viterbi;
+    HiddenMarkovModelColumns<std::uint8_t> viterbi_reachable;
+    HiddenMarkovModelColumns<std::pair<unsigned, unsigned>> parents;
+    HiddenMarkovModelColumns<float> path_distances;
+    HiddenMarkovModelColumns<std::uint8_t> pruned;
+    // filled by the caller before the model is initialized
+    HiddenMarkovModelColumns<float> emission_log_probabilities;
+    std::vector<std::uint8_t> &breakage;
+
+    HiddenMarkovModel(const CandidateLists &candidates_list, HiddenMarkovModelStorage &storage)
+        : candidates_list(candidates_list), viterbi(storage.viterbi, storage.offsets),
+          viterbi_reachable(storage.viterbi_reachable, storage.offsets),
+          parents(storage.parents, storage.offsets),
+          path_distances(storage.path_distances, storage.offsets),
+          pruned(storage.pruned, storage.offsets),
+          emission_log_probabilities(storage.emission_log_probabilities, storage.offsets),
+          breakage(storage.breakage), storage(storage)
     {
-        viterbi.resize(candidates_list.size());
-        viterbi_reachable.resize(candidates_list.size());
-        parents.resize(candidates_list.size());
-        path_distances.resize(candidates_list.size());
-        pruned.resize(candidates_list.size());
-        breakage.resize(candidates_list.size());
-        for (const auto i : util::irange<std::size_t>(0UL, candidates_list.size()))
+        auto &offsets = storage.offsets;
+        offsets.resize(candidates_list.size() + 1);
+        offsets[0] = 0;
+        for (const auto t : util::irange<std::size_t>(0UL, candidates_list.size()))
         {
-            const auto &num_candidates = candidates_list[i].size();
-            // add empty vectors
-            if (num_candidates > 0)
-            {
-                viterbi[i].resize(num_candidates);
-                viterbi_reachable[i].resize(num_candidates);
-                parents[i].resize(num_candidates);
-                path_distances[i].resize(num_candidates);
-                pruned[i].resize(num_candidates);
-            }
+            offsets[t + 1] = offsets[t] + candidates_list[t].size();
         }
 
+        const auto number_of_states = offsets.back();
+        storage.viterbi.resize(number_of_states);
+        storage.viterbi_reachable.resize(number_of_states);
+        storage.parents.resize(number_of_states);
+        storage.path_distances.resize(number_of_states);
+        storage.pruned.resize(number_of_states);
+        storage.emission_log_probabilities.resize(number_of_states);
+        breakage.resize(candidates_list.size());
+
         Clear(0);
     }
 
+    ~HiddenMarkovModel() { storage.Shrink(); }
+
     void Clear(std::size_t initial_timestamp)
     {
-        BOOST_ASSERT(viterbi.size() == parents.size() && parents.size() == path_distances.size() &&
-                     path_distances.size() == pruned.size() && pruned.size() == breakage.size());
-
-        for (const auto t : util::irange(initial_timestamp, viterbi.size()))
-        {
-            std::fill(viterbi[t].begin(), viterbi[t].end(), IMPOSSIBLE_LOG_PROB);
-            std::fill(viterbi_reachable[t].begin(), viterbi_reachable[t].end(), false);
-            std::fill(parents[t].begin(), parents[t].end(), std::make_pair(0u, 0u));
-            std::fill(path_distances[t].begin(), path_distances[t].end(), 0);
-            std::fill(pruned[t].begin(), pruned[t].end(), true);
-        }
+        BOOST_ASSERT(initial_timestamp < storage.offsets.size());
+
+        // the columns from initial_timestamp on are the tail of every array
+        const auto begin = storage.offsets[initial_timestamp];
+        std::fill(storage.viterbi.begin() + begin, storage.viterbi.end(), IMPOSSIBLE_LOG_PROB);
+        std::fill(storage.viterbi_reachable.begin() + begin, storage.viterbi_reachable.end(), 0);
+        std::fill(storage.parents.begin() + begin, storage.parents.end(), std::make_pair(0u, 0u));
+        std::fill(storage.path_distances.begin() + begin, storage.path_distances.end(), 0);
+        std::fill(storage.pruned.begin() + begin, storage.pruned.end(), 1);
         std::fill(breakage.begin() + initial_timestamp, breakage.end(), true);
     }
 
@@ -111,14 +201,17 @@ template <class CandidateLists> struct HiddenMarkovModel
         {
             BOOST_ASSERT(initial_timestamp < num_points);
 
-            for (const auto s : util::irange<std::size_t>(0UL, viterbi[initial_timestamp].size()))
+            auto initial_viterbi = viterbi[initial_timestamp];
+            auto initial_parents = parents[initial_timestamp];
+            auto initial_pruned = pruned[initial_timestamp];
+            const auto initial_emissions = emission_log_probabilities[initial_timestamp];
+            for (const auto s : util::irange<std::size_t>(0UL, initial_viterbi.size()))
             {
-                viterbi[initial_timestamp][s] = emission_log_probabilities[initial_timestamp][s];
-                parents[initial_timestamp][s] = std::make_pair(initial_timestamp, s);
-                pruned[initial_timestamp][s] = viterbi[initial_timestamp][s] < MINIMAL_LOG_PROB;
+                initial_viterbi[s] = initial_emissions[s];
+                initial_parents[s] = std::make_pair(initial_timestamp, s);
+                initial_pruned[s] = initial_viterbi[s] < MINIMAL_LOG_PROB;
 
-                breakage[initial_timestamp] =
-                    breakage[initial_timestamp] && pruned[initial_timestamp][s];
+                breakage[initial_timestamp] = breakage[initial_timestamp] && initial_pruned[s];
             }
 
             ++initial_timestamp;
@@ -136,6 +229,9 @@ template <class CandidateLists> struct HiddenMarkovModel
 
         return initial_timestamp;
     }
+
+  private:
+    HiddenMarkovModelStorage &storage;
 };
 }
 }
@@ -0,0 +1,74 @@
+#ifndef MAP_MATCHING_MATCHING_FRONTIER_HPP
+#define MAP_MATCHING_MATCHING_FRONTIER_HPP
+
+#include "engine/phantom_node.hpp"
+
+#include "util/coordinate.hpp"
+
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace map_matching
+{
+
+// Last matched column of the hidden Markov model of a trace that is matched incrementally.
+// New points of the trace only need the transitions from this column, so extending a trace
+// does not depend on its length.
+struct MatchingFrontier
+{
+    std::vector<PhantomNodeWithDistance> candidates;
+    // normalized to a maximum of 0, only the differences between candidates matter
+    std::vector<double> viterbi;
+    std::vector<bool> pruned;
+    util::Coordinate coordinate;
+    boost::optional<unsigned> timestamp;
+    // times between the most recent samples seen so far, oldest first
+    std::vector<unsigned> sample_times;
+    // points of the trace after the frontier that could not be matched
+    unsigned broken_points = 0;
+
+    static constexpr std::size_t MAX_SAMPLE_TIMES = 32;
+
+    bool Empty() const { return candidates.empty(); }
+
+    // Clears the matching state, the sample times still describe the trace
+    void Clear()
+    {
+        auto recent_sample_times = std::move(sample_times);
+        *this = MatchingFrontier{};
+        sample_times = std::move(recent_sample_times);
+    }
+
+    void AddSampleTimes(const std::vector<unsigned> &new_sample_times)
+    {
+        sample_times.insert(sample_times.end(), new_sample_times.begin(), new_sample_times.end());
+        if (sample_times.size() > MAX_SAMPLE_TIMES)
+        {
+            sample_times.erase(sample_times.begin(), sample_times.end() - MAX_SAMPLE_TIMES);
+        }
+    }
+
+    // Median time between the recent samples, 0 if unknown. The lower median is taken, so a
+    // single gap among few samples is not mistaken for the sample time.
+    unsigned GetMedianSampleTime() const
+    {
+        if (sample_times.empty())
+            return 0;
+
+        auto sorted_sample_times = sample_times;
+        const auto median = sorted_sample_times.begin() + (sorted_sample_times.size() - 1) / 2;
+        std::nth_element(sorted_sample_times.begin(), median, sorted_sample_times.end());
+        return std::max(1u, *median);
+    }
+};
+}
+}
+}
+
+#endif
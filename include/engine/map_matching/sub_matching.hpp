@@ -3,6 +3,7 @@
 
 #include "engine/phantom_node.hpp"
 
+#include <limits>
 #include <vector>
 
 namespace osrm
@@ -12,6 +13,9 @@ namespace engine
 namespace map_matching
 {
 
+// index of a matched node that is not a point of the request, like the frontier of a session
+static const constexpr unsigned INVALID_TRACE_INDEX = std::numeric_limits<unsigned>::max();
+
 struct SubMatching
 {
     std::vector<PhantomNode> nodes;
@@ -0,0 +1,110 @@
+#ifndef OSRM_ENGINE_MATCHING_SESSION_STORE_HPP
+#define OSRM_ENGINE_MATCHING_SESSION_STORE_HPP
+
+#include "engine/map_matching/matching_frontier.hpp"
+
+#include "util/log.hpp"
+#include "util/lru_cache.hpp"
+
+#include <boost/assert.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Traces of live vehicles that are matched incrementally, one request per batch of new points.
+// A session keeps the frontier of the hidden Markov model between the requests, so new points
+// extend the matching instead of matching the whole trailing window again.
+//
+// Sessions that were not used for the time to live expire. At most max_sessions are kept, when
+// more are opened the least recently used ones are dropped.
+class MatchingSessionStore
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Session
+    {
+        // serializes the requests of a session, the frontier is only valid for the facade
+        // generation it was matched on
+        std::mutex mutex;
+        std::uint64_t facade_generation = 0;
+        map_matching::MatchingFrontier frontier;
+    };
+
+    MatchingSessionStore(const std::size_t max_sessions, const Clock::duration time_to_live)
+        : time_to_live(time_to_live), sessions(max_sessions)
+    {
+        BOOST_ASSERT(max_sessions > 0);
+    }
+
+    MatchingSessionStore(const MatchingSessionStore &) = delete;
+    MatchingSessionStore &operator=(const MatchingSessionStore &) = delete;
+
+    ~MatchingSessionStore()
+    {
+        util::Log(logDEBUG) << "Matching sessions: " << opened << " opened, " << expired
+                            << " expired";
+    }
+
+    // Returns the session of the id, a new one if it does not exist or expired
+    std::shared_ptr<Session> Get(const std::string &id, const Clock::time_point now = Clock::now())
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // least recently used sessions expire first
+        while (const auto oldest = sessions.GetLeastRecentlyUsed())
+        {
+            if (now - oldest->second->last_used <= time_to_live)
+                break;
+            sessions.Erase(oldest->first);
+            expired++;
+        }
+
+        auto entry = sessions.Get(id);
+        if (!entry)
+        {
+            entry = std::make_shared<Entry>();
+            sessions.Insert(id, *entry, 1);
+            opened++;
+        }
+        (*entry)->last_used = now;
+
+        // shares the ownership of the entry, dropping the session keeps it alive until the
+        // request using it finished
+        return std::shared_ptr<Session>(*entry, &(*entry)->session);
+    }
+
+    std::size_t GetNumberOfSessions() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sessions.GetNumberOfEntries();
+    }
+
+  private:
+    struct Entry
+    {
+        Session session;
+        // guarded by the mutex of the store
+        Clock::time_point last_used;
+    };
+
+    const Clock::duration time_to_live;
+
+    mutable std::mutex mutex;
+    // every session has a size of 1, the capacity is the number of sessions
+    util::LRUCache<std::string, std::shared_ptr<Entry>> sessions;
+    std::size_t opened = 0;
+    std::size_t expired = 0;
+};
+}
+}
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef OSRM_ENGINE_PHANTOM_NODE_CACHE_HPP
+#define OSRM_ENGINE_PHANTOM_NODE_CACHE_HPP
+
+#include "engine/approach.hpp"
+#include "engine/bearing.hpp"
+#include "engine/phantom_node.hpp"
+
+#include "util/coordinate.hpp"
+#include "util/log.hpp"
+#include "util/lru_cache.hpp"
+#include "util/std_hash.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/optional.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Phantom nodes snapped for coordinates, shared by all requests of an engine. Locations like
+// depots and stations are requested over and over again, for them the R-tree query, which may
+// fault in pages of mmap-ed datasets, is replaced by a lookup.
+//
+// Entries are keyed by the coordinate and the snapping parameters. The facade generation
+// covers the dataset and the exclude classes: facades of a new dataset have new generations,
+// so phantom nodes of replaced datasets are never returned and age out of the cache.
+//
+// The cache is split into shards of the same capacity, each guarded by its own mutex, so that
+// concurrent requests rarely contend for the same lock.
+class PhantomNodeCache
+{
+  public:
+    struct Key
+    {
+        std::uint64_t facade_generation;
+        util::Coordinate coordinate;
+        // negative if unlimited
+        double radius;
+        // bearing and range are negative if not restricted
+        Bearing bearing;
+        Approach approach;
+
+        Key(const std::uint64_t facade_generation,
+            const util::Coordinate coordinate,
+            const boost::optional<double> &radius,
+            const boost::optional<Bearing> &bearing,
+            const Approach approach)
+            : facade_generation(facade_generation), coordinate(coordinate),
+              radius(radius ? *radius : -1.), bearing(bearing ? *bearing : Bearing{-1, -1}),
+              approach(approach)
+        {
+        }
+
+        bool operator==(const Key &other) const
+        {
+            return std::tie(facade_generation,
+                            coordinate.lon,
+                            coordinate.lat,
+                            radius,
+                            bearing.bearing,
+                            bearing.range,
+                            approach) == std::tie(other.facade_generation,
+                                                  other.coordinate.lon,
+                                                  other.coordinate.lat,
+                                                  other.radius,
+                                                  other.bearing.bearing,
+                                                  other.bearing.range,
+                                                  other.approach);
+        }
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key &key) const
+        {
+            return hash_val(key.facade_generation,
+                            static_cast<std::int32_t>(key.coordinate.lon),
+                            static_cast<std::int32_t>(key.coordinate.lat),
+                            key.radius,
+                            key.bearing.bearing,
+                            key.bearing.range,
+                            static_cast<std::uint8_t>(key.approach));
+        }
+    };
+
+    struct Statistics
+    {
+        std::size_t number_of_entries;
+        std::size_t hits;
+        std::size_t misses;
+    };
+
+    // Capacity in bytes, split evenly between the shards
+    explicit PhantomNodeCache(const std::size_t capacity)
+    {
+        shards.reserve(NUMBER_OF_SHARDS);
+        for (std::size_t index = 0; index < NUMBER_OF_SHARDS; ++index)
+            shards.push_back(std::make_unique<Shard>(capacity / NUMBER_OF_SHARDS));
+    }
+
+    PhantomNodeCache(const PhantomNodeCache &) = delete;
+    PhantomNodeCache &operator=(const PhantomNodeCache &) = delete;
+
+    ~PhantomNodeCache()
+    {
+        const auto statistics = GetStatistics();
+        util::Log(logDEBUG) << "Phantom node cache: " << statistics.hits << " hits, "
+                            << statistics.misses << " misses, " << statistics.number_of_entries
+                            << " entries";
+    }
+
+    boost::optional<PhantomNodePair> Get(const Key &key)
+    {
+        auto &shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto phantom_nodes = shard.cache.Get(key);
+        if (phantom_nodes)
+            shard.hits++;
+        else
+            shard.misses++;
+        return phantom_nodes;
+    }
+
+    void Insert(const Key &key, const PhantomNodePair &phantom_nodes)
+    {
+        auto &shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.cache.Insert(key, phantom_nodes, ENTRY_SIZE);
+    }
+
+    Statistics GetStatistics() const
+    {
+        Statistics statistics{0, 0, 0};
+        for (const auto &shard : shards)
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            statistics.number_of_entries += shard->cache.GetNumberOfEntries();
+            statistics.hits += shard->hits;
+            statistics.misses += shard->misses;
+        }
+        return statistics;
+    }
+
+  private:
+    static constexpr std::size_t NUMBER_OF_SHARDS = 16;
+    // Key, value and the list and hash map nodes holding them, roughly
+    static constexpr std::size_t ENTRY_SIZE = sizeof(Key) + sizeof(PhantomNodePair) + 64;
+
+    struct Shard
+    {
+        explicit Shard(const std::size_t capacity) : cache(capacity) {}
+
+        mutable std::mutex mutex;
+        util::LRUCache<Key, PhantomNodePair, KeyHash> cache;
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+    };
+
+    Shard &GetShard(const Key &key)
+    {
+        // the low bits of the hash also select the bucket of the shard's hash map
+        return *shards[(KeyHash{}(key) >> 16) % NUMBER_OF_SHARDS];
+    }
+
+    std::vector<std::unique_ptr<Shard>> shards;
+};
+}
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef ISOCHRONE_HPP
+#define ISOCHRONE_HPP
+
+#include "engine/plugins/plugin_base.hpp"
+
+#include "engine/api/isochrone_parameters.hpp"
+#include "engine/routing_algorithms.hpp"
+
+#include "util/json_container.hpp"
+
+namespace osrm
+{
+namespace engine
+{
+namespace plugins
+{
+
+class IsochronePlugin final : public BasePlugin
+{
+  public:
+    explicit IsochronePlugin(const double max_duration_isochrone);
+
+    Status HandleRequest(const RoutingAlgorithmsInterface &algorithms,
+                         const api::IsochroneParameters &params,
+                         util::json::Object &result) const;
+
+  private:
+    const double max_duration_isochrone;
+};
+}
+}
+}
+
+#endif // ISOCHRONE_HPP
@@ -2,6 +2,9 @@
 #define MATCH_HPP
 
 #include "engine/api/match_parameters.hpp"
+#include "engine/api/match_parameters_tidy.hpp"
+#include "engine/api/matched_trace.hpp"
+#include "engine/matching_session_store.hpp"
 #include "engine/plugins/plugin_base.hpp"
 #include "engine/routing_algorithms.hpp"
 
@@ -24,9 +27,11 @@ class MatchPlugin : public BasePlugin
     using CandidateLists = routing_algorithms::CandidateLists;
     static const constexpr double RADIUS_MULTIPLIER = 3;
 
-    MatchPlugin(const int max_locations_map_matching, const double max_radius_map_matching)
+    MatchPlugin(const int max_locations_map_matching,
+                const double max_radius_map_matching,
+                MatchingSessionStore *matching_sessions = nullptr)
         : max_locations_map_matching(max_locations_map_matching),
-          max_radius_map_matching(max_radius_map_matching)
+          max_radius_map_matching(max_radius_map_matching), matching_sessions(matching_sessions)
     {
     }
 
@@ -34,9 +39,36 @@ class MatchPlugin : public BasePlugin
                          const api::MatchParameters &parameters,
                          util::json::Object &json_result) const;
 
+    // Matches a trace of a batch, the result is not formatted as JSON
+    Status HandleBatchTrace(const RoutingAlgorithmsInterface &algorithms,
+                            const api::MatchParameters &parameters,
+                            api::MatchedTrace &matched_trace) const;
+
   private:
+    // Validates the parameters and snaps the coordinates to candidates
+    Status SnapTrace(const RoutingAlgorithmsInterface &algorithms,
+                     const api::MatchParameters &parameters,
+                     api::tidy::Result &tidied,
+                     CandidateLists &candidates_lists,
+                     util::json::Object &json_result) const;
+
+    Status MatchTrace(const RoutingAlgorithmsInterface &algorithms,
+                      const api::MatchParameters &parameters,
+                      const api::tidy::Result &tidied,
+                      const CandidateLists &candidates_lists,
+                      SubMatchingList &sub_matchings,
+                      util::json::Object &json_result) const;
+
+    // Extends the trace of the session by the coordinates of the request
+    Status HandleSessionRequest(const RoutingAlgorithmsInterface &algorithms,
+                                const api::MatchParameters &parameters,
+                                const api::tidy::Result &tidied,
+                                const CandidateLists &candidates_lists,
+                                util::json::Object &json_result) const;
+
     const int max_locations_map_matching;
     const double max_radius_map_matching;
+    MatchingSessionStore *const matching_sessions;
 };
 }
 }
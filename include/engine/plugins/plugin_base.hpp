@@ -2,8 +2,10 @@
 #define BASE_PLUGIN_HPP
 
 #include "engine/api/base_parameters.hpp"
+#include "engine/datafacade.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
 #include "engine/phantom_node.hpp"
+#include "engine/phantom_node_cache.hpp"
 #include "engine/routing_algorithms.hpp"
 #include "engine/status.hpp"
 
@@ -12,6 +14,8 @@
 #include "util/integer_range.hpp"
 #include "util/json_container.hpp"
 
+#include <boost/optional.hpp>
+
 #include <algorithm>
 #include <iterator>
 #include <string>
@@ -29,6 +33,13 @@ namespace plugins
 class BasePlugin
 {
   protected:
+    BasePlugin() = default;
+    // Phantom node pairs snapped for coordinates without hints are looked up in the cache first
+    explicit BasePlugin(PhantomNodeCache *phantom_node_cache)
+        : phantom_node_cache(phantom_node_cache)
+    {
+    }
+
     bool CheckAllCoordinates(const std::vector<util::Coordinate> &coordinates) const
     {
         return !std::any_of(
@@ -261,7 +272,7 @@ class BasePlugin
         return phantom_nodes;
     }
 
-    std::vector<PhantomNodePair> GetPhantomNodes(const datafacade::BaseDataFacade &facade,
+    std::vector<PhantomNodePair> GetPhantomNodes(const DataFacadeBase &facade,
                                                  const api::BaseParameters &parameters) const
     {
         std::vector<PhantomNodePair> phantom_node_pairs(parameters.coordinates.size());
@@ -272,6 +283,15 @@ class BasePlugin
         const bool use_approaches = !parameters.approaches.empty();
 
         BOOST_ASSERT(parameters.IsValid());
+
+        // Coordinates without a valid hint or a cached result are snapped in one batch
+        std::vector<std::size_t> snapped_indices;
+        std::vector<util::Coordinate> snapped_coordinates;
+        std::vector<boost::optional<double>> snapped_radiuses;
+        std::vector<boost::optional<Bearing>> snapped_bearings;
+        std::vector<boost::optional<Approach>> snapped_approaches;
+        std::vector<boost::optional<PhantomNodeCache::Key>> cache_keys(
+            parameters.coordinates.size());
         for (const auto i : util::irange<std::size_t>(0UL, parameters.coordinates.size()))
         {
             Approach approach = engine::Approach::UNRESTRICTED;
@@ -286,44 +306,42 @@ class BasePlugin
                 continue;
             }
 
-            if (use_bearings && parameters.bearings[i])
-            {
-                if (use_radiuses && parameters.radiuses[i])
-                {
-                    phantom_node_pairs[i] =
-                        facade.NearestPhantomNodeWithAlternativeFromBigComponent(
-                            parameters.coordinates[i],
-                            *parameters.radiuses[i],
-                            parameters.bearings[i]->bearing,
-                            parameters.bearings[i]->range,
-                            approach);
-                }
-                else
-                {
-                    phantom_node_pairs[i] =
-                        facade.NearestPhantomNodeWithAlternativeFromBigComponent(
-                            parameters.coordinates[i],
-                            parameters.bearings[i]->bearing,
-                            parameters.bearings[i]->range,
-                            approach);
-                }
-            }
-            else
+            if (phantom_node_cache)
             {
-                if (use_radiuses && parameters.radiuses[i])
-                {
-                    phantom_node_pairs[i] =
-                        facade.NearestPhantomNodeWithAlternativeFromBigComponent(
-                            parameters.coordinates[i], *parameters.radiuses[i], approach);
-                }
-                else
+                cache_keys[i].emplace(facade.GetGeneration(),
+                                      parameters.coordinates[i],
+                                      use_radiuses ? parameters.radiuses[i] : boost::none,
+                                      use_bearings ? parameters.bearings[i] : boost::none,
+                                      approach);
+                if (const auto cached_phantom_nodes = phantom_node_cache->Get(*cache_keys[i]))
                 {
-                    phantom_node_pairs[i] =
-                        facade.NearestPhantomNodeWithAlternativeFromBigComponent(
-                            parameters.coordinates[i], approach);
+                    phantom_node_pairs[i] = *cached_phantom_nodes;
+                    continue;
                 }
             }
 
+            snapped_indices.push_back(i);
+            snapped_coordinates.push_back(parameters.coordinates[i]);
+            snapped_radiuses.push_back(use_radiuses ? parameters.radiuses[i] : boost::none);
+            snapped_bearings.push_back(use_bearings ? parameters.bearings[i] : boost::none);
+            snapped_approaches.push_back(approach);
+        }
+
+        if (snapped_indices.empty())
+        {
+            return phantom_node_pairs;
+        }
+
+        const auto snapped_phantom_node_pairs =
+            facade.NearestPhantomNodesWithAlternativeFromBigComponent(
+                snapped_coordinates, snapped_radiuses, snapped_bearings, snapped_approaches);
+        BOOST_ASSERT(snapped_phantom_node_pairs.size() == snapped_indices.size());
+
+        for (const auto k : util::irange<std::size_t>(0UL, snapped_indices.size()))
+        {
+            const auto i = snapped_indices[k];
+            phantom_node_pairs[i] = snapped_phantom_node_pairs[k];
+
             // we didn't find a fitting node, return error
             if (!phantom_node_pairs[i].first.IsValid())
             {
@@ -334,9 +352,17 @@ class BasePlugin
             }
             BOOST_ASSERT(phantom_node_pairs[i].first.IsValid());
             BOOST_ASSERT(phantom_node_pairs[i].second.IsValid());
+
+            if (cache_keys[i])
+            {
+                phantom_node_cache->Insert(*cache_keys[i], phantom_node_pairs[i]);
+            }
         }
         return phantom_node_pairs;
     }
+
+  private:
+    PhantomNodeCache *phantom_node_cache = nullptr;
 };
 }
 }
@@ -36,7 +36,11 @@ class TripPlugin final : public BasePlugin
                                      const bool roundtrip) const;
 
   public:
-    explicit TripPlugin(const int max_locations_trip_) : max_locations_trip(max_locations_trip_) {}
+    explicit TripPlugin(const int max_locations_trip_,
+                        PhantomNodeCache *phantom_node_cache = nullptr)
+        : BasePlugin(phantom_node_cache), max_locations_trip(max_locations_trip_)
+    {
+    }
 
     Status HandleRequest(const RoutingAlgorithmsInterface &algorithms,
                          const api::TripParameters &parameters,
@@ -27,9 +27,13 @@ class ViaRoutePlugin final : public BasePlugin
   private:
     const int max_locations_viaroute;
     const int max_alternatives;
+    const int max_alternatives_search_time;
 
   public:
-    explicit ViaRoutePlugin(int max_locations_viaroute, int max_alternatives);
+    explicit ViaRoutePlugin(int max_locations_viaroute,
+                            int max_alternatives,
+                            int max_alternatives_search_time,
+                            PhantomNodeCache *phantom_node_cache = nullptr);
 
     Status HandleRequest(const RoutingAlgorithmsInterface &algorithms,
                          const api::RouteParameters &route_parameters,
@@ -6,10 +6,18 @@
 #include "engine/phantom_node.hpp"
 #include "engine/routing_algorithms/alternative_path.hpp"
 #include "engine/routing_algorithms/direct_shortest_path.hpp"
+#include "engine/routing_algorithms/isochrone.hpp"
 #include "engine/routing_algorithms/many_to_many.hpp"
 #include "engine/routing_algorithms/map_matching.hpp"
 #include "engine/routing_algorithms/shortest_path.hpp"
 #include "engine/routing_algorithms/tile_turns.hpp"
+#include "engine/search_engine_pool.hpp"
+
+#include <chrono>
+#include <vector>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 
 namespace osrm
 {
@@ -21,14 +29,20 @@ class RoutingAlgorithmsInterface
   public:
     virtual InternalManyRoutesResult
     AlternativePathSearch(const PhantomNodes &phantom_node_pair,
-                          unsigned number_of_alternatives) const = 0;
+                          unsigned number_of_alternatives,
+                          const std::chrono::steady_clock::time_point deadline) const = 0;
 
     virtual InternalRouteResult
     ShortestPathSearch(const std::vector<PhantomNodes> &phantom_node_pair,
                        const boost::optional<bool> continue_straight_at_waypoint) const = 0;
 
-    virtual InternalRouteResult
-    DirectShortestPathSearch(const PhantomNodes &phantom_node_pair) const = 0;
+    // Routes that do not depend on each other, searched in parallel on idle search contexts
+    virtual std::vector<InternalRouteResult>
+    ShortestPathSearches(const std::vector<std::vector<PhantomNodes>> &phantom_node_pairs,
+                         const boost::optional<bool> continue_straight_at_waypoint) const = 0;
+
+    virtual InternalRouteResult DirectShortestPathSearch(const PhantomNodes &phantom_node_pair,
+                                                         const bool unpack_path) const = 0;
 
     virtual std::pair<std::vector<EdgeDuration>, std::vector<EdgeDistance>>
     ManyToManySearch(const std::vector<PhantomNode> &phantom_nodes,
@@ -36,6 +50,10 @@ class RoutingAlgorithmsInterface
                      const std::vector<std::size_t> &target_indices,
                      const bool calculate_distance) const = 0;
 
+    virtual std::vector<routing_algorithms::ReachableNode>
+    OneToAllSearch(const PhantomNode &source_phantom,
+                   const EdgeDuration duration_limit) const = 0;
+
     virtual routing_algorithms::SubMatchingList
     MapMatching(const routing_algorithms::CandidateLists &candidates_list,
                 const std::vector<util::Coordinate> &trace_coordinates,
@@ -43,6 +61,14 @@ class RoutingAlgorithmsInterface
                 const std::vector<boost::optional<double>> &trace_gps_precision,
                 const bool allow_splitting) const = 0;
 
+    virtual routing_algorithms::SubMatchingList
+    StreamingMapMatching(map_matching::MatchingFrontier &frontier,
+                         const routing_algorithms::CandidateLists &candidates_list,
+                         const std::vector<util::Coordinate> &trace_coordinates,
+                         const std::vector<unsigned> &trace_timestamps,
+                         const std::vector<boost::optional<double>> &trace_gps_precision,
+                         const bool allow_splitting) const = 0;
+
     virtual std::vector<routing_algorithms::TurnData>
     GetTileTurns(const std::vector<datafacade::BaseDataFacade::RTreeLeaf> &edges,
                  const std::vector<std::size_t> &sorted_edge_indexes) const = 0;
@@ -54,6 +80,7 @@ class RoutingAlgorithmsInterface
     virtual bool HasDirectShortestPathSearch() const = 0;
     virtual bool HasMapMatching() const = 0;
     virtual bool HasManyToManySearch() const = 0;
+    virtual bool HasOneToAllSearch() const = 0;
     virtual bool SupportsDistanceAnnotationType() const = 0;
     virtual bool HasGetTileTurns() const = 0;
     virtual bool HasExcludeFlags() const = 0;
@@ -64,24 +91,33 @@ class RoutingAlgorithmsInterface
 template <typename Algorithm> class RoutingAlgorithms final : public RoutingAlgorithmsInterface
 {
   public:
-    RoutingAlgorithms(SearchEngineData<Algorithm> &heaps,
-                      std::shared_ptr<const DataFacade<Algorithm>> facade)
-        : heaps(heaps), facade(facade)
+    RoutingAlgorithms(typename SearchEnginePool<Algorithm>::Lease heaps,
+                      std::shared_ptr<const DataFacade<Algorithm>> facade,
+                      SearchEnginePool<Algorithm> *pool = nullptr,
+                      routing_algorithms::SearchSpaceCache *search_space_cache = nullptr)
+        : heaps(std::move(heaps)), facade(facade), pool(pool),
+          search_space_cache(search_space_cache)
     {
     }
 
+    RoutingAlgorithms(RoutingAlgorithms &&) = default;
     virtual ~RoutingAlgorithms() = default;
 
-    InternalManyRoutesResult
-    AlternativePathSearch(const PhantomNodes &phantom_node_pair,
-                          unsigned number_of_alternatives) const final override;
+    InternalManyRoutesResult AlternativePathSearch(
+        const PhantomNodes &phantom_node_pair,
+        unsigned number_of_alternatives,
+        const std::chrono::steady_clock::time_point deadline) const final override;
 
     InternalRouteResult ShortestPathSearch(
         const std::vector<PhantomNodes> &phantom_node_pair,
         const boost::optional<bool> continue_straight_at_waypoint) const final override;
 
-    InternalRouteResult
-    DirectShortestPathSearch(const PhantomNodes &phantom_nodes) const final override;
+    std::vector<InternalRouteResult> ShortestPathSearches(
+        const std::vector<std::vector<PhantomNodes>> &phantom_node_pairs,
+        const boost::optional<bool> continue_straight_at_waypoint) const final override;
+
+    InternalRouteResult DirectShortestPathSearch(const PhantomNodes &phantom_nodes,
+                                                 const bool unpack_path) const final override;
 
     virtual std::pair<std::vector<EdgeDuration>, std::vector<EdgeDistance>>
     ManyToManySearch(const std::vector<PhantomNode> &phantom_nodes,
@@ -89,6 +125,10 @@ template <typename Algorithm> class RoutingAlgorithms final : public RoutingAlgo
                      const std::vector<std::size_t> &target_indices,
                      const bool calculate_distance) const final override;
 
+    std::vector<routing_algorithms::ReachableNode>
+    OneToAllSearch(const PhantomNode &source_phantom,
+                   const EdgeDuration duration_limit) const final override;
+
     routing_algorithms::SubMatchingList
     MapMatching(const routing_algorithms::CandidateLists &candidates_list,
                 const std::vector<util::Coordinate> &trace_coordinates,
@@ -96,6 +136,14 @@ template <typename Algorithm> class RoutingAlgorithms final : public RoutingAlgo
                 const std::vector<boost::optional<double>> &trace_gps_precision,
                 const bool allow_splitting) const final override;
 
+    routing_algorithms::SubMatchingList
+    StreamingMapMatching(map_matching::MatchingFrontier &frontier,
+                         const routing_algorithms::CandidateLists &candidates_list,
+                         const std::vector<util::Coordinate> &trace_coordinates,
+                         const std::vector<unsigned> &trace_timestamps,
+                         const std::vector<boost::optional<double>> &trace_gps_precision,
+                         const bool allow_splitting) const final override;
+
     std::vector<routing_algorithms::TurnData>
     GetTileTurns(const std::vector<datafacade::BaseDataFacade::RTreeLeaf> &edges,
                  const std::vector<std::size_t> &sorted_edge_indexes) const final override;
@@ -127,6 +175,11 @@ template <typename Algorithm> class RoutingAlgorithms final : public RoutingAlgo
         return routing_algorithms::HasManyToManySearch<Algorithm>::value;
     }
 
+    bool HasOneToAllSearch() const final override
+    {
+        return routing_algorithms::HasOneToAllSearch<Algorithm>::value;
+    }
+
     bool SupportsDistanceAnnotationType() const final override
     {
         return routing_algorithms::SupportsDistanceAnnotationType<Algorithm>::value;
@@ -145,17 +198,79 @@ template <typename Algorithm> class RoutingAlgorithms final : public RoutingAlgo
     bool IsValid() const final override { return static_cast<bool>(facade); }
 
   private:
-    SearchEngineData<Algorithm> &heaps;
+    // Minimal number of legs a route needs per search context to be searched in parallel
+    static constexpr std::size_t MIN_LEGS_PER_CONTEXT = 4;
+
+    // Borrows idle contexts of the pool so that a request can use up to the given number of
+    // contexts including its own. Returns nothing while the pool is busy, so concurrent requests
+    // are not slowed down by a single expensive one.
+    std::vector<typename SearchEnginePool<Algorithm>::Lease>
+    BorrowHelperContexts(const std::size_t number_of_contexts) const
+    {
+        std::vector<typename SearchEnginePool<Algorithm>::Lease> helpers;
+        if (!pool)
+            return helpers;
+
+        while (helpers.size() + 1 < number_of_contexts)
+        {
+            auto lease = pool->TryBorrow();
+            if (!lease)
+                break;
+            helpers.push_back(std::move(lease));
+        }
+        return helpers;
+    }
+
+    // Every context searches every n-th route
+    template <typename SearchAlgorithm>
+    std::vector<InternalRouteResult>
+    searchRoutes(const std::vector<SearchEngineData<SearchAlgorithm> *> &contexts,
+                 const std::vector<std::vector<PhantomNodes>> &phantom_node_pairs,
+                 const boost::optional<bool> continue_straight_at_waypoint) const
+    {
+        std::vector<InternalRouteResult> routes(phantom_node_pairs.size());
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, contexts.size(), 1),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                for (auto index = range.begin(); index != range.end(); ++index)
+                {
+                    for (auto route = index; route < phantom_node_pairs.size();
+                         route += contexts.size())
+                    {
+                        routes[route] = routing_algorithms::shortestPathSearch<SearchAlgorithm>(
+                            *contexts[index],
+                            *facade,
+                            phantom_node_pairs[route],
+                            continue_straight_at_waypoint);
+                    }
+                }
+            });
+        return routes;
+    }
+
+    // Search context borrowed from the engine's pool for the duration of the request
+    typename SearchEnginePool<Algorithm>::Lease heaps;
     std::shared_ptr<const DataFacade<Algorithm>> facade;
+    // Pool the additional contexts of parallel searches are borrowed from
+    SearchEnginePool<Algorithm> *pool;
+    // Backward search spaces of table targets shared by all requests, may be null
+    routing_algorithms::SearchSpaceCache *search_space_cache;
 };
 
 template <typename Algorithm>
 InternalManyRoutesResult
-RoutingAlgorithms<Algorithm>::AlternativePathSearch(const PhantomNodes &phantom_node_pair,
-                                                    unsigned number_of_alternatives) const
+RoutingAlgorithms<Algorithm>::AlternativePathSearch(
+    const PhantomNodes &phantom_node_pair,
+    unsigned number_of_alternatives,
+    const std::chrono::steady_clock::time_point deadline) const
 {
+    const auto helpers = BorrowHelperContexts(number_of_alternatives + 1);
+    std::vector<SearchEngineData<Algorithm> *> helper_contexts;
+    for (const auto &helper : helpers)
+        helper_contexts.push_back(helper.get());
+
     return routing_algorithms::alternativePathSearch(
-        heaps, *facade, phantom_node_pair, number_of_alternatives);
+        *heaps, *facade, phantom_node_pair, number_of_alternatives, helper_contexts, deadline);
 }
 
 template <typename Algorithm>
@@ -163,15 +278,41 @@ InternalRouteResult RoutingAlgorithms<Algorithm>::ShortestPathSearch(
     const std::vector<PhantomNodes> &phantom_node_pair,
     const boost::optional<bool> continue_straight_at_waypoint) const
 {
+    const auto helpers = BorrowHelperContexts(phantom_node_pair.size() / MIN_LEGS_PER_CONTEXT);
+    std::vector<SearchEngineData<Algorithm> *> helper_contexts;
+    for (const auto &helper : helpers)
+        helper_contexts.push_back(helper.get());
+
     return routing_algorithms::shortestPathSearch(
-        heaps, *facade, phantom_node_pair, continue_straight_at_waypoint);
+        *heaps, *facade, phantom_node_pair, continue_straight_at_waypoint, helper_contexts);
+}
+
+template <typename Algorithm>
+std::vector<InternalRouteResult> RoutingAlgorithms<Algorithm>::ShortestPathSearches(
+    const std::vector<std::vector<PhantomNodes>> &phantom_node_pairs,
+    const boost::optional<bool> continue_straight_at_waypoint) const
+{
+    // a single route searches its legs in parallel instead
+    if (phantom_node_pairs.size() == 1)
+    {
+        return {ShortestPathSearch(phantom_node_pairs.front(), continue_straight_at_waypoint)};
+    }
+
+    const auto helpers = BorrowHelperContexts(phantom_node_pairs.size());
+    std::vector<SearchEngineData<Algorithm> *> contexts = {heaps.get()};
+    for (const auto &helper : helpers)
+        contexts.push_back(helper.get());
+
+    return searchRoutes(contexts, phantom_node_pairs, continue_straight_at_waypoint);
 }
 
 template <typename Algorithm>
 InternalRouteResult
-RoutingAlgorithms<Algorithm>::DirectShortestPathSearch(const PhantomNodes &phantom_nodes) const
+RoutingAlgorithms<Algorithm>::DirectShortestPathSearch(const PhantomNodes &phantom_nodes,
+                                                       const bool unpack_path) const
 {
-    return routing_algorithms::directShortestPathSearch(heaps, *facade, phantom_nodes);
+    return routing_algorithms::directShortestPathSearch(
+        *heaps, *facade, phantom_nodes, unpack_path);
 }
 
 template <typename Algorithm>
@@ -182,13 +323,39 @@ inline routing_algorithms::SubMatchingList RoutingAlgorithms<Algorithm>::MapMatc
     const std::vector<boost::optional<double>> &trace_gps_precision,
     const bool allow_splitting) const
 {
-    return routing_algorithms::mapMatching(heaps,
+    const auto helpers = BorrowHelperContexts(
+        routing_algorithms::getTracePartBegins(trace_timestamps, allow_splitting).size());
+    std::vector<SearchEngineData<Algorithm> *> helper_contexts;
+    for (const auto &helper : helpers)
+        helper_contexts.push_back(helper.get());
+
+    return routing_algorithms::mapMatching(*heaps,
                                            *facade,
                                            candidates_list,
                                            trace_coordinates,
                                            trace_timestamps,
                                            trace_gps_precision,
-                                           allow_splitting);
+                                           allow_splitting,
+                                           helper_contexts);
+}
+
+template <typename Algorithm>
+inline routing_algorithms::SubMatchingList RoutingAlgorithms<Algorithm>::StreamingMapMatching(
+    map_matching::MatchingFrontier &frontier,
+    const routing_algorithms::CandidateLists &candidates_list,
+    const std::vector<util::Coordinate> &trace_coordinates,
+    const std::vector<unsigned> &trace_timestamps,
+    const std::vector<boost::optional<double>> &trace_gps_precision,
+    const bool allow_splitting) const
+{
+    return routing_algorithms::streamingMapMatching(*heaps,
+                                                    *facade,
+                                                    frontier,
+                                                    candidates_list,
+                                                    trace_coordinates,
+                                                    trace_timestamps,
+                                                    trace_gps_precision,
+                                                    allow_splitting);
 }
 
 template <typename Algorithm>
@@ -214,12 +381,21 @@ RoutingAlgorithms<Algorithm>::ManyToManySearch(const std::vector<PhantomNode> &p
         std::iota(target_indices.begin(), target_indices.end(), 0);
     }
 
-    return routing_algorithms::manyToManySearch(heaps,
+    return routing_algorithms::manyToManySearch(*heaps,
                                                 *facade,
                                                 phantom_nodes,
                                                 std::move(source_indices),
                                                 std::move(target_indices),
-                                                calculate_distance);
+                                                calculate_distance,
+                                                search_space_cache);
+}
+
+template <typename Algorithm>
+std::vector<routing_algorithms::ReachableNode>
+RoutingAlgorithms<Algorithm>::OneToAllSearch(const PhantomNode &source_phantom,
+                                             const EdgeDuration duration_limit) const
+{
+    return routing_algorithms::oneToAllSearch(*heaps, *facade, source_phantom, duration_limit);
 }
 
 template <typename Algorithm>
@@ -230,6 +406,126 @@ inline std::vector<routing_algorithms::TurnData> RoutingAlgorithms<Algorithm>::G
     return routing_algorithms::getTileTurns(*facade, edges, sorted_edge_indexes);
 }
 
+// Hub Labels only answer many-to-many queries themselves, all searches that need the path use
+// the CH the labels were derived from.
+template <>
+inline InternalRouteResult
+RoutingAlgorithms<routing_algorithms::hl::Algorithm>::ShortestPathSearch(
+    const std::vector<PhantomNodes> &phantom_node_pair,
+    const boost::optional<bool> continue_straight_at_waypoint) const
+{
+    const auto helpers = BorrowHelperContexts(phantom_node_pair.size() / MIN_LEGS_PER_CONTEXT);
+    std::vector<SearchEngineData<routing_algorithms::ch::Algorithm> *> helper_contexts;
+    for (const auto &helper : helpers)
+        helper_contexts.push_back(helper.get());
+
+    return routing_algorithms::shortestPathSearch<routing_algorithms::ch::Algorithm>(
+        *heaps,
+        *facade,
+        phantom_node_pair,
+        continue_straight_at_waypoint,
+        helper_contexts);
+}
+
+template <>
+inline std::vector<InternalRouteResult>
+RoutingAlgorithms<routing_algorithms::hl::Algorithm>::ShortestPathSearches(
+    const std::vector<std::vector<PhantomNodes>> &phantom_node_pairs,
+    const boost::optional<bool> continue_straight_at_waypoint) const
+{
+    if (phantom_node_pairs.size() == 1)
+    {
+        return {ShortestPathSearch(phantom_node_pairs.front(), continue_straight_at_waypoint)};
+    }
+
+    const auto helpers = BorrowHelperContexts(phantom_node_pairs.size());
+    std::vector<SearchEngineData<routing_algorithms::ch::Algorithm> *> contexts = {heaps.get()};
+    for (const auto &helper : helpers)
+        contexts.push_back(helper.get());
+
+    return searchRoutes(contexts, phantom_node_pairs, continue_straight_at_waypoint);
+}
+
+template <>
+inline InternalManyRoutesResult
+RoutingAlgorithms<routing_algorithms::hl::Algorithm>::AlternativePathSearch(
+    const PhantomNodes &phantom_node_pair,
+    unsigned number_of_alternatives,
+    const std::chrono::steady_clock::time_point deadline) const
+{
+    const auto helpers = BorrowHelperContexts(number_of_alternatives + 1);
+    std::vector<SearchEngineData<routing_algorithms::ch::Algorithm> *> helper_contexts;
+    for (const auto &helper : helpers)
+        helper_contexts.push_back(helper.get());
+
+    return routing_algorithms::alternativePathSearch(
+        *heaps, *facade, phantom_node_pair, number_of_alternatives, helper_contexts, deadline);
+}
+
+template <>
+inline InternalRouteResult
+RoutingAlgorithms<routing_algorithms::hl::Algorithm>::DirectShortestPathSearch(
+    const PhantomNodes &phantom_nodes, const bool unpack_path) const
+{
+    return routing_algorithms::directShortestPathSearch<routing_algorithms::ch::Algorithm>(
+        *heaps, *facade, phantom_nodes, unpack_path);
+}
+
+template <>
+inline routing_algorithms::SubMatchingList
+RoutingAlgorithms<routing_algorithms::hl::Algorithm>::MapMatching(
+    const routing_algorithms::CandidateLists &candidates_list,
+    const std::vector<util::Coordinate> &trace_coordinates,
+    const std::vector<unsigned> &trace_timestamps,
+    const std::vector<boost::optional<double>> &trace_gps_precision,
+    const bool allow_splitting) const
+{
+    const auto helpers = BorrowHelperContexts(
+        routing_algorithms::getTracePartBegins(trace_timestamps, allow_splitting).size());
+    std::vector<SearchEngineData<routing_algorithms::ch::Algorithm> *> helper_contexts;
+    for (const auto &helper : helpers)
+        helper_contexts.push_back(helper.get());
+
+    return routing_algorithms::mapMatching<routing_algorithms::ch::Algorithm>(*heaps,
+                                                                              *facade,
+                                                                              candidates_list,
+                                                                              trace_coordinates,
+                                                                              trace_timestamps,
+                                                                              trace_gps_precision,
+                                                                              allow_splitting,
+                                                                              helper_contexts);
+}
+
+template <>
+inline routing_algorithms::SubMatchingList
+RoutingAlgorithms<routing_algorithms::hl::Algorithm>::StreamingMapMatching(
+    map_matching::MatchingFrontier &frontier,
+    const routing_algorithms::CandidateLists &candidates_list,
+    const std::vector<util::Coordinate> &trace_coordinates,
+    const std::vector<unsigned> &trace_timestamps,
+    const std::vector<boost::optional<double>> &trace_gps_precision,
+    const bool allow_splitting) const
+{
+    return routing_algorithms::streamingMapMatching<routing_algorithms::ch::Algorithm>(
+        *heaps,
+        *facade,
+        frontier,
+        candidates_list,
+        trace_coordinates,
+        trace_timestamps,
+        trace_gps_precision,
+        allow_splitting);
+}
+
+template <>
+inline std::vector<routing_algorithms::ReachableNode>
+RoutingAlgorithms<routing_algorithms::hl::Algorithm>::OneToAllSearch(
+    const PhantomNode &source_phantom, const EdgeDuration duration_limit) const
+{
+    return routing_algorithms::oneToAllSearch<routing_algorithms::ch::Algorithm>(
+        *heaps, *facade, source_phantom, duration_limit);
+}
+
 } // ns engine
 } // ns osrm
 
@@ -9,6 +9,9 @@
 
 #include "util/exception.hpp"
 
+#include <chrono>
+#include <vector>
+
 namespace osrm
 {
 namespace engine
@@ -16,15 +19,26 @@ namespace engine
 namespace routing_algorithms
 {
 
-InternalManyRoutesResult alternativePathSearch(SearchEngineData<ch::Algorithm> &search_engine_data,
-                                               const DataFacade<ch::Algorithm> &facade,
-                                               const PhantomNodes &phantom_node_pair,
-                                               unsigned number_of_alternatives);
-
-InternalManyRoutesResult alternativePathSearch(SearchEngineData<mld::Algorithm> &search_engine_data,
-                                               const DataFacade<mld::Algorithm> &facade,
-                                               const PhantomNodes &phantom_node_pair,
-                                               unsigned number_of_alternatives);
+// The candidates are evaluated on the helper contexts in parallel. Candidates that were not
+// evaluated when the deadline passed are dropped and the best alternatives among the evaluated
+// ones are returned, the shortest path is always part of the result.
+InternalManyRoutesResult
+alternativePathSearch(SearchEngineData<ch::Algorithm> &search_engine_data,
+                      const DataFacade<ch::Algorithm> &facade,
+                      const PhantomNodes &phantom_node_pair,
+                      unsigned number_of_alternatives,
+                      const std::vector<SearchEngineData<ch::Algorithm> *> &helper_contexts = {},
+                      const std::chrono::steady_clock::time_point deadline =
+                          std::chrono::steady_clock::time_point::max());
+
+InternalManyRoutesResult
+alternativePathSearch(SearchEngineData<mld::Algorithm> &search_engine_data,
+                      const DataFacade<mld::Algorithm> &facade,
+                      const PhantomNodes &phantom_node_pair,
+                      unsigned number_of_alternatives,
+                      const std::vector<SearchEngineData<mld::Algorithm> *> &helper_contexts = {},
+                      const std::chrono::steady_clock::time_point deadline =
+                          std::chrono::steady_clock::time_point::max());
 
 } // namespace routing_algorithms
 } // namespace engine
@@ -21,10 +21,13 @@ namespace routing_algorithms
 /// by the previous route.
 /// This variation is only an optimization for graphs with slow queries, for example
 /// not fully contracted graphs.
+/// Without unpack_path only the totals of the leg are computed from the packed path, which
+/// leaves the unpacked path of the result empty.
 template <typename Algorithm>
 InternalRouteResult directShortestPathSearch(SearchEngineData<Algorithm> &engine_working_data,
                                              const DataFacade<Algorithm> &facade,
-                                             const PhantomNodes &phantom_nodes);
+                                             const PhantomNodes &phantom_nodes,
+                                             const bool unpack_path = true);
 
 } // namespace routing_algorithms
 } // namespace engine
@@ -0,0 +1,49 @@
+#ifndef OSRM_ENGINE_ROUTING_ALGORITHMS_ISOCHRONE_HPP
+#define OSRM_ENGINE_ROUTING_ALGORITHMS_ISOCHRONE_HPP
+
+#include "engine/algorithm.hpp"
+#include "engine/datafacade.hpp"
+#include "engine/phantom_node.hpp"
+#include "engine/search_engine_data.hpp"
+
+#include "util/typedefs.hpp"
+
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace routing_algorithms
+{
+
+// An edge-based node that can be entered from the source within the duration limit.
+// The weight and duration are measured up to the start of the node, so the node
+// itself is only partially traversable if duration + node duration exceeds the limit.
+struct ReachableNode
+{
+    NodeID node;
+    EdgeWeight weight;
+    EdgeDuration duration;
+};
+
+// Computes all edge-based nodes that can be reached from the source phantom node with
+// a duration of at most duration_limit (in deciseconds) on the weight-shortest paths.
+//
+// CH: PHAST, an upward search from the source followed by a downward sweep over
+//     all nodes in reverse contraction order.
+// MLD: bounded one-to-all Dijkstra on the base graph, overlay cliques are of no use
+//      since every node inside the limit needs to be settled.
+//
+// The result is sorted by duration.
+template <typename Algorithm>
+std::vector<ReachableNode> oneToAllSearch(SearchEngineData<Algorithm> &engine_working_data,
+                                          const DataFacade<Algorithm> &facade,
+                                          const PhantomNode &source_phantom,
+                                          const EdgeDuration duration_limit);
+
+} // namespace routing_algorithms
+} // namespace engine
+} // namespace osrm
+
+#endif
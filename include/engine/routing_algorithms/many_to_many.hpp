@@ -4,9 +4,12 @@
 #include "engine/algorithm.hpp"
 #include "engine/datafacade.hpp"
 #include "engine/search_engine_data.hpp"
+#include "engine/search_space_cache.hpp"
 
 #include "util/typedefs.hpp"
 
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 
 namespace osrm
@@ -15,8 +18,7 @@ namespace engine
 {
 namespace routing_algorithms
 {
-namespace
-{
+
 struct NodeBucket
 {
     NodeID middle_node;
@@ -88,8 +90,64 @@ struct NodeBucket
         }
     };
 };
-} // namespace
 
+using SearchSpaceCache = engine::SearchSpaceCache<NodeBucket>;
+
+// Searches for paths up to a weight bound need to look a bit beyond it: the paths start and end
+// with the weights of the phantom nodes, which the searches from the other side may subtract.
+// Returns the largest key the searches have to settle, INVALID_EDGE_WEIGHT for no bound.
+inline EdgeWeight getSearchWeightLimit(const std::vector<PhantomNode> &phantom_nodes,
+                                       const std::vector<std::size_t> &source_indices,
+                                       const std::vector<std::size_t> &target_indices,
+                                       const EdgeWeight weight_upper_bound)
+{
+    if (weight_upper_bound == INVALID_EDGE_WEIGHT)
+        return INVALID_EDGE_WEIGHT;
+
+    EdgeWeight phantom_weight = 0;
+    for (const auto *indices : {&source_indices, &target_indices})
+    {
+        for (const auto index : *indices)
+        {
+            const auto &phantom_node = phantom_nodes[index];
+            if (phantom_node.forward_segment_id.enabled)
+                phantom_weight =
+                    std::max(phantom_weight, phantom_node.GetForwardWeightPlusOffset());
+            if (phantom_node.reverse_segment_id.enabled)
+                phantom_weight =
+                    std::max(phantom_weight, phantom_node.GetReverseWeightPlusOffset());
+        }
+    }
+
+    return std::min<std::int64_t>(std::int64_t{weight_upper_bound} + phantom_weight,
+                                  INVALID_EDGE_WEIGHT - 1);
+}
+
+// Marks the entries of paths heavier than the bound as unreachable
+inline void discardPathsAboveBound(const std::vector<EdgeWeight> &weights_table,
+                                   std::vector<EdgeDuration> &durations_table,
+                                   std::vector<EdgeDistance> &distances_table,
+                                   const EdgeWeight weight_upper_bound)
+{
+    if (weight_upper_bound == INVALID_EDGE_WEIGHT)
+        return;
+
+    for (std::size_t index = 0; index < weights_table.size(); ++index)
+    {
+        if (weights_table[index] > weight_upper_bound)
+        {
+            durations_table[index] = MAXIMAL_EDGE_DURATION;
+            if (!distances_table.empty())
+                distances_table[index] = MAXIMAL_EDGE_DISTANCE;
+        }
+    }
+}
+
+// The backward search spaces of the targets are looked up in and added to the search space
+// cache if one is given. Only CH uses it, the search spaces of MLD depend on the sources.
+//
+// With a weight upper bound the searches stop early and all paths heavier than the bound are
+// reported as unreachable.
 template <typename Algorithm>
 std::pair<std::vector<EdgeDuration>, std::vector<EdgeDistance>>
 manyToManySearch(SearchEngineData<Algorithm> &engine_working_data,
@@ -97,7 +155,9 @@ manyToManySearch(SearchEngineData<Algorithm> &engine_working_data,
                  const std::vector<PhantomNode> &phantom_nodes,
                  const std::vector<std::size_t> &source_indices,
                  const std::vector<std::size_t> &target_indices,
-                 const bool calculate_distance);
+                 const bool calculate_distance,
+                 SearchSpaceCache *search_space_cache = nullptr,
+                 const EdgeWeight weight_upper_bound = INVALID_EDGE_WEIGHT);
 
 } // namespace routing_algorithms
 } // namespace engine
@@ -3,6 +3,7 @@
 
 #include "engine/algorithm.hpp"
 #include "engine/datafacade.hpp"
+#include "engine/map_matching/matching_frontier.hpp"
 #include "engine/map_matching/sub_matching.hpp"
 #include "engine/search_engine_data.hpp"
 
@@ -20,16 +21,51 @@ using CandidateLists = std::vector<CandidateList>;
 using SubMatchingList = std::vector<map_matching::SubMatching>;
 static const constexpr double DEFAULT_GPS_PRECISION = 5;
 
+// Gaps in time always split a trace if splitting is allowed, the parts between them can be
+// matched independently of each other. Returns the index of the first point of every part.
+std::vector<std::size_t> getTracePartBegins(const std::vector<unsigned> &trace_timestamps,
+                                            const bool allow_splitting);
+
+// Network distances of the transitions from the candidates at source_indices to the ones at
+// target_indices, row-major, std::numeric_limits<double>::max() for transitions heavier than
+// weight_upper_bound
+template <typename Algorithm>
+std::vector<double> getTransitionDistances(SearchEngineData<Algorithm> &engine_working_data,
+                                           const DataFacade<Algorithm> &facade,
+                                           const std::vector<PhantomNode> &phantom_nodes,
+                                           const std::vector<std::size_t> &source_indices,
+                                           const std::vector<std::size_t> &target_indices,
+                                           const EdgeWeight weight_upper_bound);
+
 //[1] "Hidden Markov Map Matching Through Noise and Sparseness";
 //     P. Newson and J. Krumm; 2009; ACM GIS
+//
+// The parts of the trace are matched in parallel if helper contexts are passed, each context
+// is used by one thread.
+template <typename Algorithm>
+SubMatchingList
+mapMatching(SearchEngineData<Algorithm> &engine_working_data,
+            const DataFacade<Algorithm> &facade,
+            const CandidateLists &candidates_list,
+            const std::vector<util::Coordinate> &trace_coordinates,
+            const std::vector<unsigned> &trace_timestamps,
+            const std::vector<boost::optional<double>> &trace_gps_precision,
+            const bool allow_splitting,
+            const std::vector<SearchEngineData<Algorithm> *> &helper_contexts = {});
+
+// Extends the matching of a trace by new points, starting from the frontier of the points
+// matched before. The frontier is replaced by the last matched new point. The first node of a
+// returned matching may be the frontier, its index is map_matching::INVALID_TRACE_INDEX.
 template <typename Algorithm>
-SubMatchingList mapMatching(SearchEngineData<Algorithm> &engine_working_data,
-                            const DataFacade<Algorithm> &facade,
-                            const CandidateLists &candidates_list,
-                            const std::vector<util::Coordinate> &trace_coordinates,
-                            const std::vector<unsigned> &trace_timestamps,
-                            const std::vector<boost::optional<double>> &trace_gps_precision,
-                            const bool allow_splitting);
+SubMatchingList
+streamingMapMatching(SearchEngineData<Algorithm> &engine_working_data,
+                     const DataFacade<Algorithm> &facade,
+                     map_matching::MatchingFrontier &frontier,
+                     const CandidateLists &candidates_list,
+                     const std::vector<util::Coordinate> &trace_coordinates,
+                     const std::vector<unsigned> &trace_timestamps,
+                     const std::vector<boost::optional<double>> &trace_gps_precision,
+                     const bool allow_splitting);
 
 } // namespace routing_algorithms
 } // namespace engine
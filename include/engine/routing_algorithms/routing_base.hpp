@@ -38,6 +38,36 @@ static constexpr bool FORWARD_DIRECTION = true;
 static constexpr bool REVERSE_DIRECTION = false;
 static constexpr bool DO_NOT_FORCE_LOOPS = false;
 
+// Set by the ENABLE_PREFETCHING build option, see prefetchHeapEntries
+#if defined(OSRM_ENABLE_PREFETCHING)
+static constexpr bool PREFETCH_HEAP_ENTRIES = true;
+#else
+static constexpr bool PREFETCH_HEAP_ENTRIES = false;
+#endif
+
+// Prefetches the heap index entries of all targets of the edges before they are relaxed.
+// Relaxing looks up every target in the heap index, which is a random access into an array of
+// the size of the graph. Issuing all of them up front overlaps the cache misses instead of
+// waiting for each of them in turn. Only array based heap indices can be prefetched.
+template <typename FacadeT, typename EdgeRangeT, typename HeapT>
+inline void prefetchHeapEntries(const FacadeT &facade, const EdgeRangeT &edges, const HeapT &heap)
+{
+    for (const auto edge : edges)
+    {
+        heap.Prefetch(facade.GetTarget(edge));
+    }
+}
+
+// Same for the targets of cell shortcuts, which are given as a list of nodes
+template <typename NodeRangeT, typename HeapT>
+inline void prefetchHeapEntries(const NodeRangeT &nodes, const HeapT &heap)
+{
+    for (const auto node : nodes)
+    {
+        heap.Prefetch(node);
+    }
+}
+
 bool needsLoopForward(const PhantomNode &source_phantom, const PhantomNode &target_phantom);
 bool needsLoopBackwards(const PhantomNode &source_phantom, const PhantomNode &target_phantom);
 
@@ -30,11 +30,11 @@ bool stallAtNode(const DataFacade<Algorithm> &facade,
 {
     for (auto edge : facade.GetAdjacentEdgeRange(node))
     {
-        const auto &data = facade.GetEdgeData(edge);
-        if (DIRECTION == REVERSE_DIRECTION ? data.forward : data.backward)
+        if (DIRECTION == REVERSE_DIRECTION ? facade.IsForwardEdge(edge)
+                                           : facade.IsBackwardEdge(edge))
         {
             const NodeID to = facade.GetTarget(edge);
-            const EdgeWeight edge_weight = data.weight;
+            const EdgeWeight edge_weight = facade.GetEdgeWeight(edge);
             BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
             if (query_heap.WasInserted(to))
             {
@@ -54,13 +54,19 @@ void relaxOutgoingEdges(const DataFacade<Algorithm> &facade,
                         const EdgeWeight weight,
                         SearchEngineData<Algorithm>::QueryHeap &heap)
 {
-    for (const auto edge : facade.GetAdjacentEdgeRange(node))
+    const auto edges = facade.GetAdjacentEdgeRange(node);
+    if (PREFETCH_HEAP_ENTRIES)
     {
-        const auto &data = facade.GetEdgeData(edge);
-        if (DIRECTION == FORWARD_DIRECTION ? data.forward : data.backward)
+        prefetchHeapEntries(facade, edges, heap);
+    }
+
+    for (const auto edge : edges)
+    {
+        if (DIRECTION == FORWARD_DIRECTION ? facade.IsForwardEdge(edge)
+                                           : facade.IsBackwardEdge(edge))
         {
             const NodeID to = facade.GetTarget(edge);
-            const EdgeWeight edge_weight = data.weight;
+            const EdgeWeight edge_weight = facade.GetEdgeWeight(edge);
 
             BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
             const EdgeWeight to_weight = weight + edge_weight;
@@ -210,6 +216,42 @@ std::tuple<EdgeWeight, EdgeDistance> getLoopWeight(const DataFacade<Algorithm> &
     return std::make_tuple(loop_weight, loop_distance);
 }
 
+// Finds the edge the search used to get from `from` to `to`
+inline EdgeID findPathEdge(const DataFacade<Algorithm> &facade, const NodeID from, const NodeID to)
+{
+    // Look for an edge on the forward CH graph (.forward)
+    EdgeID smaller_edge_id =
+        facade.FindSmallestEdge(from, to, [](const auto &data) { return data.forward; });
+
+    // If we didn't find one there, the we might be looking at a part of the path that
+    // was found using the backward search.  Here, we flip the node order (to, from)
+    // and only consider edges with the `.backward` flag.
+    if (SPECIAL_EDGEID == smaller_edge_id)
+    {
+        smaller_edge_id =
+            facade.FindSmallestEdge(to, from, [](const auto &data) { return data.backward; });
+    }
+
+    // If we didn't find anything *still*, then something is broken and someone has
+    // called this function with bad values.
+    BOOST_ASSERT_MSG(smaller_edge_id != SPECIAL_EDGEID, "Invalid smaller edge ID");
+
+    return smaller_edge_id;
+}
+
+// Returns the edges of the shortcut `edge` in the order they are traversed from `from` to `to`,
+// or SPECIAL_EDGEID if they need to be searched for.
+inline std::pair<EdgeID, EdgeID> getPathShortcutChildren(const DataFacade<Algorithm> &facade,
+                                                         const EdgeID edge,
+                                                         const NodeID to)
+{
+    const auto children = facade.GetShortcutChildren(edge);
+    // the shortcut is traversed in its original direction if we end at its target
+    if (facade.GetTarget(edge) == to)
+        return children;
+    return {children.second, children.first};
+}
+
 /**
  * Given a sequence of connected `NodeID`s in the CH graph, performs a depth-first unpacking of
  * the shortcut
@@ -225,6 +267,9 @@ std::tuple<EdgeWeight, EdgeDistance> getLoopWeight(const DataFacade<Algorithm> &
  * the original route
  * from beginning to end.
  *
+ * If the dataset stores the children of shortcuts they are followed directly, otherwise the
+ * edge between two nodes of the path is searched for in their adjacency.
+ *
  * @param packed_path_begin iterator pointing to the start of the NodeID list
  * @param packed_path_end iterator pointing to the end of the NodeID list
  * @param callback void(const std::pair<NodeID, NodeID>, const EdgeID &) called for each
@@ -240,38 +285,28 @@ void unpackPath(const DataFacade<Algorithm> &facade,
     if (packed_path_begin == packed_path_end)
         return;
 
-    std::stack<std::pair<NodeID, NodeID>> recursion_stack;
+    // (from, to, edge) where edge is SPECIAL_EDGEID if it is not known yet
+    std::stack<std::tuple<NodeID, NodeID, EdgeID>> recursion_stack;
 
     // We have to push the path in reverse order onto the stack because it's LIFO.
     for (auto current = std::prev(packed_path_end); current != packed_path_begin;
          current = std::prev(current))
     {
-        recursion_stack.emplace(*std::prev(current), *current);
+        recursion_stack.emplace(*std::prev(current), *current, SPECIAL_EDGEID);
     }
 
     std::pair<NodeID, NodeID> edge;
     while (!recursion_stack.empty())
     {
-        edge = recursion_stack.top();
+        EdgeID smaller_edge_id;
+        std::tie(edge.first, edge.second, smaller_edge_id) = recursion_stack.top();
         recursion_stack.pop();
 
-        // Look for an edge on the forward CH graph (.forward)
-        EdgeID smaller_edge_id = facade.FindSmallestEdge(
-            edge.first, edge.second, [](const auto &data) { return data.forward; });
-
-        // If we didn't find one there, the we might be looking at a part of the path that
-        // was found using the backward search.  Here, we flip the node order (.second, .first)
-        // and only consider edges with the `.backward` flag.
         if (SPECIAL_EDGEID == smaller_edge_id)
         {
-            smaller_edge_id = facade.FindSmallestEdge(
-                edge.second, edge.first, [](const auto &data) { return data.backward; });
+            smaller_edge_id = findPathEdge(facade, edge.first, edge.second);
         }
 
-        // If we didn't find anything *still*, then something is broken and someone has
-        // called this function with bad values.
-        BOOST_ASSERT_MSG(smaller_edge_id != SPECIAL_EDGEID, "Invalid smaller edge ID");
-
         const auto &data = facade.GetEdgeData(smaller_edge_id);
         BOOST_ASSERT_MSG(data.weight != std::numeric_limits<EdgeWeight>::max(),
                          "edge weight invalid");
@@ -280,10 +315,11 @@ void unpackPath(const DataFacade<Algorithm> &facade,
         if (data.shortcut)
         { // unpack
             const NodeID middle_node_id = data.turn_id;
+            const auto children = getPathShortcutChildren(facade, smaller_edge_id, edge.second);
             // Note the order here - we're adding these to a stack, so we
             // want the first->middle to get visited before middle->second
-            recursion_stack.emplace(middle_node_id, edge.second);
-            recursion_stack.emplace(edge.first, middle_node_id);
+            recursion_stack.emplace(middle_node_id, edge.second, children.second);
+            recursion_stack.emplace(edge.first, middle_node_id, children.first);
         }
         else
         {
@@ -303,16 +339,17 @@ EdgeDistance calculateEBGNodeAnnotations(const DataFacade<Algorithm> &facade,
         std::distance(packed_path_begin, packed_path_end) <= 1)
         return 0;
 
-    std::stack<std::tuple<NodeID, NodeID, bool>> recursion_stack;
+    // (from, to, processed, edge) where edge is SPECIAL_EDGEID if it is not known yet
+    std::stack<std::tuple<NodeID, NodeID, bool, EdgeID>> recursion_stack;
     std::stack<EdgeDistance> distance_stack;
     // We have to push the path in reverse order onto the stack because it's LIFO.
     for (auto current = std::prev(packed_path_end); current > packed_path_begin;
          current = std::prev(current))
     {
-        recursion_stack.emplace(*std::prev(current), *current, false);
+        recursion_stack.emplace(*std::prev(current), *current, false, SPECIAL_EDGEID);
     }
 
-    std::tuple<NodeID, NodeID, bool> edge;
+    std::tuple<NodeID, NodeID, bool, EdgeID> edge;
     while (!recursion_stack.empty())
     {
         edge = recursion_stack.top();
@@ -325,27 +362,12 @@ EdgeDistance calculateEBGNodeAnnotations(const DataFacade<Algorithm> &facade,
 
             std::get<2>(edge) = true; // mark that this edge will now be processed
 
-            // Look for an edge on the forward CH graph (.forward)
-            EdgeID smaller_edge_id =
-                facade.FindSmallestEdge(std::get<0>(edge), std::get<1>(edge), [](const auto &data) {
-                    return data.forward;
-                });
-
-            // If we didn't find one there, the we might be looking at a part of the path that
-            // was found using the backward search.  Here, we flip the node order (.second,
-            // .first) and only consider edges with the `.backward` flag.
+            EdgeID smaller_edge_id = std::get<3>(edge);
             if (SPECIAL_EDGEID == smaller_edge_id)
             {
-                smaller_edge_id =
-                    facade.FindSmallestEdge(std::get<1>(edge),
-                                            std::get<0>(edge),
-                                            [](const auto &data) { return data.backward; });
+                smaller_edge_id = findPathEdge(facade, std::get<0>(edge), std::get<1>(edge));
             }
 
-            // If we didn't find anything *still*, then something is broken and someone has
-            // called this function with bad values.
-            BOOST_ASSERT_MSG(smaller_edge_id != SPECIAL_EDGEID, "Invalid smaller edge ID");
-
             const auto &data = facade.GetEdgeData(smaller_edge_id);
             BOOST_ASSERT_MSG(data.weight != std::numeric_limits<EdgeWeight>::max(),
                              "edge weight invalid");
@@ -354,11 +376,13 @@ EdgeDistance calculateEBGNodeAnnotations(const DataFacade<Algorithm> &facade,
             if (data.shortcut)
             { // unpack
                 const NodeID middle_node_id = data.turn_id;
+                const auto children =
+                    getPathShortcutChildren(facade, smaller_edge_id, std::get<1>(edge));
                 // Note the order here - we're adding these to a stack, so we
                 // want the first->middle to get visited before middle->second
                 recursion_stack.emplace(edge);
-                recursion_stack.emplace(middle_node_id, std::get<1>(edge), false);
-                recursion_stack.emplace(std::get<0>(edge), middle_node_id, false);
+                recursion_stack.emplace(middle_node_id, std::get<1>(edge), false, children.second);
+                recursion_stack.emplace(std::get<0>(edge), middle_node_id, false, children.first);
             }
             else
             {
@@ -473,17 +497,6 @@ void search(SearchEngineData<Algorithm> &engine_working_data,
             const PhantomNodes &phantom_nodes,
             const int duration_upper_bound = INVALID_EDGE_WEIGHT);
 
-// Requires the heaps for be empty
-// If heaps should be adjusted to be initialized outside of this function,
-// the addition of force_loop parameters might be required
-double getNetworkDistance(SearchEngineData<Algorithm> &engine_working_data,
-                          const DataFacade<ch::Algorithm> &facade,
-                          SearchEngineData<Algorithm>::QueryHeap &forward_heap,
-                          SearchEngineData<Algorithm>::QueryHeap &reverse_heap,
-                          const PhantomNode &source_phantom,
-                          const PhantomNode &target_phantom,
-                          int duration_upper_bound = INVALID_EDGE_WEIGHT);
-
 } // namespace ch
 } // namespace routing_algorithms
 } // namespace engine
@@ -6,13 +6,18 @@
 #include "engine/routing_algorithms/routing_base.hpp"
 #include "engine/search_engine_data.hpp"
 
+#include "util/concurrent_node_weights.hpp"
 #include "util/typedefs.hpp"
 
 #include <boost/assert.hpp>
 
+#include <tbb/parallel_invoke.h>
+
 #include <algorithm>
+#include <atomic>
 #include <iterator>
 #include <limits>
+#include <mutex>
 #include <tuple>
 #include <vector>
 
@@ -226,8 +231,15 @@ retrievePackedPathFromHeap(const SearchEngineData<Algorithm>::QueryHeap &forward
     return packed_path;
 }
 
-template <bool DIRECTION, typename Algorithm, typename... Args>
-void relaxOutgoingEdges(const DataFacade<Algorithm> &facade,
+// Called with every node and weight a relaxation inserts or decreases
+struct IgnoreKeyUpdates
+{
+    void operator()(const NodeID, const EdgeWeight) const {}
+};
+
+template <bool DIRECTION, typename Algorithm, typename KeyObserver, typename... Args>
+void relaxOutgoingEdges(const KeyObserver &key_observer,
+                        const DataFacade<Algorithm> &facade,
                         typename SearchEngineData<Algorithm>::QueryHeap &forward_heap,
                         const NodeID node,
                         const EdgeWeight weight,
@@ -245,6 +257,10 @@ void relaxOutgoingEdges(const DataFacade<Algorithm> &facade,
         {
             // Shortcuts in forward direction
             const auto &cell = cells.GetCell(metric, level, partition.GetCell(level, node));
+            if (PREFETCH_HEAP_ENTRIES)
+            {
+                prefetchHeapEntries(cell.GetDestinationNodes(), forward_heap);
+            }
             auto destination = cell.GetDestinationNodes().begin();
             for (auto shortcut_weight : cell.GetOutWeight(node))
             {
@@ -258,11 +274,13 @@ void relaxOutgoingEdges(const DataFacade<Algorithm> &facade,
                     if (!forward_heap.WasInserted(to))
                     {
                         forward_heap.Insert(to, to_weight, {node, true});
+                        key_observer(to, to_weight);
                     }
                     else if (to_weight < forward_heap.GetKey(to))
                     {
                         forward_heap.GetData(to) = {node, true};
                         forward_heap.DecreaseKey(to, to_weight);
+                        key_observer(to, to_weight);
                     }
                 }
                 ++destination;
@@ -272,6 +290,10 @@ void relaxOutgoingEdges(const DataFacade<Algorithm> &facade,
         {
             // Shortcuts in backward direction
             const auto &cell = cells.GetCell(metric, level, partition.GetCell(level, node));
+            if (PREFETCH_HEAP_ENTRIES)
+            {
+                prefetchHeapEntries(cell.GetSourceNodes(), forward_heap);
+            }
             auto source = cell.GetSourceNodes().begin();
             for (auto shortcut_weight : cell.GetInWeight(node))
             {
@@ -285,11 +307,13 @@ void relaxOutgoingEdges(const DataFacade<Algorithm> &facade,
                     if (!forward_heap.WasInserted(to))
                     {
                         forward_heap.Insert(to, to_weight, {node, true});
+                        key_observer(to, to_weight);
                     }
                     else if (to_weight < forward_heap.GetKey(to))
                     {
                         forward_heap.GetData(to) = {node, true};
                         forward_heap.DecreaseKey(to, to_weight);
+                        key_observer(to, to_weight);
                     }
                 }
                 ++source;
@@ -298,7 +322,13 @@ void relaxOutgoingEdges(const DataFacade<Algorithm> &facade,
     }
 
     // Boundary edges
-    for (const auto edge : facade.GetBorderEdgeRange(level, node))
+    const auto border_edges = facade.GetBorderEdgeRange(level, node);
+    if (PREFETCH_HEAP_ENTRIES)
+    {
+        prefetchHeapEntries(facade, border_edges, forward_heap);
+    }
+
+    for (const auto edge : border_edges)
     {
         const auto &edge_data = facade.GetEdgeData(edge);
 
@@ -321,17 +351,29 @@ void relaxOutgoingEdges(const DataFacade<Algorithm> &facade,
                 if (!forward_heap.WasInserted(to))
                 {
                     forward_heap.Insert(to, to_weight, {node, false});
+                    key_observer(to, to_weight);
                 }
                 else if (to_weight < forward_heap.GetKey(to))
                 {
                     forward_heap.GetData(to) = {node, false};
                     forward_heap.DecreaseKey(to, to_weight);
+                    key_observer(to, to_weight);
                 }
             }
         }
     }
 }
 
+template <bool DIRECTION, typename Algorithm, typename... Args>
+void relaxOutgoingEdges(const DataFacade<Algorithm> &facade,
+                        typename SearchEngineData<Algorithm>::QueryHeap &forward_heap,
+                        const NodeID node,
+                        const EdgeWeight weight,
+                        Args... args)
+{
+    relaxOutgoingEdges<DIRECTION>(IgnoreKeyUpdates{}, facade, forward_heap, node, weight, args...);
+}
+
 template <bool DIRECTION, typename Algorithm, typename... Args>
 void routingStep(const DataFacade<Algorithm> &facade,
                  typename SearchEngineData<Algorithm>::QueryHeap &forward_heap,
@@ -372,6 +414,165 @@ void routingStep(const DataFacade<Algorithm> &facade,
     relaxOutgoingEdges<DIRECTION>(facade, forward_heap, node, weight, args...);
 }
 
+// One direction of the parallel bidirectional search. Every key the search inserts, decreases
+// or settles is published to the other thread. A path through a node is found by the thread
+// that comes second of the one settling the node and the one reaching it from the opposite
+// direction, which are the same meetings the sequential search checks in routingStep.
+template <bool DIRECTION, typename Algorithm, typename MeetingHandler, typename... Args>
+void parallelRoutingSteps(const DataFacade<Algorithm> &facade,
+                          typename SearchEngineData<Algorithm>::QueryHeap &heap,
+                          util::ConcurrentNodeWeights &node_weights,
+                          const util::ConcurrentNodeWeights &other_node_weights,
+                          std::atomic<EdgeWeight> &heap_min,
+                          const std::atomic<EdgeWeight> &other_heap_min,
+                          const std::atomic<EdgeWeight> &path_upper_bound,
+                          const MeetingHandler &meet,
+                          const bool force_loop,
+                          const bool other_force_loop,
+                          Args... args)
+{
+    const auto observe_key = [&](const NodeID node, const EdgeWeight weight) {
+        node_weights.Set(node, {weight, false, false});
+        const auto other = other_node_weights.Get(node);
+        if (other && other->settled && !(other_force_loop && other->seed))
+            meet(node, weight + other->weight);
+    };
+
+    while (!heap.Empty() && heap.MinKey() + other_heap_min.load() < path_upper_bound.load())
+    {
+        const auto node = heap.DeleteMin();
+        const auto weight = heap.GetKey(node);
+        const bool seed = heap.GetData(node).parent == node;
+
+        node_weights.Set(node, {weight, true, seed});
+        const auto other = other_node_weights.Get(node);
+        if (other && !(force_loop && seed) && !(other_force_loop && other->seed))
+            meet(node, weight + other->weight);
+
+        relaxOutgoingEdges<DIRECTION>(observe_key, facade, heap, node, weight, args...);
+
+        if (!heap.Empty())
+            heap_min.store(heap.MinKey());
+    }
+}
+
+// Restricted searches, like the ones unpacking overlay edges, always run sequentially
+template <typename Algorithm, typename... Args>
+bool parallelSearch(SearchEngineData<Algorithm> &,
+                    const DataFacade<Algorithm> &,
+                    typename SearchEngineData<Algorithm>::QueryHeap &,
+                    typename SearchEngineData<Algorithm>::QueryHeap &,
+                    NodeID &,
+                    EdgeWeight &,
+                    const bool,
+                    const bool,
+                    const Args &...)
+{
+    return false;
+}
+
+// Runs the forward and the reverse search on two threads until the sum of their minimal keys
+// exceeds the shortest path found, which gives the same middle node and weight as the
+// sequential loop in search up to ties. Only searches between different top level cells are
+// run in parallel, they spend most of their time on the highest level and are long enough to
+// pay for the second thread. Returns false if the search needs to run sequentially.
+inline bool parallelSearch(SearchEngineData<Algorithm> &engine_working_data,
+                           const DataFacade<Algorithm> &facade,
+                           SearchEngineData<Algorithm>::QueryHeap &forward_heap,
+                           SearchEngineData<Algorithm>::QueryHeap &reverse_heap,
+                           NodeID &middle,
+                           EdgeWeight &weight,
+                           const bool force_loop_forward,
+                           const bool force_loop_reverse,
+                           const PhantomNodes &phantom_nodes)
+{
+    if (!engine_working_data.UseParallelBidirectionalSearch())
+        return false;
+
+    const auto &partition = facade.GetMultiLevelPartition();
+    const auto segment = [](const PhantomNode &phantom_node) {
+        return phantom_node.forward_segment_id.enabled ? phantom_node.forward_segment_id
+                                                       : phantom_node.reverse_segment_id;
+    };
+    const auto source = segment(phantom_nodes.source_phantom);
+    const auto target = segment(phantom_nodes.target_phantom);
+    if (!source.enabled || !target.enabled ||
+        partition.GetHighestDifferentLevel(source.id, target.id) + 1u <
+            partition.GetNumberOfLevels())
+        return false;
+
+    engine_working_data.InitializeOrClearNodeWeights(facade.GetMaxBorderNodeID() + 1);
+    auto &forward_node_weights = *engine_working_data.forward_node_weights;
+    auto &reverse_node_weights = *engine_working_data.reverse_node_weights;
+
+    // The heaps only contain the nodes they were initialized with
+    const auto publish_seeds = [](const SearchEngineData<Algorithm>::QueryHeap &heap,
+                                  util::ConcurrentNodeWeights &node_weights,
+                                  const PhantomNode &phantom_node) {
+        for (const auto &segment :
+             {phantom_node.forward_segment_id, phantom_node.reverse_segment_id})
+        {
+            if (segment.enabled && heap.WasInserted(segment.id))
+            {
+                node_weights.Set(segment.id,
+                                 {heap.GetKey(segment.id),
+                                  false,
+                                  heap.GetData(segment.id).parent == segment.id});
+            }
+        }
+    };
+    publish_seeds(forward_heap, forward_node_weights, phantom_nodes.source_phantom);
+    publish_seeds(reverse_heap, reverse_node_weights, phantom_nodes.target_phantom);
+
+    std::mutex meeting_mutex;
+    std::atomic<EdgeWeight> path_upper_bound{weight};
+    std::atomic<EdgeWeight> forward_heap_min{forward_heap.MinKey()};
+    std::atomic<EdgeWeight> reverse_heap_min{reverse_heap.MinKey()};
+
+    const auto meet = [&](const NodeID node, const EdgeWeight path_weight) {
+        if (path_weight < 0 || path_weight >= path_upper_bound.load())
+            return;
+
+        std::lock_guard<std::mutex> lock(meeting_mutex);
+        if (path_weight < path_upper_bound.load())
+        {
+            middle = node;
+            path_upper_bound.store(path_weight);
+        }
+    };
+
+    tbb::parallel_invoke(
+        [&] {
+            parallelRoutingSteps<FORWARD_DIRECTION>(facade,
+                                                    forward_heap,
+                                                    forward_node_weights,
+                                                    reverse_node_weights,
+                                                    forward_heap_min,
+                                                    reverse_heap_min,
+                                                    path_upper_bound,
+                                                    meet,
+                                                    force_loop_forward,
+                                                    force_loop_reverse,
+                                                    phantom_nodes);
+        },
+        [&] {
+            parallelRoutingSteps<REVERSE_DIRECTION>(facade,
+                                                    reverse_heap,
+                                                    reverse_node_weights,
+                                                    forward_node_weights,
+                                                    reverse_heap_min,
+                                                    forward_heap_min,
+                                                    path_upper_bound,
+                                                    meet,
+                                                    force_loop_reverse,
+                                                    force_loop_forward,
+                                                    phantom_nodes);
+        });
+
+    weight = path_upper_bound.load();
+    return true;
+}
+
 // With (s, middle, t) we trace back the paths middle -> s and middle -> t.
 // This gives us a packed path (node ids) from the base graph around s and t,
 // and overlay node ids otherwise. We then have to unpack the overlay clique
@@ -381,71 +582,116 @@ using UnpackedNodes = std::vector<NodeID>;
 using UnpackedEdges = std::vector<EdgeID>;
 using UnpackedPath = std::tuple<EdgeWeight, UnpackedNodes, UnpackedEdges>;
 
+// Runs the bidirectional search without unpacking the path. Returns the weight of the path, the
+// node where both searches met and the packed path, or INVALID_EDGE_WEIGHT if there is none.
 template <typename Algorithm, typename... Args>
-UnpackedPath search(SearchEngineData<Algorithm> &engine_working_data,
-                    const DataFacade<Algorithm> &facade,
-                    typename SearchEngineData<Algorithm>::QueryHeap &forward_heap,
-                    typename SearchEngineData<Algorithm>::QueryHeap &reverse_heap,
-                    const bool force_loop_forward,
-                    const bool force_loop_reverse,
-                    EdgeWeight weight_upper_bound,
-                    Args... args)
+std::tuple<EdgeWeight, NodeID, PackedPath>
+searchPackedPath(SearchEngineData<Algorithm> &engine_working_data,
+                 const DataFacade<Algorithm> &facade,
+                 typename SearchEngineData<Algorithm>::QueryHeap &forward_heap,
+                 typename SearchEngineData<Algorithm>::QueryHeap &reverse_heap,
+                 const bool force_loop_forward,
+                 const bool force_loop_reverse,
+                 EdgeWeight weight_upper_bound,
+                 Args... args)
 {
     if (forward_heap.Empty() || reverse_heap.Empty())
     {
-        return std::make_tuple(INVALID_EDGE_WEIGHT, std::vector<NodeID>(), std::vector<EdgeID>());
+        return std::make_tuple(INVALID_EDGE_WEIGHT, SPECIAL_NODEID, PackedPath());
     }
 
-    const auto &partition = facade.GetMultiLevelPartition();
-
     BOOST_ASSERT(!forward_heap.Empty() && forward_heap.MinKey() < INVALID_EDGE_WEIGHT);
     BOOST_ASSERT(!reverse_heap.Empty() && reverse_heap.MinKey() < INVALID_EDGE_WEIGHT);
 
     // run two-Target Dijkstra routing step.
     NodeID middle = SPECIAL_NODEID;
     EdgeWeight weight = weight_upper_bound;
-    EdgeWeight forward_heap_min = forward_heap.MinKey();
-    EdgeWeight reverse_heap_min = reverse_heap.MinKey();
-    while (forward_heap.Size() + reverse_heap.Size() > 0 &&
-           forward_heap_min + reverse_heap_min < weight)
+    if (!parallelSearch(engine_working_data,
+                        facade,
+                        forward_heap,
+                        reverse_heap,
+                        middle,
+                        weight,
+                        force_loop_forward,
+                        force_loop_reverse,
+                        args...))
     {
-        if (!forward_heap.Empty())
+        EdgeWeight forward_heap_min = forward_heap.MinKey();
+        EdgeWeight reverse_heap_min = reverse_heap.MinKey();
+        while (forward_heap.Size() + reverse_heap.Size() > 0 &&
+               forward_heap_min + reverse_heap_min < weight)
         {
-            routingStep<FORWARD_DIRECTION>(facade,
-                                           forward_heap,
-                                           reverse_heap,
-                                           middle,
-                                           weight,
-                                           force_loop_forward,
-                                           force_loop_reverse,
-                                           args...);
             if (!forward_heap.Empty())
-                forward_heap_min = forward_heap.MinKey();
-        }
-        if (!reverse_heap.Empty())
-        {
-            routingStep<REVERSE_DIRECTION>(facade,
-                                           reverse_heap,
-                                           forward_heap,
-                                           middle,
-                                           weight,
-                                           force_loop_reverse,
-                                           force_loop_forward,
-                                           args...);
+            {
+                routingStep<FORWARD_DIRECTION>(facade,
+                                               forward_heap,
+                                               reverse_heap,
+                                               middle,
+                                               weight,
+                                               force_loop_forward,
+                                               force_loop_reverse,
+                                               args...);
+                if (!forward_heap.Empty())
+                    forward_heap_min = forward_heap.MinKey();
+            }
             if (!reverse_heap.Empty())
-                reverse_heap_min = reverse_heap.MinKey();
+            {
+                routingStep<REVERSE_DIRECTION>(facade,
+                                               reverse_heap,
+                                               forward_heap,
+                                               middle,
+                                               weight,
+                                               force_loop_reverse,
+                                               force_loop_forward,
+                                               args...);
+                if (!reverse_heap.Empty())
+                    reverse_heap_min = reverse_heap.MinKey();
+            }
         }
-    };
+    }
 
     // No path found for both target nodes?
     if (weight >= weight_upper_bound || SPECIAL_NODEID == middle)
     {
-        return std::make_tuple(INVALID_EDGE_WEIGHT, std::vector<NodeID>(), std::vector<EdgeID>());
+        return std::make_tuple(INVALID_EDGE_WEIGHT, SPECIAL_NODEID, PackedPath());
     }
 
     // Get packed path as edges {from node ID, to node ID, from_clique_arc}
     auto packed_path = retrievePackedPathFromHeap(forward_heap, reverse_heap, middle);
 
+    return std::make_tuple(weight, middle, std::move(packed_path));
+}
+
+template <typename Algorithm, typename... Args>
+UnpackedPath search(SearchEngineData<Algorithm> &engine_working_data,
+                    const DataFacade<Algorithm> &facade,
+                    typename SearchEngineData<Algorithm>::QueryHeap &forward_heap,
+                    typename SearchEngineData<Algorithm>::QueryHeap &reverse_heap,
+                    const bool force_loop_forward,
+                    const bool force_loop_reverse,
+                    EdgeWeight weight_upper_bound,
+                    Args... args)
+{
+    // TODO: when structured bindings will be allowed change to
+    // auto [weight, middle, packed_path] = ...
+    EdgeWeight weight;
+    NodeID middle;
+    PackedPath packed_path;
+    std::tie(weight, middle, packed_path) = searchPackedPath(engine_working_data,
+                                                             facade,
+                                                             forward_heap,
+                                                             reverse_heap,
+                                                             force_loop_forward,
+                                                             force_loop_reverse,
+                                                             weight_upper_bound,
+                                                             args...);
+    if (weight == INVALID_EDGE_WEIGHT)
+    {
+        return std::make_tuple(INVALID_EDGE_WEIGHT, std::vector<NodeID>(), std::vector<EdgeID>());
+    }
+
+    const auto &partition = facade.GetMultiLevelPartition();
+
     // Beware the edge case when start, middle, end are all the same.
     // In this case we return a single node, no edges. We also don't unpack.
     const NodeID source_node = !packed_path.empty() ? std::get<0>(packed_path.front()) : middle;
@@ -564,45 +810,6 @@ void unpackPath(const FacadeT &facade,
     annotatePath(facade, phantom_nodes, unpacked_nodes, unpacked_edges, unpacked_path);
 }
 
-template <typename Algorithm>
-double getNetworkDistance(SearchEngineData<Algorithm> &engine_working_data,
-                          const DataFacade<Algorithm> &facade,
-                          typename SearchEngineData<Algorithm>::QueryHeap &forward_heap,
-                          typename SearchEngineData<Algorithm>::QueryHeap &reverse_heap,
-                          const PhantomNode &source_phantom,
-                          const PhantomNode &target_phantom,
-                          EdgeWeight weight_upper_bound = INVALID_EDGE_WEIGHT)
-{
-    forward_heap.Clear();
-    reverse_heap.Clear();
-
-    const PhantomNodes phantom_nodes{source_phantom, target_phantom};
-    insertNodesInHeaps(forward_heap, reverse_heap, phantom_nodes);
-
-    EdgeWeight weight = INVALID_EDGE_WEIGHT;
-    std::vector<NodeID> unpacked_nodes;
-    std::vector<EdgeID> unpacked_edges;
-    std::tie(weight, unpacked_nodes, unpacked_edges) = search(engine_working_data,
-                                                              facade,
-                                                              forward_heap,
-                                                              reverse_heap,
-                                                              DO_NOT_FORCE_LOOPS,
-                                                              DO_NOT_FORCE_LOOPS,
-                                                              weight_upper_bound,
-                                                              phantom_nodes);
-
-    if (weight == INVALID_EDGE_WEIGHT)
-    {
-        return std::numeric_limits<double>::max();
-    }
-
-    std::vector<PathData> unpacked_path;
-
-    annotatePath(facade, phantom_nodes, unpacked_nodes, unpacked_edges, unpacked_path);
-
-    return getPathDistance(facade, unpacked_path, source_phantom, target_phantom);
-}
-
 } // namespace mld
 } // namespace routing_algorithms
 } // namespace engine
@@ -6,6 +6,8 @@
 #include "engine/search_engine_data.hpp"
 #include "util/typedefs.hpp"
 
+#include <vector>
+
 namespace osrm
 {
 namespace engine
@@ -13,11 +15,15 @@ namespace engine
 namespace routing_algorithms
 {
 
+// Legs are searched in parallel if helper contexts are passed, each context is used by one
+// thread at a time. The result is the same as for the sequential search up to ties.
 template <typename Algorithm>
-InternalRouteResult shortestPathSearch(SearchEngineData<Algorithm> &engine_working_data,
-                                       const DataFacade<Algorithm> &facade,
-                                       const std::vector<PhantomNodes> &phantom_nodes_vector,
-                                       const boost::optional<bool> continue_straight_at_waypoint);
+InternalRouteResult
+shortestPathSearch(SearchEngineData<Algorithm> &engine_working_data,
+                   const DataFacade<Algorithm> &facade,
+                   const std::vector<PhantomNodes> &phantom_nodes_vector,
+                   const boost::optional<bool> continue_straight_at_waypoint,
+                   const std::vector<SearchEngineData<Algorithm> *> &helper_contexts = {});
 
 } // namespace routing_algorithms
 } // namespace engine
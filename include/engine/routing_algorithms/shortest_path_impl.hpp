@@ -6,6 +6,12 @@
 #include <boost/assert.hpp>
 #include <boost/optional.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <array>
+#include <vector>
+
 namespace osrm
 {
 namespace engine
@@ -177,20 +183,252 @@ void search(SearchEngineData<Algorithm> &engine_working_data,
     }
 }
 
+// Searches one leg of the route, the target nodes that can not be reached are set to
+// INVALID_EDGE_WEIGHT
+template <typename Algorithm>
+void searchLeg(SearchEngineData<Algorithm> &engine_working_data,
+               const DataFacade<Algorithm> &facade,
+               const bool allow_uturn_at_waypoint,
+               const bool search_from_forward_node,
+               const bool search_from_reverse_node,
+               const PhantomNode &source_phantom,
+               const PhantomNode &target_phantom,
+               const int total_weight_to_forward,
+               const int total_weight_to_reverse,
+               int &new_total_weight_to_forward,
+               int &new_total_weight_to_reverse,
+               std::vector<NodeID> &packed_leg_to_forward,
+               std::vector<NodeID> &packed_leg_to_reverse)
+{
+    auto &forward_heap = *engine_working_data.forward_heap_1;
+    auto &reverse_heap = *engine_working_data.reverse_heap_1;
+
+    const bool search_to_forward_node = target_phantom.IsValidForwardTarget();
+    const bool search_to_reverse_node = target_phantom.IsValidReverseTarget();
+
+    if (!search_to_reverse_node && !search_to_forward_node)
+        return;
+
+    if (allow_uturn_at_waypoint)
+    {
+        searchWithUTurn(engine_working_data,
+                        facade,
+                        forward_heap,
+                        reverse_heap,
+                        search_from_forward_node,
+                        search_from_reverse_node,
+                        search_to_forward_node,
+                        search_to_reverse_node,
+                        source_phantom,
+                        target_phantom,
+                        total_weight_to_forward,
+                        total_weight_to_reverse,
+                        new_total_weight_to_forward,
+                        packed_leg_to_forward);
+        // if only the reverse node is valid (e.g. when using the match plugin) we
+        // actually need to move
+        if (!target_phantom.IsValidForwardTarget())
+        {
+            BOOST_ASSERT(target_phantom.IsValidReverseTarget());
+            new_total_weight_to_reverse = new_total_weight_to_forward;
+            packed_leg_to_reverse = std::move(packed_leg_to_forward);
+            new_total_weight_to_forward = INVALID_EDGE_WEIGHT;
+
+            // (*)
+            //
+            //   Callers have to check if new_total_weight_to_forward is invalid.
+            //   This prevents use-after-move on packed_leg_to_forward.
+        }
+        else if (target_phantom.IsValidReverseTarget())
+        {
+            new_total_weight_to_reverse = new_total_weight_to_forward;
+            packed_leg_to_reverse = packed_leg_to_forward;
+        }
+    }
+    else
+    {
+        search(engine_working_data,
+               facade,
+               forward_heap,
+               reverse_heap,
+               search_from_forward_node,
+               search_from_reverse_node,
+               search_to_forward_node,
+               search_to_reverse_node,
+               source_phantom,
+               target_phantom,
+               total_weight_to_forward,
+               total_weight_to_reverse,
+               new_total_weight_to_forward,
+               new_total_weight_to_reverse,
+               packed_leg_to_forward,
+               packed_leg_to_reverse);
+    }
+}
+
+// Searches of a leg that do not depend on the weights of the legs before it. Index 0 stands
+// for the forward and index 1 for the reverse node of a phantom.
+struct LegCandidates
+{
+    // The leg has to be searched once the legs before it are known
+    bool deferred = true;
+    // Source nodes the search started from, only used with u-turns
+    std::array<bool, 2> search_from = {{false, false}};
+    // Weights and paths from a source node to a target node. With u-turns all source nodes
+    // are searched at once and only the first row is used.
+    std::array<std::array<int, 2>, 2> weights = {
+        {{{INVALID_EDGE_WEIGHT, INVALID_EDGE_WEIGHT}}, {{INVALID_EDGE_WEIGHT, INVALID_EDGE_WEIGHT}}}};
+    std::array<std::array<std::vector<NodeID>, 2>, 2> paths;
+};
+
+// The shortest path of a leg only depends on the legs before it through the weights of its
+// source nodes and the nodes that are reachable at all. Searching from every reachable source
+// node separately, or from all of them at once in case of u-turns, makes the legs independent
+// of each other. If source and target are on the same segment the search prunes paths with
+// negative weights which does depend on the weights before the leg, so these legs are left
+// to the sequential search.
+template <typename Algorithm>
+LegCandidates computeLegCandidates(SearchEngineData<Algorithm> &engine_working_data,
+                                   const DataFacade<Algorithm> &facade,
+                                   const bool allow_uturn_at_waypoint,
+                                   const PhantomNodes &phantom_node_pair)
+{
+    LegCandidates candidates;
+
+    const auto &source_phantom = phantom_node_pair.source_phantom;
+    const auto &target_phantom = phantom_node_pair.target_phantom;
+    const auto same_segment = [](const PhantomNode &lhs, const PhantomNode &rhs) {
+        return lhs.forward_segment_id.id == rhs.forward_segment_id.id ||
+               lhs.forward_segment_id.id == rhs.reverse_segment_id.id ||
+               lhs.reverse_segment_id.id == rhs.forward_segment_id.id ||
+               lhs.reverse_segment_id.id == rhs.reverse_segment_id.id;
+    };
+    if (same_segment(source_phantom, target_phantom))
+        return candidates;
+
+    candidates.deferred = false;
+    candidates.search_from = {
+        {source_phantom.IsValidForwardSource(), source_phantom.IsValidReverseSource()}};
+
+    if (allow_uturn_at_waypoint)
+    {
+        searchLeg(engine_working_data,
+                  facade,
+                  allow_uturn_at_waypoint,
+                  candidates.search_from[0],
+                  candidates.search_from[1],
+                  source_phantom,
+                  target_phantom,
+                  0,
+                  0,
+                  candidates.weights[0][0],
+                  candidates.weights[0][1],
+                  candidates.paths[0][0],
+                  candidates.paths[0][1]);
+        return candidates;
+    }
+
+    for (const auto source : {0, 1})
+    {
+        if (!candidates.search_from[source])
+            continue;
+
+        searchLeg(engine_working_data,
+                  facade,
+                  allow_uturn_at_waypoint,
+                  source == 0,
+                  source == 1,
+                  source_phantom,
+                  target_phantom,
+                  0,
+                  0,
+                  candidates.weights[source][0],
+                  candidates.weights[source][1],
+                  candidates.paths[source][0],
+                  candidates.paths[source][1]);
+    }
+
+    return candidates;
+}
+
+// Picks the shortest way to reach the target nodes of a leg from the candidates. Returns false
+// if the candidates were searched from other source nodes than the route can reach.
+inline bool pickLegCandidates(LegCandidates &candidates,
+                              const bool allow_uturn_at_waypoint,
+                              const bool search_from_forward_node,
+                              const bool search_from_reverse_node,
+                              const int total_weight_to_forward,
+                              const int total_weight_to_reverse,
+                              int &new_total_weight_to_forward,
+                              int &new_total_weight_to_reverse,
+                              std::vector<NodeID> &packed_leg_to_forward,
+                              std::vector<NodeID> &packed_leg_to_reverse)
+{
+    if (candidates.deferred)
+        return false;
+
+    const std::array<int, 2> total_weights = {{total_weight_to_forward, total_weight_to_reverse}};
+    const std::array<bool, 2> search_from = {{search_from_forward_node, search_from_reverse_node}};
+    std::array<int, 2> new_total_weights = {{INVALID_EDGE_WEIGHT, INVALID_EDGE_WEIGHT}};
+    std::array<std::vector<NodeID> *, 2> packed_legs = {
+        {&packed_leg_to_forward, &packed_leg_to_reverse}};
+
+    if (allow_uturn_at_waypoint)
+    {
+        // the u-turn search depends on the source nodes it starts from
+        if (candidates.search_from != search_from)
+            return false;
+
+        const auto min_total_weight = std::min(total_weight_to_forward, total_weight_to_reverse);
+        for (const auto target : {0, 1})
+        {
+            if (candidates.weights[0][target] != INVALID_EDGE_WEIGHT)
+            {
+                new_total_weights[target] = candidates.weights[0][target] + min_total_weight;
+                *packed_legs[target] = std::move(candidates.paths[0][target]);
+            }
+        }
+    }
+    else
+    {
+        for (const auto target : {0, 1})
+        {
+            for (const auto source : {0, 1})
+            {
+                const auto weight = candidates.weights[source][target];
+                if (!search_from[source] || weight == INVALID_EDGE_WEIGHT)
+                    continue;
+
+                BOOST_ASSERT(total_weights[source] != INVALID_EDGE_WEIGHT);
+                if (total_weights[source] + weight < new_total_weights[target])
+                {
+                    new_total_weights[target] = total_weights[source] + weight;
+                    *packed_legs[target] = std::move(candidates.paths[source][target]);
+                }
+            }
+        }
+    }
+
+    new_total_weight_to_forward = new_total_weights[0];
+    new_total_weight_to_reverse = new_total_weights[1];
+    return true;
+}
+
 template <typename Algorithm>
 void unpackLegs(const DataFacade<Algorithm> &facade,
                 const std::vector<PhantomNodes> &phantom_nodes_vector,
                 const std::vector<NodeID> &total_packed_path,
                 const std::vector<std::size_t> &packed_leg_begin,
                 const EdgeWeight shortest_path_weight,
+                const bool parallel,
                 InternalRouteResult &raw_route_data)
 {
-    raw_route_data.unpacked_path_segments.resize(packed_leg_begin.size() - 1);
+    const auto number_of_legs = packed_leg_begin.size() - 1;
+    raw_route_data.unpacked_path_segments.resize(number_of_legs);
 
     raw_route_data.shortest_path_weight = shortest_path_weight;
 
-    for (const auto current_leg : util::irange<std::size_t>(0UL, packed_leg_begin.size() - 1))
-    {
+    const auto unpack_leg = [&](const std::size_t current_leg) {
         auto leg_begin = total_packed_path.begin() + packed_leg_begin[current_leg];
         auto leg_end = total_packed_path.begin() + packed_leg_begin[current_leg + 1];
         const auto &unpack_phantom_node_pair = phantom_nodes_vector[current_leg];
@@ -199,6 +437,28 @@ void unpackLegs(const DataFacade<Algorithm> &facade,
                    leg_end,
                    unpack_phantom_node_pair,
                    raw_route_data.unpacked_path_segments[current_leg]);
+    };
+
+    // Unpacking only reads from the facade, so the legs can be unpacked independently
+    if (parallel)
+    {
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, number_of_legs),
+                          [&](const tbb::blocked_range<std::size_t> &range) {
+                              for (auto current_leg = range.begin(); current_leg != range.end();
+                                   ++current_leg)
+                                  unpack_leg(current_leg);
+                          });
+    }
+    else
+    {
+        for (const auto current_leg : util::irange<std::size_t>(0UL, number_of_legs))
+            unpack_leg(current_leg);
+    }
+
+    for (const auto current_leg : util::irange<std::size_t>(0UL, number_of_legs))
+    {
+        auto leg_begin = total_packed_path.begin() + packed_leg_begin[current_leg];
+        auto leg_end = total_packed_path.begin() + packed_leg_begin[current_leg + 1];
 
         raw_route_data.source_traversed_in_reverse.push_back(
             (*leg_begin != phantom_nodes_vector[current_leg].source_phantom.forward_segment_id.id));
@@ -214,7 +474,7 @@ inline void initializeHeap(SearchEngineData<Algorithm> &engine_working_data,
 {
 
     const auto nodes_number = facade.GetNumberOfNodes();
-    engine_working_data.InitializeOrClearFirstThreadLocalStorage(nodes_number);
+    engine_working_data.InitializeOrClearFirstHeaps(nodes_number);
 }
 
 template <>
@@ -224,15 +484,17 @@ inline void initializeHeap<mld::Algorithm>(SearchEngineData<mld::Algorithm> &eng
 
     const auto nodes_number = facade.GetNumberOfNodes();
     const auto border_nodes_number = facade.GetMaxBorderNodeID() + 1;
-    engine_working_data.InitializeOrClearFirstThreadLocalStorage(nodes_number, border_nodes_number);
+    engine_working_data.InitializeOrClearFirstHeaps(nodes_number, border_nodes_number);
 }
 }
 
 template <typename Algorithm>
-InternalRouteResult shortestPathSearch(SearchEngineData<Algorithm> &engine_working_data,
-                                       const DataFacade<Algorithm> &facade,
-                                       const std::vector<PhantomNodes> &phantom_nodes_vector,
-                                       const boost::optional<bool> continue_straight_at_waypoint)
+InternalRouteResult
+shortestPathSearch(SearchEngineData<Algorithm> &engine_working_data,
+                   const DataFacade<Algorithm> &facade,
+                   const std::vector<PhantomNodes> &phantom_nodes_vector,
+                   const boost::optional<bool> continue_straight_at_waypoint,
+                   const std::vector<SearchEngineData<Algorithm> *> &helper_contexts)
 {
     InternalRouteResult raw_route_data;
     raw_route_data.segment_end_coordinates = phantom_nodes_vector;
@@ -240,10 +502,36 @@ InternalRouteResult shortestPathSearch(SearchEngineData<Algorithm> &engine_worki
         !(continue_straight_at_waypoint ? *continue_straight_at_waypoint
                                         : facade.GetContinueStraightDefault());
 
-    initializeHeap(engine_working_data, facade);
+    const bool parallel = !helper_contexts.empty();
 
-    auto &forward_heap = *engine_working_data.forward_heap_1;
-    auto &reverse_heap = *engine_working_data.reverse_heap_1;
+    // Every context searches every n-th leg, the legs are then connected by the dynamic program
+    // below which only falls back to searching for legs that were deferred
+    std::vector<LegCandidates> leg_candidates;
+    if (parallel)
+    {
+        std::vector<SearchEngineData<Algorithm> *> contexts = {&engine_working_data};
+        contexts.insert(contexts.end(), helper_contexts.begin(), helper_contexts.end());
+
+        leg_candidates.resize(phantom_nodes_vector.size());
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, contexts.size(), 1),
+            [&](const tbb::blocked_range<std::size_t> &range) {
+                for (auto index = range.begin(); index != range.end(); ++index)
+                {
+                    initializeHeap(*contexts[index], facade);
+                    for (auto leg = index; leg < phantom_nodes_vector.size();
+                         leg += contexts.size())
+                    {
+                        leg_candidates[leg] = computeLegCandidates(*contexts[index],
+                                                                   facade,
+                                                                   allow_uturn_at_waypoint,
+                                                                   phantom_nodes_vector[leg]);
+                    }
+                }
+            });
+    }
+
+    initializeHeap(engine_working_data, facade);
 
     int total_weight_to_forward = 0;
     int total_weight_to_reverse = 0;
@@ -274,73 +562,37 @@ InternalRouteResult shortestPathSearch(SearchEngineData<Algorithm> &engine_worki
         const auto &source_phantom = phantom_node_pair.source_phantom;
         const auto &target_phantom = phantom_node_pair.target_phantom;
 
-        bool search_to_forward_node = target_phantom.IsValidForwardTarget();
-        bool search_to_reverse_node = target_phantom.IsValidReverseTarget();
-
         BOOST_ASSERT(!search_from_forward_node || source_phantom.IsValidForwardSource());
         BOOST_ASSERT(!search_from_reverse_node || source_phantom.IsValidReverseSource());
 
-        if (search_to_reverse_node || search_to_forward_node)
+        if (!parallel || !pickLegCandidates(leg_candidates[current_leg],
+                                            allow_uturn_at_waypoint,
+                                            search_from_forward_node,
+                                            search_from_reverse_node,
+                                            total_weight_to_forward,
+                                            total_weight_to_reverse,
+                                            new_total_weight_to_forward,
+                                            new_total_weight_to_reverse,
+                                            packed_leg_to_forward,
+                                            packed_leg_to_reverse))
         {
-            if (allow_uturn_at_waypoint)
-            {
-                searchWithUTurn(engine_working_data,
-                                facade,
-                                forward_heap,
-                                reverse_heap,
-                                search_from_forward_node,
-                                search_from_reverse_node,
-                                search_to_forward_node,
-                                search_to_reverse_node,
-                                source_phantom,
-                                target_phantom,
-                                total_weight_to_forward,
-                                total_weight_to_reverse,
-                                new_total_weight_to_forward,
-                                packed_leg_to_forward);
-                // if only the reverse node is valid (e.g. when using the match plugin) we
-                // actually need to move
-                if (!target_phantom.IsValidForwardTarget())
-                {
-                    BOOST_ASSERT(target_phantom.IsValidReverseTarget());
-                    new_total_weight_to_reverse = new_total_weight_to_forward;
-                    packed_leg_to_reverse = std::move(packed_leg_to_forward);
-                    new_total_weight_to_forward = INVALID_EDGE_WEIGHT;
-
-                    // (*)
-                    //
-                    //   Below we have to check if new_total_weight_to_forward is invalid.
-                    //   This prevents use-after-move on packed_leg_to_forward.
-                }
-                else if (target_phantom.IsValidReverseTarget())
-                {
-                    new_total_weight_to_reverse = new_total_weight_to_forward;
-                    packed_leg_to_reverse = packed_leg_to_forward;
-                }
-            }
-            else
-            {
-                search(engine_working_data,
-                       facade,
-                       forward_heap,
-                       reverse_heap,
-                       search_from_forward_node,
-                       search_from_reverse_node,
-                       search_to_forward_node,
-                       search_to_reverse_node,
-                       source_phantom,
-                       target_phantom,
-                       total_weight_to_forward,
-                       total_weight_to_reverse,
-                       new_total_weight_to_forward,
-                       new_total_weight_to_reverse,
-                       packed_leg_to_forward,
-                       packed_leg_to_reverse);
-            }
+            searchLeg(engine_working_data,
+                      facade,
+                      allow_uturn_at_waypoint,
+                      search_from_forward_node,
+                      search_from_reverse_node,
+                      source_phantom,
+                      target_phantom,
+                      total_weight_to_forward,
+                      total_weight_to_reverse,
+                      new_total_weight_to_forward,
+                      new_total_weight_to_reverse,
+                      packed_leg_to_forward,
+                      packed_leg_to_reverse);
         }
 
         // Note: To make sure we do not access the moved-from packed_leg_to_forward
-        // we guard its access by a check for invalid edge weight. See  (*) above.
+        // we guard its access by a check for invalid edge weight. See  (*) in searchLeg.
 
         // No path found for both target nodes?
         if ((INVALID_EDGE_WEIGHT == new_total_weight_to_forward) &&
@@ -456,6 +708,7 @@ InternalRouteResult shortestPathSearch(SearchEngineData<Algorithm> &engine_worki
                    total_packed_path_to_forward,
                    packed_leg_to_forward_begin,
                    total_weight_to_forward,
+                   parallel,
                    raw_route_data);
     }
     else
@@ -469,6 +722,7 @@ InternalRouteResult shortestPathSearch(SearchEngineData<Algorithm> &engine_worki
                    total_packed_path_to_reverse,
                    packed_leg_to_reverse_begin,
                    total_weight_to_reverse,
+                   parallel,
                    raw_route_data);
     }
 
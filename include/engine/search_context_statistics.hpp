@@ -0,0 +1,25 @@
+#ifndef OSRM_ENGINE_SEARCH_CONTEXT_STATISTICS_HPP
+#define OSRM_ENGINE_SEARCH_CONTEXT_STATISTICS_HPP
+
+#include <cstddef>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Usage of the search contexts of an engine since it was started
+struct SearchContextStatistics
+{
+    std::size_t size;
+    std::size_t in_use;
+    std::size_t peak_in_use;
+    // Number of requests that had to wait for a context
+    std::size_t number_of_waits;
+    // Bytes allocated by the heaps of all contexts at the time they were last returned
+    std::size_t memory_usage;
+};
+}
+}
+
+#endif
@@ -2,10 +2,12 @@
 #define SEARCH_ENGINE_DATA_HPP
 
 #include "engine/algorithm.hpp"
+#include "engine/map_matching/hidden_markov_model.hpp"
+#include "util/concurrent_node_weights.hpp"
 #include "util/query_heap.hpp"
 #include "util/typedefs.hpp"
 
-#include <boost/thread/tss.hpp>
+#include <memory>
 
 namespace osrm
 {
@@ -16,6 +18,11 @@ namespace engine
 // - CH algorithms use CH heaps
 // - CoreCH algorithms use CH
 // - MLD algorithms use MLD heaps
+// - HL algorithms use CH heaps for the searches that fall back to CH
+//
+// A SearchEngineData is the search context of one request. Heaps are allocated on first
+// use and kept for the lifetime of the context, contexts are handed out by SearchEnginePool.
+// So are the arrays of the hidden Markov model map matching fills.
 
 template <typename Algorithm> struct SearchEngineData
 {
@@ -40,32 +47,55 @@ struct ManyToManyHeapData : HeapData
 template <> struct SearchEngineData<routing_algorithms::ch::Algorithm>
 {
     using QueryHeap = util::
-        QueryHeap<NodeID, NodeID, EdgeWeight, HeapData, util::UnorderedMapStorage<NodeID, int>>;
+        QueryHeap<NodeID, NodeID, EdgeWeight, HeapData, util::DenseOrSparseStorage<NodeID, int>>;
 
     using ManyToManyQueryHeap = util::QueryHeap<NodeID,
                                                 NodeID,
                                                 EdgeWeight,
                                                 ManyToManyHeapData,
-                                                util::UnorderedMapStorage<NodeID, int>>;
+                                                util::DenseOrSparseStorage<NodeID, int>>;
+
+    using SearchEngineHeapPtr = std::unique_ptr<QueryHeap>;
+    using ManyToManyHeapPtr = std::unique_ptr<ManyToManyQueryHeap>;
+
+    SearchEngineHeapPtr forward_heap_1;
+    SearchEngineHeapPtr reverse_heap_1;
+    SearchEngineHeapPtr forward_heap_2;
+    SearchEngineHeapPtr reverse_heap_2;
+    SearchEngineHeapPtr forward_heap_3;
+    SearchEngineHeapPtr reverse_heap_3;
+    ManyToManyHeapPtr many_to_many_heap;
+
+    map_matching::HiddenMarkovModelStorage hidden_markov_model_storage;
+
+    // Dense heaps index nodes in an array of the size of the graph instead of a hash map,
+    // see EngineConfig::use_dense_query_heaps.
+    explicit SearchEngineData(const bool use_dense_heaps = false,
+                              const bool /*use_parallel_bidirectional_search*/ = false)
+        : use_dense_heaps(use_dense_heaps)
+    {
+    }
 
-    using SearchEngineHeapPtr = boost::thread_specific_ptr<QueryHeap>;
-    using ManyToManyHeapPtr = boost::thread_specific_ptr<ManyToManyQueryHeap>;
+    void InitializeOrClearFirstHeaps(unsigned number_of_nodes);
 
-    static SearchEngineHeapPtr forward_heap_1;
-    static SearchEngineHeapPtr reverse_heap_1;
-    static SearchEngineHeapPtr forward_heap_2;
-    static SearchEngineHeapPtr reverse_heap_2;
-    static SearchEngineHeapPtr forward_heap_3;
-    static SearchEngineHeapPtr reverse_heap_3;
-    static ManyToManyHeapPtr many_to_many_heap;
+    void InitializeOrClearSecondHeaps(unsigned number_of_nodes);
 
-    void InitializeOrClearFirstThreadLocalStorage(unsigned number_of_nodes);
+    void InitializeOrClearThirdHeaps(unsigned number_of_nodes);
 
-    void InitializeOrClearSecondThreadLocalStorage(unsigned number_of_nodes);
+    void InitializeOrClearManyToManyHeaps(unsigned number_of_nodes);
 
-    void InitializeOrClearThirdThreadLocalStorage(unsigned number_of_nodes);
+    // Bytes allocated by all heaps of this context
+    std::size_t GetMemoryUsage() const;
+
+  private:
+    bool use_dense_heaps;
+};
 
-    void InitializeOrClearManyToManyThreadLocalStorage(unsigned number_of_nodes);
+template <>
+struct SearchEngineData<routing_algorithms::hl::Algorithm>
+    : SearchEngineData<routing_algorithms::ch::Algorithm>
+{
+    using SearchEngineData<routing_algorithms::ch::Algorithm>::SearchEngineData;
 };
 
 struct MultiLayerDijkstraHeapData
@@ -107,18 +137,44 @@ template <> struct SearchEngineData<routing_algorithms::mld::Algorithm>
                                                 ManyToManyMultiLayerDijkstraHeapData,
                                                 util::TwoLevelStorage<NodeID, int>>;
 
-    using SearchEngineHeapPtr = boost::thread_specific_ptr<QueryHeap>;
-    using ManyToManyHeapPtr = boost::thread_specific_ptr<ManyToManyQueryHeap>;
+    using SearchEngineHeapPtr = std::unique_ptr<QueryHeap>;
+    using ManyToManyHeapPtr = std::unique_ptr<ManyToManyQueryHeap>;
+
+    using NodeWeightsPtr = std::unique_ptr<util::ConcurrentNodeWeights>;
+
+    SearchEngineHeapPtr forward_heap_1;
+    SearchEngineHeapPtr reverse_heap_1;
+    ManyToManyHeapPtr many_to_many_heap;
+
+    // Weights the two threads of the parallel bidirectional search exchange
+    NodeWeightsPtr forward_node_weights;
+    NodeWeightsPtr reverse_node_weights;
+
+    map_matching::HiddenMarkovModelStorage hidden_markov_model_storage;
+
+    // MLD heaps always keep the overlay nodes in a dense array. Searches between different
+    // top level cells run the forward and reverse search on two threads if enabled, see
+    // EngineConfig::use_parallel_bidirectional_search.
+    explicit SearchEngineData(const bool /*use_dense_heaps*/ = false,
+                              const bool use_parallel_bidirectional_search = false)
+        : use_parallel_bidirectional_search(use_parallel_bidirectional_search)
+    {
+    }
+
+    void InitializeOrClearFirstHeaps(unsigned number_of_nodes, unsigned number_of_boundary_nodes);
+
+    void InitializeOrClearNodeWeights(unsigned number_of_boundary_nodes);
+
+    void InitializeOrClearManyToManyHeaps(unsigned number_of_nodes,
+                                          unsigned number_of_boundary_nodes);
 
-    static SearchEngineHeapPtr forward_heap_1;
-    static SearchEngineHeapPtr reverse_heap_1;
-    static ManyToManyHeapPtr many_to_many_heap;
+    // Bytes allocated by all heaps of this context
+    std::size_t GetMemoryUsage() const;
 
-    void InitializeOrClearFirstThreadLocalStorage(unsigned number_of_nodes,
-                                                  unsigned number_of_boundary_nodes);
+    bool UseParallelBidirectionalSearch() const { return use_parallel_bidirectional_search; }
 
-    void InitializeOrClearManyToManyThreadLocalStorage(unsigned number_of_nodes,
-                                                       unsigned number_of_boundary_nodes);
+  private:
+    bool use_parallel_bidirectional_search;
 };
 }
 }
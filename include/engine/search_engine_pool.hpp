@@ -0,0 +1,162 @@
+#ifndef OSRM_ENGINE_SEARCH_ENGINE_POOL_HPP
+#define OSRM_ENGINE_SEARCH_ENGINE_POOL_HPP
+
+#include "engine/search_context_statistics.hpp"
+#include "engine/search_engine_data.hpp"
+
+#include "util/log.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Bounded pool of search contexts. Every request borrows one context for its whole duration
+// and returns it when the lease goes out of scope. All contexts are created up front, their
+// heaps are allocated on first use and then reused, so the memory used for heaps is bounded
+// by the pool size and not by the number of threads that ever ran a query.
+//
+// Borrowing blocks while all contexts are in use. TryBorrow never blocks and is meant for
+// requests that can use additional contexts to parallelize their work while the pool is idle.
+template <typename Algorithm> class SearchEnginePool
+{
+  public:
+    using Context = SearchEngineData<Algorithm>;
+
+    class ContextReleaser
+    {
+      public:
+        ContextReleaser() = default;
+        ContextReleaser(SearchEnginePool *pool, std::size_t index) : pool(pool), index(index) {}
+
+        void operator()(Context *context) const
+        {
+            BOOST_ASSERT(pool);
+            pool->Release(context, index);
+        }
+
+      private:
+        SearchEnginePool *pool = nullptr;
+        std::size_t index = 0;
+    };
+
+    using Lease = std::unique_ptr<Context, ContextReleaser>;
+
+    using Statistics = SearchContextStatistics;
+
+    SearchEnginePool(const std::size_t size,
+                     const bool use_dense_heaps,
+                     const bool use_parallel_bidirectional_search = false)
+        : memory_usage(size, 0)
+    {
+        BOOST_ASSERT(size > 0);
+        contexts.reserve(size);
+        idle_contexts.reserve(size);
+        for (std::size_t index = 0; index < size; ++index)
+        {
+            contexts.push_back(
+                std::make_unique<Context>(use_dense_heaps, use_parallel_bidirectional_search));
+            idle_contexts.push_back(index);
+        }
+    }
+
+    SearchEnginePool(const SearchEnginePool &) = delete;
+    SearchEnginePool &operator=(const SearchEnginePool &) = delete;
+
+    ~SearchEnginePool()
+    {
+        const auto statistics = GetStatistics();
+        util::Log(logDEBUG) << "Search context pool: " << statistics.peak_in_use << " of "
+                            << statistics.size << " contexts used at peak, "
+                            << statistics.number_of_waits << " waits, "
+                            << (statistics.memory_usage >> 20) << " MiB of heaps";
+    }
+
+    Lease Borrow()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (idle_contexts.empty())
+        {
+            number_of_waits++;
+            context_returned.wait(lock, [this] { return !idle_contexts.empty(); });
+        }
+
+        const auto index = idle_contexts.back();
+        idle_contexts.pop_back();
+        peak_in_use = std::max(peak_in_use, contexts.size() - idle_contexts.size());
+
+        return Lease{contexts[index].get(), ContextReleaser{this, index}};
+    }
+
+    // Returns an empty lease if all contexts are in use
+    Lease TryBorrow()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (idle_contexts.empty())
+            return Lease{nullptr, ContextReleaser{}};
+
+        const auto index = idle_contexts.back();
+        idle_contexts.pop_back();
+        peak_in_use = std::max(peak_in_use, contexts.size() - idle_contexts.size());
+
+        return Lease{contexts[index].get(), ContextReleaser{this, index}};
+    }
+
+    // Calls initialize on every idle context, for example to allocate their heaps before the
+    // first request is served
+    template <typename InitializeFunction> void Prewarm(InitializeFunction &&initialize)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto index : idle_contexts)
+        {
+            initialize(*contexts[index]);
+            memory_usage[index] = contexts[index]->GetMemoryUsage();
+        }
+    }
+
+    Statistics GetStatistics() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return {contexts.size(),
+                contexts.size() - idle_contexts.size(),
+                peak_in_use,
+                number_of_waits,
+                std::accumulate(memory_usage.begin(), memory_usage.end(), std::size_t{0})};
+    }
+
+  private:
+    void Release(Context *context, const std::size_t index)
+    {
+        BOOST_ASSERT(contexts[index].get() == context);
+        // Heaps only grow while the context is borrowed, so measuring them here is race free
+        const auto context_memory_usage = context->GetMemoryUsage();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            memory_usage[index] = context_memory_usage;
+            idle_contexts.push_back(index);
+        }
+        context_returned.notify_one();
+    }
+
+    mutable std::mutex mutex;
+    std::condition_variable context_returned;
+    std::vector<std::unique_ptr<Context>> contexts;
+    std::vector<std::size_t> idle_contexts;
+    std::vector<std::size_t> memory_usage;
+    std::size_t peak_in_use = 0;
+    std::size_t number_of_waits = 0;
+};
+}
+}
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef OSRM_ENGINE_SEARCH_SPACE_CACHE_HPP
+#define OSRM_ENGINE_SEARCH_SPACE_CACHE_HPP
+
+#include "engine/phantom_node.hpp"
+
+#include "util/log.hpp"
+#include "util/lru_cache.hpp"
+#include "util/std_hash.hpp"
+#include "util/typedefs.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Search spaces of the backward searches run for table targets, shared by all requests of an
+// engine. Frequent destinations like depots appear in many tables, their search spaces only
+// depend on the nodes the search starts from and the facade it runs on, not on the sources.
+//
+// Entries are keyed by the generation of the facade and the heap entries the target phantom
+// node seeds the search with. A facade of a new dataset has a new generation, so search spaces
+// of replaced datasets are never returned and age out of the cache.
+template <typename BucketT> class SearchSpaceCache
+{
+  public:
+    using SearchSpace = std::vector<BucketT>;
+    using SearchSpacePtr = std::shared_ptr<const SearchSpace>;
+
+    struct Key
+    {
+        std::uint64_t facade_generation;
+        NodeID forward_node;
+        EdgeWeight forward_weight;
+        EdgeDuration forward_duration;
+        EdgeDistance forward_distance;
+        NodeID reverse_node;
+        EdgeWeight reverse_weight;
+        EdgeDuration reverse_duration;
+        EdgeDistance reverse_distance;
+
+        // Same seeds as insertTargetInHeap
+        Key(const std::uint64_t facade_generation, const PhantomNode &phantom)
+            : facade_generation(facade_generation), forward_node(SPECIAL_NODEID),
+              forward_weight(0), forward_duration(0), forward_distance(0),
+              reverse_node(SPECIAL_NODEID), reverse_weight(0), reverse_duration(0),
+              reverse_distance(0)
+        {
+            if (phantom.IsValidForwardTarget())
+            {
+                forward_node = phantom.forward_segment_id.id;
+                forward_weight = phantom.GetForwardWeightPlusOffset();
+                forward_duration = phantom.GetForwardDuration();
+                forward_distance = phantom.GetForwardDistance();
+            }
+            if (phantom.IsValidReverseTarget())
+            {
+                reverse_node = phantom.reverse_segment_id.id;
+                reverse_weight = phantom.GetReverseWeightPlusOffset();
+                reverse_duration = phantom.GetReverseDuration();
+                reverse_distance = phantom.GetReverseDistance();
+            }
+        }
+
+        bool operator==(const Key &other) const
+        {
+            return std::tie(facade_generation,
+                            forward_node,
+                            forward_weight,
+                            forward_duration,
+                            forward_distance,
+                            reverse_node,
+                            reverse_weight,
+                            reverse_duration,
+                            reverse_distance) == std::tie(other.facade_generation,
+                                                          other.forward_node,
+                                                          other.forward_weight,
+                                                          other.forward_duration,
+                                                          other.forward_distance,
+                                                          other.reverse_node,
+                                                          other.reverse_weight,
+                                                          other.reverse_duration,
+                                                          other.reverse_distance);
+        }
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key &key) const
+        {
+            return hash_val(key.facade_generation,
+                            key.forward_node,
+                            key.forward_weight,
+                            key.reverse_node,
+                            key.reverse_weight);
+        }
+    };
+
+    struct Statistics
+    {
+        std::size_t number_of_entries;
+        std::size_t memory_usage;
+        std::size_t hits;
+        std::size_t misses;
+    };
+
+    // Capacity in bytes
+    explicit SearchSpaceCache(const std::size_t capacity) : cache(capacity) {}
+
+    SearchSpaceCache(const SearchSpaceCache &) = delete;
+    SearchSpaceCache &operator=(const SearchSpaceCache &) = delete;
+
+    ~SearchSpaceCache()
+    {
+        const auto statistics = GetStatistics();
+        util::Log(logDEBUG) << "Search space cache: " << statistics.hits << " hits, "
+                            << statistics.misses << " misses, " << statistics.number_of_entries
+                            << " entries using " << (statistics.memory_usage >> 20) << " MiB";
+    }
+
+    SearchSpacePtr Get(const Key &key)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto search_space = cache.Get(key);
+        if (!search_space)
+        {
+            misses++;
+            return {};
+        }
+        hits++;
+        return *search_space;
+    }
+
+    void Insert(const Key &key, SearchSpace search_space)
+    {
+        const auto entry_size = sizeof(Key) + sizeof(SearchSpace) + ENTRY_OVERHEAD +
+                                search_space.size() * sizeof(BucketT);
+        auto entry = std::make_shared<const SearchSpace>(std::move(search_space));
+
+        std::lock_guard<std::mutex> lock(mutex);
+        cache.Insert(key, std::move(entry), entry_size);
+    }
+
+    Statistics GetStatistics() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return {cache.GetNumberOfEntries(), cache.GetSize(), hits, misses};
+    }
+
+  private:
+    // List node, hash map node and shared pointer control block per entry, roughly
+    static constexpr std::size_t ENTRY_OVERHEAD = 96;
+
+    mutable std::mutex mutex;
+    util::LRUCache<Key, SearchSpacePtr, KeyHash> cache;
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+};
+}
+}
+
+#endif
@@ -96,7 +96,8 @@ class Extractor
                         const std::vector<EdgeBasedNodeSegment> &input_node_segments,
                         EdgeBasedNodeDataContainer &nodes_container) const;
     void BuildRTree(std::vector<EdgeBasedNodeSegment> edge_based_node_segments,
-                    const std::vector<util::Coordinate> &coordinates);
+                    const std::vector<util::Coordinate> &coordinates,
+                    const EdgeBasedNodeDataContainer &nodes_container);
     std::shared_ptr<RestrictionMap> LoadRestrictionMap();
 
     void WriteConditionalRestrictions(
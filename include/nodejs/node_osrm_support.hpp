@@ -233,15 +233,19 @@ inline engine_config_ptr argumentsToEngineConfig(const Nan::FunctionCallbackInfo
         {
             engine_config->algorithm = osrm::EngineConfig::Algorithm::MLD;
         }
+        else if (*v8::String::Utf8Value(algorithm_str) == std::string("HL"))
+        {
+            engine_config->algorithm = osrm::EngineConfig::Algorithm::HL;
+        }
         else
         {
-            Nan::ThrowError("algorithm option must be one of 'CH', 'CoreCH', or 'MLD'.");
+            Nan::ThrowError("algorithm option must be one of 'CH', 'CoreCH', 'MLD', or 'HL'.");
             return engine_config_ptr();
         }
     }
     else if (!algorithm->IsUndefined())
     {
-        Nan::ThrowError("algorithm option must be a string and one of 'CH', 'CoreCH', or 'MLD'.");
+        Nan::ThrowError("algorithm option must be a string and one of 'CH', 'CoreCH', 'MLD', or 'HL'.");
         return engine_config_ptr();
     }
 
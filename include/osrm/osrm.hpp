@@ -33,11 +33,15 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace osrm
 {
 namespace json = util::json;
 using engine::EngineConfig;
+using engine::SearchContextStatistics;
+using engine::api::IsochroneParameters;
+using engine::api::MatchedTrace;
 using engine::api::MatchParameters;
 using engine::api::NearestParameters;
 using engine::api::RouteParameters;
@@ -56,8 +60,11 @@ using engine::api::TripParameters;
  *  - Trip: shortest round trip between coordinates
  *  - Match: snaps noisy coordinate traces to the road network
  *  - Tile: vector tiles with internal graph representation
+ *  - Isochrone: area reachable from a coordinate within travel time limits
  *
  *  All services take service-specific parameters, fill a JSON object, and return a status code.
+ *
+ *  MatchBatch matches many traces for offline processing, its results are not formatted as JSON.
  */
 class OSRM final
 {
@@ -121,6 +128,18 @@ class OSRM final
      */
     Status Match(const MatchParameters &parameters, json::Object &result) const;
 
+    /**
+     * MatchBatch: matches many traces on all search contexts of the engine in parallel, it uses
+     * at most as many threads as EngineConfig::search_context_pool_size
+     *
+     * \param traces match query specific parameters of every trace
+     * \param results compact result of every trace, empty for traces that could not be matched
+     * \return Status indicating whether the algorithm supports map matching
+     * \see Status, MatchParameters and MatchedTrace
+     */
+    Status MatchBatch(const std::vector<MatchParameters> &traces,
+                      std::vector<MatchedTrace> &results) const;
+
     /**
      * Tile: vector tiles with internal graph representation
      *
@@ -130,6 +149,23 @@ class OSRM final
      */
     Status Tile(const TileParameters &parameters, std::string &result) const;
 
+    /**
+     * Isochrone: area reachable from a coordinate within travel time limits
+     *
+     * \param parameters isochrone query specific parameters
+     * \return Status indicating success for the query or failure
+     * \see Status, IsochroneParameters and json::Object
+     */
+    Status Isochrone(const IsochroneParameters &parameters, json::Object &result) const;
+
+    /**
+     * Usage of the search contexts that requests borrow their query heaps from
+     *
+     * \return number of contexts, how many are and were in use at most and their memory usage
+     * \see SearchContextStatistics
+     */
+    SearchContextStatistics GetSearchContextStatistics() const;
+
   private:
     std::unique_ptr<engine::EngineInterface> engine_;
 };
@@ -52,10 +52,13 @@ struct NearestParameters;
 struct TripParameters;
 struct MatchParameters;
 struct TileParameters;
+struct IsochroneParameters;
+struct MatchedTrace;
 } // ns api
 
 class EngineInterface;
 struct EngineConfig;
+struct SearchContextStatistics;
 } // ns engine
 } // ns osrm
 
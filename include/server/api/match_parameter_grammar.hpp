@@ -46,13 +46,18 @@ struct MatchParametersGrammar final : public RouteParametersGrammar<Iterator, Si
             qi::lit("waypoints=") >
             (size_t_ % ';')[ph::bind(&engine::api::MatchParameters::waypoints, qi::_r1) = qi::_1];
 
+        session_rule =
+            qi::lit("session=") >
+            qi::as_string[+qi::char_("a-zA-Z0-9--_")]
+                         [ph::bind(&engine::api::MatchParameters::session, qi::_r1) = qi::_1];
+
         gaps_type.add("split", engine::api::MatchParameters::GapsType::Split)(
             "ignore", engine::api::MatchParameters::GapsType::Ignore);
 
         root_rule =
             BaseGrammar::query_rule(qi::_r1) > -qi::lit(".json") >
             -('?' > (timestamps_rule(qi::_r1) | BaseGrammar::base_rule(qi::_r1) |
-                     waypoints_rule(qi::_r1) |
+                     waypoints_rule(qi::_r1) | session_rule(qi::_r1) |
                      (qi::lit("gaps=") >
                       gaps_type[ph::bind(&engine::api::MatchParameters::gaps, qi::_r1) = qi::_1]) |
                      (qi::lit("tidy=") >
@@ -64,6 +69,7 @@ struct MatchParametersGrammar final : public RouteParametersGrammar<Iterator, Si
     qi::rule<Iterator, Signature> root_rule;
     qi::rule<Iterator, Signature> timestamps_rule;
     qi::rule<Iterator, Signature> waypoints_rule;
+    qi::rule<Iterator, Signature> session_rule;
     qi::rule<Iterator, std::size_t()> size_t_;
 
     qi::symbols<char, engine::api::MatchParameters::GapsType> gaps_type;
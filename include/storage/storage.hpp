@@ -55,6 +55,7 @@ class Storage
     void PopulateLayout(storage::BaseDataLayout &layout,
                         const std::vector<std::pair<bool, boost::filesystem::path>> &files);
     std::string PopulateLayoutWithRTree(storage::BaseDataLayout &layout);
+    void PopulateLayoutWithRTreeLeaves(storage::BaseDataLayout &layout);
     std::vector<std::pair<bool, boost::filesystem::path>> GetUpdatableFiles();
     std::vector<std::pair<bool, boost::filesystem::path>> GetStaticFiles();
 
@@ -62,6 +62,7 @@ struct StorageConfig final : IOConfig
                     ".osrm.icd",
                     ".osrm.maneuver_overrides"},
                    {".osrm.hsgr",
+                    ".osrm.hl",
                     ".osrm.nbg_nodes",
                     ".osrm.ebg_nodes",
                     ".osrm.cells",
@@ -73,6 +74,21 @@ struct StorageConfig final : IOConfig
                    {})
     {
     }
+
+    // How the pages of the R-tree leaves are read when the .fileIndex file is mapped
+    enum class PreloadPolicy
+    {
+        None,     // on the first access
+        WillNeed, // in the background, with madvise(MADV_WILLNEED)
+        Populate, // all of them before the data is used
+        Lock      // all of them before the data is used, locked in memory with mlock
+    };
+
+    // Copies the R-tree leaves into the data region (shared memory of osrm-datastore or process
+    // memory) instead of mapping the .fileIndex file when the data is used
+    bool load_rtree_leaves = false;
+    // Only used when the data files are mapped
+    PreloadPolicy rtree_leaves_preload = PreloadPolicy::None;
 };
 }
 }
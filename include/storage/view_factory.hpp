@@ -4,6 +4,7 @@
 #include "storage/shared_data_index.hpp"
 
 #include "contractor/contracted_metric.hpp"
+#include "contractor/hub_labels.hpp"
 #include "contractor/query_graph.hpp"
 
 #include "customizer/edge_based_graph.hpp"
@@ -28,6 +29,7 @@
 #include "partitioner/multi_level_partition.hpp"
 
 #include "util/coordinate.hpp"
+#include "util/integer_range.hpp"
 #include "util/packed_vector.hpp"
 #include "util/range_table.hpp"
 #include "util/static_graph.hpp"
@@ -209,6 +211,17 @@ inline auto make_search_tree_view(const SharedDataIndex &index, const std::strin
 
     const auto coordinates = make_coordinates_view(index, "/common/nbn_data/coordinates");
 
+    // the leaves were loaded or mapped by the allocator of the data
+    if (index.HasBlock(name + "/leaves"))
+    {
+        const auto leaves = make_vector_view<RTreeLeaf>(index, name + "/leaves");
+        return util::StaticRTree<RTreeLeaf, storage::Ownership::View>{
+            std::move(search_tree),
+            std::move(rtree_level_starts),
+            util::vector_view<const RTreeLeaf>(leaves.data(), leaves.size()),
+            std::move(coordinates)};
+    }
+
     const char *path = index.template GetBlockPtr<char>(name + "/file_index_path");
 
     if (!boost::filesystem::exists(boost::filesystem::path{path}))
@@ -243,12 +256,28 @@ inline auto make_entry_classes_view(const SharedDataIndex &index, const std::str
     return make_vector_view<util::guidance::EntryClass>(index, name);
 }
 
+inline auto make_query_graph_view(const SharedDataIndex &index, const std::string &name)
+{
+    auto node_list =
+        make_vector_view<contractor::QueryGraphView::NodeArrayEntry>(index, name + "/node_array");
+    auto node_to_position = make_vector_view<NodeID>(index, name + "/node_to_position");
+    auto edge_list =
+        make_vector_view<contractor::QueryGraphView::EdgeArrayEntry>(index, name + "/edge_array");
+    auto edge_data =
+        make_vector_view<contractor::QueryGraphView::EdgeDataEntry>(index, name + "/edge_data");
+    auto shortcut_children = make_vector_view<contractor::QueryGraphView::ShortcutChildrenEntry>(
+        index, name + "/shortcut_children");
+
+    return contractor::QueryGraphView{std::move(node_list),
+                                      std::move(node_to_position),
+                                      std::move(edge_list),
+                                      std::move(edge_data),
+                                      std::move(shortcut_children)};
+}
+
 inline auto make_contracted_metric_view(const SharedDataIndex &index, const std::string &name)
 {
-    auto node_list = make_vector_view<contractor::QueryGraphView::NodeArrayEntry>(
-        index, name + "/contracted_graph/node_array");
-    auto edge_list = make_vector_view<contractor::QueryGraphView::EdgeArrayEntry>(
-        index, name + "/contracted_graph/edge_array");
+    auto graph = make_query_graph_view(index, name + "/contracted_graph");
 
     std::vector<util::vector_view<bool>> edge_filter;
     index.List(name + "/exclude",
@@ -256,8 +285,46 @@ inline auto make_contracted_metric_view(const SharedDataIndex &index, const std:
                    edge_filter.push_back(make_vector_view<bool>(index, filter_name));
                }));
 
-    return contractor::ContractedMetricView{{std::move(node_list), std::move(edge_list)},
-                                            std::move(edge_filter)};
+    return contractor::ContractedMetricView{std::move(graph), std::move(edge_filter)};
+}
+
+inline auto make_hub_label_set_view(const SharedDataIndex &index, const std::string &name)
+{
+    auto offsets = make_vector_view<std::uint64_t>(index, name + "/offsets");
+    auto hub_offsets = make_vector_view<std::uint64_t>(index, name + "/hub_offsets");
+    auto packed_hubs = make_vector_view<std::uint32_t>(index, name + "/packed_hubs");
+    auto weights = make_vector_view<EdgeWeight>(index, name + "/weights");
+    auto durations = make_vector_view<EdgeDuration>(index, name + "/durations");
+    auto distances = make_vector_view<EdgeDistance>(index, name + "/distances");
+
+    return contractor::HubLabelSetView{std::move(offsets),
+                                       std::move(hub_offsets),
+                                       std::move(packed_hubs),
+                                       std::move(weights),
+                                       std::move(durations),
+                                       std::move(distances)};
+}
+
+inline auto make_hub_labels_view(const SharedDataIndex &index, const std::string &name)
+{
+    return contractor::HubLabelsView{make_hub_label_set_view(index, name + "/forward"),
+                                     make_hub_label_set_view(index, name + "/backward")};
+}
+
+// Labels of all exclude classes of a metric, ordered by exclude index
+inline auto make_hub_labels_views(const SharedDataIndex &index, const std::string &name)
+{
+    std::vector<std::string> exclude_prefixes;
+    index.List(name + "/exclude/", std::back_inserter(exclude_prefixes));
+
+    std::vector<contractor::HubLabelsView> labels;
+    for (const auto exclude_index : util::irange<std::size_t>(0, exclude_prefixes.size()))
+    {
+        labels.push_back(
+            make_hub_labels_view(index, name + "/exclude/" + std::to_string(exclude_index)));
+    }
+
+    return labels;
 }
 
 inline auto make_partition_view(const SharedDataIndex &index, const std::string &name)
@@ -367,12 +434,9 @@ inline auto make_filtered_graph_view(const SharedDataIndex &index,
 {
     auto exclude_prefix = name + "/exclude/" + std::to_string(exclude_index);
     auto edge_filter = make_vector_view<bool>(index, exclude_prefix + "/edge_filter");
-    auto node_list = make_vector_view<contractor::QueryGraphView::NodeArrayEntry>(
-        index, name + "/contracted_graph/node_array");
-    auto edge_list = make_vector_view<contractor::QueryGraphView::EdgeArrayEntry>(
-        index, name + "/contracted_graph/edge_array");
+    auto graph = make_query_graph_view(index, name + "/contracted_graph");
 
-    return util::FilteredGraphView<contractor::QueryGraphView>({node_list, edge_list}, edge_filter);
+    return util::FilteredGraphView<contractor::QueryGraphView>(std::move(graph), edge_filter);
 }
 }
 }
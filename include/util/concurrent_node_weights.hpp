@@ -0,0 +1,131 @@
+#ifndef OSRM_UTIL_CONCURRENT_NODE_WEIGHTS_HPP
+#define OSRM_UTIL_CONCURRENT_NODE_WEIGHTS_HPP
+
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+#include <boost/optional.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// Weights of the nodes a search reached, written by the thread running the search and read by
+// the thread searching in the opposite direction.
+//
+// Like TwoLevelStorage the overlay nodes, which are numbered first, are kept in a dense array
+// and all other nodes in a map, which is guarded by a mutex as a search on the overlay only
+// touches few of them. All accesses are sequentially consistent: if two threads each write
+// their entry of a node and then read the entry of the other thread, at least one of them
+// sees the entry of the other.
+class ConcurrentNodeWeights
+{
+  public:
+    struct Entry
+    {
+        EdgeWeight weight;
+        // The node was removed from the heap, its weight is final
+        bool settled;
+        // The node was inserted into the heap when the search was initialized
+        bool seed;
+    };
+
+    explicit ConcurrentNodeWeights(const std::size_t number_of_overlay_nodes)
+        : number_of_overlay_nodes(number_of_overlay_nodes),
+          overlay(new std::atomic<std::uint64_t>[number_of_overlay_nodes]())
+    {
+    }
+
+    // Must only be called by the thread that owns the entries
+    void Set(const NodeID node, const Entry &entry)
+    {
+        const auto value = Encode(entry);
+        if (node < number_of_overlay_nodes)
+        {
+            if (overlay[node].load(std::memory_order_relaxed) == EMPTY)
+                touched_overlay_nodes.push_back(node);
+            overlay[node].store(value);
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(base_mutex);
+            base[node] = value;
+        }
+    }
+
+    boost::optional<Entry> Get(const NodeID node) const
+    {
+        std::uint64_t value = EMPTY;
+        if (node < number_of_overlay_nodes)
+        {
+            value = overlay[node].load();
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(base_mutex);
+            const auto iter = base.find(node);
+            if (iter != base.end())
+                value = iter->second;
+        }
+
+        if (value == EMPTY)
+            return boost::none;
+        return Decode(value);
+    }
+
+    // Must not be called while other threads read the entries
+    void Clear()
+    {
+        for (const auto node : touched_overlay_nodes)
+            overlay[node].store(EMPTY, std::memory_order_relaxed);
+        touched_overlay_nodes.clear();
+        base.clear();
+    }
+
+    std::size_t GetNumberOfOverlayNodes() const { return number_of_overlay_nodes; }
+
+    std::size_t GetMemoryUsage() const
+    {
+        return number_of_overlay_nodes * sizeof(std::atomic<std::uint64_t>) +
+               touched_overlay_nodes.capacity() * sizeof(NodeID) +
+               base.size() * (sizeof(NodeID) + sizeof(std::uint64_t));
+    }
+
+  private:
+    static constexpr std::uint64_t EMPTY = 0;
+    static constexpr std::uint64_t VALID_BIT = std::uint64_t{1} << 32;
+    static constexpr std::uint64_t SETTLED_BIT = std::uint64_t{1} << 33;
+    static constexpr std::uint64_t SEED_BIT = std::uint64_t{1} << 34;
+
+    static std::uint64_t Encode(const Entry &entry)
+    {
+        return static_cast<std::uint32_t>(entry.weight) | VALID_BIT |
+               (entry.settled ? SETTLED_BIT : 0) | (entry.seed ? SEED_BIT : 0);
+    }
+
+    static Entry Decode(const std::uint64_t value)
+    {
+        BOOST_ASSERT(value & VALID_BIT);
+        return {static_cast<EdgeWeight>(static_cast<std::uint32_t>(value)),
+                (value & SETTLED_BIT) != 0,
+                (value & SEED_BIT) != 0};
+    }
+
+    const std::size_t number_of_overlay_nodes;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> overlay;
+    std::vector<NodeID> touched_overlay_nodes;
+    mutable std::mutex base_mutex;
+    std::unordered_map<NodeID, std::uint64_t> base;
+};
+}
+}
+
+#endif
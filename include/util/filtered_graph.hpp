@@ -14,18 +14,18 @@ namespace util
 {
 namespace detail
 {
-template <typename GraphT, storage::Ownership Ownership> class FilteredGraphImpl;
-
 // For static graphs we can save the filters as a static vector since
 // we don't modify the structure of the graph. This also makes it easy to
 // swap out the filter.
-template <typename EdgeDataT, storage::Ownership Ownership>
-class FilteredGraphImpl<util::StaticGraph<EdgeDataT, Ownership>, Ownership>
+//
+// GraphT can be any static graph that exposes its adjacency through BeginEdges/EndEdges,
+// e.g. util::StaticGraph or contractor::QueryGraph.
+template <typename GraphT, storage::Ownership Ownership> class FilteredGraphImpl
 {
     template <typename T> using Vector = util::ViewOrVector<T, Ownership>;
 
   public:
-    using Graph = util::StaticGraph<EdgeDataT, Ownership>;
+    using Graph = GraphT;
     using EdgeIterator = typename Graph::EdgeIterator;
     using NodeIterator = typename Graph::NodeIterator;
     using NodeArrayEntry = typename Graph::NodeArrayEntry;
@@ -50,18 +50,42 @@ class FilteredGraphImpl<util::StaticGraph<EdgeDataT, Ownership>, Ownership>
         return graph.GetTarget(e);
     }
 
-    auto &GetEdgeData(const EdgeIterator e)
+    decltype(auto) GetEdgeData(const EdgeIterator e)
     {
         BOOST_ASSERT(edge_filter[e]);
         return graph.GetEdgeData(e);
     }
 
-    const auto &GetEdgeData(const EdgeIterator e) const
+    decltype(auto) GetEdgeData(const EdgeIterator e) const
     {
         BOOST_ASSERT(edge_filter[e]);
         return graph.GetEdgeData(e);
     }
 
+    EdgeWeight GetEdgeWeight(const EdgeIterator e) const
+    {
+        BOOST_ASSERT(edge_filter[e]);
+        return graph.GetEdgeWeight(e);
+    }
+
+    bool IsForwardEdge(const EdgeIterator e) const
+    {
+        BOOST_ASSERT(edge_filter[e]);
+        return graph.IsForwardEdge(e);
+    }
+
+    bool IsBackwardEdge(const EdgeIterator e) const
+    {
+        BOOST_ASSERT(edge_filter[e]);
+        return graph.IsBackwardEdge(e);
+    }
+
+    auto GetShortcutChildren(const EdgeIterator e) const
+    {
+        BOOST_ASSERT(edge_filter[e]);
+        return graph.GetShortcutChildren(e);
+    }
+
     auto GetAdjacentEdgeRange(const NodeIterator n) const
     {
         return EdgeRange{graph.BeginEdges(n), graph.EndEdges(n), edge_filter};
@@ -84,9 +108,6 @@ class FilteredGraphImpl<util::StaticGraph<EdgeDataT, Ownership>, Ownership>
     EdgeIterator
     FindSmallestEdge(const NodeIterator from, const NodeIterator to, FilterFunction &&filter) const
     {
-        static_assert(traits::HasDataMember<typename Graph::EdgeArrayEntry>::value,
-                      "Filtering on .data not possible without .data member attribute");
-
         EdgeIterator smallest_edge = SPECIAL_EDGEID;
         EdgeWeight smallest_weight = INVALID_EDGE_WEIGHT;
         for (auto edge : GetAdjacentEdgeRange(from))
@@ -0,0 +1,104 @@
+#ifndef OSRM_UTIL_LRU_CACHE_HPP
+#define OSRM_UTIL_LRU_CACHE_HPP
+
+#include <boost/assert.hpp>
+#include <boost/optional.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace osrm
+{
+namespace util
+{
+
+// Cache bounded by the total size of its entries, which is given by the caller on insertion.
+// When an insertion exceeds the capacity the least recently used entries are evicted. Not
+// thread safe, callers need to serialize all accesses including Get.
+template <typename Key, typename Value, typename Hash = std::hash<Key>> class LRUCache
+{
+  public:
+    explicit LRUCache(const std::size_t capacity) : capacity(capacity) {}
+
+    // Marks the entry as most recently used
+    boost::optional<Value> Get(const Key &key)
+    {
+        const auto iter = index.find(key);
+        if (iter == index.end())
+            return boost::none;
+
+        entries.splice(entries.begin(), entries, iter->second);
+        return iter->second->value;
+    }
+
+    // Replaces an existing entry of the same key. Entries larger than the capacity are not
+    // inserted at all.
+    void Insert(const Key &key, Value value, const std::size_t entry_size)
+    {
+        Erase(key);
+        if (entry_size > capacity)
+            return;
+
+        while (size + entry_size > capacity)
+        {
+            BOOST_ASSERT(!entries.empty());
+            Erase(entries.back().key);
+        }
+
+        entries.push_front(Entry{key, std::move(value), entry_size});
+        index.emplace(key, entries.begin());
+        size += entry_size;
+    }
+
+    void Erase(const Key &key)
+    {
+        const auto iter = index.find(key);
+        if (iter == index.end())
+            return;
+
+        BOOST_ASSERT(size >= iter->second->size);
+        size -= iter->second->size;
+        entries.erase(iter->second);
+        index.erase(iter);
+    }
+
+    // Entry that is evicted next, without marking it as used
+    boost::optional<std::pair<Key, Value>> GetLeastRecentlyUsed() const
+    {
+        if (entries.empty())
+            return boost::none;
+        return std::make_pair(entries.back().key, entries.back().value);
+    }
+
+    void Clear()
+    {
+        entries.clear();
+        index.clear();
+        size = 0;
+    }
+
+    std::size_t GetSize() const { return size; }
+    std::size_t GetCapacity() const { return capacity; }
+    std::size_t GetNumberOfEntries() const { return entries.size(); }
+
+  private:
+    struct Entry
+    {
+        Key key;
+        Value value;
+        std::size_t size;
+    };
+
+    const std::size_t capacity;
+    std::size_t size = 0;
+    // most recently used entries first
+    std::list<Entry> entries;
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index;
+};
+}
+}
+
+#endif
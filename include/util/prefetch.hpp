@@ -0,0 +1,22 @@
+#ifndef OSRM_UTIL_PREFETCH_HPP
+#define OSRM_UTIL_PREFETCH_HPP
+
+namespace osrm
+{
+namespace util
+{
+
+// Hints that the cache line of address will be read soon. Never faults, so it can be called
+// for addresses that are not valid.
+inline void prefetch(const void *address)
+{
+#if (defined(__clang__) || defined(__GNUC__) || defined(__GNUG__))
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+}
+}
+}
+
+#endif
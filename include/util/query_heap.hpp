@@ -1,13 +1,19 @@
 #ifndef OSRM_UTIL_QUERY_HEAP_HPP
 #define OSRM_UTIL_QUERY_HEAP_HPP
 
+#include "util/prefetch.hpp"
+
 #include <boost/assert.hpp>
 #include <boost/heap/d_ary_heap.hpp>
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <limits>
 #include <map>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -15,31 +21,49 @@ namespace osrm
 namespace util
 {
 
+// Dense storage with O(1) Clear: every entry is stamped with the generation it was written
+// in, entries of older generations count as not inserted.
 template <typename NodeID, typename Key> class GenerationArrayStorage
 {
     using GenerationCounter = std::uint16_t;
 
   public:
     explicit GenerationArrayStorage(std::size_t size)
-        : positions(size, 0), generation(1), generations(size, 0)
+        : generation(1), generations(size, 0), positions(size, 0)
     {
     }
 
     Key &operator[](NodeID node)
     {
-        generation[node] = generation;
+        // grows if a dataset with more nodes is loaded, e.g. into shared memory
+        if (static_cast<std::size_t>(node) >= generations.size())
+        {
+            generations.resize(node + 1, 0);
+            positions.resize(node + 1, 0);
+        }
+        generations[node] = generation;
         return positions[node];
     }
 
     Key peek_index(const NodeID node) const
     {
-        if (generations[node] < generation)
+        if (static_cast<std::size_t>(node) >= generations.size() ||
+            generations[node] != generation)
         {
             return std::numeric_limits<Key>::max();
         }
         return positions[node];
     }
 
+    void Prefetch(const NodeID node) const
+    {
+        if (static_cast<std::size_t>(node) < generations.size())
+        {
+            util::prefetch(generations.data() + node);
+            util::prefetch(positions.data() + node);
+        }
+    }
+
     void Clear()
     {
         generation++;
@@ -51,6 +75,12 @@ template <typename NodeID, typename Key> class GenerationArrayStorage
         }
     }
 
+    std::size_t GetMemoryUsage() const
+    {
+        return generations.capacity() * sizeof(GenerationCounter) +
+               positions.capacity() * sizeof(Key);
+    }
+
   private:
     GenerationCounter generation;
     std::vector<GenerationCounter> generations;
@@ -68,8 +98,12 @@ template <typename NodeID, typename Key> class ArrayStorage
 
     Key peek_index(const NodeID node) const { return positions[node]; }
 
+    void Prefetch(const NodeID node) const { util::prefetch(positions.data() + node); }
+
     void Clear() {}
 
+    std::size_t GetMemoryUsage() const { return positions.capacity() * sizeof(Key); }
+
   private:
     std::vector<Key> positions;
 };
@@ -83,6 +117,9 @@ template <typename NodeID, typename Key> class MapStorage
 
     void Clear() { nodes.clear(); }
 
+    // the tree node can't be located without searching for it
+    void Prefetch(const NodeID) const {}
+
     Key peek_index(const NodeID node) const
     {
         const auto iter = nodes.find(node);
@@ -93,6 +130,12 @@ template <typename NodeID, typename Key> class MapStorage
         return std::numeric_limits<Key>::max();
     }
 
+    // estimated, every tree node holds the entry, three pointers and the color
+    std::size_t GetMemoryUsage() const
+    {
+        return nodes.size() * (sizeof(typename decltype(nodes)::value_type) + 4 * sizeof(void *));
+    }
+
   private:
     std::map<NodeID, Key> nodes;
 };
@@ -122,10 +165,70 @@ template <typename NodeID, typename Key> class UnorderedMapStorage
 
     void Clear() { nodes.clear(); }
 
+    // the entry can't be located without hashing and walking the bucket
+    void Prefetch(const NodeID) const {}
+
+    // estimated, every entry is a singly linked node and every bucket a pointer
+    std::size_t GetMemoryUsage() const
+    {
+        return nodes.bucket_count() * sizeof(void *) +
+               nodes.size() * (sizeof(typename decltype(nodes)::value_type) + sizeof(void *));
+    }
+
   private:
     std::unordered_map<NodeID, Key> nodes;
 };
 
+// Either GenerationArrayStorage or UnorderedMapStorage, chosen at construction. The dense
+// array needs memory linear in the number of nodes but avoids hashing on every access.
+template <typename NodeID, typename Key> class DenseOrSparseStorage
+{
+  public:
+    DenseOrSparseStorage(std::size_t number_of_nodes, bool use_dense)
+        : use_dense(use_dense), dense(use_dense ? number_of_nodes : 0), sparse(number_of_nodes)
+    {
+    }
+
+    Key &operator[](const NodeID node) { return use_dense ? dense[node] : sparse[node]; }
+
+    Key peek_index(const NodeID node) const
+    {
+        return use_dense ? dense.peek_index(node) : sparse.peek_index(node);
+    }
+
+    void Prefetch(const NodeID node) const
+    {
+        if (use_dense)
+        {
+            dense.Prefetch(node);
+        }
+    }
+
+    void Clear()
+    {
+        if (use_dense)
+        {
+            dense.Clear();
+        }
+        else
+        {
+            sparse.Clear();
+        }
+    }
+
+    bool IsDense() const { return use_dense; }
+
+    std::size_t GetMemoryUsage() const
+    {
+        return dense.GetMemoryUsage() + sparse.GetMemoryUsage();
+    }
+
+  private:
+    const bool use_dense;
+    GenerationArrayStorage<NodeID, Key> dense;
+    UnorderedMapStorage<NodeID, Key> sparse;
+};
+
 template <typename NodeID,
           typename Key,
           template <typename N, typename K> class BaseIndexStorage = UnorderedMapStorage,
@@ -163,6 +266,18 @@ class TwoLevelStorage
         }
     }
 
+    void Prefetch(const NodeID node) const
+    {
+        if (node < number_of_overlay_nodes)
+        {
+            overlay.Prefetch(node);
+        }
+        else
+        {
+            base.Prefetch(node);
+        }
+    }
+
     Key const &operator[](const NodeID node) const
     {
         if (node < number_of_overlay_nodes)
@@ -181,17 +296,446 @@ class TwoLevelStorage
         overlay.Clear();
     }
 
+    std::size_t GetMemoryUsage() const
+    {
+        return base.GetMemoryUsage() + overlay.GetMemoryUsage();
+    }
+
   private:
     const std::size_t number_of_overlay_nodes;
     BaseIndexStorage<NodeID, Key> base;
     OverlayIndexStorage<NodeID, Key> overlay;
 };
 
+// Priority queues used by QueryHeap. They order the dense indices that QueryHeap assigns
+// to inserted nodes, so per-index bookkeeping can live in plain vectors.
+
+// Mutable d-ary heap from Boost, every index keeps a handle into the heap
+template <typename Weight, typename Key> class BoostDAryHeap
+{
+  public:
+    void Push(const Weight weight, const Key index)
+    {
+        if (static_cast<std::size_t>(index) >= handles.size())
+        {
+            handles.resize(index + 1, NoneHandle());
+        }
+        handles[index] = heap.push(std::make_pair(weight, index));
+    }
+
+    Key Min() const
+    {
+        BOOST_ASSERT(!heap.empty());
+        return heap.top().second;
+    }
+
+    Weight MinWeight() const
+    {
+        BOOST_ASSERT(!heap.empty());
+        return heap.top().first;
+    }
+
+    void Pop()
+    {
+        BOOST_ASSERT(!heap.empty());
+        const Key index = heap.top().second;
+        heap.pop();
+        handles[index] = NoneHandle();
+    }
+
+    void Decrease(const Key index, const Weight weight)
+    {
+        heap.increase(handles[index], std::make_pair(weight, index));
+    }
+
+    bool Contains(const Key index) const
+    {
+        // Use end iterator as a reliable "non-existent" handle.
+        // Default-constructed handles are singular and
+        // can only be checked-compared to another singular instance.
+        // Behaviour investigated at https://lists.boost.org/boost-users/2017/08/87787.php,
+        // eventually confirmation at https://stackoverflow.com/a/45622940/151641.
+        // Corrected in https://github.com/Project-OSRM/osrm-backend/pull/4396
+        return static_cast<std::size_t>(index) < handles.size() && handles[index] != NoneHandle();
+    }
+
+    std::size_t Size() const { return heap.size(); }
+
+    void DeleteAll()
+    {
+        std::fill(handles.begin(), handles.end(), NoneHandle());
+        heap.clear();
+    }
+
+    void Clear()
+    {
+        handles.clear();
+        heap.clear();
+    }
+
+    // estimated, the mutable heap keeps every entry in a list node and an index vector
+    std::size_t GetMemoryUsage() const
+    {
+        return handles.capacity() * sizeof(HeapHandle) +
+               heap.size() * (sizeof(HeapData) + sizeof(std::size_t) + 3 * sizeof(void *));
+    }
+
+  private:
+    using HeapData = std::pair<Weight, Key>;
+    using HeapContainer = boost::heap::d_ary_heap<HeapData,
+                                                  boost::heap::arity<4>,
+                                                  boost::heap::mutable_<true>,
+                                                  boost::heap::compare<std::greater<HeapData>>>;
+    using HeapHandle = typename HeapContainer::handle_type;
+
+    HeapHandle NoneHandle() const
+    {
+        auto const end_it = const_cast<HeapContainer &>(heap).end(); // non-const iterator
+        return heap.s_handle_from_iterator(end_it);                   // from non-const iterator
+    }
+
+    HeapContainer heap;
+    std::vector<HeapHandle> handles;
+};
+
+// Intrusive 4-ary heap: the heap array holds (weight, index) pairs by value and the heap
+// position of every index is kept in a flat vector, so there is no handle to follow.
+template <typename Weight, typename Key> class FourAryHeap
+{
+    static constexpr std::size_t ARITY = 4;
+    static constexpr std::size_t REMOVED = std::numeric_limits<std::size_t>::max();
+
+  public:
+    void Push(const Weight weight, const Key index)
+    {
+        if (static_cast<std::size_t>(index) >= positions.size())
+        {
+            positions.resize(index + 1, REMOVED);
+        }
+        heap.emplace_back(weight, index);
+        SiftUp(heap.size() - 1);
+    }
+
+    Key Min() const
+    {
+        BOOST_ASSERT(!heap.empty());
+        return heap.front().second;
+    }
+
+    Weight MinWeight() const
+    {
+        BOOST_ASSERT(!heap.empty());
+        return heap.front().first;
+    }
+
+    void Pop()
+    {
+        BOOST_ASSERT(!heap.empty());
+        positions[heap.front().second] = REMOVED;
+        heap.front() = heap.back();
+        heap.pop_back();
+        if (!heap.empty())
+        {
+            SiftDown(0);
+        }
+    }
+
+    void Decrease(const Key index, const Weight weight)
+    {
+        BOOST_ASSERT(Contains(index));
+        const auto position = positions[index];
+        BOOST_ASSERT(weight <= heap[position].first);
+        heap[position].first = weight;
+        SiftUp(position);
+    }
+
+    bool Contains(const Key index) const
+    {
+        return static_cast<std::size_t>(index) < positions.size() && positions[index] != REMOVED;
+    }
+
+    std::size_t Size() const { return heap.size(); }
+
+    void DeleteAll()
+    {
+        for (const auto &entry : heap)
+        {
+            positions[entry.second] = REMOVED;
+        }
+        heap.clear();
+    }
+
+    void Clear()
+    {
+        positions.clear();
+        heap.clear();
+    }
+
+    std::size_t GetMemoryUsage() const
+    {
+        return heap.capacity() * sizeof(HeapData) + positions.capacity() * sizeof(std::size_t);
+    }
+
+  private:
+    // Ties are broken by index to order exactly like BoostDAryHeap
+    using HeapData = std::pair<Weight, Key>;
+
+    void SiftUp(std::size_t position)
+    {
+        const auto entry = heap[position];
+        while (position > 0)
+        {
+            const auto parent = (position - 1) / ARITY;
+            if (!(entry < heap[parent]))
+                break;
+            heap[position] = heap[parent];
+            positions[heap[position].second] = position;
+            position = parent;
+        }
+        heap[position] = entry;
+        positions[entry.second] = position;
+    }
+
+    void SiftDown(std::size_t position)
+    {
+        const auto entry = heap[position];
+        const auto size = heap.size();
+        while (true)
+        {
+            const auto first_child = position * ARITY + 1;
+            if (first_child >= size)
+                break;
+
+            const auto last_child = std::min(first_child + ARITY, size);
+            auto min_child = first_child;
+            for (auto child = first_child + 1; child < last_child; ++child)
+            {
+                if (heap[child] < heap[min_child])
+                    min_child = child;
+            }
+
+            if (!(heap[min_child] < entry))
+                break;
+            heap[position] = heap[min_child];
+            positions[heap[position].second] = position;
+            position = min_child;
+        }
+        heap[position] = entry;
+        positions[entry.second] = position;
+    }
+
+    std::vector<HeapData> heap;
+    std::vector<std::size_t> positions;
+};
+
+template <typename Weight, typename Key> constexpr std::size_t FourAryHeap<Weight, Key>::REMOVED;
+
+// Monotone radix heap for integral weights. Entries are kept in buckets by the highest bit
+// in which they differ from the last removed weight, so Pop is amortized O(log C).
+// Decrease appends a new entry and leaves the old one behind, stale entries are dropped
+// when their bucket is redistributed.
+//
+// Only valid for Dijkstra-like use: no weight pushed or decreased may be smaller than
+// the weight of the last removed index.
+template <typename Weight, typename Key> class RadixHeap
+{
+    static_assert(std::is_integral<Weight>::value, "radix heap needs integral weights");
+    using Bits = typename std::make_unsigned<Weight>::type;
+    static constexpr std::size_t NUMBER_OF_BITS = std::numeric_limits<Bits>::digits;
+    static constexpr std::size_t NUMBER_OF_BUCKETS = NUMBER_OF_BITS + 1;
+
+  public:
+    RadixHeap() { Clear(); }
+
+    void Push(const Weight weight, const Key index)
+    {
+        if (static_cast<std::size_t>(index) >= weights.size())
+        {
+            weights.resize(index + 1);
+            queued.resize(index + 1, false);
+        }
+        BOOST_ASSERT(!queued[index]);
+        weights[index] = weight;
+        queued[index] = true;
+        ++size;
+        Append(weight, index);
+    }
+
+    Key Min() const { return FindMin().second; }
+
+    Weight MinWeight() const { return FindMin().first; }
+
+    void Pop()
+    {
+        BOOST_ASSERT(size > 0);
+        Redistribute();
+        BOOST_ASSERT(!buckets[0].empty());
+        const auto index = buckets[0].back().second;
+        buckets[0].pop_back();
+        queued[index] = false;
+        --size;
+    }
+
+    void Decrease(const Key index, const Weight weight)
+    {
+        BOOST_ASSERT(Contains(index));
+        BOOST_ASSERT(weight <= weights[index]);
+        if (weight == weights[index])
+            return;
+        weights[index] = weight;
+        Append(weight, index);
+    }
+
+    bool Contains(const Key index) const
+    {
+        return static_cast<std::size_t>(index) < queued.size() && queued[index];
+    }
+
+    std::size_t Size() const { return size; }
+
+    void DeleteAll()
+    {
+        for (auto &bucket : buckets)
+        {
+            for (const auto &entry : bucket)
+            {
+                queued[entry.second] = false;
+            }
+            bucket.clear();
+        }
+        size = 0;
+        last = 0;
+    }
+
+    void Clear()
+    {
+        for (auto &bucket : buckets)
+        {
+            bucket.clear();
+        }
+        weights.clear();
+        queued.clear();
+        size = 0;
+        last = 0;
+    }
+
+    std::size_t GetMemoryUsage() const
+    {
+        std::size_t usage = weights.capacity() * sizeof(Weight) + queued.capacity() / 8;
+        for (const auto &bucket : buckets)
+        {
+            usage += bucket.capacity() * sizeof(HeapData);
+        }
+        return usage;
+    }
+
+  private:
+    using HeapData = std::pair<Weight, Key>;
+
+    // Order preserving mapping of signed weights to unsigned integers
+    static Bits ToBits(const Weight weight)
+    {
+        return static_cast<Bits>(weight) ^
+               (std::is_signed<Weight>::value ? Bits{1} << (NUMBER_OF_BITS - 1) : Bits{0});
+    }
+
+    std::size_t BucketIndex(const Weight weight) const
+    {
+        auto difference = ToBits(weight) ^ last;
+        std::size_t index = 0;
+        while (difference != 0)
+        {
+            difference >>= 1;
+            ++index;
+        }
+        return index;
+    }
+
+    bool IsStale(const HeapData &entry) const
+    {
+        return !queued[entry.second] || weights[entry.second] != entry.first;
+    }
+
+    void Append(const Weight weight, const Key index)
+    {
+        BOOST_ASSERT(ToBits(weight) >= last);
+        buckets[BucketIndex(weight)].emplace_back(weight, index);
+    }
+
+    // Drops stale entries up to the first bucket that still holds a queued index.
+    // All entries of the first bucket have the last removed weight, so it is enough
+    // to trim its back which is the entry handed out next.
+    std::size_t FirstNonEmptyBucket() const
+    {
+        BOOST_ASSERT(size > 0);
+        auto &first = buckets[0];
+        while (!first.empty() && IsStale(first.back()))
+        {
+            first.pop_back();
+        }
+        if (!first.empty())
+            return 0;
+
+        for (std::size_t bucket_index = 1; bucket_index < NUMBER_OF_BUCKETS; ++bucket_index)
+        {
+            auto &bucket = buckets[bucket_index];
+            bucket.erase(
+                std::remove_if(bucket.begin(),
+                               bucket.end(),
+                               [this](const HeapData &entry) { return IsStale(entry); }),
+                bucket.end());
+            if (!bucket.empty())
+                return bucket_index;
+        }
+        BOOST_ASSERT_MSG(false, "size does not match the number of queued entries");
+        return 0;
+    }
+
+    // Peeking does not advance the last removed weight, so the heap still accepts
+    // weights between the last removed weight and the current minimum.
+    const HeapData &FindMin() const
+    {
+        const auto bucket_index = FirstNonEmptyBucket();
+        const auto &bucket = buckets[bucket_index];
+        if (bucket_index == 0)
+            return bucket.back();
+        return *std::min_element(bucket.begin(), bucket.end());
+    }
+
+    // Moves the minimum entries into the first bucket
+    void Redistribute()
+    {
+        const auto bucket_index = FirstNonEmptyBucket();
+        if (bucket_index == 0)
+            return;
+
+        auto entries = std::move(buckets[bucket_index]);
+        buckets[bucket_index].clear();
+        const auto min = *std::min_element(entries.begin(), entries.end());
+        last = ToBits(min.first);
+        for (const auto &entry : entries)
+        {
+            buckets[BucketIndex(entry.first)].push_back(entry);
+        }
+
+        // Pop takes the back of the first bucket, which has to be the entry Min returned
+        auto &first = buckets[0];
+        std::iter_swap(std::find(first.begin(), first.end(), min), first.end() - 1);
+    }
+
+    mutable std::array<std::vector<HeapData>, NUMBER_OF_BUCKETS> buckets;
+    std::vector<Weight> weights;
+    std::vector<bool> queued;
+    std::size_t size;
+    Bits last;
+};
+
 template <typename NodeID,
           typename Key,
           typename Weight,
           typename Data,
-          typename IndexStorage = ArrayStorage<NodeID, NodeID>>
+          typename IndexStorage = ArrayStorage<NodeID, NodeID>,
+          template <typename W, typename K> class PriorityQueue = BoostDAryHeap>
 class QueryHeap
 {
   public:
@@ -205,12 +749,12 @@ class QueryHeap
 
     void Clear()
     {
-        heap.clear();
+        heap.Clear();
         inserted_nodes.clear();
         node_index.Clear();
     }
 
-    std::size_t Size() const { return heap.size(); }
+    std::size_t Size() const { return heap.Size(); }
 
     bool Empty() const { return 0 == Size(); }
 
@@ -218,8 +762,8 @@ class QueryHeap
     {
         BOOST_ASSERT(node < std::numeric_limits<NodeID>::max());
         const auto index = static_cast<Key>(inserted_nodes.size());
-        const auto handle = heap.push(std::make_pair(weight, index));
-        inserted_nodes.emplace_back(HeapNode{handle, node, weight, data});
+        heap.Push(weight, index);
+        inserted_nodes.emplace_back(HeapNode{node, weight, data});
         node_index[node] = index;
     }
 
@@ -247,16 +791,7 @@ class QueryHeap
     {
         BOOST_ASSERT(WasInserted(node));
         const Key index = node_index.peek_index(node);
-
-        // Use end iterator as a reliable "non-existent" handle.
-        // Default-constructed handles are singular and
-        // can only be checked-compared to another singular instance.
-        // Behaviour investigated at https://lists.boost.org/boost-users/2017/08/87787.php,
-        // eventually confirmation at https://stackoverflow.com/a/45622940/151641.
-        // Corrected in https://github.com/Project-OSRM/osrm-backend/pull/4396
-        auto const end_it = const_cast<HeapContainer &>(heap).end();  // non-const iterator
-        auto const none_handle = heap.s_handle_from_iterator(end_it); // from non-const iterator
-        return inserted_nodes[index].handle == none_handle;
+        return !heap.Contains(index);
     }
 
     bool WasInserted(const NodeID node) const
@@ -271,33 +806,30 @@ class QueryHeap
 
     NodeID Min() const
     {
-        BOOST_ASSERT(!heap.empty());
-        return inserted_nodes[heap.top().second].node;
+        BOOST_ASSERT(!Empty());
+        return inserted_nodes[heap.Min()].node;
     }
 
     Weight MinKey() const
     {
-        BOOST_ASSERT(!heap.empty());
-        return heap.top().first;
+        BOOST_ASSERT(!Empty());
+        return heap.MinWeight();
     }
 
     NodeID DeleteMin()
     {
-        BOOST_ASSERT(!heap.empty());
-        const Key removedIndex = heap.top().second;
-        heap.pop();
-        inserted_nodes[removedIndex].handle = heap.s_handle_from_iterator(heap.end());
+        BOOST_ASSERT(!Empty());
+        const Key removedIndex = heap.Min();
+        heap.Pop();
         return inserted_nodes[removedIndex].node;
     }
 
-    void DeleteAll()
-    {
-        auto const none_handle = heap.s_handle_from_iterator(heap.end());
-        std::for_each(inserted_nodes.begin(), inserted_nodes.end(), [&none_handle](auto &node) {
-            node.handle = none_handle;
-        });
-        heap.clear();
-    }
+    void DeleteAll() { heap.DeleteAll(); }
+
+    const IndexStorage &GetIndexStorage() const { return node_index; }
+
+    // Loads the index entry of node into the cache ahead of WasInserted/GetKey/Insert
+    void Prefetch(const NodeID node) const { node_index.Prefetch(node); }
 
     void DecreaseKey(NodeID node, Weight weight)
     {
@@ -305,27 +837,26 @@ class QueryHeap
         const auto index = node_index.peek_index(node);
         auto &reference = inserted_nodes[index];
         reference.weight = weight;
-        heap.increase(reference.handle, std::make_pair(weight, index));
+        heap.Decrease(index, weight);
     }
 
-  private:
-    using HeapData = std::pair<Weight, Key>;
-    using HeapContainer = boost::heap::d_ary_heap<HeapData,
-                                                  boost::heap::arity<4>,
-                                                  boost::heap::mutable_<true>,
-                                                  boost::heap::compare<std::greater<HeapData>>>;
-    using HeapHandle = typename HeapContainer::handle_type;
+    // Bytes allocated by this heap, estimated for node based containers
+    std::size_t GetMemoryUsage() const
+    {
+        return inserted_nodes.capacity() * sizeof(HeapNode) + heap.GetMemoryUsage() +
+               node_index.GetMemoryUsage();
+    }
 
+  private:
     struct HeapNode
     {
-        HeapHandle handle;
         NodeID node;
         Weight weight;
         Data data;
     };
 
     std::vector<HeapNode> inserted_nodes;
-    HeapContainer heap;
+    PriorityQueue<Weight, Key> heap;
     IndexStorage node_index;
 };
 }
@@ -0,0 +1,67 @@
+#ifndef OSRM_UTIL_RTREE_SEGMENT_ATTRIBUTES_HPP
+#define OSRM_UTIL_RTREE_SEGMENT_ATTRIBUTES_HPP
+
+#include <cstdint>
+#include <limits>
+
+namespace osrm
+{
+namespace util
+{
+
+/**
+ * Attributes of the segments below a node of the static R-tree, aggregated when the tree is
+ * built. A search can skip a whole subtree if its attributes show that none of the segments
+ * below can pass the filter of the search.
+ *
+ * The aggregation is conservative. A subtree is never skipped if one of its segments could
+ * pass, but it may be searched although none does. For example, a mix of motorway-only and
+ * toll-only segments has no common class and is searched with exclude=motorway,toll.
+ */
+struct RTreeSegmentAttributes
+{
+    enum Flags : std::uint8_t
+    {
+        STARTPOINT = 1,     // a segment that phantom nodes can snap to by default
+        BIG_COMPONENT = 2,  // a segment in a big strongly connected component
+        TINY_COMPONENT = 4, // a segment in a tiny strongly connected component
+        ALL_FLAGS = STARTPOINT | BIG_COMPONENT | TINY_COMPONENT
+    };
+
+    // classes that all segments have in common
+    std::uint8_t common_classes;
+    // bitwise or of the flags of all segments
+    std::uint8_t flags;
+
+    // Attributes that do not rule out any segment
+    static RTreeSegmentAttributes Unknown()
+    {
+        return {0, ALL_FLAGS};
+    }
+
+    // Attributes of an empty set of segments, the neutral element of Merge
+    static RTreeSegmentAttributes Empty()
+    {
+        return {std::numeric_limits<std::uint8_t>::max(), 0};
+    }
+
+    void Merge(const RTreeSegmentAttributes &other)
+    {
+        common_classes &= other.common_classes;
+        flags |= other.flags;
+    }
+
+    bool HasFlag(const Flags flag) const { return (flags & flag) != 0; }
+
+    // If true, every segment has at least one of the classes of the mask
+    bool HasClassOf(const std::uint8_t class_mask) const
+    {
+        return (common_classes & class_mask) != 0;
+    }
+};
+
+static_assert(sizeof(RTreeSegmentAttributes) == 2, "segment attributes are not packed");
+}
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef STATIC_RTREE_HPP
 #define STATIC_RTREE_HPP
 
+#include "storage/io.hpp"
 #include "storage/tar_fwd.hpp"
 
 #include "util/bearing.hpp"
@@ -9,8 +10,11 @@
 #include "util/exception.hpp"
 #include "util/hilbert_value.hpp"
 #include "util/integer_range.hpp"
+#include "util/log.hpp"
 #include "util/mmap_file.hpp"
 #include "util/rectangle.hpp"
+#include "util/rtree_segment_attributes.hpp"
+#include "util/timing_util.hpp"
 #include "util/typedefs.hpp"
 #include "util/vector_view.hpp"
 #include "util/web_mercator.hpp"
@@ -32,10 +36,15 @@
 #include <array>
 #include <limits>
 #include <memory>
+#include <numeric>
 #include <queue>
 #include <string>
 #include <vector>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace osrm
 {
 namespace util
@@ -121,21 +130,17 @@ class StaticRTree
      * Step 3a- Repeat this process for each level, until you only create 1 TreeNode
      *          to contain its children (in this case, W).
      *
-     * As we create TreeNodes, we append them to the m_search_tree vector.
-     *
-     * After this part of the building process, m_search_tree will contain TreeNode
-     * objects in this order:
+     * The number of nodes in each level follows from the number of objects alone:
      *
-     * ABCDEFGHIJ KLMNO PQR UV W
-     * 10         5     3   2  1  <- number of nodes in the level
+     *   ABCDEFGHIJ KLMNO PQR UV W
+     *   10         5     3   2  1  <- number of nodes in the level
      *
-     * In order to make our math easy later on, we reverse the whole array,
-     * then reverse the nodes within each level:
+     * In order to make our math easy later on, the levels are stored in
+     * m_search_tree from the root down, the nodes of each level from left to right:
      *
-     *   Reversed:        W VU RQP ONMKL JIHGFEDCBA
-     *   Levels reversed: W UV PQR KLMNO ABCDEFGHIJ
+     *   W UV PQR KLMNO ABCDEFGHIJ
      *
-     * We also now have the following information:
+     * with the following level sizes:
      *
      *   level sizes = {1,2,3,5,10}
      *
@@ -187,9 +192,14 @@ class StaticRTree
     struct TreeNode
     {
         Rectangle minimum_bounding_rectangle;
+        // aggregated over all segments below the node, lets searches skip the subtree
+        RTreeSegmentAttributes segment_attributes = RTreeSegmentAttributes::Empty();
     };
 
   private:
+    // Approximate size in bytes of the blocks of leaves written to the .fileIndex file at once
+    static constexpr std::uint64_t LEAF_WRITE_BUFFER_SIZE = 64 * 1024 * 1024;
+
     /**
      * A lightweight wrapper for the Hilbert Code for each EdgeDataT object
      * A vector of these is used to sort the EdgeDataT input onto the
@@ -274,12 +284,31 @@ class StaticRTree
     explicit StaticRTree(const std::vector<EdgeDataT> &input_data_vector,
                          const Vector<Coordinate> &coordinate_list,
                          const boost::filesystem::path &on_disk_file_name)
+        : StaticRTree(input_data_vector,
+                      coordinate_list,
+                      on_disk_file_name,
+                      [](const EdgeDataT &) { return RTreeSegmentAttributes::Unknown(); })
+    {
+    }
+
+    // Same as above, the attributes that get_segment_attributes returns for every segment are
+    // aggregated in the tree nodes above it.
+    //
+    // All steps of the construction run in parallel. The size of every level is known up front,
+    // so the nodes are written to their final position right away and each level is built in
+    // one parallel pass over its nodes.
+    template <typename GetSegmentAttributesT>
+    explicit StaticRTree(const std::vector<EdgeDataT> &input_data_vector,
+                         const Vector<Coordinate> &coordinate_list,
+                         const boost::filesystem::path &on_disk_file_name,
+                         const GetSegmentAttributesT &get_segment_attributes)
         : m_coordinate_list(coordinate_list.data(), coordinate_list.size())
     {
         const auto element_count = input_data_vector.size();
         std::vector<WrappedInputElement> input_wrapper_vector(element_count);
 
         // Step 1 - create a vector of Hilbert Code/original position pairs
+        TIMER_START(hilbert_values);
         tbb::parallel_for(
             tbb::blocked_range<uint64_t>(0, element_count),
             [&input_data_vector, &input_wrapper_vector, this](
@@ -306,128 +335,25 @@ class StaticRTree
                     current_wrapper.m_hilbert_value = GetHilbertCode(current_centroid);
                 }
             });
+        TIMER_STOP(hilbert_values);
 
         // sort the hilbert-value representatives
+        TIMER_START(sort);
         tbb::parallel_sort(input_wrapper_vector.begin(), input_wrapper_vector.end());
-        {
-            boost::iostreams::mapped_file out_objects_region;
-            auto out_objects = mmapFile<EdgeDataT>(on_disk_file_name,
-                                                   out_objects_region,
-                                                   input_data_vector.size() * sizeof(EdgeDataT));
-
-            // Note, we can't just write everything in one go, because the input_data_vector
-            // is not sorted by hilbert code, only the input_wrapper_vector is in the correct
-            // order.  Instead, we iterate over input_wrapper_vector, copy the hilbert-indexed
-            // entries from input_data_vector into a temporary contiguous array, then write
-            // that array to disk.
-
-            // Create the first level of TreeNodes - each bounding LEAF_NODE_COUNT EdgeDataT
-            // objects.
-            std::size_t wrapped_element_index = 0;
-            auto objects_iter = out_objects.begin();
-
-            while (wrapped_element_index < element_count)
-            {
-                TreeNode current_node;
-
-                // Loop over the next block of EdgeDataT, calculate the bounding box
-                // for the block, and save the data to write to disk in the correct
-                // order.
-                for (std::uint32_t object_index = 0;
-                     object_index < LEAF_NODE_SIZE && wrapped_element_index < element_count;
-                     ++object_index, ++wrapped_element_index)
-                {
-                    const std::uint32_t input_object_index =
-                        input_wrapper_vector[wrapped_element_index].m_original_index;
-                    const EdgeDataT &object = input_data_vector[input_object_index];
-
-                    *objects_iter++ = object;
-
-                    Coordinate projected_u{
-                        web_mercator::fromWGS84(Coordinate{m_coordinate_list[object.u]})};
-                    Coordinate projected_v{
-                        web_mercator::fromWGS84(Coordinate{m_coordinate_list[object.v]})};
-
-                    BOOST_ASSERT(std::abs(toFloating(projected_u.lon).operator double()) <= 180.);
-                    BOOST_ASSERT(std::abs(toFloating(projected_u.lat).operator double()) <= 180.);
-                    BOOST_ASSERT(std::abs(toFloating(projected_v.lon).operator double()) <= 180.);
-                    BOOST_ASSERT(std::abs(toFloating(projected_v.lat).operator double()) <= 180.);
-
-                    Rectangle rectangle;
-                    rectangle.min_lon =
-                        std::min(rectangle.min_lon, std::min(projected_u.lon, projected_v.lon));
-                    rectangle.max_lon =
-                        std::max(rectangle.max_lon, std::max(projected_u.lon, projected_v.lon));
-
-                    rectangle.min_lat =
-                        std::min(rectangle.min_lat, std::min(projected_u.lat, projected_v.lat));
-                    rectangle.max_lat =
-                        std::max(rectangle.max_lat, std::max(projected_u.lat, projected_v.lat));
-
-                    BOOST_ASSERT(rectangle.IsValid());
-                    current_node.minimum_bounding_rectangle.MergeBoundingBoxes(rectangle);
-                }
+        TIMER_STOP(sort);
 
-                m_search_tree.emplace_back(current_node);
-            }
-        }
-        // mmap as read-only now
-        m_objects = mmapFile<EdgeDataT>(on_disk_file_name, m_objects_region);
-
-        // Should hold the number of nodes at the lowest level of the graph (closest
-        // to the data)
-        std::uint32_t nodes_in_previous_level = m_search_tree.size();
-
-        // Holds the number of TreeNodes in each level.
-        // We always start with the root node, so
-        // m_tree_level_sizes[0] should always be 1
+        // Holds the number of TreeNodes in each level, starting with the leaves. Every level
+        // groups BRANCHING_FACTOR nodes of the level below until only the root is left.
         std::vector<std::uint64_t> tree_level_sizes;
-        tree_level_sizes.push_back(nodes_in_previous_level);
-
-        // Now, repeatedly create levels of nodes that contain BRANCHING_FACTOR
-        // nodes from the previous level.
-        while (nodes_in_previous_level > 1)
+        tree_level_sizes.push_back((element_count + LEAF_NODE_SIZE - 1) / LEAF_NODE_SIZE);
+        while (tree_level_sizes.back() > 1)
         {
-            auto previous_level_start_pos = m_search_tree.size() - nodes_in_previous_level;
-
-            // We can calculate how many nodes will be in this level, we divide by
-            // BRANCHING_FACTOR
-            // and round up
-            std::uint32_t nodes_in_current_level =
-                std::ceil(static_cast<double>(nodes_in_previous_level) / BRANCHING_FACTOR);
-
-            for (auto current_node_idx : irange<std::size_t>(0, nodes_in_current_level))
-            {
-                TreeNode parent_node;
-                auto first_child_index =
-                    current_node_idx * BRANCHING_FACTOR + previous_level_start_pos;
-                auto last_child_index =
-                    first_child_index +
-                    std::min<std::size_t>(BRANCHING_FACTOR,
-                                          nodes_in_previous_level -
-                                              current_node_idx * BRANCHING_FACTOR);
-
-                // Calculate the bounding box for BRANCHING_FACTOR nodes in the previous
-                // level, then save that box as a new TreeNode in the new level.
-                for (auto child_node_idx : irange<std::size_t>(first_child_index, last_child_index))
-                {
-                    parent_node.minimum_bounding_rectangle.MergeBoundingBoxes(
-                        m_search_tree[child_node_idx].minimum_bounding_rectangle);
-                }
-                m_search_tree.emplace_back(parent_node);
-            }
-            nodes_in_previous_level = nodes_in_current_level;
-            tree_level_sizes.push_back(nodes_in_previous_level);
+            tree_level_sizes.push_back((tree_level_sizes.back() + BRANCHING_FACTOR - 1) /
+                                       BRANCHING_FACTOR);
         }
-        // At this point, we've got our tree built, but the nodes are in a weird order.
-        // Next thing we'll do is flip it around so that we don't end up with a lot of
-        // `size - n` math later on.
 
-        // Flip the tree so that the root node is at 0.
-        // This just makes our math during search a bit more intuitive
-        std::reverse(m_search_tree.begin(), m_search_tree.end());
-
-        // Same for the level sizes - root node / base level is at 0
+        // Flip the levels so that the root node is at 0, see the big comment at the top of
+        // this class. This just makes our math during search a bit more intuitive.
         std::reverse(tree_level_sizes.begin(), tree_level_sizes.end());
 
         // The first level starts at 0
@@ -437,22 +363,106 @@ class StaticRTree
                          tree_level_sizes.end(),
                          std::back_inserter(m_tree_level_starts));
         BOOST_ASSERT(m_tree_level_starts.size() >= 2);
+        m_search_tree.resize(m_tree_level_starts.back());
 
-        // Now we have to flip the coordinates within each level so that math is easier
-        // later on.  The workflow here is:
-        // The initial order of tree nodes in the m_search_tree array is roughly:
-        // 6789 345 12 0   (each block here is a level of the tree)
-        // Then we reverse it and get:
-        // 0 21 543 9876
-        // Now the loop below reverses each level to give us the final result
-        // 0 12 345 6789
-        // This ordering keeps the position math easy to understand during later
-        // searches
-        for (auto i : irange<std::size_t>(0, tree_level_sizes.size()))
+        // Step 2 - create the leaves, each bounding LEAF_NODE_SIZE EdgeDataT objects.
+        // The objects are copied in Hilbert order into a buffer of many leaves that is written
+        // to the .fileIndex file in one go, the leaves of a buffer are filled in parallel.
+        TIMER_START(leaves);
         {
-            std::reverse(m_search_tree.begin() + m_tree_level_starts[i],
-                         m_search_tree.begin() + m_tree_level_starts[i] + tree_level_sizes[i]);
+            storage::io::FileWriter objects_writer(on_disk_file_name,
+                                                   storage::io::FileWriter::HasNoFingerprint);
+
+            const std::uint64_t leaf_level_start =
+                m_tree_level_starts[m_tree_level_starts.size() - 2];
+            const std::uint64_t leaf_count = tree_level_sizes.back();
+            const std::uint64_t leaves_per_write =
+                std::max<std::uint64_t>(1, LEAF_WRITE_BUFFER_SIZE / LEAF_PAGE_SIZE);
+            std::vector<EdgeDataT> objects_buffer;
+
+            for (std::uint64_t first_leaf = 0; first_leaf < leaf_count;
+                 first_leaf += leaves_per_write)
+            {
+                const auto end_leaf = std::min(first_leaf + leaves_per_write, leaf_count);
+                const auto first_object = first_leaf * LEAF_NODE_SIZE;
+                const auto end_object =
+                    std::min<std::uint64_t>(end_leaf * LEAF_NODE_SIZE, element_count);
+                objects_buffer.resize(end_object - first_object);
+
+                tbb::parallel_for(
+                    tbb::blocked_range<std::uint64_t>(first_leaf, end_leaf),
+                    [&](const tbb::blocked_range<std::uint64_t> &range) {
+                        for (auto leaf = range.begin(); leaf != range.end(); ++leaf)
+                        {
+                            TreeNode &current_node = m_search_tree[leaf_level_start + leaf];
+                            const auto end_leaf_object = std::min<std::uint64_t>(
+                                (leaf + 1) * LEAF_NODE_SIZE, element_count);
+                            for (auto object_index = leaf * LEAF_NODE_SIZE;
+                                 object_index < end_leaf_object;
+                                 ++object_index)
+                            {
+                                const EdgeDataT &object =
+                                    input_data_vector[input_wrapper_vector[object_index]
+                                                          .m_original_index];
+                                objects_buffer[object_index - first_object] = object;
+
+                                current_node.minimum_bounding_rectangle.MergeBoundingBoxes(
+                                    GetProjectedBoundingBox(object));
+                                current_node.segment_attributes.Merge(
+                                    get_segment_attributes(object));
+                            }
+                        }
+                    });
+
+                objects_writer.WriteFrom(objects_buffer.data(), objects_buffer.size());
+            }
         }
+        TIMER_STOP(leaves);
+
+        // mmap as read-only now
+        m_objects = mmapFile<EdgeDataT>(on_disk_file_name, m_objects_region);
+
+        // Step 3 - create the levels above the leaves, from the bottom up. The nodes of a level
+        // only depend on the level below, so they are built in parallel.
+        TIMER_START(levels);
+        for (std::size_t level = tree_level_sizes.size() - 1; level-- > 0;)
+        {
+            const auto level_start = m_tree_level_starts[level];
+            const auto children_start = m_tree_level_starts[level + 1];
+            const auto children_end = m_tree_level_starts[level + 2];
+
+            tbb::parallel_for(
+                tbb::blocked_range<std::uint64_t>(0, tree_level_sizes[level]),
+                [&](const tbb::blocked_range<std::uint64_t> &range) {
+                    for (auto offset = range.begin(); offset != range.end(); ++offset)
+                    {
+                        TreeNode &parent_node = m_search_tree[level_start + offset];
+                        const auto first_child_index = children_start + offset * BRANCHING_FACTOR;
+                        const auto last_child_index =
+                            std::min<std::uint64_t>(first_child_index + BRANCHING_FACTOR,
+                                                    children_end);
+
+                        // Calculate the bounding box for BRANCHING_FACTOR nodes in the level
+                        // below.
+                        for (auto child_node_idx = first_child_index;
+                             child_node_idx < last_child_index;
+                             ++child_node_idx)
+                        {
+                            parent_node.minimum_bounding_rectangle.MergeBoundingBoxes(
+                                m_search_tree[child_node_idx].minimum_bounding_rectangle);
+                            parent_node.segment_attributes.Merge(
+                                m_search_tree[child_node_idx].segment_attributes);
+                        }
+                    }
+                });
+        }
+        TIMER_STOP(levels);
+
+        util::Log() << "R-tree of " << element_count << " segments: Hilbert values "
+                    << TIMER_SEC(hilbert_values) << "s, sorting " << TIMER_SEC(sort)
+                    << "s, writing " << tree_level_sizes.back() << " leaves " << TIMER_SEC(leaves)
+                    << "s, building " << tree_level_sizes.size() - 1 << " levels "
+                    << TIMER_SEC(levels) << "s";
     }
 
     /**
@@ -484,6 +494,22 @@ class StaticRTree
         m_objects = mmapFile<EdgeDataT>(on_disk_file_name, m_objects_region);
     }
 
+    /**
+     * Constructs an r-tree from blocks of memory loaded by someone else, including the
+     * contents of the .fileIndex file (osrm-datastore with --load-rtree-leaves, or the
+     * allocator that maps the data files)
+     */
+    explicit StaticRTree(Vector<TreeNode> search_tree_,
+                         Vector<std::uint64_t> tree_level_starts,
+                         util::vector_view<const EdgeDataT> objects,
+                         const Vector<Coordinate> &coordinate_list)
+        : m_search_tree(std::move(search_tree_)),
+          m_coordinate_list(coordinate_list.data(), coordinate_list.size()),
+          m_tree_level_starts(std::move(tree_level_starts)), m_objects(std::move(objects))
+    {
+        BOOST_ASSERT(m_tree_level_starts.size() >= 2);
+    }
+
     /* Returns all features inside the bounding box.
        Rectangle needs to be projected!*/
     std::vector<EdgeDataT> SearchInBox(const Rectangle &search_rectangle) const
@@ -559,11 +585,17 @@ class StaticRTree
     std::vector<EdgeDataT> Nearest(const Coordinate input_coordinate,
                                    const std::size_t max_results) const
     {
-        return Nearest(input_coordinate,
-                       [](const CandidateSegment &) { return std::make_pair(true, true); },
-                       [max_results](const std::size_t num_results, const CandidateSegment &) {
-                           return num_results >= max_results;
-                       });
+        // Every segment is accepted, so candidates farther away than the max_results closest
+        // segments seen so far can never be returned and are not queued at all.
+        KthDistanceBound bound(max_results);
+        return SearchNearest(
+            input_coordinate,
+            [](const CandidateSegment &) { return std::make_pair(true, true); },
+            [max_results](const std::size_t num_results, const CandidateSegment &) {
+                return num_results >= max_results;
+            },
+            [](const RTreeSegmentAttributes &) { return true; },
+            bound);
     }
 
     // Override filter and terminator for the desired behaviour.
@@ -571,6 +603,73 @@ class StaticRTree
     std::vector<EdgeDataT> Nearest(const Coordinate input_coordinate,
                                    const FilterT filter,
                                    const TerminationT terminate) const
+    {
+        return Nearest(input_coordinate,
+                       filter,
+                       terminate,
+                       [](const RTreeSegmentAttributes &) { return true; });
+    }
+
+    // Override filter and terminator for the desired behaviour. The node filter returns false
+    // for the aggregated attributes of subtrees that do not contain any segment the filter
+    // accepts, these subtrees are skipped.
+    template <typename FilterT, typename TerminationT, typename NodeFilterT>
+    std::vector<EdgeDataT> Nearest(const Coordinate input_coordinate,
+                                   const FilterT filter,
+                                   const TerminationT terminate,
+                                   const NodeFilterT node_filter) const
+    {
+        // The filter may reject any segment, no candidate can be pruned before it is dequeued
+        NoDistanceBound bound;
+        return SearchNearest(input_coordinate, filter, terminate, node_filter, bound);
+    }
+
+  private:
+    // Upper bound of the squared distance of a candidate that can still be part of the result
+    struct NoDistanceBound
+    {
+        std::uint64_t Get() const { return std::numeric_limits<std::uint64_t>::max(); }
+        void Update(const std::uint64_t) {}
+    };
+
+    // Squared distance of the k-th closest segment queued so far, when the first k segments
+    // that are dequeued make up the result.
+    class KthDistanceBound
+    {
+      public:
+        explicit KthDistanceBound(const std::size_t k) : k(k) {}
+
+        std::uint64_t Get() const
+        {
+            return k > 0 && closest.size() == k ? closest.top()
+                                                : std::numeric_limits<std::uint64_t>::max();
+        }
+
+        void Update(const std::uint64_t squared_distance)
+        {
+            if (closest.size() < k)
+            {
+                closest.push(squared_distance);
+            }
+            else if (k > 0 && squared_distance < closest.top())
+            {
+                closest.pop();
+                closest.push(squared_distance);
+            }
+        }
+
+      private:
+        const std::size_t k;
+        // max-heap of the squared distances of the k closest segments
+        std::priority_queue<std::uint64_t> closest;
+    };
+
+    template <typename FilterT, typename TerminationT, typename NodeFilterT, typename BoundT>
+    std::vector<EdgeDataT> SearchNearest(const Coordinate input_coordinate,
+                                         const FilterT filter,
+                                         const TerminationT terminate,
+                                         const NodeFilterT node_filter,
+                                         BoundT &bound) const
     {
         std::vector<EdgeDataT> results;
         auto projected_coordinate = web_mercator::fromWGS84(input_coordinate);
@@ -587,17 +686,28 @@ class StaticRTree
             const TreeIndex &current_tree_index = current_query_node.tree_index;
             if (!current_query_node.is_segment())
             { // current object is a tree node
+                // the node filter may reject more nodes than at the time this one was queued
+                const auto &current_node =
+                    m_search_tree[m_tree_level_starts[current_tree_index.level] +
+                                  current_tree_index.offset];
+                if (!node_filter(current_node.segment_attributes))
+                    continue;
+
                 if (is_leaf(current_tree_index))
                 {
                     ExploreLeafNode(current_tree_index,
                                     fixed_projected_coordinate,
                                     projected_coordinate,
-                                    traversal_queue);
+                                    traversal_queue,
+                                    bound);
                 }
                 else
                 {
-                    ExploreTreeNode(
-                        current_tree_index, fixed_projected_coordinate, traversal_queue);
+                    ExploreTreeNode(current_tree_index,
+                                    fixed_projected_coordinate,
+                                    traversal_queue,
+                                    node_filter,
+                                    bound);
                 }
             }
             else
@@ -631,18 +741,18 @@ class StaticRTree
         return results;
     }
 
-  private:
     /**
      * Iterates over all the objects in a leaf node and inserts them into our
      * search priority queue.  The speed of this function is very much governed
      * by the value of LEAF_NODE_SIZE, as we'll calculate the euclidean distance
      * for every child of each leaf node visited.
      */
-    template <typename QueueT>
+    template <typename QueueT, typename BoundT>
     void ExploreLeafNode(const TreeIndex &leaf_id,
                          const Coordinate &projected_input_coordinate_fixed,
                          const FloatCoordinate &projected_input_coordinate,
-                         QueueT &traversal_queue) const
+                         QueueT &traversal_queue,
+                         BoundT &bound) const
     {
         // Check that we're actually looking at the bottom level of the tree
         BOOST_ASSERT(is_leaf(leaf_id));
@@ -664,6 +774,10 @@ class StaticRTree
             // distance must be non-negative
             BOOST_ASSERT(0. <= squared_distance);
             BOOST_ASSERT(i < std::numeric_limits<std::uint32_t>::max());
+            if (squared_distance > bound.Get())
+                continue;
+
+            bound.Update(squared_distance);
             traversal_queue.push(QueryCandidate{squared_distance,
                                                 leaf_id,
                                                 static_cast<std::uint32_t>(i),
@@ -678,30 +792,143 @@ class StaticRTree
      * The closests distance to a box from our point is also the closest distance
      * to the closest line in that box (assuming the boxes hug their contents).
      */
-    template <class QueueT>
+    template <class QueueT, typename NodeFilterT, typename BoundT>
     void ExploreTreeNode(const TreeIndex &parent,
                          const Coordinate &fixed_projected_input_coordinate,
-                         QueueT &traversal_queue) const
+                         QueueT &traversal_queue,
+                         const NodeFilterT &node_filter,
+                         const BoundT &bound) const
     {
         // Figure out which_id level the parent is on, and it's offset
         // in that level.
         // Check that we're actually looking at the bottom level of the tree
         BOOST_ASSERT(!is_leaf(parent));
 
-        for (const auto child_index : child_indexes(parent))
+        const auto children = child_indexes(parent);
+        BOOST_ASSERT(children.size() <= BRANCHING_FACTOR);
+
+        // The children of a node are stored next to each other, their lower bounds are computed
+        // in one go before any of them is queued.
+        std::array<std::uint64_t, BRANCHING_FACTOR> squared_lower_bounds;
+        GetMinSquaredDistances(&m_search_tree[children.front()],
+                               children.size(),
+                               fixed_projected_input_coordinate,
+                               squared_lower_bounds.data());
+
+        const auto max_squared_distance = bound.Get();
+        const auto level_start = m_tree_level_starts[parent.level + 1];
+        for (const auto child : irange<std::size_t>(0, children.size()))
         {
-            const auto &child = m_search_tree[child_index];
+            if (squared_lower_bounds[child] > max_squared_distance)
+                continue;
 
-            const auto squared_lower_bound_to_element =
-                child.minimum_bounding_rectangle.GetMinSquaredDist(
-                    fixed_projected_input_coordinate);
+            const auto child_index = children.front() + child;
+            if (!node_filter(m_search_tree[child_index].segment_attributes))
+                continue;
 
-            traversal_queue.push(QueryCandidate{
-                squared_lower_bound_to_element,
-                TreeIndex(parent.level + 1, child_index - m_tree_level_starts[parent.level + 1])});
+            traversal_queue.push(
+                QueryCandidate{squared_lower_bounds[child],
+                               TreeIndex(parent.level + 1, child_index - level_start)});
         }
     }
 
+    /**
+     * Computes the same squared distances as Rectangle::GetMinSquaredDist for the bounding
+     * rectangles of count consecutive tree nodes.
+     *
+     * With SSE2 the rectangles of four nodes are transposed into vectors of their sides, so the
+     * four distances are computed at once. The remaining nodes are handled one at a time.
+     */
+    static void GetMinSquaredDistances(const TreeNode *nodes,
+                                       const std::size_t count,
+                                       const Coordinate location,
+                                       std::uint64_t *squared_distances)
+    {
+        std::size_t index = 0;
+
+#if defined(__SSE2__)
+        static_assert(sizeof(Rectangle) == 4 * sizeof(std::int32_t),
+                      "rectangle is not four packed integers");
+
+        const auto lon = _mm_set1_epi32(static_cast<std::int32_t>(location.lon));
+        const auto lat = _mm_set1_epi32(static_cast<std::int32_t>(location.lat));
+        const auto zero = _mm_setzero_si128();
+
+        // max(min - x, x - max, 0) is the distance of x to the interval [min, max]
+        const auto distance_to_interval = [zero](
+            const __m128i min, const __m128i max, const __m128i x) {
+            const auto below = _mm_sub_epi32(min, x);
+            const auto above = _mm_sub_epi32(x, max);
+            const auto above_is_larger = _mm_cmpgt_epi32(above, below);
+            const auto larger = _mm_or_si128(_mm_and_si128(above_is_larger, above),
+                                             _mm_andnot_si128(above_is_larger, below));
+            return _mm_and_si128(larger, _mm_cmpgt_epi32(larger, zero));
+        };
+
+        for (; index + 4 <= count; index += 4)
+        {
+            // min_lon, max_lon, min_lat, max_lat of one rectangle per vector
+            const auto load = [nodes, index](const std::size_t offset) {
+                return _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+                    &nodes[index + offset].minimum_bounding_rectangle));
+            };
+            const auto first_lons = _mm_unpacklo_epi32(load(0), load(1));
+            const auto second_lons = _mm_unpacklo_epi32(load(2), load(3));
+            const auto first_lats = _mm_unpackhi_epi32(load(0), load(1));
+            const auto second_lats = _mm_unpackhi_epi32(load(2), load(3));
+
+            const auto d_lon = distance_to_interval(_mm_unpacklo_epi64(first_lons, second_lons),
+                                                    _mm_unpackhi_epi64(first_lons, second_lons),
+                                                    lon);
+            const auto d_lat = distance_to_interval(_mm_unpacklo_epi64(first_lats, second_lats),
+                                                    _mm_unpackhi_epi64(first_lats, second_lats),
+                                                    lat);
+
+            // the distances are non-negative, the unsigned products of the even and the odd
+            // lanes are their squares
+            const auto even =
+                _mm_add_epi64(_mm_mul_epu32(d_lon, d_lon), _mm_mul_epu32(d_lat, d_lat));
+            const auto d_lon_odd = _mm_srli_epi64(d_lon, 32);
+            const auto d_lat_odd = _mm_srli_epi64(d_lat, 32);
+            const auto odd = _mm_add_epi64(_mm_mul_epu32(d_lon_odd, d_lon_odd),
+                                           _mm_mul_epu32(d_lat_odd, d_lat_odd));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(squared_distances + index),
+                             _mm_unpacklo_epi64(even, odd));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(squared_distances + index + 2),
+                             _mm_unpackhi_epi64(even, odd));
+        }
+#endif
+
+        for (; index < count; ++index)
+        {
+            squared_distances[index] =
+                nodes[index].minimum_bounding_rectangle.GetMinSquaredDist(location);
+        }
+    }
+
+    // Bounding box of the segment in Web Mercator projection
+    Rectangle GetProjectedBoundingBox(const EdgeDataT &object) const
+    {
+        Coordinate projected_u{web_mercator::fromWGS84(Coordinate{m_coordinate_list[object.u]})};
+        Coordinate projected_v{web_mercator::fromWGS84(Coordinate{m_coordinate_list[object.v]})};
+
+        BOOST_ASSERT(std::abs(toFloating(projected_u.lon).operator double()) <= 180.);
+        BOOST_ASSERT(std::abs(toFloating(projected_u.lat).operator double()) <= 180.);
+        BOOST_ASSERT(std::abs(toFloating(projected_v.lon).operator double()) <= 180.);
+        BOOST_ASSERT(std::abs(toFloating(projected_v.lat).operator double()) <= 180.);
+
+        Rectangle rectangle;
+        rectangle.min_lon = std::min(rectangle.min_lon, std::min(projected_u.lon, projected_v.lon));
+        rectangle.max_lon = std::max(rectangle.max_lon, std::max(projected_u.lon, projected_v.lon));
+
+        rectangle.min_lat = std::min(rectangle.min_lat, std::min(projected_u.lat, projected_v.lat));
+        rectangle.max_lat = std::max(rectangle.max_lat, std::max(projected_u.lat, projected_v.lat));
+
+        BOOST_ASSERT(rectangle.IsValid());
+        return rectangle;
+    }
+
     std::uint64_t GetLevelSize(const std::size_t level) const
     {
         BOOST_ASSERT(m_tree_level_starts.size() > level + 1);
@@ -0,0 +1,279 @@
+#include "contractor/files.hpp"
+#include "contractor/query_graph.hpp"
+#include "customizer/edge_based_graph.hpp"
+#include "customizer/files.hpp"
+#include "extractor/files.hpp"
+#include "extractor/profile_properties.hpp"
+
+#include "util/query_heap.hpp"
+#include "util/timing_util.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace benchmarks
+{
+
+// Choosen by a fair W20 dice roll (this value is completely arbitrary)
+constexpr unsigned RANDOM_SEED = 13;
+
+struct HeapData
+{
+    NodeID parent;
+};
+
+template <template <typename W, typename K> class PriorityQueue>
+using BenchQueryHeap = util::QueryHeap<NodeID,
+                                       NodeID,
+                                       EdgeWeight,
+                                       HeapData,
+                                       util::ArrayStorage<NodeID, NodeID>,
+                                       PriorityQueue>;
+
+using QueryPairs = std::vector<std::pair<NodeID, NodeID>>;
+
+QueryPairs makeQueries(const NodeID number_of_nodes, const unsigned number_of_queries)
+{
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<NodeID> node_udist(0, number_of_nodes - 1);
+    QueryPairs queries;
+    for (unsigned i = 0; i < number_of_queries; i++)
+    {
+        queries.emplace_back(node_udist(mt_rand), node_udist(mt_rand));
+    }
+    return queries;
+}
+
+// Issues the heap index lookups of all edge targets before the edges are relaxed, as the
+// routing searches do when built with ENABLE_PREFETCHING
+template <bool PREFETCH, typename HeapT, typename GraphT>
+void prefetchTargets(const HeapT &heap, const GraphT &graph, const NodeID node)
+{
+    if (PREFETCH)
+    {
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            heap.Prefetch(graph.GetTarget(edge));
+        }
+    }
+}
+
+template <bool PREFETCH, typename HeapT, typename GraphT>
+void relaxUpward(HeapT &heap, const GraphT &graph, const NodeID node, const bool forward)
+{
+    const auto weight = heap.GetKey(node);
+    prefetchTargets<PREFETCH>(heap, graph, node);
+    for (const auto edge : graph.GetAdjacentEdgeRange(node))
+    {
+        const auto &data = graph.GetEdgeData(edge);
+        if (forward ? !data.forward : !data.backward)
+            continue;
+
+        const auto to = graph.GetTarget(edge);
+        const auto to_weight = weight + data.weight;
+        if (!heap.WasInserted(to))
+        {
+            heap.Insert(to, to_weight, {node});
+        }
+        else if (to_weight < heap.GetKey(to))
+        {
+            heap.GetData(to).parent = node;
+            heap.DecreaseKey(to, to_weight);
+        }
+    }
+}
+
+// Bidirectional upward search as done by the CH one-to-one query, without stalling
+template <bool PREFETCH, typename HeapT>
+EdgeWeight chQuery(HeapT &forward_heap,
+                   HeapT &reverse_heap,
+                   const contractor::QueryGraph &graph,
+                   const NodeID source,
+                   const NodeID target)
+{
+    forward_heap.Clear();
+    reverse_heap.Clear();
+    forward_heap.Insert(source, 0, {source});
+    reverse_heap.Insert(target, 0, {target});
+
+    EdgeWeight best = INVALID_EDGE_WEIGHT;
+    while (forward_heap.Size() + reverse_heap.Size() > 0)
+    {
+        const auto forward_min = forward_heap.Empty() ? INVALID_EDGE_WEIGHT : forward_heap.MinKey();
+        const auto reverse_min = reverse_heap.Empty() ? INVALID_EDGE_WEIGHT : reverse_heap.MinKey();
+        if (std::min(forward_min, reverse_min) >= best)
+            break;
+
+        const bool forward = forward_min <= reverse_min;
+        auto &heap = forward ? forward_heap : reverse_heap;
+        auto &other_heap = forward ? reverse_heap : forward_heap;
+
+        const auto node = heap.DeleteMin();
+        if (other_heap.WasInserted(node))
+        {
+            best = std::min(best, heap.GetKey(node) + other_heap.GetKey(node));
+        }
+        relaxUpward<PREFETCH>(heap, graph, node, forward);
+    }
+    return best;
+}
+
+// Plain Dijkstra on the MLD base graph, the cell overlay is not used
+template <bool PREFETCH, typename HeapT>
+EdgeWeight mldQuery(HeapT &heap,
+                    const customizer::MultiLevelEdgeBasedGraph &graph,
+                    const std::vector<TurnPenalty> &turn_weight_penalties,
+                    const NodeID source,
+                    const NodeID target)
+{
+    heap.Clear();
+    heap.Insert(source, 0, {source});
+
+    while (!heap.Empty())
+    {
+        const auto weight = heap.MinKey();
+        const auto node = heap.DeleteMin();
+        if (node == target)
+            return weight;
+
+        prefetchTargets<PREFETCH>(heap, graph, node);
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            if (!graph.IsForwardEdge(edge))
+                continue;
+
+            const auto to = graph.GetTarget(edge);
+            const auto turn_id = graph.GetEdgeData(edge).turn_id;
+            const auto to_weight =
+                weight + graph.GetNodeWeight(node) + turn_weight_penalties[turn_id];
+            if (!heap.WasInserted(to))
+            {
+                heap.Insert(to, to_weight, {node});
+            }
+            else if (!heap.WasRemoved(to) && to_weight < heap.GetKey(to))
+            {
+                heap.GetData(to).parent = node;
+                heap.DecreaseKey(to, to_weight);
+            }
+        }
+    }
+    return INVALID_EDGE_WEIGHT;
+}
+
+template <typename QueryT>
+void benchmarkQuery(const QueryPairs &queries, const std::string &name, QueryT query)
+{
+    std::cout << "Running " << name << " with " << queries.size() << " queries: " << std::flush;
+
+    std::uint64_t checksum = 0;
+    TIMER_START(query);
+    for (const auto &q : queries)
+    {
+        checksum += query(q.first, q.second);
+    }
+    TIMER_STOP(query);
+
+    std::cout << "Took " << TIMER_SEC(query) << " seconds "
+              << "(" << TIMER_MSEC(query) << "ms"
+              << ")  ->  " << TIMER_MSEC(query) / queries.size() << " ms/query "
+              << "(checksum " << checksum << ")" << std::endl;
+}
+
+template <template <typename W, typename K> class PriorityQueue, bool PREFETCH = false>
+void benchmarkCH(const contractor::QueryGraph &graph,
+                 const QueryPairs &queries,
+                 const std::string &name)
+{
+    const auto number_of_nodes = graph.GetNumberOfNodes();
+    BenchQueryHeap<PriorityQueue> forward_heap(number_of_nodes);
+    BenchQueryHeap<PriorityQueue> reverse_heap(number_of_nodes);
+    benchmarkQuery(
+        queries, "CH queries with " + name, [&](const NodeID source, const NodeID target) {
+            return chQuery<PREFETCH>(forward_heap, reverse_heap, graph, source, target);
+        });
+}
+
+template <template <typename W, typename K> class PriorityQueue, bool PREFETCH = false>
+void benchmarkMLD(const customizer::MultiLevelEdgeBasedGraph &graph,
+                  const std::vector<TurnPenalty> &turn_weight_penalties,
+                  const QueryPairs &queries,
+                  const std::string &name)
+{
+    BenchQueryHeap<PriorityQueue> heap(graph.GetNumberOfNodes());
+    benchmarkQuery(queries,
+                   "MLD base graph queries with " + name,
+                   [&](const NodeID source, const NodeID target) {
+                       return mldQuery<PREFETCH>(
+                           heap, graph, turn_weight_penalties, source, target);
+                   });
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "./queryheap-bench file.osrm [number of queries]"
+                  << "\n";
+        return 1;
+    }
+
+    using namespace osrm;
+
+    const std::string base_path = argv[1];
+    const unsigned number_of_queries = argc > 2 ? std::stoul(argv[2]) : 1000;
+
+    extractor::ProfileProperties properties;
+    extractor::files::readProfileProperties(base_path + ".properties", properties);
+    const std::string metric_name = properties.GetWeightName();
+
+    if (boost::filesystem::exists(base_path + ".hsgr"))
+    {
+        std::unordered_map<std::string, contractor::ContractedMetric> metrics = {
+            {metric_name, {}}};
+        std::uint32_t connectivity_checksum = 0;
+        contractor::files::readGraph(base_path + ".hsgr", metrics, connectivity_checksum);
+        const auto &graph = metrics[metric_name].graph;
+
+        const auto queries = benchmarks::makeQueries(graph.GetNumberOfNodes(), number_of_queries);
+        benchmarks::benchmarkCH<util::BoostDAryHeap>(graph, queries, "boost d-ary heap");
+        benchmarks::benchmarkCH<util::FourAryHeap>(graph, queries, "4-ary heap");
+        benchmarks::benchmarkCH<util::RadixHeap>(graph, queries, "radix heap");
+        benchmarks::benchmarkCH<util::FourAryHeap, true>(
+            graph, queries, "4-ary heap and prefetching");
+    }
+
+    if (boost::filesystem::exists(base_path + ".mldgr"))
+    {
+        customizer::MultiLevelEdgeBasedGraph graph;
+        std::uint32_t connectivity_checksum = 0;
+        customizer::files::readGraph(base_path + ".mldgr", graph, connectivity_checksum);
+
+        std::vector<TurnPenalty> turn_weight_penalties;
+        extractor::files::readTurnWeightPenalty(base_path + ".turn_weight_penalties",
+                                                turn_weight_penalties);
+
+        const auto queries = benchmarks::makeQueries(graph.GetNumberOfNodes(), number_of_queries);
+        benchmarks::benchmarkMLD<util::BoostDAryHeap>(
+            graph, turn_weight_penalties, queries, "boost d-ary heap");
+        benchmarks::benchmarkMLD<util::FourAryHeap>(
+            graph, turn_weight_penalties, queries, "4-ary heap");
+        benchmarks::benchmarkMLD<util::RadixHeap>(
+            graph, turn_weight_penalties, queries, "radix heap");
+        benchmarks::benchmarkMLD<util::FourAryHeap, true>(
+            graph, turn_weight_penalties, queries, "4-ary heap and prefetching");
+    }
+
+    return 0;
+}
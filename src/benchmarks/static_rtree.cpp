@@ -73,6 +73,29 @@ void benchmark(BenchStaticRTree &rtree, unsigned num_queries)
     benchmarkQuery(queries, "raw RTree queries (10 results)", [&rtree](const util::Coordinate &q) {
         return rtree.Nearest(q, 10);
     });
+    benchmarkQuery(queries, "raw RTree queries (100 results)", [&rtree](const util::Coordinate &q) {
+        return rtree.Nearest(q, 100);
+    });
+
+    // With a filter the candidates can not be pruned by the distance of the k-th result,
+    // the difference to the raw queries is the gain of pruning.
+    const auto accept_all = [](const BenchStaticRTree::CandidateSegment &) {
+        return std::make_pair(true, true);
+    };
+    for (const std::size_t max_results : {10, 100})
+    {
+        benchmarkQuery(queries,
+                       "filtered RTree queries (" + std::to_string(max_results) + " results)",
+                       [&rtree, &accept_all, max_results](const util::Coordinate &q) {
+                           return rtree.Nearest(
+                               q,
+                               accept_all,
+                               [max_results](const std::size_t num_results,
+                                             const BenchStaticRTree::CandidateSegment &) {
+                                   return num_results >= max_results;
+                               });
+                       });
+    }
 }
 }
 }
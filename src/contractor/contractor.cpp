@@ -5,6 +5,8 @@
 #include "contractor/files.hpp"
 #include "contractor/graph_contractor.hpp"
 #include "contractor/graph_contractor_adaptors.hpp"
+#include "contractor/hub_labels.hpp"
+#include "contractor/query_graph_layout.hpp"
 
 #include "extractor/compressed_edge_container.hpp"
 #include "extractor/edge_based_graph_factory.hpp"
@@ -35,6 +37,7 @@
 #include <vector>
 
 #include <boost/assert.hpp>
+#include <boost/filesystem/operations.hpp>
 
 #include <tbb/task_scheduler_init.h>
 namespace osrm
@@ -110,6 +113,47 @@ int Contractor::Run()
     util::Log() << "Contracted graph has " << query_graph.GetNumberOfEdges() << " edges.";
     util::Log() << "Contraction took " << TIMER_SEC(contraction) << " sec";
 
+    if (config.rank_ordered_layout)
+    {
+        TIMER_START(layout);
+        reorderByRank(query_graph, edge_filters);
+        TIMER_STOP(layout);
+        util::Log() << "Reordering the contracted graph by rank took " << TIMER_SEC(layout)
+                    << " sec";
+    }
+
+    TIMER_START(shortcut_children);
+    storeShortcutChildren(query_graph, edge_filters);
+    TIMER_STOP(shortcut_children);
+    util::Log() << "Computing the children of shortcuts took " << TIMER_SEC(shortcut_children)
+                << " sec";
+
+    if (config.hub_labels)
+    {
+        TIMER_START(hub_labels);
+        std::vector<HubLabels> exclude_labels;
+        std::uint64_t number_of_entries = 0;
+        for (const auto &edge_filter : edge_filters)
+        {
+            exclude_labels.push_back(computeHubLabels(query_graph, edge_filter));
+            number_of_entries += exclude_labels.back().forward.GetNumberOfEntries() +
+                                 exclude_labels.back().backward.GetNumberOfEntries();
+        }
+        TIMER_STOP(hub_labels);
+        util::Log() << "Computing hub labels took " << TIMER_SEC(hub_labels) << " sec, "
+                    << number_of_entries << " label entries";
+
+        std::unordered_map<std::string, std::vector<HubLabels>> labels = {
+            {metric_name, std::move(exclude_labels)}};
+        files::writeHubLabels(config.GetPath(".osrm.hl"), labels, connectivity_checksum);
+    }
+    else if (boost::filesystem::exists(config.GetPath(".osrm.hl")))
+    {
+        util::Log(logWARNING) << config.GetPath(".osrm.hl").string()
+                              << " does not belong to the new contracted graph, run with "
+                                 "--hub-labels to update it";
+    }
+
     std::unordered_map<std::string, ContractedMetric> metrics = {
         {metric_name, {std::move(query_graph), std::move(edge_filters)}}};
 
@@ -0,0 +1,307 @@
+#include "contractor/hub_labels.hpp"
+
+#include "util/exception.hpp"
+#include "util/exception_utils.hpp"
+#include "util/integer_range.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <tuple>
+#include <utility>
+
+namespace osrm
+{
+namespace contractor
+{
+
+namespace
+{
+struct LabelEntry
+{
+    NodeID hub;
+    EdgeWeight weight;
+    EdgeDuration duration;
+    EdgeDistance distance;
+};
+
+// Label of one node while the labels are computed
+struct LabelBuffer
+{
+    std::vector<NodeID> hubs;
+    std::vector<EdgeWeight> weights;
+    std::vector<EdgeDuration> durations;
+    std::vector<EdgeDistance> distances;
+
+    HubLabel GetLabel() const
+    {
+        return HubLabel{
+            hubs.data(), weights.data(), durations.data(), distances.data(), hubs.size()};
+    }
+};
+
+// Groups the nodes by their distance from the top of the hierarchy. All upward neighbours of a
+// node are in an earlier group, so the labels of each group only depend on those before it.
+std::vector<std::vector<NodeID>> computeTopDownLevels(const QueryGraph &graph,
+                                                      const std::vector<bool> &edge_filter)
+{
+    const auto number_of_nodes = graph.GetNumberOfNodes();
+
+    std::vector<std::uint32_t> remaining_parents(number_of_nodes, 0);
+    std::vector<EdgeID> child_offsets(number_of_nodes + 1, 0);
+    for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+    {
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            const auto parent = graph.GetTarget(edge);
+            if (edge_filter[edge] && parent != node)
+            {
+                remaining_parents[node]++;
+                child_offsets[parent + 1]++;
+            }
+        }
+    }
+    std::partial_sum(child_offsets.begin(), child_offsets.end(), child_offsets.begin());
+
+    std::vector<NodeID> children(child_offsets.back());
+    {
+        auto insert_position = child_offsets;
+        for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+        {
+            for (const auto edge : graph.GetAdjacentEdgeRange(node))
+            {
+                const auto parent = graph.GetTarget(edge);
+                if (edge_filter[edge] && parent != node)
+                    children[insert_position[parent]++] = node;
+            }
+        }
+    }
+
+    std::vector<std::vector<NodeID>> levels(1);
+    for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+    {
+        if (remaining_parents[node] == 0)
+            levels.front().push_back(node);
+    }
+
+    std::size_t number_of_levelled_nodes = 0;
+    while (!levels.back().empty())
+    {
+        number_of_levelled_nodes += levels.back().size();
+
+        std::vector<NodeID> next_level;
+        for (const auto node : levels.back())
+        {
+            for (const auto index : util::irange(child_offsets[node], child_offsets[node + 1]))
+            {
+                const auto child = children[index];
+                if (--remaining_parents[child] == 0)
+                    next_level.push_back(child);
+            }
+        }
+        levels.push_back(std::move(next_level));
+    }
+    levels.pop_back();
+
+    if (number_of_levelled_nodes != number_of_nodes)
+    {
+        throw util::exception("Contracted graph contains a cycle, can not compute hub labels" +
+                              SOURCE_REF);
+    }
+
+    return levels;
+}
+
+// Smallest weight over any hub that is in both labels
+EdgeWeight queryWeight(const HubLabel &forward, const HubLabel &backward)
+{
+    EdgeWeight weight = INVALID_EDGE_WEIGHT;
+    intersectHubLabels(forward, backward, [&](const std::size_t lhs, const std::size_t rhs) {
+        weight = std::min(weight, forward.weights[lhs] + backward.weights[rhs]);
+    });
+    return weight;
+}
+
+// The label of a node is the union of the labels of its upward neighbours, extended by the edge
+// to them. Entries that are not shortest paths are pruned, these never are the minimum of a
+// query since the actual shortest path is covered by the top node on it.
+template <bool FORWARD>
+LabelBuffer computeLabel(const QueryGraph &graph,
+                         const std::vector<bool> &edge_filter,
+                         const std::vector<LabelBuffer> &labels,
+                         const std::vector<LabelBuffer> &opposite_labels,
+                         const NodeID node)
+{
+    std::vector<LabelEntry> entries = {{node, 0, 0, 0}};
+    for (const auto edge : graph.GetAdjacentEdgeRange(node))
+    {
+        const auto parent = graph.GetTarget(edge);
+        if (!edge_filter[edge] || parent == node ||
+            !(FORWARD ? graph.IsForwardEdge(edge) : graph.IsBackwardEdge(edge)))
+            continue;
+
+        const auto data = graph.GetEdgeData(edge);
+        const auto &parent_label = labels[parent];
+        for (const auto index : util::irange<std::size_t>(0, parent_label.hubs.size()))
+        {
+            entries.push_back({parent_label.hubs[index],
+                               parent_label.weights[index] + data.weight,
+                               parent_label.durations[index] + data.duration,
+                               parent_label.distances[index] + data.distance});
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const auto &lhs, const auto &rhs) {
+        return std::tie(lhs.hub, lhs.weight, lhs.duration) <
+               std::tie(rhs.hub, rhs.weight, rhs.duration);
+    });
+    entries.erase(std::unique(entries.begin(),
+                              entries.end(),
+                              [](const auto &lhs, const auto &rhs) { return lhs.hub == rhs.hub; }),
+                  entries.end());
+
+    LabelBuffer unpruned;
+    for (const auto &entry : entries)
+    {
+        unpruned.hubs.push_back(entry.hub);
+        unpruned.weights.push_back(entry.weight);
+        unpruned.durations.push_back(entry.duration);
+        unpruned.distances.push_back(entry.distance);
+    }
+
+    LabelBuffer label;
+    for (const auto &entry : entries)
+    {
+        if (entry.hub != node)
+        {
+            const auto hub_label = opposite_labels[entry.hub].GetLabel();
+            const auto shortest_weight = FORWARD ? queryWeight(unpruned.GetLabel(), hub_label)
+                                                 : queryWeight(hub_label, unpruned.GetLabel());
+            if (shortest_weight < entry.weight)
+                continue;
+        }
+
+        label.hubs.push_back(entry.hub);
+        label.weights.push_back(entry.weight);
+        label.durations.push_back(entry.duration);
+        label.distances.push_back(entry.distance);
+    }
+
+    return label;
+}
+
+HubLabelSet flatten(std::vector<LabelBuffer> labels)
+{
+    std::vector<std::uint64_t> offsets;
+    offsets.reserve(labels.size() + 1);
+    offsets.push_back(0);
+    for (const auto &label : labels)
+    {
+        offsets.push_back(offsets.back() + label.hubs.size());
+    }
+
+    std::vector<std::uint64_t> hub_offsets;
+    std::vector<std::uint32_t> packed_hubs;
+    std::vector<EdgeWeight> weights;
+    std::vector<EdgeDuration> durations;
+    std::vector<EdgeDistance> distances;
+    hub_offsets.reserve(labels.size() + 1);
+    weights.reserve(offsets.back());
+    durations.reserve(offsets.back());
+    distances.reserve(offsets.back());
+    for (auto &label : labels)
+    {
+        hub_offsets.push_back(packed_hubs.size());
+        encodeHubs(label.hubs.data(), label.hubs.size(), packed_hubs);
+        weights.insert(weights.end(), label.weights.begin(), label.weights.end());
+        durations.insert(durations.end(), label.durations.begin(), label.durations.end());
+        distances.insert(distances.end(), label.distances.begin(), label.distances.end());
+        label = LabelBuffer{};
+    }
+    hub_offsets.push_back(packed_hubs.size());
+    packed_hubs.shrink_to_fit();
+
+    return HubLabelSet{std::move(offsets),
+                       std::move(hub_offsets),
+                       std::move(packed_hubs),
+                       std::move(weights),
+                       std::move(durations),
+                       std::move(distances)};
+}
+}
+
+void encodeHubs(const NodeID *hubs, const std::size_t size, std::vector<std::uint32_t> &words)
+{
+    for (std::size_t begin = 0; begin < size; begin += HUB_BLOCK_SIZE)
+    {
+        const auto end = std::min(begin + HUB_BLOCK_SIZE, size);
+
+        std::uint32_t max_gap = 0;
+        for (auto index = begin + 1; index < end; ++index)
+        {
+            BOOST_ASSERT(hubs[index - 1] < hubs[index]);
+            max_gap = std::max<std::uint32_t>(max_gap, hubs[index] - hubs[index - 1] - 1);
+        }
+        std::uint32_t width = 0;
+        while (width < 32 && (max_gap >> width) != 0)
+            ++width;
+
+        words.push_back(hubs[begin]);
+        words.push_back(width);
+
+        std::uint64_t buffer = 0;
+        std::uint32_t buffered_bits = 0;
+        for (auto index = begin + 1; index < end; ++index)
+        {
+            buffer |= std::uint64_t{hubs[index] - hubs[index - 1] - 1} << buffered_bits;
+            buffered_bits += width;
+            if (buffered_bits >= 32)
+            {
+                words.push_back(static_cast<std::uint32_t>(buffer));
+                buffer >>= 32;
+                buffered_bits -= 32;
+            }
+        }
+        if (buffered_bits > 0)
+            words.push_back(static_cast<std::uint32_t>(buffer));
+    }
+}
+
+HubLabels computeHubLabels(const QueryGraph &graph, const std::vector<bool> &edge_filter)
+{
+    BOOST_ASSERT(edge_filter.size() == graph.GetNumberOfEdges());
+
+    std::vector<LabelBuffer> forward_labels(graph.GetNumberOfNodes());
+    std::vector<LabelBuffer> backward_labels(graph.GetNumberOfNodes());
+
+    for (const auto &level : computeTopDownLevels(graph, edge_filter))
+    {
+        // forward and backward labels of a level only depend on labels of earlier levels
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, level.size()), [&](const auto &range) {
+            for (auto index = range.begin(); index != range.end(); ++index)
+            {
+                const auto node = level[index];
+                forward_labels[node] = computeLabel<true>(
+                    graph, edge_filter, forward_labels, backward_labels, node);
+            }
+        });
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, level.size()), [&](const auto &range) {
+            for (auto index = range.begin(); index != range.end(); ++index)
+            {
+                const auto node = level[index];
+                backward_labels[node] = computeLabel<false>(
+                    graph, edge_filter, backward_labels, forward_labels, node);
+            }
+        });
+    }
+
+    return HubLabels{flatten(std::move(forward_labels)), flatten(std::move(backward_labels))};
+}
+
+} // namespace contractor
+} // namespace osrm
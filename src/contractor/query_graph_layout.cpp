@@ -0,0 +1,202 @@
+#include "contractor/query_graph_layout.hpp"
+
+#include "util/integer_range.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+
+namespace osrm
+{
+namespace contractor
+{
+
+std::vector<NodeID> computeRankOrder(const QueryGraph &graph)
+{
+    const auto number_of_nodes = graph.GetNumberOfNodes();
+
+    // Edges are stored at the lower node and point upwards
+    std::vector<std::uint32_t> in_degree(number_of_nodes, 0);
+    for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+    {
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            const auto to = graph.GetTarget(edge);
+            if (to != node)
+                in_degree[to]++;
+        }
+    }
+
+    std::vector<NodeID> queue;
+    queue.reserve(number_of_nodes);
+    for (const auto node : util::irange<NodeID>(0, number_of_nodes))
+    {
+        if (in_degree[node] == 0)
+            queue.push_back(node);
+    }
+
+    std::vector<std::uint32_t> level(number_of_nodes, 0);
+    for (std::size_t index = 0; index < queue.size(); ++index)
+    {
+        const auto node = queue[index];
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            const auto to = graph.GetTarget(edge);
+            if (to == node)
+                continue;
+
+            level[to] = std::max(level[to], level[node] + 1);
+            if (--in_degree[to] == 0)
+                queue.push_back(to);
+        }
+    }
+    // Graphs with exclude flags merge the hierarchies of several contractions which can
+    // contain cycles. Nodes on them keep the level reached so far, which only costs locality.
+
+    std::vector<NodeID> order(number_of_nodes);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&level](const NodeID lhs, const NodeID rhs) {
+        return level[lhs] > level[rhs];
+    });
+
+    return order;
+}
+
+void reorderByRank(QueryGraph &graph, std::vector<std::vector<bool>> &edge_filters)
+{
+    const auto old_to_new_edge = graph.Reorder(computeRankOrder(graph));
+
+    for (auto &filter : edge_filters)
+    {
+        BOOST_ASSERT(filter.size() == old_to_new_edge.size());
+        std::vector<bool> reordered_filter(filter.size());
+        for (const auto edge : util::irange<EdgeID>(0, filter.size()))
+        {
+            reordered_filter[old_to_new_edge[edge]] = filter[edge];
+        }
+        filter = std::move(reordered_filter);
+    }
+}
+
+namespace
+{
+// Same as the edge lookup used to unpack paths: the smallest edge from -> to that can be used in
+// forward direction, or otherwise the smallest edge to -> from usable in backward direction.
+EdgeID findPathEdge(const QueryGraph &graph,
+                    const std::vector<bool> &edge_filter,
+                    const NodeID from,
+                    const NodeID to)
+{
+    const auto find_smallest = [&](const NodeID source, const NodeID target, const bool forward) {
+        EdgeID smallest_edge = SPECIAL_EDGEID;
+        EdgeWeight smallest_weight = INVALID_EDGE_WEIGHT;
+        for (const auto edge : graph.GetAdjacentEdgeRange(source))
+        {
+            if (edge_filter[edge] && graph.GetTarget(edge) == target &&
+                graph.GetEdgeWeight(edge) < smallest_weight &&
+                (forward ? graph.IsForwardEdge(edge) : graph.IsBackwardEdge(edge)))
+            {
+                smallest_edge = edge;
+                smallest_weight = graph.GetEdgeWeight(edge);
+            }
+        }
+        return smallest_edge;
+    };
+
+    const auto edge = find_smallest(from, to, true);
+    return edge != SPECIAL_EDGEID ? edge : find_smallest(to, from, false);
+}
+
+QueryGraph::ShortcutChildrenEntry getShortcutChildren(const QueryGraph &graph,
+                                                      const std::vector<std::vector<bool>> &filters,
+                                                      const NodeID source,
+                                                      const EdgeID shortcut)
+{
+    const QueryGraph::ShortcutChildrenEntry invalid{query_graph_details::INVALID_CHILD_OFFSET,
+                                                    query_graph_details::INVALID_CHILD_OFFSET};
+
+    const auto target = graph.GetTarget(shortcut);
+    const auto middle = graph.GetEdgeData(shortcut).turn_id;
+    if (source == target)
+        return invalid;
+
+    const auto middle_begin = graph.BeginEdges(middle);
+    const auto middle_end = graph.EndEdges(middle);
+    const auto to_offset = [&](const EdgeID edge) -> std::uint32_t {
+        if (edge < middle_begin || edge >= middle_end)
+            return query_graph_details::INVALID_CHILD_OFFSET;
+        return std::min<std::uint32_t>(edge - middle_begin,
+                                       query_graph_details::INVALID_CHILD_OFFSET);
+    };
+
+    bool first = true;
+    QueryGraph::ShortcutChildrenEntry children = invalid;
+    const auto merge = [&](const EdgeID source_child, const EdgeID target_child) {
+        const auto source_offset = to_offset(source_child);
+        const auto target_offset = to_offset(target_child);
+        if (source_offset == query_graph_details::INVALID_CHILD_OFFSET ||
+            target_offset == query_graph_details::INVALID_CHILD_OFFSET)
+            return false;
+
+        if (first)
+        {
+            children = {static_cast<std::uint16_t>(source_offset),
+                        static_cast<std::uint16_t>(target_offset)};
+            first = false;
+            return true;
+        }
+        return children.source_child == source_offset && children.target_child == target_offset;
+    };
+
+    for (const auto &filter : filters)
+    {
+        if (!filter[shortcut])
+            continue;
+
+        // path source -> middle -> target found by the forward search
+        if (graph.IsForwardEdge(shortcut) && !merge(findPathEdge(graph, filter, source, middle),
+                                                     findPathEdge(graph, filter, middle, target)))
+            return invalid;
+
+        // path target -> middle -> source found by the backward search
+        if (graph.IsBackwardEdge(shortcut) &&
+            !merge(findPathEdge(graph, filter, middle, source),
+                   findPathEdge(graph, filter, target, middle)))
+            return invalid;
+    }
+
+    return children;
+}
+}
+
+void storeShortcutChildren(QueryGraph &graph, const std::vector<std::vector<bool>> &edge_filters)
+{
+    std::vector<QueryGraph::ShortcutChildrenEntry> shortcut_children(
+        graph.GetNumberOfEdges(),
+        {query_graph_details::INVALID_CHILD_OFFSET, query_graph_details::INVALID_CHILD_OFFSET});
+
+    tbb::parallel_for(tbb::blocked_range<NodeID>(0, graph.GetNumberOfNodes()),
+                      [&](const auto &range) {
+                          for (auto node = range.begin(); node != range.end(); ++node)
+                          {
+                              for (const auto edge : graph.GetAdjacentEdgeRange(node))
+                              {
+                                  if (graph.GetEdgeData(edge).shortcut)
+                                  {
+                                      shortcut_children[edge] = getShortcutChildren(
+                                          graph, edge_filters, node, edge);
+                                  }
+                              }
+                          }
+                      });
+
+    graph.SetShortcutChildren(std::move(shortcut_children));
+}
+
+} // namespace contractor
+} // namespace osrm
@@ -10,12 +10,58 @@
 
 #include <boost/assert.hpp>
 
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace osrm
 {
 namespace engine
 {
 namespace datafacade
 {
+namespace
+{
+void preloadMappedFile(const boost::filesystem::path &path,
+                       const boost::iostreams::mapped_file &mapped_file,
+                       const storage::StorageConfig::PreloadPolicy policy)
+{
+    using PreloadPolicy = storage::StorageConfig::PreloadPolicy;
+    if (policy == PreloadPolicy::None || mapped_file.size() == 0)
+        return;
+
+#ifdef __linux__
+    if (-1 == madvise(mapped_file.data(), mapped_file.size(), MADV_WILLNEED))
+    {
+        util::Log(logWARNING) << "Could not advise the kernel to read ahead " << path;
+    }
+
+    if (policy == PreloadPolicy::Populate)
+    {
+        // boost maps the file without MAP_POPULATE, reading one byte per page has the same effect
+        const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        const volatile char *data = mapped_file.const_data();
+        char checksum = 0;
+        for (std::size_t offset = 0; offset < mapped_file.size(); offset += page_size)
+        {
+            checksum ^= data[offset];
+        }
+        (void)checksum;
+    }
+    else if (policy == PreloadPolicy::Lock)
+    {
+        // faults in all pages, needs a RLIMIT_MEMLOCK of at least the file size
+        if (-1 == mlock(mapped_file.const_data(), mapped_file.size()))
+        {
+            util::Log(logWARNING) << "Could not lock " << path << " in memory";
+        }
+    }
+#else
+    util::Log(logWARNING) << "Preloading " << path << " is not supported on this platform";
+#endif
+}
+}
 
 MMapMemoryAllocator::MMapMemoryAllocator(const storage::StorageConfig &config)
 {
@@ -42,6 +88,21 @@ MMapMemoryAllocator::MMapMemoryAllocator(const storage::StorageConfig &config)
         allocated_regions.push_back({&(rtree_filename[0]), std::move(fake_layout)});
     }
 
+    // The leaves of the R-tree are the whole .fileIndex file, which is not a tar file
+    {
+        std::unique_ptr<storage::BaseDataLayout> leaves_layout =
+            std::make_unique<storage::TarDataLayout>();
+        storage.PopulateLayoutWithRTreeLeaves(*leaves_layout);
+
+        const auto file_index_path = config.GetPath(".osrm.fileIndex");
+        boost::iostreams::mapped_file mapped_leaves_file;
+        util::mmapFile<char>(file_index_path, mapped_leaves_file);
+        preloadMappedFile(file_index_path, mapped_leaves_file, config.rtree_leaves_preload);
+
+        allocated_regions.push_back({mapped_leaves_file.data(), std::move(leaves_layout)});
+        mapped_memory_files.push_back(std::move(mapped_leaves_file));
+    }
+
     auto files = storage.GetStaticFiles();
     auto updatable_files = storage.GetUpdatableFiles();
     files.insert(files.end(), updatable_files.begin(), updatable_files.end());
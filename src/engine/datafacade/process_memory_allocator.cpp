@@ -20,6 +20,10 @@ ProcessMemoryAllocator::ProcessMemoryAllocator(const storage::StorageConfig &con
     std::unique_ptr<storage::BaseDataLayout> layout =
         std::make_unique<storage::ContiguousDataLayout>();
     storage.PopulateLayoutWithRTree(*layout);
+    if (config.load_rtree_leaves)
+    {
+        storage.PopulateLayoutWithRTreeLeaves(*layout);
+    }
     storage.PopulateLayout(*layout, static_files);
     storage.PopulateLayout(*layout, updatable_files);
 
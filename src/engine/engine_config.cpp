@@ -1,5 +1,12 @@
 #include "engine/engine_config.hpp"
 
+#include "util/exception.hpp"
+#include "util/exception_utils.hpp"
+
+#include <boost/algorithm/string/case_conv.hpp>
+
+#include <istream>
+
 namespace osrm
 {
 namespace engine
@@ -21,11 +28,35 @@ bool EngineConfig::IsValid() const
                               unlimited_or_more_than(max_locations_trip, 2) &&
                               unlimited_or_more_than(max_locations_viaroute, 2) &&
                               unlimited_or_more_than(max_results_nearest, 0) &&
+                              unlimited_or_more_than(max_duration_isochrone, 0) &&
+                              max_alternatives_search_time >= -1 &&
                               max_alternatives >= 0;
 
+    // only leaves mapped by the engine itself can be preloaded
+    using PreloadPolicy = storage::StorageConfig::PreloadPolicy;
+    const bool preload_valid =
+        use_mmap || storage_config.rtree_leaves_preload == PreloadPolicy::None;
+
     return ((use_shared_memory && all_path_are_empty) || (use_mmap && storage_config.IsValid()) ||
             storage_config.IsValid()) &&
-           limits_valid;
+           limits_valid && preload_valid;
+}
+
+std::istream &operator>>(std::istream &in, EngineConfig::Algorithm &algorithm)
+{
+    std::string token;
+    in >> token;
+    boost::to_lower(token);
+
+    if (token == "ch" || token == "corech")
+        algorithm = EngineConfig::Algorithm::CH;
+    else if (token == "mld")
+        algorithm = EngineConfig::Algorithm::MLD;
+    else if (token == "hl")
+        algorithm = EngineConfig::Algorithm::HL;
+    else
+        throw util::RuntimeError(token, ErrorCode::UnknownAlgorithm, SOURCE_REF);
+    return in;
 }
 }
 }
@@ -0,0 +1,87 @@
+#include "engine/plugins/isochrone.hpp"
+
+#include "engine/api/isochrone_api.hpp"
+#include "engine/api/isochrone_parameters.hpp"
+#include "engine/routing_algorithms/isochrone.hpp"
+#include "util/json_container.hpp"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <boost/assert.hpp>
+
+namespace osrm
+{
+namespace engine
+{
+namespace plugins
+{
+
+IsochronePlugin::IsochronePlugin(const double max_duration_isochrone)
+    : max_duration_isochrone(max_duration_isochrone)
+{
+}
+
+Status IsochronePlugin::HandleRequest(const RoutingAlgorithmsInterface &algorithms,
+                                      const api::IsochroneParameters &params,
+                                      util::json::Object &result) const
+{
+    if (!algorithms.HasOneToAllSearch())
+    {
+        return Error("NotImplemented",
+                     "One to all search is not implemented for the chosen search algorithm.",
+                     result);
+    }
+
+    if (!CheckAllCoordinates(params.coordinates))
+    {
+        return Error("InvalidOptions", "Coordinates are invalid", result);
+    }
+
+    if (params.coordinates.size() != 1)
+    {
+        return Error("InvalidOptions", "Only one input coordinate is supported", result);
+    }
+
+    if (!params.IsValid())
+    {
+        return Error(
+            "InvalidOptions", "Contours need to be positive and in increasing order", result);
+    }
+
+    const auto max_contour = params.contours.back();
+    if (max_duration_isochrone > 0 && max_contour > max_duration_isochrone)
+    {
+        return Error("TooBig",
+                     "Contour " + std::to_string(max_contour) +
+                         " is higher than current maximum (" +
+                         std::to_string(max_duration_isochrone) + ")",
+                     result);
+    }
+
+    if (!CheckAlgorithms(params, algorithms, result))
+        return Status::Error;
+
+    const auto &facade = algorithms.GetFacade();
+    auto phantom_nodes = GetPhantomNodes(facade, params);
+
+    if (phantom_nodes.size() != params.coordinates.size())
+    {
+        return Error("NoSegment", "Could not find a matching segment for coordinate", result);
+    }
+
+    const auto source_phantom = SnapPhantomNodes(phantom_nodes).front();
+
+    // durations are stored in deciseconds
+    const auto duration_limit = static_cast<EdgeDuration>(std::ceil(max_contour * 10.));
+    const auto reachable_nodes = algorithms.OneToAllSearch(source_phantom, duration_limit);
+
+    api::IsochroneAPI isochrone_api{facade, params};
+    isochrone_api.MakeResponse(source_phantom, reachable_nodes, result);
+
+    return Status::Ok;
+}
+}
+}
+}
@@ -17,6 +17,8 @@
 #include <functional>
 #include <iterator>
 #include <memory>
+#include <mutex>
+#include <numeric>
 #include <set>
 #include <string>
 #include <vector>
@@ -110,9 +112,45 @@ void filterCandidates(const std::vector<util::Coordinate> &coordinates,
     }
 }
 
-Status MatchPlugin::HandleRequest(const RoutingAlgorithmsInterface &algorithms,
-                                  const api::MatchParameters &parameters,
-                                  util::json::Object &json_result) const
+// Routes between the matched nodes of every sub matching, the sub matchings are independent
+// of each other and routed in parallel
+std::vector<InternalRouteResult>
+routeSubMatchings(const RoutingAlgorithmsInterface &algorithms,
+                  const std::vector<map_matching::SubMatching> &sub_matchings)
+{
+    // FIXME we only run this to obtain the geometry
+    // The clean way would be to get this directly from the map matching plugin
+    std::vector<std::vector<PhantomNodes>> segment_end_coordinates(sub_matchings.size());
+    for (auto index : util::irange<std::size_t>(0UL, sub_matchings.size()))
+    {
+        const auto &sub_matching = sub_matchings[index];
+        BOOST_ASSERT(sub_matching.nodes.size() > 1);
+
+        PhantomNodes current_phantom_node_pair;
+        for (unsigned i = 0; i < sub_matching.nodes.size() - 1; ++i)
+        {
+            current_phantom_node_pair.source_phantom = sub_matching.nodes[i];
+            current_phantom_node_pair.target_phantom = sub_matching.nodes[i + 1];
+            BOOST_ASSERT(current_phantom_node_pair.source_phantom.IsValid());
+            BOOST_ASSERT(current_phantom_node_pair.target_phantom.IsValid());
+            segment_end_coordinates[index].emplace_back(current_phantom_node_pair);
+        }
+    }
+    // force uturns to be on
+    // we split the phantom nodes anyway and only have bi-directional phantom nodes for
+    // possible uturns
+    auto sub_routes = algorithms.ShortestPathSearches(segment_end_coordinates, {false});
+    BOOST_ASSERT(std::all_of(sub_routes.begin(), sub_routes.end(), [](const auto &sub_route) {
+        return sub_route.shortest_path_weight != INVALID_EDGE_WEIGHT;
+    }));
+    return sub_routes;
+}
+
+Status MatchPlugin::SnapTrace(const RoutingAlgorithmsInterface &algorithms,
+                              const api::MatchParameters &parameters,
+                              api::tidy::Result &tidied,
+                              CandidateLists &candidates_lists,
+                              util::json::Object &json_result) const
 {
     if (!algorithms.HasMapMatching())
     {
@@ -128,6 +166,11 @@ Status MatchPlugin::HandleRequest(const RoutingAlgorithmsInterface &algorithms,
 
     BOOST_ASSERT(parameters.IsValid());
 
+    if (!parameters.session.empty() && !matching_sessions)
+    {
+        return Error("InvalidOptions", "Map matching sessions are not enabled.", json_result);
+    }
+
     // enforce maximum number of locations for performance reasons
     if (max_locations_map_matching > 0 &&
         static_cast<int>(parameters.coordinates.size()) > max_locations_map_matching)
@@ -162,8 +205,6 @@ Status MatchPlugin::HandleRequest(const RoutingAlgorithmsInterface &algorithms,
             "InvalidValue", "Timestamps need to be monotonically increasing.", json_result);
     }
 
-    SubMatchingList sub_matchings;
-    api::tidy::Result tidied;
     if (parameters.tidy)
     {
         // Transparently tidy match parameters, do map matching on tidied parameters.
@@ -213,10 +254,20 @@ Status MatchPlugin::HandleRequest(const RoutingAlgorithmsInterface &algorithms,
                        });
     }
 
-    auto candidates_lists =
-        GetPhantomNodesInRange(facade, tidied.parameters, search_radiuses, true);
+    candidates_lists = GetPhantomNodesInRange(facade, tidied.parameters, search_radiuses, true);
 
     filterCandidates(tidied.parameters.coordinates, candidates_lists);
+
+    return Status::Ok;
+}
+
+Status MatchPlugin::MatchTrace(const RoutingAlgorithmsInterface &algorithms,
+                               const api::MatchParameters &parameters,
+                               const api::tidy::Result &tidied,
+                               const CandidateLists &candidates_lists,
+                               SubMatchingList &sub_matchings,
+                               util::json::Object &json_result) const
+{
     if (std::all_of(candidates_lists.begin(),
                     candidates_lists.end(),
                     [](const std::vector<PhantomNodeWithDistance> &candidates) {
@@ -264,33 +315,45 @@ Status MatchPlugin::HandleRequest(const RoutingAlgorithmsInterface &algorithms,
                 "NoMatch", "Requested waypoint parameter could not be matched.", json_result);
         }
     }
+
+    return Status::Ok;
+}
+
+Status MatchPlugin::HandleRequest(const RoutingAlgorithmsInterface &algorithms,
+                                  const api::MatchParameters &parameters,
+                                  util::json::Object &json_result) const
+{
+    api::tidy::Result tidied;
+    CandidateLists candidates_lists;
+    const auto snap_status =
+        SnapTrace(algorithms, parameters, tidied, candidates_lists, json_result);
+    if (snap_status != Status::Ok)
+    {
+        return snap_status;
+    }
+
+    // points of a live trace that can not be matched are skipped, the session continues
+    if (!parameters.session.empty())
+    {
+        return HandleSessionRequest(algorithms, parameters, tidied, candidates_lists, json_result);
+    }
+
+    SubMatchingList sub_matchings;
+    const auto match_status =
+        MatchTrace(algorithms, parameters, tidied, candidates_lists, sub_matchings, json_result);
+    if (match_status != Status::Ok)
+    {
+        return match_status;
+    }
+
     // we haven't errored yet, only allow leg collapsing if it was originally requested
     BOOST_ASSERT(parameters.waypoints.empty() || sub_matchings.size() == 1);
     const auto collapse_legs = !parameters.waypoints.empty();
 
     // each sub_route will correspond to a MatchObject
-    std::vector<InternalRouteResult> sub_routes(sub_matchings.size());
+    auto sub_routes = routeSubMatchings(algorithms, sub_matchings);
     for (auto index : util::irange<std::size_t>(0UL, sub_matchings.size()))
     {
-        BOOST_ASSERT(sub_matchings[index].nodes.size() > 1);
-
-        // FIXME we only run this to obtain the geometry
-        // The clean way would be to get this directly from the map matching plugin
-        PhantomNodes current_phantom_node_pair;
-        for (unsigned i = 0; i < sub_matchings[index].nodes.size() - 1; ++i)
-        {
-            current_phantom_node_pair.source_phantom = sub_matchings[index].nodes[i];
-            current_phantom_node_pair.target_phantom = sub_matchings[index].nodes[i + 1];
-            BOOST_ASSERT(current_phantom_node_pair.source_phantom.IsValid());
-            BOOST_ASSERT(current_phantom_node_pair.target_phantom.IsValid());
-            sub_routes[index].segment_end_coordinates.emplace_back(current_phantom_node_pair);
-        }
-        // force uturns to be on
-        // we split the phantom nodes anyway and only have bi-directional phantom nodes for
-        // possible uturns
-        sub_routes[index] =
-            algorithms.ShortestPathSearch(sub_routes[index].segment_end_coordinates, {false});
-        BOOST_ASSERT(sub_routes[index].shortest_path_weight != INVALID_EDGE_WEIGHT);
         if (collapse_legs)
         {
             std::vector<bool> waypoint_legs;
@@ -312,6 +375,115 @@ Status MatchPlugin::HandleRequest(const RoutingAlgorithmsInterface &algorithms,
         }
     }
 
+    api::MatchAPI match_api{algorithms.GetFacade(), parameters, tidied};
+    match_api.MakeResponse(sub_matchings, sub_routes, json_result);
+
+    return Status::Ok;
+}
+
+Status MatchPlugin::HandleBatchTrace(const RoutingAlgorithmsInterface &algorithms,
+                                     const api::MatchParameters &parameters,
+                                     api::MatchedTrace &matched_trace) const
+{
+    matched_trace = api::MatchedTrace{};
+
+    // traces of a batch are matched as a whole, the error messages are dropped
+    util::json::Object json_result;
+    if (!parameters.IsValid() || !parameters.session.empty())
+    {
+        return Status::Error;
+    }
+
+    api::tidy::Result tidied;
+    CandidateLists candidates_lists;
+    const auto snap_status =
+        SnapTrace(algorithms, parameters, tidied, candidates_lists, json_result);
+    if (snap_status != Status::Ok)
+    {
+        return snap_status;
+    }
+
+    SubMatchingList sub_matchings;
+    const auto match_status =
+        MatchTrace(algorithms, parameters, tidied, candidates_lists, sub_matchings, json_result);
+    if (match_status != Status::Ok)
+    {
+        return match_status;
+    }
+
+    const auto number_of_points = std::accumulate(
+        sub_matchings.begin(),
+        sub_matchings.end(),
+        std::size_t{0},
+        [](const std::size_t sum, const SubMatching &sub_matching) {
+            return sum + sub_matching.nodes.size();
+        });
+    matched_trace.confidences.reserve(sub_matchings.size());
+    matched_trace.sub_matching_offsets.reserve(sub_matchings.size() + 1);
+    matched_trace.indices.reserve(number_of_points);
+    matched_trace.nodes.reserve(number_of_points);
+    matched_trace.locations.reserve(number_of_points);
+
+    matched_trace.sub_matching_offsets.push_back(0);
+    for (const auto &sub_matching : sub_matchings)
+    {
+        matched_trace.confidences.push_back(sub_matching.confidence);
+        for (const auto index : util::irange<std::size_t>(0UL, sub_matching.nodes.size()))
+        {
+            const auto &phantom = sub_matching.nodes[index];
+            matched_trace.indices.push_back(tidied.tidied_to_original[sub_matching.indices[index]]);
+            // candidates are split by direction unless a u-turn is possible at the point
+            matched_trace.nodes.push_back(phantom.forward_segment_id.enabled
+                                              ? phantom.forward_segment_id.id
+                                              : phantom.reverse_segment_id.id);
+            matched_trace.locations.push_back(phantom.location);
+        }
+        matched_trace.sub_matching_offsets.push_back(matched_trace.indices.size());
+    }
+
+    return Status::Ok;
+}
+
+Status MatchPlugin::HandleSessionRequest(const RoutingAlgorithmsInterface &algorithms,
+                                         const api::MatchParameters &parameters,
+                                         const api::tidy::Result &tidied,
+                                         const CandidateLists &candidates_lists,
+                                         util::json::Object &json_result) const
+{
+    BOOST_ASSERT(matching_sessions);
+    BOOST_ASSERT(!parameters.tidy && parameters.waypoints.empty());
+
+    const auto &facade = algorithms.GetFacade();
+
+    const auto session = matching_sessions->Get(parameters.session);
+    std::lock_guard<std::mutex> lock(session->mutex);
+
+    auto &frontier = session->frontier;
+    // candidates of other datasets or exclude classes can not be extended
+    if (session->facade_generation != facade.GetGeneration())
+    {
+        frontier.Clear();
+        session->facade_generation = facade.GetGeneration();
+    }
+
+    if (frontier.timestamp && !tidied.parameters.timestamps.empty() &&
+        tidied.parameters.timestamps.front() < *frontier.timestamp)
+    {
+        return Error(
+            "InvalidValue", "Timestamps need to be monotonically increasing.", json_result);
+    }
+
+    const auto sub_matchings =
+        algorithms.StreamingMapMatching(frontier,
+                                        candidates_lists,
+                                        tidied.parameters.coordinates,
+                                        tidied.parameters.timestamps,
+                                        tidied.parameters.radiuses,
+                                        parameters.gaps == api::MatchParameters::GapsType::Split);
+
+    // the first matching starts at the last point matched by the previous requests
+    const auto sub_routes = routeSubMatchings(algorithms, sub_matchings);
+
     api::MatchAPI match_api{facade, parameters, tidied};
     match_api.MakeResponse(sub_matchings, sub_routes, json_result);
 
@@ -24,8 +24,9 @@ namespace engine
 namespace plugins
 {
 
-TablePlugin::TablePlugin(const int max_locations_distance_table)
-    : max_locations_distance_table(max_locations_distance_table)
+TablePlugin::TablePlugin(const int max_locations_distance_table,
+                         PhantomNodeCache *phantom_node_cache)
+    : BasePlugin(phantom_node_cache), max_locations_distance_table(max_locations_distance_table)
 {
 }
 
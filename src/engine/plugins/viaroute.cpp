@@ -10,6 +10,7 @@
 #include <cstdlib>
 
 #include <algorithm>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
@@ -21,8 +22,13 @@ namespace engine
 namespace plugins
 {
 
-ViaRoutePlugin::ViaRoutePlugin(int max_locations_viaroute, int max_alternatives)
-    : max_locations_viaroute(max_locations_viaroute), max_alternatives(max_alternatives)
+ViaRoutePlugin::ViaRoutePlugin(int max_locations_viaroute,
+                               int max_alternatives,
+                               int max_alternatives_search_time,
+                               PhantomNodeCache *phantom_node_cache)
+    : BasePlugin(phantom_node_cache), max_locations_viaroute(max_locations_viaroute),
+      max_alternatives(max_alternatives),
+      max_alternatives_search_time(max_alternatives_search_time)
 {
 }
 
@@ -112,11 +118,18 @@ Status ViaRoutePlugin::HandleRequest(const RoutingAlgorithmsInterface &algorithm
     // https://github.com/Project-OSRM/osrm-backend/issues/3905
     if (1 == start_end_nodes.size() && algorithms.HasAlternativePathSearch() && wants_alternatives)
     {
-        routes = algorithms.AlternativePathSearch(start_end_nodes.front(), number_of_alternatives);
+        const auto deadline =
+            max_alternatives_search_time < 0
+                ? std::chrono::steady_clock::time_point::max()
+                : std::chrono::steady_clock::now() +
+                      std::chrono::milliseconds(max_alternatives_search_time);
+        routes = algorithms.AlternativePathSearch(
+            start_end_nodes.front(), number_of_alternatives, deadline);
     }
     else if (1 == start_end_nodes.size() && algorithms.HasDirectShortestPathSearch())
     {
-        routes = algorithms.DirectShortestPathSearch(start_end_nodes.front());
+        routes = algorithms.DirectShortestPathSearch(start_end_nodes.front(),
+                                                     route_api.NeedsUnpackedPath());
     }
     else
     {
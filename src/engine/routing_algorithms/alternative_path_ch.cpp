@@ -4,8 +4,14 @@
 #include "util/integer_range.hpp"
 
 #include <boost/assert.hpp>
+#include <boost/optional.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iterator>
 #include <memory>
 #include <unordered_set>
@@ -152,19 +158,20 @@ void retrievePackedAlternatePath(const QueryHeap &forward_heap1,
 // TODO: reorder parameters
 // compute and unpack <s,..,v> and <v,..,t> by exploring search spaces
 // from v and intersecting against queues. only half-searches have to be
-// done at this stage
+// done at this stage. the existing queues are only read, so they can be
+// shared by several working data instances searching in parallel
 void computeWeightAndSharingOfViaPath(SearchEngineData<Algorithm> &engine_working_data,
                                       const DataFacade<Algorithm> &facade,
+                                      QueryHeap &existing_forward_heap,
+                                      QueryHeap &existing_reverse_heap,
                                       const NodeID via_node,
                                       EdgeWeight *real_weight_of_via_path,
                                       EdgeWeight *sharing_of_via_path,
                                       const std::vector<NodeID> &packed_shortest_path,
                                       const EdgeWeight min_edge_offset)
 {
-    engine_working_data.InitializeOrClearSecondThreadLocalStorage(facade.GetNumberOfNodes());
+    engine_working_data.InitializeOrClearSecondHeaps(facade.GetNumberOfNodes());
 
-    auto &existing_forward_heap = *engine_working_data.forward_heap_1;
-    auto &existing_reverse_heap = *engine_working_data.reverse_heap_1;
     auto &new_forward_heap = *engine_working_data.forward_heap_2;
     auto &new_reverse_heap = *engine_working_data.reverse_heap_2;
 
@@ -521,7 +528,7 @@ bool viaNodeCandidatePassesTTest(SearchEngineData<Algorithm> &engine_working_dat
 
     t_test_path_weight += unpacked_until_weight;
     // Run actual T-Test query and compare if weight equal.
-    engine_working_data.InitializeOrClearThirdThreadLocalStorage(facade.GetNumberOfNodes());
+    engine_working_data.InitializeOrClearThirdHeaps(facade.GetNumberOfNodes());
 
     QueryHeap &forward_heap3 = *engine_working_data.forward_heap_3;
     QueryHeap &reverse_heap3 = *engine_working_data.reverse_heap_3;
@@ -560,10 +567,13 @@ bool viaNodeCandidatePassesTTest(SearchEngineData<Algorithm> &engine_working_dat
 }
 } // anon. namespace
 
-InternalManyRoutesResult alternativePathSearch(SearchEngineData<Algorithm> &engine_working_data,
-                                               const DataFacade<Algorithm> &facade,
-                                               const PhantomNodes &phantom_node_pair,
-                                               unsigned /*number_of_alternatives*/)
+InternalManyRoutesResult
+alternativePathSearch(SearchEngineData<Algorithm> &engine_working_data,
+                      const DataFacade<Algorithm> &facade,
+                      const PhantomNodes &phantom_node_pair,
+                      unsigned /*number_of_alternatives*/,
+                      const std::vector<SearchEngineData<Algorithm> *> &helper_contexts,
+                      const std::chrono::steady_clock::time_point deadline)
 {
     InternalRouteResult primary_route;
     InternalRouteResult secondary_route;
@@ -577,9 +587,9 @@ InternalManyRoutesResult alternativePathSearch(SearchEngineData<Algorithm> &engi
     std::vector<SearchSpaceEdge> reverse_search_space;
 
     // Init queues, semi-expensive because access to TSS invokes a sys-call
-    engine_working_data.InitializeOrClearFirstThreadLocalStorage(facade.GetNumberOfNodes());
-    engine_working_data.InitializeOrClearSecondThreadLocalStorage(facade.GetNumberOfNodes());
-    engine_working_data.InitializeOrClearThirdThreadLocalStorage(facade.GetNumberOfNodes());
+    engine_working_data.InitializeOrClearFirstHeaps(facade.GetNumberOfNodes());
+    engine_working_data.InitializeOrClearSecondHeaps(facade.GetNumberOfNodes());
+    engine_working_data.InitializeOrClearThirdHeaps(facade.GetNumberOfNodes());
 
     auto &forward_heap1 = *engine_working_data.forward_heap_1;
     auto &reverse_heap1 = *engine_working_data.reverse_heap_1;
@@ -745,26 +755,56 @@ InternalManyRoutesResult alternativePathSearch(SearchEngineData<Algorithm> &engi
         packed_shortest_path.insert(
             packed_shortest_path.end(), packed_reverse_path.begin(), packed_reverse_path.end());
     }
-    std::vector<RankedCandidateNode> ranked_candidates_list;
 
-    // prioritizing via nodes for deep inspection
-    for (const NodeID node : preselected_node_list)
-    {
-        EdgeWeight weight_of_via_path = 0, sharing_of_via_path = 0;
-        computeWeightAndSharingOfViaPath(engine_working_data,
-                                         facade,
-                                         node,
-                                         &weight_of_via_path,
-                                         &sharing_of_via_path,
-                                         packed_shortest_path,
-                                         min_edge_offset);
-        const EdgeWeight maximum_allowed_sharing =
-            static_cast<EdgeWeight>(upper_bound_to_shortest_path_weight * VIAPATH_GAMMA);
-        if (sharing_of_via_path <= maximum_allowed_sharing &&
-            weight_of_via_path <= upper_bound_to_shortest_path_weight * (1 + VIAPATH_EPSILON))
-        {
-            ranked_candidates_list.emplace_back(node, weight_of_via_path, sharing_of_via_path);
-        }
+    // prioritizing via nodes for deep inspection. every working data instance
+    // takes the next node that was not inspected yet, until the deadline passed
+    std::vector<SearchEngineData<Algorithm> *> contexts = {&engine_working_data};
+    contexts.insert(contexts.end(), helper_contexts.begin(), helper_contexts.end());
+    contexts.resize(std::min(contexts.size(), preselected_node_list.size()));
+
+    std::vector<boost::optional<RankedCandidateNode>> inspected_candidates(
+        preselected_node_list.size());
+    std::atomic<std::size_t> next_candidate{0};
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, contexts.size(), 1),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            for (auto index = range.begin(); index != range.end(); ++index)
+            {
+                for (auto candidate = next_candidate++; candidate < preselected_node_list.size();
+                     candidate = next_candidate++)
+                {
+                    if (std::chrono::steady_clock::now() >= deadline)
+                        break;
+
+                    const NodeID node = preselected_node_list[candidate];
+                    EdgeWeight weight_of_via_path = 0, sharing_of_via_path = 0;
+                    computeWeightAndSharingOfViaPath(*contexts[index],
+                                                     facade,
+                                                     forward_heap1,
+                                                     reverse_heap1,
+                                                     node,
+                                                     &weight_of_via_path,
+                                                     &sharing_of_via_path,
+                                                     packed_shortest_path,
+                                                     min_edge_offset);
+                    const EdgeWeight maximum_allowed_sharing = static_cast<EdgeWeight>(
+                        upper_bound_to_shortest_path_weight * VIAPATH_GAMMA);
+                    if (sharing_of_via_path <= maximum_allowed_sharing &&
+                        weight_of_via_path <=
+                            upper_bound_to_shortest_path_weight * (1 + VIAPATH_EPSILON))
+                    {
+                        inspected_candidates[candidate] =
+                            RankedCandidateNode(node, weight_of_via_path, sharing_of_via_path);
+                    }
+                }
+            }
+        });
+
+    std::vector<RankedCandidateNode> ranked_candidates_list;
+    for (const auto &candidate : inspected_candidates)
+    {
+        if (candidate)
+            ranked_candidates_list.push_back(*candidate);
     }
     std::sort(ranked_candidates_list.begin(), ranked_candidates_list.end());
 
@@ -790,6 +830,10 @@ InternalManyRoutesResult alternativePathSearch(SearchEngineData<Algorithm> &engi
             selected_via_node = candidate.node;
             break;
         }
+
+        // out of time, continue with the shortest path only
+        if (std::chrono::steady_clock::now() >= deadline)
+            break;
     }
 
     // Unpack shortest path and alternative, if they exist
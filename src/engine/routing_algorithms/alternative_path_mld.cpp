@@ -5,7 +5,12 @@
 
 #include <boost/assert.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iterator>
 #include <memory>
 #include <type_traits>
@@ -539,125 +544,165 @@ RandIt filterAnnotatedRoutesByStretch(RandIt first,
     return std::remove_if(first, last, over_duration_limit);
 }
 
-// Unpacks a range of WeightedViaNodePackedPaths into a range of WeightedViaNodeUnpackedPaths.
+// Unpacks a WeightedViaNodePackedPath into a WeightedViaNodeUnpackedPath.
 // Note: destroys search engine heaps for recursive unpacking. Extract heap data you need before.
-template <typename InputIt, typename OutIt>
-void unpackPackedPaths(InputIt first,
-                       InputIt last,
-                       OutIt out,
-                       SearchEngineData<Algorithm> &search_engine_data,
-                       const Facade &facade,
-                       const PhantomNodes &phantom_node_pair)
+WeightedViaNodeUnpackedPath unpackPackedPath(const WeightedViaNodePackedPath &weighted_packed_path,
+                                             SearchEngineData<Algorithm> &search_engine_data,
+                                             const Facade &facade,
+                                             const PhantomNodes &phantom_node_pair)
 {
-    util::static_assert_iter_category<InputIt, std::input_iterator_tag>();
-    util::static_assert_iter_category<OutIt, std::output_iterator_tag>();
-    util::static_assert_iter_value<InputIt, WeightedViaNodePackedPath>();
-
     const Partition &partition = facade.GetMultiLevelPartition();
 
     Heap &forward_heap = *search_engine_data.forward_heap_1;
     Heap &reverse_heap = *search_engine_data.reverse_heap_1;
 
-    for (auto it = first; it != last; ++it, ++out)
-    {
-        const auto packed_path_weight = it->via.weight;
-        const auto packed_path_via = it->via.node;
+    const auto packed_path_weight = weighted_packed_path.via.weight;
+    const auto packed_path_via = weighted_packed_path.via.node;
 
-        const auto &packed_path = it->path;
+    const auto &packed_path = weighted_packed_path.path;
 
-        //
-        // Todo: dup. code with mld::search except for level entry: we run a slight mld::search
-        //       adaption here and then dispatch to mld::search for recursively descending down.
-        //
+    //
+    // Todo: dup. code with mld::search except for level entry: we run a slight mld::search
+    //       adaption here and then dispatch to mld::search for recursively descending down.
+    //
 
-        std::vector<NodeID> unpacked_nodes;
-        std::vector<EdgeID> unpacked_edges;
-        unpacked_nodes.reserve(packed_path.size());
-        unpacked_edges.reserve(packed_path.size());
+    std::vector<NodeID> unpacked_nodes;
+    std::vector<EdgeID> unpacked_edges;
+    unpacked_nodes.reserve(packed_path.size());
+    unpacked_edges.reserve(packed_path.size());
 
-        // Beware the edge case when start, via, end are all the same.
-        // In this case we return a single node, no edges. We also don't unpack.
-        if (packed_path.empty())
-        {
-            const auto source_node = packed_path_via;
-            unpacked_nodes.push_back(source_node);
+    // Beware the edge case when start, via, end are all the same.
+    // In this case we return a single node, no edges. We also don't unpack.
+    if (packed_path.empty())
+    {
+        const auto source_node = packed_path_via;
+        unpacked_nodes.push_back(source_node);
+    }
+    else
+    {
+        const auto source_node = std::get<0>(packed_path.front());
+        unpacked_nodes.push_back(source_node);
+    }
+
+    for (auto const &packed_edge : packed_path)
+    {
+        NodeID source, target;
+        bool overlay_edge;
+        std::tie(source, target, overlay_edge) = packed_edge;
+        if (!overlay_edge)
+        { // a base graph edge
+            unpacked_nodes.push_back(target);
+            unpacked_edges.push_back(facade.FindEdge(source, target));
         }
         else
-        {
-            const auto source_node = std::get<0>(packed_path.front());
-            unpacked_nodes.push_back(source_node);
+        { // an overlay graph edge
+            LevelID level = getNodeQueryLevel(partition, source, phantom_node_pair); // XXX
+            CellID parent_cell_id = partition.GetCell(level, source);
+            BOOST_ASSERT(parent_cell_id == partition.GetCell(level, target));
+
+            LevelID sublevel = level - 1;
+
+            // Here heaps can be reused, let's go deeper!
+            forward_heap.Clear();
+            reverse_heap.Clear();
+            forward_heap.Insert(source, 0, {source});
+            reverse_heap.Insert(target, 0, {target});
+
+            BOOST_ASSERT(!facade.ExcludeNode(source));
+            BOOST_ASSERT(!facade.ExcludeNode(target));
+
+            // TODO: when structured bindings will be allowed change to
+            // auto [subpath_weight, subpath_source, subpath_target, subpath] = ...
+            EdgeWeight subpath_weight;
+            std::vector<NodeID> subpath_nodes;
+            std::vector<EdgeID> subpath_edges;
+            std::tie(subpath_weight, subpath_nodes, subpath_edges) = search(search_engine_data,
+                                                                            facade,
+                                                                            forward_heap,
+                                                                            reverse_heap,
+                                                                            DO_NOT_FORCE_LOOPS,
+                                                                            DO_NOT_FORCE_LOOPS,
+                                                                            INVALID_EDGE_WEIGHT,
+                                                                            sublevel,
+                                                                            parent_cell_id);
+            BOOST_ASSERT(!subpath_edges.empty());
+            BOOST_ASSERT(subpath_nodes.size() > 1);
+            BOOST_ASSERT(subpath_nodes.front() == source);
+            BOOST_ASSERT(subpath_nodes.back() == target);
+            unpacked_nodes.insert(
+                unpacked_nodes.end(), std::next(subpath_nodes.begin()), subpath_nodes.end());
+            unpacked_edges.insert(
+                unpacked_edges.end(), subpath_edges.begin(), subpath_edges.end());
         }
+    }
 
-        for (auto const &packed_edge : packed_path)
-        {
-            NodeID source, target;
-            bool overlay_edge;
-            std::tie(source, target, overlay_edge) = packed_edge;
-            if (!overlay_edge)
-            { // a base graph edge
-                unpacked_nodes.push_back(target);
-                unpacked_edges.push_back(facade.FindEdge(source, target));
-            }
-            else
-            { // an overlay graph edge
-                LevelID level = getNodeQueryLevel(partition, source, phantom_node_pair); // XXX
-                CellID parent_cell_id = partition.GetCell(level, source);
-                BOOST_ASSERT(parent_cell_id == partition.GetCell(level, target));
-
-                LevelID sublevel = level - 1;
-
-                // Here heaps can be reused, let's go deeper!
-                forward_heap.Clear();
-                reverse_heap.Clear();
-                forward_heap.Insert(source, 0, {source});
-                reverse_heap.Insert(target, 0, {target});
-
-                BOOST_ASSERT(!facade.ExcludeNode(source));
-                BOOST_ASSERT(!facade.ExcludeNode(target));
-
-                // TODO: when structured bindings will be allowed change to
-                // auto [subpath_weight, subpath_source, subpath_target, subpath] = ...
-                EdgeWeight subpath_weight;
-                std::vector<NodeID> subpath_nodes;
-                std::vector<EdgeID> subpath_edges;
-                std::tie(subpath_weight, subpath_nodes, subpath_edges) = search(search_engine_data,
-                                                                                facade,
-                                                                                forward_heap,
-                                                                                reverse_heap,
-                                                                                DO_NOT_FORCE_LOOPS,
-                                                                                DO_NOT_FORCE_LOOPS,
-                                                                                INVALID_EDGE_WEIGHT,
-                                                                                sublevel,
-                                                                                parent_cell_id);
-                BOOST_ASSERT(!subpath_edges.empty());
-                BOOST_ASSERT(subpath_nodes.size() > 1);
-                BOOST_ASSERT(subpath_nodes.front() == source);
-                BOOST_ASSERT(subpath_nodes.back() == target);
-                unpacked_nodes.insert(
-                    unpacked_nodes.end(), std::next(subpath_nodes.begin()), subpath_nodes.end());
-                unpacked_edges.insert(
-                    unpacked_edges.end(), subpath_edges.begin(), subpath_edges.end());
+    return WeightedViaNodeUnpackedPath{0.0,
+                                       WeightedViaNode{packed_path_via, packed_path_weight},
+                                       std::move(unpacked_nodes),
+                                       std::move(unpacked_edges)};
+}
+
+// Unpacks a ranked range of WeightedViaNodePackedPaths into WeightedViaNodeUnpackedPaths.
+// The paths are unpacked on all search contexts in parallel, in the order of their rank. Once
+// the deadline passed no further paths are unpacked except for the first (shortest) path, so
+// the returned paths are a prefix of the range.
+// Note: destroys the heaps of all contexts. Extract heap data you need before.
+template <typename RandIt>
+std::vector<WeightedViaNodeUnpackedPath>
+unpackPackedPaths(RandIt first,
+                  RandIt last,
+                  const std::vector<SearchEngineData<Algorithm> *> &contexts,
+                  const Facade &facade,
+                  const PhantomNodes &phantom_node_pair,
+                  const std::chrono::steady_clock::time_point deadline)
+{
+    util::static_assert_iter_category<RandIt, std::random_access_iterator_tag>();
+    util::static_assert_iter_value<RandIt, WeightedViaNodePackedPath>();
+
+    const auto number_of_paths = static_cast<std::size_t>(last - first);
+    std::vector<WeightedViaNodeUnpackedPath> unpacked_paths(number_of_paths);
+
+    std::atomic<std::size_t> next_path{0};
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, contexts.size(), 1),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            for (auto index = range.begin(); index != range.end(); ++index)
+            {
+                auto &context = *contexts[index];
+                context.InitializeOrClearFirstHeaps(facade.GetNumberOfNodes(),
+                                                    facade.GetMaxBorderNodeID() + 1);
+
+                for (auto path = next_path++; path < number_of_paths; path = next_path++)
+                {
+                    if (path > 0 && std::chrono::steady_clock::now() >= deadline)
+                        break;
+
+                    unpacked_paths[path] =
+                        unpackPackedPath(first[path], context, facade, phantom_node_pair);
+                }
             }
-        }
+        });
 
-        WeightedViaNodeUnpackedPath unpacked_path{
-            0.0,
-            WeightedViaNode{packed_path_via, packed_path_weight},
-            std::move(unpacked_nodes),
-            std::move(unpacked_edges)};
+    // An unpacked path has at least one node. Paths that were skipped after the deadline can
+    // be followed by paths that another context started just before it, drop those as well.
+    const auto skipped = std::find_if(begin(unpacked_paths),
+                                      end(unpacked_paths),
+                                      [](const auto &path) { return path.nodes.empty(); });
+    unpacked_paths.erase(skipped, end(unpacked_paths));
 
-        out = std::move(unpacked_path);
-    }
+    return unpacked_paths;
 }
 
 // Generates via candidate nodes from the overlap of the two search spaces from s and t.
 // Returns via node candidates in no particular order; they're not guaranteed to be unique.
 // Note: heaps are modified in-place, after the function returns they're valid and can be used.
+// Stops overlapping the search spaces once the shortest path is found and the deadline passed.
 inline std::vector<WeightedViaNode>
 makeCandidateVias(SearchEngineData<Algorithm> &search_engine_data,
                   const Facade &facade,
                   const PhantomNodes &phantom_node_pair,
-                  const Parameters &parameters)
+                  const Parameters &parameters,
+                  const std::chrono::steady_clock::time_point deadline)
 {
     Heap &forward_heap = *search_engine_data.forward_heap_1;
     Heap &reverse_heap = *search_engine_data.reverse_heap_1;
@@ -697,6 +742,13 @@ makeCandidateVias(SearchEngineData<Algorithm> &search_engine_data,
         if (!keep_going)
             break;
 
+        // The shortest path is final when the heaps meet its weight, overlap beyond that only
+        // yields more candidates which we don't wait for when the time budget is used up.
+        const bool has_shortest_path = shortest_path_weight != INVALID_EDGE_WEIGHT &&
+                                       forward_heap_min + reverse_heap_min >= shortest_path_weight;
+        if (has_shortest_path && std::chrono::steady_clock::now() >= deadline)
+            break;
+
         // Force forward step to not break early when we reached the middle, continue for overlap.
         // Note: only invalidate the via node, the weight upper bound is still correct!
         overlap_via = SPECIAL_NODEID;
@@ -770,10 +822,13 @@ makeCandidateVias(SearchEngineData<Algorithm> &search_engine_data,
 //   Prune based on vertex cell id
 //
 // https://github.com/Project-OSRM/osrm-backend/issues/3905
-InternalManyRoutesResult alternativePathSearch(SearchEngineData<Algorithm> &search_engine_data,
-                                               const Facade &facade,
-                                               const PhantomNodes &phantom_node_pair,
-                                               unsigned number_of_alternatives)
+InternalManyRoutesResult
+alternativePathSearch(SearchEngineData<Algorithm> &search_engine_data,
+                      const Facade &facade,
+                      const PhantomNodes &phantom_node_pair,
+                      unsigned number_of_alternatives,
+                      const std::vector<SearchEngineData<Algorithm> *> &helper_contexts,
+                      const std::chrono::steady_clock::time_point deadline)
 {
     Parameters parameters = parametersFromRequest(phantom_node_pair);
 
@@ -786,15 +841,15 @@ InternalManyRoutesResult alternativePathSearch(SearchEngineData<Algorithm> &sear
     const Partition &partition = facade.GetMultiLevelPartition();
 
     // Prepare heaps for usage below. The searches will modify them in-place.
-    search_engine_data.InitializeOrClearFirstThreadLocalStorage(facade.GetNumberOfNodes(),
-                                                                facade.GetMaxBorderNodeID() + 1);
+    search_engine_data.InitializeOrClearFirstHeaps(facade.GetNumberOfNodes(),
+                                                   facade.GetMaxBorderNodeID() + 1);
 
     Heap &forward_heap = *search_engine_data.forward_heap_1;
     Heap &reverse_heap = *search_engine_data.reverse_heap_1;
 
     // Do forward and backward search, save search space overlap as via candidates.
     auto candidate_vias =
-        makeCandidateVias(search_engine_data, facade, phantom_node_pair, parameters);
+        makeCandidateVias(search_engine_data, facade, phantom_node_pair, parameters, deadline);
 
     const auto by_weight = [](const auto &lhs, const auto &rhs) { return lhs.weight < rhs.weight; };
     auto shortest_path_via_it =
@@ -887,16 +942,15 @@ InternalManyRoutesResult alternativePathSearch(SearchEngineData<Algorithm> &sear
     const auto paths_last = begin(weighted_packed_paths) + 1 + number_of_filtered_alternative_paths;
     const auto number_of_packed_paths = paths_last - paths_first;
 
-    std::vector<WeightedViaNodeUnpackedPath> unpacked_paths;
-    unpacked_paths.reserve(number_of_packed_paths);
+    BOOST_ASSERT(number_of_packed_paths >= 1);
+
+    std::vector<SearchEngineData<Algorithm> *> contexts = {&search_engine_data};
+    contexts.insert(contexts.end(), helper_contexts.begin(), helper_contexts.end());
+    contexts.resize(std::min(contexts.size(), static_cast<std::size_t>(number_of_packed_paths)));
 
     // Note: re-uses (read: destroys) heaps; we don't need them from here on anyway.
-    unpackPackedPaths(paths_first,
-                      paths_last,
-                      std::back_inserter(unpacked_paths),
-                      search_engine_data,
-                      facade,
-                      phantom_node_pair);
+    auto unpacked_paths =
+        unpackPackedPaths(paths_first, paths_last, contexts, facade, phantom_node_pair, deadline);
 
     //
     // Filter and rank a second time. This time instead of being fast and doing
@@ -919,17 +973,20 @@ InternalManyRoutesResult alternativePathSearch(SearchEngineData<Algorithm> &sear
     // Annotate the unpacked path and transform to proper internal route result.
     //
 
-    std::vector<InternalRouteResult> routes;
-    routes.reserve(number_of_unpacked_paths);
+    std::vector<InternalRouteResult> routes(number_of_unpacked_paths);
 
     const auto unpacked_path_to_route = [&](const WeightedViaNodeUnpackedPath &path) {
         return extractRoute(facade, path.via.weight, phantom_node_pair, path.nodes, path.edges);
     };
 
-    std::transform(unpacked_paths_first,
-                   unpacked_paths_last,
-                   std::back_inserter(routes),
-                   unpacked_path_to_route);
+    // Annotating only reads from the facade, it runs in parallel without search contexts
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, number_of_unpacked_paths),
+                      [&](const tbb::blocked_range<std::size_t> &range) {
+                          for (auto index = range.begin(); index != range.end(); ++index)
+                          {
+                              routes[index] = unpacked_path_to_route(unpacked_paths_first[index]);
+                          }
+                      });
 
     BOOST_ASSERT(routes.size() >= 1);
 
@@ -3,6 +3,12 @@
 #include "engine/routing_algorithms/routing_base_ch.hpp"
 #include "engine/routing_algorithms/routing_base_mld.hpp"
 
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+
 namespace osrm
 {
 namespace engine
@@ -10,6 +16,54 @@ namespace engine
 namespace routing_algorithms
 {
 
+namespace
+{
+// Builds a route that only has the totals of its leg from the totals of the edges between the
+// source and the target node. Like insertNodesInHeaps, the part of the source segment before the
+// source phantom is removed and the part of the target segment before the target phantom added.
+InternalRouteResult extractRouteTotals(const EdgeWeight weight,
+                                       const PhantomNodes &phantom_nodes,
+                                       const NodeID source_node,
+                                       const NodeID target_node,
+                                       const EdgeDuration edges_duration,
+                                       const EdgeDistance edges_distance)
+{
+    InternalRouteResult raw_route_data;
+    raw_route_data.segment_end_coordinates = {phantom_nodes};
+
+    // No path found for both target nodes?
+    if (INVALID_EDGE_WEIGHT == weight)
+    {
+        return raw_route_data;
+    }
+
+    const auto &source_phantom = phantom_nodes.source_phantom;
+    const auto &target_phantom = phantom_nodes.target_phantom;
+    const bool source_traversed_in_reverse = source_phantom.forward_segment_id.id != source_node;
+    const bool target_traversed_in_reverse = target_phantom.forward_segment_id.id != target_node;
+
+    const auto source_duration = source_traversed_in_reverse ? source_phantom.GetReverseDuration()
+                                                             : source_phantom.GetForwardDuration();
+    const auto source_distance = source_traversed_in_reverse ? source_phantom.GetReverseDistance()
+                                                             : source_phantom.GetForwardDistance();
+    const auto target_duration = target_traversed_in_reverse ? target_phantom.GetReverseDuration()
+                                                             : target_phantom.GetForwardDuration();
+    const auto target_distance = target_traversed_in_reverse ? target_phantom.GetReverseDistance()
+                                                             : target_phantom.GetForwardDistance();
+
+    raw_route_data.shortest_path_weight = weight;
+    raw_route_data.source_traversed_in_reverse.push_back(source_traversed_in_reverse);
+    raw_route_data.target_traversed_in_reverse.push_back(target_traversed_in_reverse);
+    // clamp to 0 like the unpacked path does for flooring errors in phantom snapping
+    raw_route_data.leg_totals.push_back(
+        LegTotals{weight,
+                  std::max(0, edges_duration - source_duration + target_duration),
+                  std::max(0.f, edges_distance - source_distance + target_distance)});
+
+    return raw_route_data;
+}
+}
+
 /// This is a stripped down version of the general shortest path algorithm.
 /// The general algorithm always computes two queries for each leg. This is only
 /// necessary in case of vias, where the directions of the start node is constrained
@@ -19,9 +73,10 @@ namespace routing_algorithms
 template <>
 InternalRouteResult directShortestPathSearch(SearchEngineData<ch::Algorithm> &engine_working_data,
                                              const DataFacade<ch::Algorithm> &facade,
-                                             const PhantomNodes &phantom_nodes)
+                                             const PhantomNodes &phantom_nodes,
+                                             const bool unpack_path)
 {
-    engine_working_data.InitializeOrClearFirstThreadLocalStorage(facade.GetNumberOfNodes());
+    engine_working_data.InitializeOrClearFirstHeaps(facade.GetNumberOfNodes());
     auto &forward_heap = *engine_working_data.forward_heap_1;
     auto &reverse_heap = *engine_working_data.reverse_heap_1;
     forward_heap.Clear();
@@ -41,6 +96,27 @@ InternalRouteResult directShortestPathSearch(SearchEngineData<ch::Algorithm> &en
            DO_NOT_FORCE_LOOPS,
            phantom_nodes);
 
+    if (!unpack_path)
+    {
+        // shortcuts store the sums of the edges they replace
+        EdgeDuration duration = 0;
+        EdgeDistance distance = 0;
+        for (auto current = packed_leg.begin(); packed_leg.end() - current > 1; ++current)
+        {
+            const auto &data =
+                facade.GetEdgeData(ch::findPathEdge(facade, *current, *std::next(current)));
+            duration += data.duration;
+            distance += data.distance;
+        }
+
+        return extractRouteTotals(weight,
+                                  phantom_nodes,
+                                  packed_leg.empty() ? SPECIAL_NODEID : packed_leg.front(),
+                                  packed_leg.empty() ? SPECIAL_NODEID : packed_leg.back(),
+                                  duration,
+                                  distance);
+    }
+
     std::vector<NodeID> unpacked_nodes;
     std::vector<EdgeID> unpacked_edges;
 
@@ -66,14 +142,73 @@ InternalRouteResult directShortestPathSearch(SearchEngineData<ch::Algorithm> &en
 template <>
 InternalRouteResult directShortestPathSearch(SearchEngineData<mld::Algorithm> &engine_working_data,
                                              const DataFacade<mld::Algorithm> &facade,
-                                             const PhantomNodes &phantom_nodes)
+                                             const PhantomNodes &phantom_nodes,
+                                             const bool unpack_path)
 {
-    engine_working_data.InitializeOrClearFirstThreadLocalStorage(facade.GetNumberOfNodes(),
-                                                                 facade.GetMaxBorderNodeID() + 1);
+    engine_working_data.InitializeOrClearFirstHeaps(facade.GetNumberOfNodes(),
+                                                    facade.GetMaxBorderNodeID() + 1);
     auto &forward_heap = *engine_working_data.forward_heap_1;
     auto &reverse_heap = *engine_working_data.reverse_heap_1;
     insertNodesInHeaps(forward_heap, reverse_heap, phantom_nodes);
 
+    if (!unpack_path)
+    {
+        // TODO: when structured bindings will be allowed change to
+        // auto [weight, middle, packed_path] = ...
+        EdgeWeight weight = INVALID_EDGE_WEIGHT;
+        NodeID middle = SPECIAL_NODEID;
+        mld::PackedPath packed_path;
+        std::tie(weight, middle, packed_path) = mld::searchPackedPath(engine_working_data,
+                                                                      facade,
+                                                                      forward_heap,
+                                                                      reverse_heap,
+                                                                      DO_NOT_FORCE_LOOPS,
+                                                                      DO_NOT_FORCE_LOOPS,
+                                                                      INVALID_EDGE_WEIGHT,
+                                                                      phantom_nodes);
+
+        // overlay edges are looked up in the cell that holds the shortcut on the query level
+        const auto &partition = facade.GetMultiLevelPartition();
+        const auto &cells = facade.GetCellStorage();
+        const auto &metric = facade.GetCellMetric();
+
+        EdgeDuration duration = 0;
+        EdgeDistance distance = 0;
+        for (const auto &packed_edge : packed_path)
+        {
+            NodeID source, target;
+            bool overlay_edge;
+            std::tie(source, target, overlay_edge) = packed_edge;
+            if (!overlay_edge)
+            {
+                const auto turn_id = facade.GetEdgeData(facade.FindEdge(source, target)).turn_id;
+                duration += facade.GetNodeDuration(source) +
+                            facade.GetDurationPenaltyForEdgeID(turn_id);
+                distance += facade.GetNodeDistance(source);
+            }
+            else
+            {
+                const auto level = mld::getNodeQueryLevel(partition, source, phantom_nodes);
+                const auto cell = cells.GetCell(metric, level, partition.GetCell(level, source));
+                const auto destinations = cell.GetDestinationNodes();
+                const auto column = std::distance(
+                    destinations.begin(),
+                    std::find(destinations.begin(), destinations.end(), target));
+                BOOST_ASSERT(column < std::distance(destinations.begin(), destinations.end()));
+                duration += cell.GetOutDuration(source)[column];
+                distance += cell.GetOutDistance(source)[column];
+            }
+        }
+
+        return extractRouteTotals(
+            weight,
+            phantom_nodes,
+            packed_path.empty() ? middle : std::get<0>(packed_path.front()),
+            packed_path.empty() ? middle : std::get<1>(packed_path.back()),
+            duration,
+            distance);
+    }
+
     // TODO: when structured bindings will be allowed change to
     // auto [weight, source_node, target_node, unpacked_edges] = ...
     EdgeWeight weight = INVALID_EDGE_WEIGHT;
@@ -0,0 +1,118 @@
+#include "engine/routing_algorithms/isochrone.hpp"
+#include "engine/routing_algorithms/routing_base_ch.hpp"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace routing_algorithms
+{
+
+template <>
+std::vector<ReachableNode> oneToAllSearch(SearchEngineData<ch::Algorithm> &engine_working_data,
+                                          const DataFacade<ch::Algorithm> &facade,
+                                          const PhantomNode &source_phantom,
+                                          const EdgeDuration duration_limit)
+{
+    const auto number_of_nodes = facade.GetNumberOfNodes();
+
+    std::vector<EdgeWeight> weights(number_of_nodes, INVALID_EDGE_WEIGHT);
+    std::vector<EdgeDuration> durations(number_of_nodes, MAXIMAL_EDGE_DURATION);
+
+    // Upward search from the source without stalling, all settled weights are needed
+    // as starting values for the sweep below.
+    engine_working_data.InitializeOrClearManyToManyHeaps(number_of_nodes);
+    auto &query_heap = *(engine_working_data.many_to_many_heap);
+    insertSourceInHeap(query_heap, source_phantom);
+
+    while (!query_heap.Empty())
+    {
+        const auto node = query_heap.DeleteMin();
+        const auto weight = query_heap.GetKey(node);
+        const auto duration = query_heap.GetData(node).duration;
+
+        weights[node] = weight;
+        durations[node] = duration;
+
+        if (duration > duration_limit)
+            continue;
+
+        for (const auto edge : facade.GetAdjacentEdgeRange(node))
+        {
+            const auto &data = facade.GetEdgeData(edge);
+            if (!data.forward)
+                continue;
+
+            const NodeID to = facade.GetTarget(edge);
+            const auto to_weight = weight + data.weight;
+            const auto to_duration = duration + data.duration;
+
+            if (!query_heap.WasInserted(to))
+            {
+                query_heap.Insert(to, to_weight, {node, to_duration, 0});
+            }
+            else if (std::tie(to_weight, to_duration) <
+                     std::tie(query_heap.GetKey(to), query_heap.GetData(to).duration))
+            {
+                query_heap.GetData(to) = {node, to_duration, 0};
+                query_heap.DecreaseKey(to, to_weight);
+            }
+        }
+    }
+
+    // Downward sweep from the highest to the lowest node. A downward edge v <- u is stored
+    // at the lower node v with the backward flag, so all values of u are final when v is
+    // visited.
+    const auto &order = facade.GetUpwardOrder();
+    for (auto iter = order.rbegin(); iter != order.rend(); ++iter)
+    {
+        const auto node = *iter;
+        auto &node_weight = weights[node];
+        auto &node_duration = durations[node];
+
+        for (const auto edge : facade.GetAdjacentEdgeRange(node))
+        {
+            const auto &data = facade.GetEdgeData(edge);
+            if (!data.backward)
+                continue;
+
+            const NodeID from = facade.GetTarget(edge);
+            if (from == node || weights[from] == INVALID_EDGE_WEIGHT ||
+                durations[from] > duration_limit)
+                continue;
+
+            const auto new_weight = weights[from] + data.weight;
+            const auto new_duration = durations[from] + data.duration;
+            if (std::tie(new_weight, new_duration) < std::tie(node_weight, node_duration))
+            {
+                node_weight = new_weight;
+                node_duration = new_duration;
+            }
+        }
+    }
+
+    std::vector<ReachableNode> reachable_nodes;
+    for (NodeID node = 0; node < number_of_nodes; ++node)
+    {
+        if (weights[node] != INVALID_EDGE_WEIGHT && durations[node] <= duration_limit)
+        {
+            reachable_nodes.push_back({node, weights[node], durations[node]});
+        }
+    }
+
+    std::sort(reachable_nodes.begin(),
+              reachable_nodes.end(),
+              [](const ReachableNode &lhs, const ReachableNode &rhs) {
+                  return std::tie(lhs.duration, lhs.node) < std::tie(rhs.duration, rhs.node);
+              });
+
+    return reachable_nodes;
+}
+
+} // namespace routing_algorithms
+} // namespace engine
+} // namespace osrm
@@ -0,0 +1,84 @@
+#include "engine/routing_algorithms/isochrone.hpp"
+#include "engine/routing_algorithms/routing_base_mld.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace routing_algorithms
+{
+
+template <>
+std::vector<ReachableNode> oneToAllSearch(SearchEngineData<mld::Algorithm> &engine_working_data,
+                                          const DataFacade<mld::Algorithm> &facade,
+                                          const PhantomNode &source_phantom,
+                                          const EdgeDuration duration_limit)
+{
+    engine_working_data.InitializeOrClearManyToManyHeaps(
+        facade.GetNumberOfNodes(), facade.GetMaxBorderNodeID() + 1);
+    auto &query_heap = *(engine_working_data.many_to_many_heap);
+    insertSourceInHeap(query_heap, source_phantom);
+
+    std::vector<ReachableNode> reachable_nodes;
+
+    while (!query_heap.Empty())
+    {
+        const auto node = query_heap.DeleteMin();
+        const auto weight = query_heap.GetKey(node);
+        const auto duration = query_heap.GetData(node).duration;
+
+        // Durations are non-negative along the shortest path tree, so everything
+        // behind this node is out of reach as well
+        if (duration > duration_limit)
+            continue;
+
+        reachable_nodes.push_back({node, weight, duration});
+
+        // Base graph edges only: the overlay shortcuts would skip nodes inside the limit
+        for (const auto edge : facade.GetAdjacentEdgeRange(node))
+        {
+            if (!facade.IsForwardEdge(edge))
+                continue;
+
+            const NodeID to = facade.GetTarget(edge);
+            if (facade.ExcludeNode(to))
+                continue;
+
+            const auto turn_id = facade.GetEdgeData(edge).turn_id;
+            const auto to_weight =
+                weight + facade.GetNodeWeight(node) + facade.GetWeightPenaltyForEdgeID(turn_id);
+            const auto to_duration = duration + facade.GetNodeDuration(node) +
+                                     facade.GetDurationPenaltyForEdgeID(turn_id);
+
+            if (!query_heap.WasInserted(to))
+            {
+                query_heap.Insert(to, to_weight, {node, false, to_duration, 0});
+            }
+            else if (std::tie(to_weight, to_duration) <
+                     std::tie(query_heap.GetKey(to), query_heap.GetData(to).duration))
+            {
+                query_heap.GetData(to) = {node, false, to_duration, 0};
+                query_heap.DecreaseKey(to, to_weight);
+            }
+        }
+    }
+
+    // Nodes are settled in weight order which is not necessarily the duration order
+    std::sort(reachable_nodes.begin(),
+              reachable_nodes.end(),
+              [](const ReachableNode &lhs, const ReachableNode &rhs) {
+                  return std::tie(lhs.duration, lhs.node) < std::tie(rhs.duration, rhs.node);
+              });
+
+    return reachable_nodes;
+}
+
+} // namespace routing_algorithms
+} // namespace engine
+} // namespace osrm
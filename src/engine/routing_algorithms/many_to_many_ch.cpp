@@ -2,6 +2,7 @@
 #include "engine/routing_algorithms/routing_base_ch.hpp"
 
 #include <boost/assert.hpp>
+#include <boost/optional.hpp>
 #include <boost/range/iterator_range_core.hpp>
 
 #include <limits>
@@ -58,11 +59,18 @@ void relaxOutgoingEdges(const DataFacade<Algorithm> &facade,
         return;
     }
 
-    for (auto edge : facade.GetAdjacentEdgeRange(node))
+    const auto edges = facade.GetAdjacentEdgeRange(node);
+    if (PREFETCH_HEAP_ENTRIES)
     {
-        const auto &data = facade.GetEdgeData(edge);
-        if (DIRECTION == FORWARD_DIRECTION ? data.forward : data.backward)
+        prefetchHeapEntries(facade, edges, query_heap);
+    }
+
+    for (auto edge : edges)
+    {
+        if (DIRECTION == FORWARD_DIRECTION ? facade.IsForwardEdge(edge)
+                                           : facade.IsBackwardEdge(edge))
         {
+            const auto &data = facade.GetEdgeData(edge);
             const NodeID to = facade.GetTarget(edge);
             const auto edge_weight = data.weight;
 
@@ -185,7 +193,9 @@ manyToManySearch(SearchEngineData<ch::Algorithm> &engine_working_data,
                  const std::vector<PhantomNode> &phantom_nodes,
                  const std::vector<std::size_t> &source_indices,
                  const std::vector<std::size_t> &target_indices,
-                 const bool calculate_distance)
+                 const bool calculate_distance,
+                 SearchSpaceCache *search_space_cache,
+                 const EdgeWeight weight_upper_bound)
 {
     const auto number_of_sources = source_indices.size();
     const auto number_of_targets = target_indices.size();
@@ -199,23 +209,54 @@ manyToManySearch(SearchEngineData<ch::Algorithm> &engine_working_data,
 
     std::vector<NodeBucket> search_space_with_buckets;
 
+    const auto weight_limit =
+        getSearchWeightLimit(phantom_nodes, source_indices, target_indices, weight_upper_bound);
+    // Search spaces of bounded searches are incomplete, but complete ones can be used for them
+    const bool cache_search_spaces = weight_upper_bound == INVALID_EDGE_WEIGHT;
+
     // Populate buckets with paths from all accessible nodes to destinations via backward searches
     for (std::uint32_t column_index = 0; column_index < target_indices.size(); ++column_index)
     {
         const auto index = target_indices[column_index];
         const auto &phantom = phantom_nodes[index];
 
-        engine_working_data.InitializeOrClearManyToManyThreadLocalStorage(
+        boost::optional<SearchSpaceCache::Key> cache_key;
+        if (search_space_cache)
+        {
+            cache_key.emplace(facade.GetGeneration(), phantom);
+            if (const auto cached_search_space = search_space_cache->Get(*cache_key))
+            {
+                for (const auto &bucket : *cached_search_space)
+                {
+                    search_space_with_buckets.push_back(bucket);
+                    search_space_with_buckets.back().column_index = column_index;
+                }
+                continue;
+            }
+        }
+
+        const auto search_space_begin = search_space_with_buckets.size();
+
+        engine_working_data.InitializeOrClearManyToManyHeaps(
             facade.GetNumberOfNodes());
         auto &query_heap = *(engine_working_data.many_to_many_heap);
         insertTargetInHeap(query_heap, phantom);
 
         // Explore search space
-        while (!query_heap.Empty())
+        while (!query_heap.Empty() && query_heap.MinKey() <= weight_limit)
         {
             backwardRoutingStep(
                 facade, column_index, query_heap, search_space_with_buckets, phantom);
         }
+
+        if (cache_key && cache_search_spaces)
+        {
+            search_space_cache->Insert(
+                *cache_key,
+                SearchSpaceCache::SearchSpace(search_space_with_buckets.begin() +
+                                                  search_space_begin,
+                                              search_space_with_buckets.end()));
+        }
     }
 
     // Order lookup buckets
@@ -228,13 +269,13 @@ manyToManySearch(SearchEngineData<ch::Algorithm> &engine_working_data,
         const auto &source_phantom = phantom_nodes[source_index];
 
         // Clear heap and insert source nodes
-        engine_working_data.InitializeOrClearManyToManyThreadLocalStorage(
+        engine_working_data.InitializeOrClearManyToManyHeaps(
             facade.GetNumberOfNodes());
         auto &query_heap = *(engine_working_data.many_to_many_heap);
         insertSourceInHeap(query_heap, source_phantom);
 
         // Explore search space
-        while (!query_heap.Empty())
+        while (!query_heap.Empty() && query_heap.MinKey() <= weight_limit)
         {
             forwardRoutingStep(facade,
                                row_index,
@@ -249,6 +290,8 @@ manyToManySearch(SearchEngineData<ch::Algorithm> &engine_working_data,
         }
     }
 
+    discardPathsAboveBound(weights_table, durations_table, distances_table, weight_upper_bound);
+
     return std::make_pair(durations_table, distances_table);
 }
 
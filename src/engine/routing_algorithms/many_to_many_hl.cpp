@@ -0,0 +1,230 @@
+#include "engine/routing_algorithms/many_to_many.hpp"
+#include "engine/routing_algorithms/routing_base_ch.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tuple>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace routing_algorithms
+{
+
+namespace hl
+{
+namespace
+{
+// A node the search starts or ends at, with the offsets of the phantom node
+struct Seed
+{
+    NodeID node;
+    EdgeWeight weight;
+    EdgeDuration duration;
+    EdgeDistance distance;
+};
+
+// The label of a seed with the hubs decoded into its own buffer
+struct DecodedLabel
+{
+    std::vector<NodeID> hubs;
+    contractor::HubLabel label;
+};
+
+// Same nodes and offsets the CH searches are initialized with
+std::vector<Seed> getSourceSeeds(const PhantomNode &phantom_node)
+{
+    std::vector<Seed> seeds;
+    if (phantom_node.IsValidForwardSource())
+    {
+        seeds.push_back({phantom_node.forward_segment_id.id,
+                         -phantom_node.GetForwardWeightPlusOffset(),
+                         -phantom_node.GetForwardDuration(),
+                         -phantom_node.GetForwardDistance()});
+    }
+    if (phantom_node.IsValidReverseSource())
+    {
+        seeds.push_back({phantom_node.reverse_segment_id.id,
+                         -phantom_node.GetReverseWeightPlusOffset(),
+                         -phantom_node.GetReverseDuration(),
+                         -phantom_node.GetReverseDistance()});
+    }
+    return seeds;
+}
+
+std::vector<Seed> getTargetSeeds(const PhantomNode &phantom_node)
+{
+    std::vector<Seed> seeds;
+    if (phantom_node.IsValidForwardTarget())
+    {
+        seeds.push_back({phantom_node.forward_segment_id.id,
+                         phantom_node.GetForwardWeightPlusOffset(),
+                         phantom_node.GetForwardDuration(),
+                         phantom_node.GetForwardDistance()});
+    }
+    if (phantom_node.IsValidReverseTarget())
+    {
+        seeds.push_back({phantom_node.reverse_segment_id.id,
+                         phantom_node.GetReverseWeightPlusOffset(),
+                         phantom_node.GetReverseDuration(),
+                         phantom_node.GetReverseDistance()});
+    }
+    return seeds;
+}
+
+// Special case for CH when contractor creates a loop edge node->node
+bool addLoopWeight(const DataFacade<ch::Algorithm> &facade,
+                   const NodeID node,
+                   EdgeWeight &weight,
+                   EdgeDuration &duration,
+                   EdgeDistance &distance)
+{
+    BOOST_ASSERT(weight < 0);
+
+    const auto loop_weight = ch::getLoopWeight<false>(facade, node);
+    if (std::get<0>(loop_weight) != INVALID_EDGE_WEIGHT)
+    {
+        const auto new_weight_with_loop = weight + std::get<0>(loop_weight);
+        if (new_weight_with_loop >= 0)
+        {
+            weight = new_weight_with_loop;
+            auto result = ch::getLoopWeight<true>(facade, node);
+            duration += std::get<0>(result);
+            distance += std::get<1>(result);
+            return true;
+        }
+    }
+
+    // No loop found or adjusted weight is negative
+    return false;
+}
+}
+} // namespace hl
+
+// Every cell is the best sum over the hubs both labels have in common. The hubs play the role
+// of the middle nodes of the CH searches, so this follows the bucket scan of the CH many-to-many
+// search including the handling of negative weights on the same segment.
+template <>
+std::pair<std::vector<EdgeDuration>, std::vector<EdgeDistance>>
+manyToManySearch(SearchEngineData<hl::Algorithm> &,
+                 const DataFacade<hl::Algorithm> &facade,
+                 const std::vector<PhantomNode> &phantom_nodes,
+                 const std::vector<std::size_t> &source_indices,
+                 const std::vector<std::size_t> &target_indices,
+                 const bool calculate_distance,
+                 SearchSpaceCache *,
+                 const EdgeWeight weight_upper_bound)
+{
+    const auto number_of_sources = source_indices.size();
+    const auto number_of_targets = target_indices.size();
+    const auto number_of_entries = number_of_sources * number_of_targets;
+
+    std::vector<EdgeDuration> durations_table(number_of_entries, MAXIMAL_EDGE_DURATION);
+    std::vector<EdgeDistance> distances_table(calculate_distance ? number_of_entries : 0,
+                                              MAXIMAL_EDGE_DISTANCE);
+
+    std::vector<std::vector<hl::Seed>> target_seeds;
+    target_seeds.reserve(number_of_targets);
+    for (const auto index : target_indices)
+    {
+        target_seeds.push_back(hl::getTargetSeeds(phantom_nodes[index]));
+    }
+
+    // labels are decoded once per seed and not for every cell
+    std::vector<std::vector<hl::DecodedLabel>> target_labels(number_of_targets);
+    for (std::size_t column_index = 0; column_index < number_of_targets; ++column_index)
+    {
+        const auto &seeds = target_seeds[column_index];
+        auto &labels = target_labels[column_index];
+        labels.resize(seeds.size());
+        for (std::size_t seed_index = 0; seed_index < seeds.size(); ++seed_index)
+        {
+            labels[seed_index].label =
+                facade.GetBackwardLabel(seeds[seed_index].node, labels[seed_index].hubs);
+        }
+    }
+
+    for (std::size_t row_index = 0; row_index < number_of_sources; ++row_index)
+    {
+        const auto source_seeds = hl::getSourceSeeds(phantom_nodes[source_indices[row_index]]);
+        std::vector<hl::DecodedLabel> source_labels(source_seeds.size());
+        for (std::size_t seed_index = 0; seed_index < source_seeds.size(); ++seed_index)
+        {
+            source_labels[seed_index].label = facade.GetForwardLabel(
+                source_seeds[seed_index].node, source_labels[seed_index].hubs);
+        }
+
+        for (std::size_t column_index = 0; column_index < number_of_targets; ++column_index)
+        {
+            EdgeWeight current_weight = INVALID_EDGE_WEIGHT;
+            EdgeDuration current_duration = MAXIMAL_EDGE_DURATION;
+            EdgeDistance current_distance = MAXIMAL_EDGE_DISTANCE;
+
+            for (std::size_t source_index = 0; source_index < source_seeds.size(); ++source_index)
+            {
+                const auto &source = source_seeds[source_index];
+                const auto &forward_label = source_labels[source_index].label;
+
+                const auto &seeds = target_seeds[column_index];
+                for (std::size_t target_index = 0; target_index < seeds.size(); ++target_index)
+                {
+                    const auto &target = seeds[target_index];
+                    const auto &backward_label = target_labels[column_index][target_index].label;
+
+                    contractor::intersectHubLabels(
+                        forward_label,
+                        backward_label,
+                        [&](const std::size_t forward_index, const std::size_t backward_index) {
+                            auto new_weight = source.weight + forward_label.weights[forward_index] +
+                                              backward_label.weights[backward_index] +
+                                              target.weight;
+                            auto new_duration = source.duration +
+                                                forward_label.durations[forward_index] +
+                                                backward_label.durations[backward_index] +
+                                                target.duration;
+                            auto new_distance = source.distance +
+                                                forward_label.distances[forward_index] +
+                                                backward_label.distances[backward_index] +
+                                                target.distance;
+
+                            if (new_weight < 0)
+                            {
+                                const auto hub = forward_label.hubs[forward_index];
+                                if (hl::addLoopWeight(
+                                        facade, hub, new_weight, new_duration, new_distance))
+                                {
+                                    current_weight = std::min(current_weight, new_weight);
+                                    current_duration = std::min(current_duration, new_duration);
+                                    current_distance = std::min(current_distance, new_distance);
+                                }
+                            }
+                            else if (std::tie(new_weight, new_duration) <
+                                     std::tie(current_weight, current_duration))
+                            {
+                                current_weight = new_weight;
+                                current_duration = new_duration;
+                                current_distance = new_distance;
+                            }
+                        });
+                }
+            }
+
+            // paths above the bound are unreachable like for the searches
+            if (current_weight > weight_upper_bound)
+                continue;
+
+            const auto table_index = row_index * number_of_targets + column_index;
+            durations_table[table_index] = current_duration;
+            if (calculate_distance)
+                distances_table[table_index] = current_distance;
+        }
+    }
+
+    return std::make_pair(durations_table, distances_table);
+}
+
+} // namespace routing_algorithms
+} // namespace engine
+} // namespace osrm
@@ -64,6 +64,10 @@ void relaxOutgoingEdges(const DataFacade<mld::Algorithm> &facade,
         const auto &cell = cells.GetCell(metric, level, partition.GetCell(level, node));
         if (DIRECTION == FORWARD_DIRECTION)
         { // Shortcuts in forward direction
+            if (PREFETCH_HEAP_ENTRIES)
+            {
+                prefetchHeapEntries(cell.GetDestinationNodes(), query_heap);
+            }
             auto destination = cell.GetDestinationNodes().begin();
             auto shortcut_durations = cell.GetOutDuration(node);
             auto shortcut_distances = cell.GetOutDistance(node);
@@ -102,6 +106,10 @@ void relaxOutgoingEdges(const DataFacade<mld::Algorithm> &facade,
         }
         else
         { // Shortcuts in backward direction
+            if (PREFETCH_HEAP_ENTRIES)
+            {
+                prefetchHeapEntries(cell.GetSourceNodes(), query_heap);
+            }
             auto source = cell.GetSourceNodes().begin();
             auto shortcut_durations = cell.GetInDuration(node);
             auto shortcut_distances = cell.GetInDistance(node);
@@ -140,7 +148,13 @@ void relaxOutgoingEdges(const DataFacade<mld::Algorithm> &facade,
         }
     }
 
-    for (const auto edge : facade.GetBorderEdgeRange(level, node))
+    const auto border_edges = facade.GetBorderEdgeRange(level, node);
+    if (PREFETCH_HEAP_ENTRIES)
+    {
+        prefetchHeapEntries(facade, border_edges, query_heap);
+    }
+
+    for (const auto edge : border_edges)
     {
         const auto &data = facade.GetEdgeData(edge);
         if ((DIRECTION == FORWARD_DIRECTION) ? facade.IsForwardEdge(edge)
@@ -194,7 +208,8 @@ oneToManySearch(SearchEngineData<Algorithm> &engine_working_data,
                 const std::vector<PhantomNode> &phantom_nodes,
                 std::size_t phantom_index,
                 const std::vector<std::size_t> &phantom_indices,
-                const bool calculate_distance)
+                const bool calculate_distance,
+                const EdgeWeight weight_upper_bound)
 {
     std::vector<EdgeWeight> weights(phantom_indices.size(), INVALID_EDGE_WEIGHT);
     std::vector<EdgeDuration> durations(phantom_indices.size(), MAXIMAL_EDGE_DURATION);
@@ -248,7 +263,7 @@ oneToManySearch(SearchEngineData<Algorithm> &engine_working_data,
     }
 
     // Initialize query heap
-    engine_working_data.InitializeOrClearManyToManyThreadLocalStorage(
+    engine_working_data.InitializeOrClearManyToManyHeaps(
         facade.GetNumberOfNodes(), facade.GetMaxBorderNodeID() + 1);
     auto &query_heap = *(engine_working_data.many_to_many_heap);
 
@@ -372,7 +387,11 @@ oneToManySearch(SearchEngineData<Algorithm> &engine_working_data,
         }
     }
 
-    while (!query_heap.Empty() && !target_nodes_index.empty())
+    const auto weight_limit =
+        getSearchWeightLimit(phantom_nodes, {phantom_index}, phantom_indices, weight_upper_bound);
+
+    while (!query_heap.Empty() && !target_nodes_index.empty() &&
+           query_heap.MinKey() <= weight_limit)
     {
         // Extract node from the heap
         const auto node = query_heap.DeleteMin();
@@ -395,6 +414,8 @@ oneToManySearch(SearchEngineData<Algorithm> &engine_working_data,
                                       phantom_indices);
     }
 
+    discardPathsAboveBound(weights, durations, distances_table, weight_upper_bound);
+
     return std::make_pair(durations, distances_table);
 }
 
@@ -538,7 +559,8 @@ manyToManySearch(SearchEngineData<Algorithm> &engine_working_data,
                  const std::vector<PhantomNode> &phantom_nodes,
                  const std::vector<std::size_t> &source_indices,
                  const std::vector<std::size_t> &target_indices,
-                 const bool calculate_distance)
+                 const bool calculate_distance,
+                 const EdgeWeight weight_upper_bound)
 {
     const auto number_of_sources = source_indices.size();
     const auto number_of_targets = target_indices.size();
@@ -552,13 +574,16 @@ manyToManySearch(SearchEngineData<Algorithm> &engine_working_data,
 
     std::vector<NodeBucket> search_space_with_buckets;
 
+    const auto weight_limit =
+        getSearchWeightLimit(phantom_nodes, source_indices, target_indices, weight_upper_bound);
+
     // Populate buckets with paths from all accessible nodes to destinations via backward searches
     for (std::uint32_t column_idx = 0; column_idx < target_indices.size(); ++column_idx)
     {
         const auto index = target_indices[column_idx];
         const auto &target_phantom = phantom_nodes[index];
 
-        engine_working_data.InitializeOrClearManyToManyThreadLocalStorage(
+        engine_working_data.InitializeOrClearManyToManyHeaps(
             facade.GetNumberOfNodes(), facade.GetMaxBorderNodeID() + 1);
         auto &query_heap = *(engine_working_data.many_to_many_heap);
 
@@ -568,7 +593,7 @@ manyToManySearch(SearchEngineData<Algorithm> &engine_working_data,
             insertSourceInHeap(query_heap, target_phantom);
 
         // explore search space
-        while (!query_heap.Empty())
+        while (!query_heap.Empty() && query_heap.MinKey() <= weight_limit)
         {
             backwardRoutingStep<DIRECTION>(
                 facade, column_idx, query_heap, search_space_with_buckets, target_phantom);
@@ -585,7 +610,7 @@ manyToManySearch(SearchEngineData<Algorithm> &engine_working_data,
         const auto &source_phantom = phantom_nodes[source_index];
 
         // Clear heap and insert source nodes
-        engine_working_data.InitializeOrClearManyToManyThreadLocalStorage(
+        engine_working_data.InitializeOrClearManyToManyHeaps(
             facade.GetNumberOfNodes(), facade.GetMaxBorderNodeID() + 1);
 
         auto &query_heap = *(engine_working_data.many_to_many_heap);
@@ -596,7 +621,7 @@ manyToManySearch(SearchEngineData<Algorithm> &engine_working_data,
             insertTargetInHeap(query_heap, source_phantom);
 
         // Explore search space
-        while (!query_heap.Empty())
+        while (!query_heap.Empty() && query_heap.MinKey() <= weight_limit)
         {
             forwardRoutingStep<DIRECTION>(facade,
                                           row_idx,
@@ -612,6 +637,8 @@ manyToManySearch(SearchEngineData<Algorithm> &engine_working_data,
         }
     }
 
+    discardPathsAboveBound(weights_table, durations_table, distances_table, weight_upper_bound);
+
     return std::make_pair(durations_table, distances_table);
 }
 
@@ -636,7 +663,9 @@ manyToManySearch(SearchEngineData<mld::Algorithm> &engine_working_data,
                  const std::vector<PhantomNode> &phantom_nodes,
                  const std::vector<std::size_t> &source_indices,
                  const std::vector<std::size_t> &target_indices,
-                 const bool calculate_distance)
+                 const bool calculate_distance,
+                 SearchSpaceCache *,
+                 const EdgeWeight weight_upper_bound)
 {
     if (source_indices.size() == 1)
     { // TODO: check if target_indices.size() == 1 and do a bi-directional search
@@ -645,7 +674,8 @@ manyToManySearch(SearchEngineData<mld::Algorithm> &engine_working_data,
                                                        phantom_nodes,
                                                        source_indices.front(),
                                                        target_indices,
-                                                       calculate_distance);
+                                                       calculate_distance,
+                                                       weight_upper_bound);
     }
 
     if (target_indices.size() == 1)
@@ -655,7 +685,8 @@ manyToManySearch(SearchEngineData<mld::Algorithm> &engine_working_data,
                                                        phantom_nodes,
                                                        target_indices.front(),
                                                        source_indices,
-                                                       calculate_distance);
+                                                       calculate_distance,
+                                                       weight_upper_bound);
     }
 
     if (target_indices.size() < source_indices.size())
@@ -665,7 +696,8 @@ manyToManySearch(SearchEngineData<mld::Algorithm> &engine_working_data,
                                                         phantom_nodes,
                                                         target_indices,
                                                         source_indices,
-                                                        calculate_distance);
+                                                        calculate_distance,
+                                                        weight_upper_bound);
     }
 
     return mld::manyToManySearch<FORWARD_DIRECTION>(engine_working_data,
@@ -673,7 +705,8 @@ manyToManySearch(SearchEngineData<mld::Algorithm> &engine_working_data,
                                                     phantom_nodes,
                                                     source_indices,
                                                     target_indices,
-                                                    calculate_distance);
+                                                    calculate_distance,
+                                                    weight_upper_bound);
 }
 
 } // namespace routing_algorithms
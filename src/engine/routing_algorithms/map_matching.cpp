@@ -1,4 +1,5 @@
 #include "engine/routing_algorithms/map_matching.hpp"
+#include "engine/routing_algorithms/many_to_many.hpp"
 #include "engine/routing_algorithms/routing_base_ch.hpp"
 #include "engine/routing_algorithms/routing_base_mld.hpp"
 
@@ -8,14 +9,21 @@
 
 #include "util/coordinate_calculation.hpp"
 #include "util/for_each_pair.hpp"
+#include "util/vector_view.hpp"
 
 #include <algorithm>
 #include <cstddef>
 #include <deque>
 #include <iomanip>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <numeric>
 #include <utility>
+#include <vector>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 
 namespace osrm
 {
@@ -26,7 +34,8 @@ namespace routing_algorithms
 
 namespace
 {
-using HMM = map_matching::HiddenMarkovModel<CandidateLists>;
+using CandidateListsView = util::vector_view<const CandidateList>;
+using HMM = map_matching::HiddenMarkovModel<CandidateListsView>;
 
 constexpr static const unsigned MAX_BROKEN_STATES = 10;
 constexpr static const double MATCHING_BETA = 10;
@@ -47,102 +56,352 @@ unsigned getMedianSampleTime(const std::vector<unsigned> &timestamps)
     return *median;
 }
 
+// Transition distances of a single many-to-many search. The searches of all targets are shared
+// by the sources, CH searches them once and scans their buckets from every source.
 template <typename Algorithm>
-inline void initializeHeap(SearchEngineData<Algorithm> &engine_working_data,
-                           const DataFacade<Algorithm> &facade)
+std::vector<double> searchTransitionDistances(SearchEngineData<Algorithm> &engine_working_data,
+                                              const DataFacade<Algorithm> &facade,
+                                              const std::vector<PhantomNode> &phantom_nodes,
+                                              const std::vector<std::size_t> &source_indices,
+                                              const std::vector<std::size_t> &target_indices,
+                                              const EdgeWeight weight_upper_bound)
 {
+    const auto distances = manyToManySearch(engine_working_data,
+                                            facade,
+                                            phantom_nodes,
+                                            source_indices,
+                                            target_indices,
+                                            true,
+                                            nullptr,
+                                            weight_upper_bound)
+                               .second;
+
+    std::vector<double> transition_distances(distances.size());
+    std::transform(distances.begin(),
+                   distances.end(),
+                   transition_distances.begin(),
+                   [](const EdgeDistance distance) {
+                       return distance == MAXIMAL_EDGE_DISTANCE
+                                  ? std::numeric_limits<double>::max()
+                                  : static_cast<double>(distance);
+                   });
+    return transition_distances;
+}
+} // namespace
 
-    const auto nodes_number = facade.GetNumberOfNodes();
-    engine_working_data.InitializeOrClearFirstThreadLocalStorage(nodes_number);
+template <typename Algorithm>
+std::vector<double> getTransitionDistances(SearchEngineData<Algorithm> &engine_working_data,
+                                           const DataFacade<Algorithm> &facade,
+                                           const std::vector<PhantomNode> &phantom_nodes,
+                                           const std::vector<std::size_t> &source_indices,
+                                           const std::vector<std::size_t> &target_indices,
+                                           const EdgeWeight weight_upper_bound)
+{
+    return searchTransitionDistances(engine_working_data,
+                                     facade,
+                                     phantom_nodes,
+                                     source_indices,
+                                     target_indices,
+                                     weight_upper_bound);
 }
 
+// MLD runs one bounded one-to-many search per source instead, the bidirectional search would
+// explore the cells of all targets again for every source
 template <>
-inline void initializeHeap<mld::Algorithm>(SearchEngineData<mld::Algorithm> &engine_working_data,
-                                           const DataFacade<mld::Algorithm> &facade)
+std::vector<double>
+getTransitionDistances<mld::Algorithm>(SearchEngineData<mld::Algorithm> &engine_working_data,
+                                       const DataFacade<mld::Algorithm> &facade,
+                                       const std::vector<PhantomNode> &phantom_nodes,
+                                       const std::vector<std::size_t> &source_indices,
+                                       const std::vector<std::size_t> &target_indices,
+                                       const EdgeWeight weight_upper_bound)
 {
-
-    const auto nodes_number = facade.GetNumberOfNodes();
-    const auto border_nodes_number = facade.GetMaxBorderNodeID() + 1;
-    engine_working_data.InitializeOrClearFirstThreadLocalStorage(nodes_number, border_nodes_number);
-}
+    std::vector<double> transition_distances;
+    transition_distances.reserve(source_indices.size() * target_indices.size());
+    for (const auto source_index : source_indices)
+    {
+        const auto row = searchTransitionDistances(engine_working_data,
+                                                   facade,
+                                                   phantom_nodes,
+                                                   {source_index},
+                                                   target_indices,
+                                                   weight_upper_bound);
+        transition_distances.insert(transition_distances.end(), row.begin(), row.end());
+    }
+    return transition_distances;
 }
 
-template <typename Algorithm>
-SubMatchingList mapMatching(SearchEngineData<Algorithm> &engine_working_data,
-                            const DataFacade<Algorithm> &facade,
-                            const CandidateLists &candidates_list,
-                            const std::vector<util::Coordinate> &trace_coordinates,
-                            const std::vector<unsigned> &trace_timestamps,
-                            const std::vector<boost::optional<double>> &trace_gps_precision,
-                            const bool allow_splitting)
+template std::vector<double>
+getTransitionDistances(SearchEngineData<ch::Algorithm> &engine_working_data,
+                       const DataFacade<ch::Algorithm> &facade,
+                       const std::vector<PhantomNode> &phantom_nodes,
+                       const std::vector<std::size_t> &source_indices,
+                       const std::vector<std::size_t> &target_indices,
+                       const EdgeWeight weight_upper_bound);
+
+namespace
 {
-    map_matching::MatchingConfidence confidence;
-    map_matching::EmissionLogProbability default_emission_log_probability(DEFAULT_GPS_PRECISION);
-    map_matching::TransitionLogProbability transition_log_probability(MATCHING_BETA);
+// Emission log probabilities of the columns from first_column on, trace_gps_precision holds the
+// precision of their points
+void computeEmissionLogProbabilities(
+    HMM &model,
+    const std::size_t first_column,
+    const std::vector<boost::optional<double>> &trace_gps_precision)
+{
+    BOOST_ASSERT(trace_gps_precision.empty() ||
+                 trace_gps_precision.size() + first_column == model.candidates_list.size());
 
-    SubMatchingList sub_matchings;
+    map_matching::EmissionLogProbability default_emission_log_probability(DEFAULT_GPS_PRECISION);
 
-    BOOST_ASSERT(candidates_list.size() == trace_coordinates.size());
-    BOOST_ASSERT(candidates_list.size() > 1);
+    for (auto t = first_column; t < model.candidates_list.size(); ++t)
+    {
+        const auto &gps_precision = trace_gps_precision.empty()
+                                        ? boost::none
+                                        : trace_gps_precision[t - first_column];
+        const auto emission_log_probability =
+            gps_precision ? map_matching::EmissionLogProbability(*gps_precision)
+                          : default_emission_log_probability;
+        std::transform(model.candidates_list[t].begin(),
+                       model.candidates_list[t].end(),
+                       model.emission_log_probabilities[t].begin(),
+                       [&emission_log_probability](const PhantomNodeWithDistance &candidate) {
+                           return emission_log_probability(candidate.distance);
+                       });
+    }
+}
 
-    const bool use_timestamps = trace_timestamps.size() > 1;
+// Fills the Viterbi column of t from the column of prev_unbroken_timestamp. The cost only
+// depends on the number of candidates of both columns. If no candidate of t can be reached,
+// model.breakage[t] stays set.
+template <typename Algorithm>
+void computeViterbiColumn(SearchEngineData<Algorithm> &engine_working_data,
+                          const DataFacade<Algorithm> &facade,
+                          HMM &model,
+                          const std::vector<util::Coordinate> &trace_coordinates,
+                          const std::size_t prev_unbroken_timestamp,
+                          const std::size_t t,
+                          const double max_distance_delta)
+{
+    map_matching::TransitionLogProbability transition_log_probability(MATCHING_BETA);
 
-    const auto median_sample_time = [&] {
-        if (use_timestamps)
+    const auto &prev_viterbi = model.viterbi[prev_unbroken_timestamp];
+    const auto &prev_pruned = model.pruned[prev_unbroken_timestamp];
+    const auto &prev_unbroken_timestamps_list = model.candidates_list[prev_unbroken_timestamp];
+    const auto &prev_coordinate = trace_coordinates[prev_unbroken_timestamp];
+
+    auto current_viterbi = model.viterbi[t];
+    auto current_pruned = model.pruned[t];
+    auto current_parents = model.parents[t];
+    auto current_lengths = model.path_distances[t];
+    const auto current_emissions = model.emission_log_probabilities[t];
+    const auto &current_timestamps_list = model.candidates_list[t];
+    const auto &current_coordinate = trace_coordinates[t];
+
+    const auto haversine_distance =
+        util::coordinate_calculation::haversineDistance(prev_coordinate, current_coordinate);
+    // assumes minumum of 4 m/s
+    const EdgeWeight weight_upper_bound =
+        ((haversine_distance + max_distance_delta) / 4.) * facade.GetWeightMultiplier();
+
+    // network distances of all transitions from the unpruned candidates
+    std::vector<PhantomNode> transition_phantom_nodes;
+    std::vector<std::size_t> source_indices;
+    std::vector<std::size_t> target_indices;
+    transition_phantom_nodes.reserve(prev_viterbi.size() + current_viterbi.size());
+    for (const auto s : util::irange<std::size_t>(0UL, prev_viterbi.size()))
+    {
+        if (!prev_pruned[s])
         {
-            return std::max(1u, getMedianSampleTime(trace_timestamps));
+            source_indices.push_back(transition_phantom_nodes.size());
+            transition_phantom_nodes.push_back(prev_unbroken_timestamps_list[s].phantom_node);
         }
-        else
+    }
+    for (const auto &candidate : current_timestamps_list)
+    {
+        target_indices.push_back(transition_phantom_nodes.size());
+        transition_phantom_nodes.push_back(candidate.phantom_node);
+    }
+    const auto network_distances =
+        source_indices.empty() ? std::vector<double>{}
+                               : getTransitionDistances(engine_working_data,
+                                                        facade,
+                                                        transition_phantom_nodes,
+                                                        source_indices,
+                                                        target_indices,
+                                                        weight_upper_bound);
+
+    // compute d_t for this timestamp and the next one
+    std::size_t row = 0;
+    for (const auto s : util::irange<std::size_t>(0UL, prev_viterbi.size()))
+    {
+        if (prev_pruned[s])
         {
-            return 1u;
+            continue;
         }
-    }();
-    const auto max_broken_time = median_sample_time * MAX_BROKEN_STATES;
+        const auto row_begin = row++ * current_viterbi.size();
+
+        for (const auto s_prime : util::irange<std::size_t>(0UL, current_viterbi.size()))
+        {
+            const double emission_pr = current_emissions[s_prime];
+            double new_value = prev_viterbi[s] + emission_pr;
+            if (current_viterbi[s_prime] > new_value)
+            {
+                continue;
+            }
+
+            const double network_distance = network_distances[row_begin + s_prime];
+
+            // get distance diff between loc1/2 and locs/s_prime
+            const auto d_t = std::abs(network_distance - haversine_distance);
+
+            // very low probability transition -> prune
+            if (d_t >= max_distance_delta)
+            {
+                continue;
+            }
+
+            const double transition_pr = transition_log_probability(d_t);
+            new_value += transition_pr;
+
+            if (new_value > current_viterbi[s_prime])
+            {
+                current_viterbi[s_prime] = new_value;
+                current_parents[s_prime] = std::make_pair(prev_unbroken_timestamp, s);
+                current_lengths[s_prime] = network_distance;
+                current_pruned[s_prime] = false;
+                model.breakage[t] = false;
+            }
+        }
+    }
+}
+
+// Backtracks the most likely path of the points in [sub_matching_begin, sub_matching_end).
+// Matchings of less than two points are invalid.
+boost::optional<map_matching::SubMatching>
+reconstructSubMatching(HMM &model,
+                       const std::vector<util::Coordinate> &trace_coordinates,
+                       std::size_t sub_matching_begin,
+                       const std::size_t sub_matching_end)
+{
+    map_matching::MatchingConfidence confidence;
+    map_matching::SubMatching matching;
 
-    std::vector<std::vector<double>> emission_log_probabilities(trace_coordinates.size());
-    if (trace_gps_precision.empty())
+    std::size_t parent_timestamp_index = sub_matching_end - 1;
+    while (parent_timestamp_index >= sub_matching_begin && model.breakage[parent_timestamp_index])
     {
-        for (auto t = 0UL; t < candidates_list.size(); ++t)
+        --parent_timestamp_index;
+    }
+    while (sub_matching_begin < sub_matching_end && model.breakage[sub_matching_begin])
+    {
+        ++sub_matching_begin;
+    }
+    const auto sub_matching_last_timestamp = parent_timestamp_index;
+
+    // matchings that only consist of one candidate are invalid
+    if (parent_timestamp_index - sub_matching_begin + 1 < 2)
+    {
+        return boost::none;
+    }
+
+    // loop through the columns, and only compare the last entry
+    const auto last_viterbi = model.viterbi[parent_timestamp_index];
+    const auto max_element_iter = std::max_element(last_viterbi.begin(), last_viterbi.end());
+
+    std::size_t parent_candidate_index = std::distance(last_viterbi.begin(), max_element_iter);
+
+    std::deque<std::pair<std::size_t, std::size_t>> reconstructed_indices;
+    while (parent_timestamp_index > sub_matching_begin)
+    {
+        reconstructed_indices.emplace_front(parent_timestamp_index, parent_candidate_index);
+        model.viterbi_reachable[parent_timestamp_index][parent_candidate_index] = true;
+        const auto &next = model.parents[parent_timestamp_index][parent_candidate_index];
+        // make sure we can never get stuck in this loop
+        if (parent_timestamp_index == next.first)
         {
-            emission_log_probabilities[t].resize(candidates_list[t].size());
-            std::transform(candidates_list[t].begin(),
-                           candidates_list[t].end(),
-                           emission_log_probabilities[t].begin(),
-                           [&](const PhantomNodeWithDistance &candidate) {
-                               return default_emission_log_probability(candidate.distance);
-                           });
+            break;
         }
+        parent_timestamp_index = next.first;
+        parent_candidate_index = next.second;
     }
-    else
+    reconstructed_indices.emplace_front(parent_timestamp_index, parent_candidate_index);
+    model.viterbi_reachable[parent_timestamp_index][parent_candidate_index] = true;
+    if (reconstructed_indices.size() < 2)
+    {
+        return boost::none;
+    }
+
+    // fill viterbi reachability matrix
+    for (const auto s_last :
+         util::irange<std::size_t>(0UL, model.viterbi[sub_matching_last_timestamp].size()))
     {
-        for (auto t = 0UL; t < candidates_list.size(); ++t)
+        parent_timestamp_index = sub_matching_last_timestamp;
+        parent_candidate_index = s_last;
+        while (parent_timestamp_index > sub_matching_begin)
         {
-            emission_log_probabilities[t].resize(candidates_list[t].size());
-            if (trace_gps_precision[t])
-            {
-                map_matching::EmissionLogProbability emission_log_probability(
-                    *trace_gps_precision[t]);
-                std::transform(
-                    candidates_list[t].begin(),
-                    candidates_list[t].end(),
-                    emission_log_probabilities[t].begin(),
-                    [&emission_log_probability](const PhantomNodeWithDistance &candidate) {
-                        return emission_log_probability(candidate.distance);
-                    });
-            }
-            else
+            if (model.viterbi_reachable[parent_timestamp_index][parent_candidate_index] ||
+                model.pruned[parent_timestamp_index][parent_candidate_index])
             {
-                std::transform(candidates_list[t].begin(),
-                               candidates_list[t].end(),
-                               emission_log_probabilities[t].begin(),
-                               [&](const PhantomNodeWithDistance &candidate) {
-                                   return default_emission_log_probability(candidate.distance);
-                               });
+                break;
             }
+            model.viterbi_reachable[parent_timestamp_index][parent_candidate_index] = true;
+            const auto &next = model.parents[parent_timestamp_index][parent_candidate_index];
+            parent_timestamp_index = next.first;
+            parent_candidate_index = next.second;
         }
+        model.viterbi_reachable[parent_timestamp_index][parent_candidate_index] = true;
+    }
+
+    auto matching_distance = 0.0;
+    auto trace_distance = 0.0;
+    matching.nodes.reserve(reconstructed_indices.size());
+    matching.indices.reserve(reconstructed_indices.size());
+    for (const auto &idx : reconstructed_indices)
+    {
+        const auto timestamp_index = idx.first;
+        const auto location_index = idx.second;
+
+        matching.indices.push_back(timestamp_index);
+        matching.nodes.push_back(
+            model.candidates_list[timestamp_index][location_index].phantom_node);
+        const auto reachable = model.viterbi_reachable[timestamp_index];
+        auto const routes_count = std::accumulate(reachable.begin(), reachable.end(), 0);
+        BOOST_ASSERT(routes_count > 0);
+        // we don't count the current route in the "alternatives_count" parameter
+        matching.alternatives_count.push_back(routes_count - 1);
+        matching_distance += model.path_distances[timestamp_index][location_index];
     }
+    util::for_each_pair(
+        reconstructed_indices,
+        [&trace_distance, &trace_coordinates](const std::pair<std::size_t, std::size_t> &prev,
+                                              const std::pair<std::size_t, std::size_t> &curr) {
+            trace_distance += util::coordinate_calculation::haversineDistance(
+                trace_coordinates[prev.first], trace_coordinates[curr.first]);
+        });
+
+    matching.confidence = confidence(trace_distance, matching_distance);
 
-    HMM model(candidates_list, emission_log_probabilities);
+    return matching;
+}
+
+// Matches the points of a part of a trace. If split_at_end is set, the trace continues after a
+// gap that always splits it, the end of the part is handled like such a gap. Then the part is
+// matched exactly like the same points of the whole trace.
+template <typename Algorithm>
+SubMatchingList matchTracePart(SearchEngineData<Algorithm> &engine_working_data,
+                               const DataFacade<Algorithm> &facade,
+                               const CandidateListsView &candidates_list,
+                               const std::vector<util::Coordinate> &trace_coordinates,
+                               const std::vector<unsigned> &trace_timestamps,
+                               const std::vector<boost::optional<double>> &trace_gps_precision,
+                               const bool use_timestamps,
+                               const unsigned max_broken_time,
+                               const bool allow_splitting,
+                               const bool split_at_end)
+{
+    SubMatchingList sub_matchings;
+
+    HMM model(candidates_list, engine_working_data.hidden_markov_model_storage);
+    computeEmissionLogProbabilities(model, 0, trace_gps_precision);
 
     std::size_t initial_timestamp = model.initialize(0);
     if (initial_timestamp == map_matching::INVALID_STATE)
@@ -150,20 +409,18 @@ SubMatchingList mapMatching(SearchEngineData<Algorithm> &engine_working_data,
         return sub_matchings;
     }
 
-    initializeHeap(engine_working_data, facade);
-    auto &forward_heap = *engine_working_data.forward_heap_1;
-    auto &reverse_heap = *engine_working_data.reverse_heap_1;
-
     std::size_t breakage_begin = map_matching::INVALID_STATE;
     std::vector<std::size_t> split_points;
     std::vector<std::size_t> prev_unbroken_timestamps;
     prev_unbroken_timestamps.reserve(candidates_list.size());
     prev_unbroken_timestamps.push_back(initial_timestamp);
-    for (auto t = initial_timestamp + 1; t < candidates_list.size(); ++t)
+    const auto end_timestamp = candidates_list.size() + (split_at_end ? 1 : 0);
+    for (auto t = initial_timestamp + 1; t < end_timestamp; ++t)
     {
+        const bool end_of_part = t == candidates_list.size();
 
         const auto step_time = [&] {
-            if (use_timestamps)
+            if (use_timestamps && !end_of_part)
             {
                 return trace_timestamps[t] - trace_timestamps[prev_unbroken_timestamps.back()];
             }
@@ -185,6 +442,10 @@ SubMatchingList mapMatching(SearchEngineData<Algorithm> &engine_working_data,
         }();
 
         const bool gap_in_trace = [&]() {
+            if (end_of_part)
+            {
+                return true;
+            }
             // use temporal information if available to determine a split
             // but do not determine split by timestamps if wasn't asked about it
             if (use_timestamps && allow_splitting)
@@ -200,74 +461,13 @@ SubMatchingList mapMatching(SearchEngineData<Algorithm> &engine_working_data,
         if (!gap_in_trace)
         {
             BOOST_ASSERT(!prev_unbroken_timestamps.empty());
-            const std::size_t prev_unbroken_timestamp = prev_unbroken_timestamps.back();
-
-            const auto &prev_viterbi = model.viterbi[prev_unbroken_timestamp];
-            const auto &prev_pruned = model.pruned[prev_unbroken_timestamp];
-            const auto &prev_unbroken_timestamps_list = candidates_list[prev_unbroken_timestamp];
-            const auto &prev_coordinate = trace_coordinates[prev_unbroken_timestamp];
-
-            auto &current_viterbi = model.viterbi[t];
-            auto &current_pruned = model.pruned[t];
-            auto &current_parents = model.parents[t];
-            auto &current_lengths = model.path_distances[t];
-            const auto &current_timestamps_list = candidates_list[t];
-            const auto &current_coordinate = trace_coordinates[t];
-
-            const auto haversine_distance = util::coordinate_calculation::haversineDistance(
-                prev_coordinate, current_coordinate);
-            // assumes minumum of 4 m/s
-            const EdgeWeight weight_upper_bound =
-                ((haversine_distance + max_distance_delta) / 4.) * facade.GetWeightMultiplier();
-
-            // compute d_t for this timestamp and the next one
-            for (const auto s : util::irange<std::size_t>(0UL, prev_viterbi.size()))
-            {
-                if (prev_pruned[s])
-                {
-                    continue;
-                }
-
-                for (const auto s_prime : util::irange<std::size_t>(0UL, current_viterbi.size()))
-                {
-                    const double emission_pr = emission_log_probabilities[t][s_prime];
-                    double new_value = prev_viterbi[s] + emission_pr;
-                    if (current_viterbi[s_prime] > new_value)
-                    {
-                        continue;
-                    }
-
-                    double network_distance =
-                        getNetworkDistance(engine_working_data,
-                                           facade,
-                                           forward_heap,
-                                           reverse_heap,
-                                           prev_unbroken_timestamps_list[s].phantom_node,
-                                           current_timestamps_list[s_prime].phantom_node,
-                                           weight_upper_bound);
-
-                    // get distance diff between loc1/2 and locs/s_prime
-                    const auto d_t = std::abs(network_distance - haversine_distance);
-
-                    // very low probability transition -> prune
-                    if (d_t >= max_distance_delta)
-                    {
-                        continue;
-                    }
-
-                    const double transition_pr = transition_log_probability(d_t);
-                    new_value += transition_pr;
-
-                    if (new_value > current_viterbi[s_prime])
-                    {
-                        current_viterbi[s_prime] = new_value;
-                        current_parents[s_prime] = std::make_pair(prev_unbroken_timestamp, s);
-                        current_lengths[s_prime] = network_distance;
-                        current_pruned[s_prime] = false;
-                        model.breakage[t] = false;
-                    }
-                }
-            }
+            computeViterbiColumn(engine_working_data,
+                                 facade,
+                                 model,
+                                 trace_coordinates,
+                                 prev_unbroken_timestamps.back(),
+                                 t,
+                                 max_distance_delta);
 
             if (model.breakage[t])
             {
@@ -302,10 +502,17 @@ SubMatchingList mapMatching(SearchEngineData<Algorithm> &engine_working_data,
 
             // note: this preserves everything before split_index
             model.Clear(split_index);
-            std::size_t new_start = model.initialize(split_index);
+            std::size_t new_start = split_index < candidates_list.size()
+                                        ? model.initialize(split_index)
+                                        : map_matching::INVALID_STATE;
             // no new start was found -> stop viterbi calculation
             if (new_start == map_matching::INVALID_STATE)
             {
+                // the matching of the whole trace continues with the next part
+                if (split_at_end)
+                {
+                    prev_unbroken_timestamps.clear();
+                }
                 break;
             }
 
@@ -328,110 +535,335 @@ SubMatchingList mapMatching(SearchEngineData<Algorithm> &engine_working_data,
     std::size_t sub_matching_begin = initial_timestamp;
     for (const auto sub_matching_end : split_points)
     {
-        map_matching::SubMatching matching;
-
-        std::size_t parent_timestamp_index = sub_matching_end - 1;
-        while (parent_timestamp_index >= sub_matching_begin &&
-               model.breakage[parent_timestamp_index])
+        auto matching =
+            reconstructSubMatching(model, trace_coordinates, sub_matching_begin, sub_matching_end);
+        if (matching)
         {
-            --parent_timestamp_index;
+            sub_matchings.push_back(std::move(*matching));
         }
-        while (sub_matching_begin < sub_matching_end && model.breakage[sub_matching_begin])
+        sub_matching_begin = sub_matching_end;
+    }
+
+    return sub_matchings;
+}
+}
+
+std::vector<std::size_t> getTracePartBegins(const std::vector<unsigned> &trace_timestamps,
+                                            const bool allow_splitting)
+{
+    std::vector<std::size_t> part_begins = {0};
+    if (trace_timestamps.size() < 2 || !allow_splitting)
+    {
+        return part_begins;
+    }
+
+    const auto max_broken_time =
+        std::max(1u, getMedianSampleTime(trace_timestamps)) * MAX_BROKEN_STATES;
+    for (const auto t : util::irange<std::size_t>(1UL, trace_timestamps.size()))
+    {
+        // the step time from the last matched point is at least as long
+        if (trace_timestamps[t] - trace_timestamps[t - 1] > max_broken_time)
         {
-            ++sub_matching_begin;
+            part_begins.push_back(t);
         }
-        const auto sub_matching_last_timestamp = parent_timestamp_index;
+    }
+    return part_begins;
+}
+
+template <typename Algorithm>
+SubMatchingList mapMatching(SearchEngineData<Algorithm> &engine_working_data,
+                            const DataFacade<Algorithm> &facade,
+                            const CandidateLists &candidates_list,
+                            const std::vector<util::Coordinate> &trace_coordinates,
+                            const std::vector<unsigned> &trace_timestamps,
+                            const std::vector<boost::optional<double>> &trace_gps_precision,
+                            const bool allow_splitting,
+                            const std::vector<SearchEngineData<Algorithm> *> &helper_contexts)
+{
+    BOOST_ASSERT(candidates_list.size() == trace_coordinates.size());
+    BOOST_ASSERT(candidates_list.size() > 1);
+
+    const bool use_timestamps = trace_timestamps.size() > 1;
 
-        // matchings that only consist of one candidate are invalid
-        if (parent_timestamp_index - sub_matching_begin + 1 < 2)
+    const auto median_sample_time = [&] {
+        if (use_timestamps)
         {
-            sub_matching_begin = sub_matching_end;
-            continue;
+            return std::max(1u, getMedianSampleTime(trace_timestamps));
+        }
+        else
+        {
+            return 1u;
         }
+    }();
+    const auto max_broken_time = median_sample_time * MAX_BROKEN_STATES;
 
-        // loop through the columns, and only compare the last entry
-        const auto max_element_iter =
-            std::max_element(model.viterbi[parent_timestamp_index].begin(),
-                             model.viterbi[parent_timestamp_index].end());
+    auto part_begins = helper_contexts.empty() ? std::vector<std::size_t>{0}
+                                               : getTracePartBegins(trace_timestamps,
+                                                                    allow_splitting);
+    const auto number_of_parts = part_begins.size();
+    if (number_of_parts == 1)
+    {
+        return matchTracePart(engine_working_data,
+                              facade,
+                              CandidateListsView(candidates_list.data(), candidates_list.size()),
+                              trace_coordinates,
+                              trace_timestamps,
+                              trace_gps_precision,
+                              use_timestamps,
+                              max_broken_time,
+                              allow_splitting,
+                              false);
+    }
+    part_begins.push_back(candidates_list.size());
 
-        std::size_t parent_candidate_index =
-            std::distance(model.viterbi[parent_timestamp_index].begin(), max_element_iter);
+    // Every context matches every n-th part, the sub-matchings are then concatenated in order
+    std::vector<SearchEngineData<Algorithm> *> contexts = {&engine_working_data};
+    contexts.insert(contexts.end(), helper_contexts.begin(), helper_contexts.end());
 
-        std::deque<std::pair<std::size_t, std::size_t>> reconstructed_indices;
-        while (parent_timestamp_index > sub_matching_begin)
-        {
-            reconstructed_indices.emplace_front(parent_timestamp_index, parent_candidate_index);
-            model.viterbi_reachable[parent_timestamp_index][parent_candidate_index] = true;
-            const auto &next = model.parents[parent_timestamp_index][parent_candidate_index];
-            // make sure we can never get stuck in this loop
-            if (parent_timestamp_index == next.first)
+    std::vector<SubMatchingList> part_sub_matchings(number_of_parts);
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, contexts.size(), 1),
+        [&](const tbb::blocked_range<std::size_t> &range) {
+            for (auto index = range.begin(); index != range.end(); ++index)
             {
-                break;
+                for (auto part = index; part < number_of_parts; part += contexts.size())
+                {
+                    const auto begin = part_begins[part];
+                    const auto end = part_begins[part + 1];
+                    const auto slice = [begin, end](const auto &values) {
+                        return values.empty() ? std::decay_t<decltype(values)>{}
+                                              : std::decay_t<decltype(values)>(
+                                                    values.begin() + begin, values.begin() + end);
+                    };
+
+                    auto &sub_matchings = part_sub_matchings[part];
+                    sub_matchings = matchTracePart(
+                        *contexts[index],
+                        facade,
+                        CandidateListsView(candidates_list.data() + begin, end - begin),
+                        slice(trace_coordinates),
+                        slice(trace_timestamps),
+                        slice(trace_gps_precision),
+                        use_timestamps,
+                        max_broken_time,
+                        allow_splitting,
+                        part + 1 < number_of_parts);
+                    for (auto &sub_matching : sub_matchings)
+                    {
+                        for (auto &trace_index : sub_matching.indices)
+                        {
+                            trace_index += begin;
+                        }
+                    }
+                }
             }
-            parent_timestamp_index = next.first;
-            parent_candidate_index = next.second;
+        });
+
+    SubMatchingList sub_matchings;
+    for (auto &part : part_sub_matchings)
+    {
+        std::move(part.begin(), part.end(), std::back_inserter(sub_matchings));
+    }
+    return sub_matchings;
+}
+
+template <typename Algorithm>
+SubMatchingList
+streamingMapMatching(SearchEngineData<Algorithm> &engine_working_data,
+                     const DataFacade<Algorithm> &facade,
+                     map_matching::MatchingFrontier &frontier,
+                     const CandidateLists &candidates_list,
+                     const std::vector<util::Coordinate> &trace_coordinates,
+                     const std::vector<unsigned> &trace_timestamps,
+                     const std::vector<boost::optional<double>> &trace_gps_precision,
+                     const bool allow_splitting)
+{
+    SubMatchingList sub_matchings;
+
+    BOOST_ASSERT(candidates_list.size() == trace_coordinates.size());
+    BOOST_ASSERT(trace_timestamps.empty() || trace_timestamps.size() == trace_coordinates.size());
+
+    // the frontier is the first column of the model, followed by the new points
+    CandidateLists extended_candidates_list;
+    extended_candidates_list.reserve(candidates_list.size() + 1);
+    extended_candidates_list.push_back(frontier.candidates);
+    extended_candidates_list.insert(
+        extended_candidates_list.end(), candidates_list.begin(), candidates_list.end());
+
+    std::vector<util::Coordinate> extended_coordinates;
+    extended_coordinates.reserve(trace_coordinates.size() + 1);
+    extended_coordinates.push_back(frontier.coordinate);
+    extended_coordinates.insert(
+        extended_coordinates.end(), trace_coordinates.begin(), trace_coordinates.end());
+
+    const bool use_timestamps =
+        !trace_timestamps.empty() && (frontier.Empty() || frontier.timestamp);
+    std::vector<unsigned> extended_timestamps;
+    if (use_timestamps)
+    {
+        extended_timestamps.reserve(trace_timestamps.size() + 1);
+        extended_timestamps.push_back(frontier.timestamp ? *frontier.timestamp
+                                                         : trace_timestamps.front());
+        extended_timestamps.insert(
+            extended_timestamps.end(), trace_timestamps.begin(), trace_timestamps.end());
+    }
+
+    // gaps are found with the sample times of the earlier requests, a single new point can not
+    // tell whether it follows one. Only the first request with timestamps uses its own.
+    std::vector<unsigned> new_sample_times;
+    if (use_timestamps)
+    {
+        for (auto t = frontier.timestamp ? 1UL : 2UL; t < extended_timestamps.size(); ++t)
+        {
+            new_sample_times.push_back(extended_timestamps[t] - extended_timestamps[t - 1]);
         }
-        reconstructed_indices.emplace_front(parent_timestamp_index, parent_candidate_index);
-        model.viterbi_reachable[parent_timestamp_index][parent_candidate_index] = true;
-        if (reconstructed_indices.size() < 2)
+    }
+    const bool first_sample_times = frontier.sample_times.empty();
+    if (first_sample_times)
+    {
+        frontier.AddSampleTimes(new_sample_times);
+    }
+    const auto median_sample_time = frontier.GetMedianSampleTime();
+    const auto max_broken_time = median_sample_time * MAX_BROKEN_STATES;
+
+    // the frontier column is taken over as is, its emissions are part of its Viterbi values
+    HMM model(CandidateListsView(extended_candidates_list.data(), extended_candidates_list.size()),
+              engine_working_data.hidden_markov_model_storage);
+    const auto frontier_emissions = model.emission_log_probabilities[0];
+    std::fill(frontier_emissions.begin(), frontier_emissions.end(), 0.f);
+    computeEmissionLogProbabilities(model, 1, trace_gps_precision);
+
+    std::size_t initial_timestamp = 0;
+    if (frontier.Empty())
+    {
+        initial_timestamp = extended_candidates_list.size() > 1 ? model.initialize(1)
+                                                                : map_matching::INVALID_STATE;
+    }
+    else
+    {
+        BOOST_ASSERT(frontier.viterbi.size() == frontier.candidates.size());
+        BOOST_ASSERT(frontier.pruned.size() == frontier.candidates.size());
+        std::copy(frontier.viterbi.begin(), frontier.viterbi.end(), model.viterbi[0].begin());
+        std::copy(frontier.pruned.begin(), frontier.pruned.end(), model.pruned[0].begin());
+        for (const auto s : util::irange<std::size_t>(0UL, frontier.candidates.size()))
         {
-            sub_matching_begin = sub_matching_end;
-            continue;
+            model.parents[0][s] = std::make_pair(0u, static_cast<unsigned>(s));
         }
+        model.breakage[0] = false;
+    }
+
+    // position in the whole trace, unmatched points after the frontier count as broken states
+    const auto previous_broken_points = frontier.broken_points;
+    const auto trace_position = [previous_broken_points](const std::size_t t) {
+        return t == 0 ? std::size_t{0} : t + previous_broken_points;
+    };
 
-        // fill viterbi reachability matrix
-        for (const auto s_last :
-             util::irange<std::size_t>(0UL, model.viterbi[sub_matching_last_timestamp].size()))
+    std::size_t prev_unbroken_timestamp = initial_timestamp;
+    std::size_t sub_matching_begin = initial_timestamp;
+    for (auto t = initial_timestamp + 1;
+         initial_timestamp != map_matching::INVALID_STATE && t < extended_candidates_list.size();
+         ++t)
+    {
+        const auto step_time =
+            use_timestamps ? extended_timestamps[t] - extended_timestamps[prev_unbroken_timestamp]
+                           : 1u;
+
+        const auto max_distance_delta =
+            use_timestamps ? step_time * facade.GetMapMatchingMaxSpeed() : MAX_DISTANCE_DELTA;
+
+        const bool gap_in_trace = [&]() {
+            if (use_timestamps && allow_splitting && median_sample_time > 0)
+            {
+                return step_time > max_broken_time;
+            }
+            else
+            {
+                return trace_position(t) - trace_position(prev_unbroken_timestamp) >
+                       MAX_BROKEN_STATES;
+            }
+        }();
+
+        if (!gap_in_trace)
         {
-            parent_timestamp_index = sub_matching_last_timestamp;
-            parent_candidate_index = s_last;
-            while (parent_timestamp_index > sub_matching_begin)
+            computeViterbiColumn(engine_working_data,
+                                 facade,
+                                 model,
+                                 extended_coordinates,
+                                 prev_unbroken_timestamp,
+                                 t,
+                                 max_distance_delta);
+
+            // Unlike in whole traces the previous point is kept, points that can not be
+            // reached are skipped. It might be the frontier, whose predecessors are gone.
+            if (!model.breakage[t])
             {
-                if (model.viterbi_reachable[parent_timestamp_index][parent_candidate_index] ||
-                    model.pruned[parent_timestamp_index][parent_candidate_index])
-                {
-                    break;
-                }
-                model.viterbi_reachable[parent_timestamp_index][parent_candidate_index] = true;
-                const auto &next = model.parents[parent_timestamp_index][parent_candidate_index];
-                parent_timestamp_index = next.first;
-                parent_candidate_index = next.second;
+                prev_unbroken_timestamp = t;
             }
-            model.viterbi_reachable[parent_timestamp_index][parent_candidate_index] = true;
+            continue;
         }
 
-        auto matching_distance = 0.0;
-        auto trace_distance = 0.0;
-        matching.nodes.reserve(reconstructed_indices.size());
-        matching.indices.reserve(reconstructed_indices.size());
-        for (const auto &idx : reconstructed_indices)
+        auto matching = reconstructSubMatching(
+            model, extended_coordinates, sub_matching_begin, prev_unbroken_timestamp + 1);
+        if (matching)
         {
-            const auto timestamp_index = idx.first;
-            const auto location_index = idx.second;
-
-            matching.indices.push_back(timestamp_index);
-            matching.nodes.push_back(candidates_list[timestamp_index][location_index].phantom_node);
-            auto const routes_count =
-                std::accumulate(model.viterbi_reachable[timestamp_index].begin(),
-                                model.viterbi_reachable[timestamp_index].end(),
-                                0);
-            BOOST_ASSERT(routes_count > 0);
-            // we don't count the current route in the "alternatives_count" parameter
-            matching.alternatives_count.push_back(routes_count - 1);
-            matching_distance += model.path_distances[timestamp_index][location_index];
+            sub_matchings.push_back(std::move(*matching));
         }
-        util::for_each_pair(
-            reconstructed_indices,
-            [&trace_distance, &trace_coordinates](const std::pair<std::size_t, std::size_t> &prev,
-                                                  const std::pair<std::size_t, std::size_t> &curr) {
-                trace_distance += util::coordinate_calculation::haversineDistance(
-                    trace_coordinates[prev.first], trace_coordinates[curr.first]);
-            });
 
-        matching.confidence = confidence(trace_distance, matching_distance);
+        initial_timestamp = model.initialize(t);
+        prev_unbroken_timestamp = initial_timestamp;
+        sub_matching_begin = initial_timestamp;
+        // the head of the loop continues with the point after the new start
+        t = initial_timestamp;
+    }
 
-        sub_matchings.push_back(matching);
-        sub_matching_begin = sub_matching_end;
+    if (initial_timestamp == map_matching::INVALID_STATE)
+    {
+        // no point could be matched since the last split, the next request starts over
+        frontier.Clear();
+    }
+    else
+    {
+        auto matching = reconstructSubMatching(
+            model, extended_coordinates, sub_matching_begin, prev_unbroken_timestamp + 1);
+        if (matching)
+        {
+            sub_matchings.push_back(std::move(*matching));
+        }
+
+        const auto last_timestamp = extended_candidates_list.size() - 1;
+        const auto frontier_viterbi = model.viterbi[prev_unbroken_timestamp];
+        const auto frontier_pruned = model.pruned[prev_unbroken_timestamp];
+        const auto max_viterbi =
+            *std::max_element(frontier_viterbi.begin(), frontier_viterbi.end());
+        frontier.candidates = extended_candidates_list[prev_unbroken_timestamp];
+        frontier.viterbi.assign(frontier_viterbi.begin(), frontier_viterbi.end());
+        for (auto &viterbi : frontier.viterbi)
+        {
+            viterbi -= max_viterbi;
+        }
+        frontier.pruned.assign(frontier_pruned.begin(), frontier_pruned.end());
+        frontier.coordinate = extended_coordinates[prev_unbroken_timestamp];
+        frontier.timestamp = boost::none;
+        if (use_timestamps)
+        {
+            frontier.timestamp = extended_timestamps[prev_unbroken_timestamp];
+        }
+        frontier.broken_points =
+            trace_position(last_timestamp) - trace_position(prev_unbroken_timestamp);
+    }
+
+    if (!first_sample_times)
+    {
+        frontier.AddSampleTimes(new_sample_times);
+    }
+
+    // the frontier is not a point of the new trace
+    for (auto &matching : sub_matchings)
+    {
+        for (auto &index : matching.indices)
+        {
+            index = index == 0 ? map_matching::INVALID_TRACE_INDEX : index - 1;
+        }
     }
 
     return sub_matchings;
@@ -445,7 +877,8 @@ mapMatching(SearchEngineData<ch::Algorithm> &engine_working_data,
             const std::vector<util::Coordinate> &trace_coordinates,
             const std::vector<unsigned> &trace_timestamps,
             const std::vector<boost::optional<double>> &trace_gps_precision,
-            const bool allow_splitting);
+            const bool allow_splitting,
+            const std::vector<SearchEngineData<ch::Algorithm> *> &helper_contexts);
 
 // MLD
 template SubMatchingList
@@ -455,7 +888,30 @@ mapMatching(SearchEngineData<mld::Algorithm> &engine_working_data,
             const std::vector<util::Coordinate> &trace_coordinates,
             const std::vector<unsigned> &trace_timestamps,
             const std::vector<boost::optional<double>> &trace_gps_precision,
-            const bool allow_splitting);
+            const bool allow_splitting,
+            const std::vector<SearchEngineData<mld::Algorithm> *> &helper_contexts);
+
+// CH
+template SubMatchingList
+streamingMapMatching(SearchEngineData<ch::Algorithm> &engine_working_data,
+                     const DataFacade<ch::Algorithm> &facade,
+                     map_matching::MatchingFrontier &frontier,
+                     const CandidateLists &candidates_list,
+                     const std::vector<util::Coordinate> &trace_coordinates,
+                     const std::vector<unsigned> &trace_timestamps,
+                     const std::vector<boost::optional<double>> &trace_gps_precision,
+                     const bool allow_splitting);
+
+// MLD
+template SubMatchingList
+streamingMapMatching(SearchEngineData<mld::Algorithm> &engine_working_data,
+                     const DataFacade<mld::Algorithm> &facade,
+                     map_matching::MatchingFrontier &frontier,
+                     const CandidateLists &candidates_list,
+                     const std::vector<util::Coordinate> &trace_coordinates,
+                     const std::vector<unsigned> &trace_timestamps,
+                     const std::vector<boost::optional<double>> &trace_gps_precision,
+                     const bool allow_splitting);
 
 } // namespace routing_algorithms
 } // namespace engine
@@ -5,130 +5,100 @@ namespace osrm
 namespace engine
 {
 
-// CH heaps
-using CH = routing_algorithms::ch::Algorithm;
-SearchEngineData<CH>::SearchEngineHeapPtr SearchEngineData<CH>::forward_heap_1;
-SearchEngineData<CH>::SearchEngineHeapPtr SearchEngineData<CH>::reverse_heap_1;
-SearchEngineData<CH>::SearchEngineHeapPtr SearchEngineData<CH>::forward_heap_2;
-SearchEngineData<CH>::SearchEngineHeapPtr SearchEngineData<CH>::reverse_heap_2;
-SearchEngineData<CH>::SearchEngineHeapPtr SearchEngineData<CH>::forward_heap_3;
-SearchEngineData<CH>::SearchEngineHeapPtr SearchEngineData<CH>::reverse_heap_3;
-SearchEngineData<CH>::ManyToManyHeapPtr SearchEngineData<CH>::many_to_many_heap;
-
-void SearchEngineData<CH>::InitializeOrClearFirstThreadLocalStorage(unsigned number_of_nodes)
+namespace
 {
-    if (forward_heap_1.get())
-    {
-        forward_heap_1->Clear();
-    }
-    else
-    {
-        forward_heap_1.reset(new QueryHeap(number_of_nodes));
-    }
+template <typename HeapPtr, typename... HeapArgs>
+void initializeOrClearHeap(HeapPtr &heap, HeapArgs... args)
+{
+    using Heap = typename HeapPtr::element_type;
 
-    if (reverse_heap_1.get())
+    if (heap)
     {
-        reverse_heap_1->Clear();
+        heap->Clear();
     }
     else
     {
-        reverse_heap_1.reset(new QueryHeap(number_of_nodes));
+        heap = std::make_unique<Heap>(args...);
     }
 }
 
-void SearchEngineData<CH>::InitializeOrClearSecondThreadLocalStorage(unsigned number_of_nodes)
+template <typename HeapPtr> std::size_t getMemoryUsage(const HeapPtr &heap)
 {
-    if (forward_heap_2.get())
-    {
-        forward_heap_2->Clear();
-    }
-    else
-    {
-        forward_heap_2.reset(new QueryHeap(number_of_nodes));
-    }
+    return heap ? heap->GetMemoryUsage() : 0;
+}
+}
 
-    if (reverse_heap_2.get())
-    {
-        reverse_heap_2->Clear();
-    }
-    else
-    {
-        reverse_heap_2.reset(new QueryHeap(number_of_nodes));
-    }
+// CH heaps
+using CH = routing_algorithms::ch::Algorithm;
+
+void SearchEngineData<CH>::InitializeOrClearFirstHeaps(unsigned number_of_nodes)
+{
+    initializeOrClearHeap(forward_heap_1, number_of_nodes, use_dense_heaps);
+    initializeOrClearHeap(reverse_heap_1, number_of_nodes, use_dense_heaps);
 }
 
-void SearchEngineData<CH>::InitializeOrClearThirdThreadLocalStorage(unsigned number_of_nodes)
+void SearchEngineData<CH>::InitializeOrClearSecondHeaps(unsigned number_of_nodes)
 {
-    if (forward_heap_3.get())
-    {
-        forward_heap_3->Clear();
-    }
-    else
-    {
-        forward_heap_3.reset(new QueryHeap(number_of_nodes));
-    }
+    initializeOrClearHeap(forward_heap_2, number_of_nodes, use_dense_heaps);
+    initializeOrClearHeap(reverse_heap_2, number_of_nodes, use_dense_heaps);
+}
 
-    if (reverse_heap_3.get())
-    {
-        reverse_heap_3->Clear();
-    }
-    else
-    {
-        reverse_heap_3.reset(new QueryHeap(number_of_nodes));
-    }
+void SearchEngineData<CH>::InitializeOrClearThirdHeaps(unsigned number_of_nodes)
+{
+    initializeOrClearHeap(forward_heap_3, number_of_nodes, use_dense_heaps);
+    initializeOrClearHeap(reverse_heap_3, number_of_nodes, use_dense_heaps);
 }
 
-void SearchEngineData<CH>::InitializeOrClearManyToManyThreadLocalStorage(unsigned number_of_nodes)
+void SearchEngineData<CH>::InitializeOrClearManyToManyHeaps(unsigned number_of_nodes)
 {
-    if (many_to_many_heap.get())
-    {
-        many_to_many_heap->Clear();
-    }
-    else
-    {
-        many_to_many_heap.reset(new ManyToManyQueryHeap(number_of_nodes));
-    }
+    initializeOrClearHeap(many_to_many_heap, number_of_nodes, use_dense_heaps);
+}
+
+std::size_t SearchEngineData<CH>::GetMemoryUsage() const
+{
+    return getMemoryUsage(forward_heap_1) + getMemoryUsage(reverse_heap_1) +
+           getMemoryUsage(forward_heap_2) + getMemoryUsage(reverse_heap_2) +
+           getMemoryUsage(forward_heap_3) + getMemoryUsage(reverse_heap_3) +
+           getMemoryUsage(many_to_many_heap) + hidden_markov_model_storage.GetMemoryUsage();
 }
 
 // MLD
 using MLD = routing_algorithms::mld::Algorithm;
-SearchEngineData<MLD>::SearchEngineHeapPtr SearchEngineData<MLD>::forward_heap_1;
-SearchEngineData<MLD>::SearchEngineHeapPtr SearchEngineData<MLD>::reverse_heap_1;
-SearchEngineData<MLD>::ManyToManyHeapPtr SearchEngineData<MLD>::many_to_many_heap;
 
-void SearchEngineData<MLD>::InitializeOrClearFirstThreadLocalStorage(
-    unsigned number_of_nodes, unsigned number_of_boundary_nodes)
+void SearchEngineData<MLD>::InitializeOrClearFirstHeaps(unsigned number_of_nodes,
+                                                        unsigned number_of_boundary_nodes)
 {
-    if (forward_heap_1.get())
-    {
-        forward_heap_1->Clear();
-    }
-    else
-    {
-        forward_heap_1.reset(new QueryHeap(number_of_nodes, number_of_boundary_nodes));
-    }
+    initializeOrClearHeap(forward_heap_1, number_of_nodes, number_of_boundary_nodes);
+    initializeOrClearHeap(reverse_heap_1, number_of_nodes, number_of_boundary_nodes);
+}
 
-    if (reverse_heap_1.get())
-    {
-        reverse_heap_1->Clear();
-    }
-    else
-    {
-        reverse_heap_1.reset(new QueryHeap(number_of_nodes, number_of_boundary_nodes));
-    }
+void SearchEngineData<MLD>::InitializeOrClearManyToManyHeaps(unsigned number_of_nodes,
+                                                             unsigned number_of_boundary_nodes)
+{
+    initializeOrClearHeap(many_to_many_heap, number_of_nodes, number_of_boundary_nodes);
 }
 
-void SearchEngineData<MLD>::InitializeOrClearManyToManyThreadLocalStorage(
-    unsigned number_of_nodes, unsigned number_of_boundary_nodes)
+void SearchEngineData<MLD>::InitializeOrClearNodeWeights(unsigned number_of_boundary_nodes)
 {
-    if (many_to_many_heap.get())
-    {
-        many_to_many_heap->Clear();
-    }
-    else
-    {
-        many_to_many_heap.reset(new ManyToManyQueryHeap(number_of_nodes, number_of_boundary_nodes));
+    for (auto *node_weights : {&forward_node_weights, &reverse_node_weights})
+    {
+        // the number of overlay nodes changes if the facade was swapped
+        if (*node_weights && (*node_weights)->GetNumberOfOverlayNodes() == number_of_boundary_nodes)
+        {
+            (*node_weights)->Clear();
+        }
+        else
+        {
+            *node_weights = std::make_unique<util::ConcurrentNodeWeights>(number_of_boundary_nodes);
+        }
     }
 }
+
+std::size_t SearchEngineData<MLD>::GetMemoryUsage() const
+{
+    return getMemoryUsage(forward_heap_1) + getMemoryUsage(reverse_heap_1) +
+           getMemoryUsage(many_to_many_heap) + getMemoryUsage(forward_node_weights) +
+           getMemoryUsage(reverse_node_weights) + hidden_markov_model_storage.GetMemoryUsage();
+}
 }
 }
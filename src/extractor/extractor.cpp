@@ -360,7 +360,7 @@ int Extractor::run(ScriptingEnvironment &scripting_environment)
 
     util::Log() << "Building r-tree ...";
     TIMER_START(rtree);
-    BuildRTree(std::move(edge_based_node_segments), coordinates);
+    BuildRTree(std::move(edge_based_node_segments), coordinates, edge_based_nodes_container);
 
     TIMER_STOP(rtree);
 
@@ -799,7 +799,8 @@ EdgeID Extractor::BuildEdgeExpandedGraph(
     Saves tree into '.ramIndex' and leaves into '.fileIndex'.
  */
 void Extractor::BuildRTree(std::vector<EdgeBasedNodeSegment> edge_based_node_segments,
-                           const std::vector<util::Coordinate> &coordinates)
+                           const std::vector<util::Coordinate> &coordinates,
+                           const EdgeBasedNodeDataContainer &nodes_container)
 {
     util::Log() << "Constructing r-tree of " << edge_based_node_segments.size()
                 << " segments build on-top of " << coordinates.size() << " coordinates";
@@ -818,14 +819,41 @@ void Extractor::BuildRTree(std::vector<EdgeBasedNodeSegment> edge_based_node_seg
                               SOURCE_REF);
     }
 
+    // Attributes of the segments that the filters of the nearest neighbour queries check, the
+    // tree nodes aggregate them so the queries can skip subtrees without admissible segments
+    const auto get_segment_attributes = [&nodes_container](const EdgeBasedNodeSegment &segment) {
+        auto attributes = util::RTreeSegmentAttributes::Empty();
+        for (const auto &segment_id : {segment.forward_segment_id, segment.reverse_segment_id})
+        {
+            if (!segment_id.enabled)
+                continue;
+            attributes.common_classes &= nodes_container.GetClassData(segment_id.id);
+        }
+
+        if (segment.is_startpoint)
+            attributes.flags |= util::RTreeSegmentAttributes::STARTPOINT;
+        // the queries take the component of the forward direction for both
+        BOOST_ASSERT(segment.forward_segment_id.enabled);
+        attributes.flags |= nodes_container.GetComponentID(segment.forward_segment_id.id).is_tiny
+                                ? util::RTreeSegmentAttributes::TINY_COMPONENT
+                                : util::RTreeSegmentAttributes::BIG_COMPONENT;
+        return attributes;
+    };
+
     TIMER_START(construction);
-    util::StaticRTree<EdgeBasedNodeSegment> rtree(
-        edge_based_node_segments, coordinates, config.GetPath(".osrm.fileIndex"));
+    util::StaticRTree<EdgeBasedNodeSegment> rtree(edge_based_node_segments,
+                                                  coordinates,
+                                                  config.GetPath(".osrm.fileIndex"),
+                                                  get_segment_attributes);
+    TIMER_STOP(construction);
 
+    TIMER_START(write_ram_index);
     files::writeRamIndex(config.GetPath(".osrm.ramIndex"), rtree);
+    TIMER_STOP(write_ram_index);
 
-    TIMER_STOP(construction);
-    util::Log() << "finished r-tree construction in " << TIMER_SEC(construction) << " seconds";
+    util::Log() << "finished r-tree construction in " << TIMER_SEC(construction)
+                << " seconds, writing the tree nodes took " << TIMER_SEC(write_ram_index)
+                << " seconds";
 }
 
 template <typename Map> auto convertIDMapToVector(const Map &map)
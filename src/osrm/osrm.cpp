@@ -1,13 +1,16 @@
 #include "osrm/osrm.hpp"
 
 #include "engine/algorithm.hpp"
+#include "engine/api/isochrone_parameters.hpp"
 #include "engine/api/match_parameters.hpp"
+#include "engine/api/matched_trace.hpp"
 #include "engine/api/nearest_parameters.hpp"
 #include "engine/api/route_parameters.hpp"
 #include "engine/api/table_parameters.hpp"
 #include "engine/api/trip_parameters.hpp"
 #include "engine/engine.hpp"
 #include "engine/engine_config.hpp"
+#include "engine/search_context_statistics.hpp"
 #include "engine/status.hpp"
 
 #include <memory>
@@ -21,6 +24,7 @@ OSRM::OSRM(engine::EngineConfig &config)
 {
     using CH = engine::routing_algorithms::ch::Algorithm;
     using MLD = engine::routing_algorithms::mld::Algorithm;
+    using HL = engine::routing_algorithms::hl::Algorithm;
 
     // First, check that necessary core data is available
     if (!config.use_shared_memory && !config.storage_config.IsValid())
@@ -29,6 +33,12 @@ OSRM::OSRM(engine::EngineConfig &config)
                               "pre-processing steps been run?");
     }
 
+    if (!config.use_mmap &&
+        config.storage_config.rtree_leaves_preload != storage::StorageConfig::PreloadPolicy::None)
+    {
+        throw util::exception("Preloading the R-tree leaves requires use_mmap.");
+    }
+
     // Now, check that the algorithm requested can be used with the data
     // that's available.
 
@@ -46,6 +56,9 @@ OSRM::OSRM(engine::EngineConfig &config)
     case EngineConfig::Algorithm::MLD:
         engine_ = std::make_unique<engine::Engine<MLD>>(config);
         break;
+    case EngineConfig::Algorithm::HL:
+        engine_ = std::make_unique<engine::Engine<HL>>(config);
+        break;
     default:
         util::exception("Algorithm not implemented!");
     }
@@ -83,9 +96,26 @@ engine::Status OSRM::Match(const engine::api::MatchParameters &params, json::Obj
     return engine_->Match(params, result);
 }
 
+engine::Status OSRM::MatchBatch(const std::vector<engine::api::MatchParameters> &traces,
+                                std::vector<engine::api::MatchedTrace> &results) const
+{
+    return engine_->MatchBatch(traces, results);
+}
+
 engine::Status OSRM::Tile(const engine::api::TileParameters &params, std::string &result) const
 {
     return engine_->Tile(params, result);
 }
 
+engine::Status OSRM::Isochrone(const engine::api::IsochroneParameters &params,
+                               json::Object &result) const
+{
+    return engine_->Isochrone(params, result);
+}
+
+engine::SearchContextStatistics OSRM::GetSearchContextStatistics() const
+{
+    return engine_->GetSearchContextStatistics();
+}
+
 } // ns osrm
@@ -32,10 +32,15 @@ std::string getWrongOptionHelp(const engine::api::MatchParameters &parameters)
         constrainParamSize(
             PARAMETER_SIZE_MISMATCH_MSG, "timestamps", parameters.timestamps, coord_size, help);
 
-    if (!param_size_mismatch && parameters.coordinates.size() < 2)
+    if (!param_size_mismatch && parameters.coordinates.size() < 2 && parameters.session.empty())
     {
         help = "Number of coordinates needs to be at least two.";
     }
+    else if (!param_size_mismatch && !parameters.session.empty() &&
+             (parameters.tidy || !parameters.waypoints.empty()))
+    {
+        help = "Sessions do not support the tidy and waypoints parameters.";
+    }
 
     return help;
 }
@@ -260,6 +260,10 @@ int Storage::Run(int max_wait, const std::string &dataset_name, bool only_metric
         std::unique_ptr<storage::BaseDataLayout> static_layout =
             std::make_unique<storage::ContiguousDataLayout>();
         Storage::PopulateLayoutWithRTree(*static_layout);
+        if (config.load_rtree_leaves)
+        {
+            Storage::PopulateLayoutWithRTreeLeaves(*static_layout);
+        }
         std::vector<std::pair<bool, boost::filesystem::path>> files = Storage::GetStaticFiles();
         Storage::PopulateLayout(*static_layout, files);
         auto static_handle = setupRegion(shared_register, *static_layout);
@@ -327,6 +331,7 @@ std::vector<std::pair<bool, boost::filesystem::path>> Storage::GetUpdatableFiles
         {OPTIONAL, config.GetPath(".osrm.mldgr")},
         {OPTIONAL, config.GetPath(".osrm.cell_metrics")},
         {OPTIONAL, config.GetPath(".osrm.hsgr")},
+        {OPTIONAL, config.GetPath(".osrm.hl")},
         {REQUIRED, config.GetPath(".osrm.datasource_names")},
         {REQUIRED, config.GetPath(".osrm.geometry")},
         {REQUIRED, config.GetPath(".osrm.turn_weight_penalties")},
@@ -359,6 +364,16 @@ std::string Storage::PopulateLayoutWithRTree(storage::BaseDataLayout &layout)
     return rtree_filename;
 }
 
+void Storage::PopulateLayoutWithRTreeLeaves(storage::BaseDataLayout &layout)
+{
+    // The .fileIndex file holds nothing but the leaves, it has no fingerprint
+    const auto file_index_size = boost::filesystem::file_size(config.GetPath(".osrm.fileIndex"));
+    layout.SetBlock(
+        "/common/rtree/leaves",
+        make_block<extractor::EdgeBasedNodeSegment>(file_index_size /
+                                                    sizeof(extractor::EdgeBasedNodeSegment)));
+}
+
 /**
  * This function examines all our data files and figures out how much
  * memory needs to be allocated, and the position of each data structure
@@ -444,6 +459,15 @@ void Storage::PopulateStaticData(const SharedDataIndex &index)
         extractor::files::readRamIndex(config.GetPath(".osrm.ramIndex"), rtree);
     }
 
+    // load the leaves of the rtree if they are kept in memory
+    if (index.HasBlock("/common/rtree/leaves"))
+    {
+        io::FileReader reader(config.GetPath(".osrm.fileIndex"), io::FileReader::HasNoFingerprint);
+        reader.ReadInto(
+            index.GetBlockPtr<extractor::EdgeBasedNodeSegment>("/common/rtree/leaves"),
+            index.GetBlockEntries("/common/rtree/leaves"));
+    }
+
     // FIXME we only need to get the weight name
     std::string metric_name;
     // load profile properties
@@ -556,6 +580,27 @@ void Storage::PopulateUpdatableData(const SharedDataIndex &index)
         }
     }
 
+    if (boost::filesystem::exists(config.GetPath(".osrm.hl")))
+    {
+        std::unordered_map<std::string, std::vector<contractor::HubLabelsView>> metrics = {
+            {metric_name, make_hub_labels_views(index, "/hl/metrics/" + metric_name)}};
+
+        std::uint32_t labels_connectivity_checksum = 0;
+        contractor::files::readHubLabels(
+            config.GetPath(".osrm.hl"), metrics, labels_connectivity_checksum);
+
+        auto turns_connectivity_checksum =
+            *index.GetBlockPtr<std::uint32_t>("/common/connectivity_checksum");
+        if (turns_connectivity_checksum != labels_connectivity_checksum)
+        {
+            throw util::exception(
+                "Connectivity checksum " + std::to_string(labels_connectivity_checksum) + " in " +
+                config.GetPath(".osrm.hl").string() + " does not equal to checksum " +
+                std::to_string(turns_connectivity_checksum) + " in " +
+                config.GetPath(".osrm.edges").string());
+        }
+    }
+
     if (boost::filesystem::exists(config.GetPath(".osrm.cell_metrics")))
     {
         auto exclude_metrics = make_cell_metric_view(index, "/mld/metrics/" + metric_name);
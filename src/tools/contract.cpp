@@ -47,6 +47,15 @@ return_code parseArguments(int argc,
         boost::program_options::value<unsigned int>(&contractor_config.requested_num_threads)
             ->default_value(tbb::task_scheduler_init::default_num_threads()),
         "Number of threads to use")(
+        "rank-ordered-layout",
+        boost::program_options::bool_switch(&contractor_config.rank_ordered_layout)
+            ->default_value(false),
+        "Store the edges of the contracted graph ordered by hierarchy level instead of node "
+        "ID for better cache locality of queries")(
+        "hub-labels",
+        boost::program_options::bool_switch(&contractor_config.hub_labels)->default_value(false),
+        "Derive hub labels from the contracted graph and write them to .osrm.hl, needed by the "
+        "HL algorithm")(
         "core,k",
         boost::program_options::value<double>(&contractor_config.core_factor)->default_value(1.0),
         "DEPRECATED: Will always be 1.0. Percentage of the graph (in vertices) to contract "
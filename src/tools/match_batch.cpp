@@ -0,0 +1,450 @@
+#include "util/exception.hpp"
+#include "util/integer_range.hpp"
+#include "util/log.hpp"
+#include "util/timing_util.hpp"
+#include "util/version.hpp"
+
+#include "osrm/coordinate.hpp"
+#include "osrm/engine_config.hpp"
+#include "osrm/exception.hpp"
+#include "osrm/match_parameters.hpp"
+#include "osrm/matched_trace.hpp"
+#include "osrm/osrm.hpp"
+#include "osrm/status.hpp"
+#include "osrm/storage_config.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
+#include <boost/program_options.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace osrm;
+
+namespace
+{
+
+// Binary traces start with this magic, followed by the traces:
+//   std::uint64_t id, std::uint32_t number of points,
+//   per point std::int32_t longitude and latitude in 1e-6 degrees, std::uint32_t timestamp and
+//   float radius, which uses the default GPS precision if not positive.
+// All values are in native byte order.
+const constexpr std::array<char, 8> TRACES_MAGIC = {{'O', 'S', 'R', 'M', 'T', 'R', 'C', '1'}};
+
+// Matched traces start with this magic, followed by the result of every input trace:
+//   std::uint64_t id, std::uint32_t number of sub-matchings n, std::uint32_t number of points m,
+//   n float confidences, n + 1 std::uint32_t offsets of the sub-matchings into the points,
+//   m std::uint32_t trace indices, m std::uint32_t edge-based nodes and
+//   m pairs of std::int32_t longitude and latitude in 1e-6 degrees.
+const constexpr std::array<char, 8> MATCHES_MAGIC = {{'O', 'S', 'R', 'M', 'M', 'T', 'C', '1'}};
+
+enum class InputFormat
+{
+    CSV,
+    Binary
+};
+
+struct Trace
+{
+    std::uint64_t id;
+    MatchParameters parameters;
+};
+
+// Reads traces in chunks, so that inputs of any size are matched in constant memory
+class TraceReader
+{
+  public:
+    TraceReader(const boost::filesystem::path &path, const InputFormat format)
+        : input(path.string(), std::ios::binary), format(format)
+    {
+        if (!input)
+            throw util::exception("Could not open " + path.string());
+
+        if (format == InputFormat::Binary)
+        {
+            std::array<char, TRACES_MAGIC.size()> magic;
+            if (!input.read(magic.data(), magic.size()) || magic != TRACES_MAGIC)
+                throw util::exception(path.string() + " is not a binary trace file");
+        }
+    }
+
+    // Returns less than the given number of traces only at the end of the input
+    std::vector<Trace> Read(const std::size_t number_of_traces)
+    {
+        std::vector<Trace> traces;
+        traces.reserve(number_of_traces);
+        while (traces.size() < number_of_traces)
+        {
+            auto trace = format == InputFormat::CSV ? ReadCSV() : ReadBinary();
+            if (!trace)
+                break;
+            traces.push_back(std::move(*trace));
+        }
+        return traces;
+    }
+
+  private:
+    struct Point
+    {
+        std::int32_t longitude;
+        std::int32_t latitude;
+        std::uint32_t timestamp;
+        float radius;
+    };
+    static_assert(sizeof(Point) == 16, "binary trace points are expected to be packed");
+
+    boost::optional<Trace> ReadBinary()
+    {
+        Trace trace;
+        std::uint32_t number_of_points;
+        if (!input.read(reinterpret_cast<char *>(&trace.id), sizeof(trace.id)))
+            return boost::none;
+        if (!input.read(reinterpret_cast<char *>(&number_of_points), sizeof(number_of_points)))
+            throw util::exception("Truncated binary trace file");
+
+        points.resize(number_of_points);
+        if (!input.read(reinterpret_cast<char *>(points.data()), number_of_points * sizeof(Point)))
+            throw util::exception("Truncated binary trace file");
+
+        auto &parameters = trace.parameters;
+        parameters.coordinates.reserve(number_of_points);
+        parameters.timestamps.reserve(number_of_points);
+        parameters.radiuses.reserve(number_of_points);
+        for (const auto &point : points)
+        {
+            parameters.coordinates.push_back(
+                {util::FixedLongitude{point.longitude}, util::FixedLatitude{point.latitude}});
+            parameters.timestamps.push_back(point.timestamp);
+            parameters.radiuses.push_back(point.radius > 0 ? boost::make_optional<double>(
+                                                                 point.radius)
+                                                           : boost::none);
+        }
+        return trace;
+    }
+
+    // Lines of id,longitude,latitude[,timestamp[,radius]], consecutive lines of the same id
+    // form a trace. Traces without a timestamp for every point are matched without timestamps.
+    boost::optional<Trace> ReadCSV()
+    {
+        boost::optional<Trace> trace;
+        bool has_timestamps = true;
+        while (pending_line || std::getline(input, line))
+        {
+            pending_line = false;
+            std::replace(line.begin(), line.end(), ',', ' ');
+            std::istringstream fields(line);
+
+            std::uint64_t id;
+            double longitude, latitude;
+            if (!(fields >> id >> longitude >> latitude))
+            {
+                // header or empty line
+                continue;
+            }
+            if (trace && trace->id != id)
+            {
+                pending_line = true;
+                // restores the line for the next trace
+                std::replace(line.begin(), line.end(), ' ', ',');
+                break;
+            }
+            if (!trace)
+            {
+                trace = Trace{id, {}};
+            }
+
+            auto &parameters = trace->parameters;
+            parameters.coordinates.push_back(
+                {util::FloatLongitude{longitude}, util::FloatLatitude{latitude}});
+
+            unsigned timestamp;
+            double radius;
+            if (fields >> timestamp)
+                parameters.timestamps.push_back(timestamp);
+            else
+                has_timestamps = false;
+            parameters.radiuses.push_back(fields >> radius && radius > 0
+                                              ? boost::make_optional(radius)
+                                              : boost::none);
+        }
+
+        if (trace && !has_timestamps)
+        {
+            trace->parameters.timestamps.clear();
+        }
+        return trace;
+    }
+
+    std::ifstream input;
+    const InputFormat format;
+    std::vector<Point> points;
+    std::string line;
+    bool pending_line = false;
+};
+
+class MatchWriter
+{
+  public:
+    explicit MatchWriter(const boost::filesystem::path &path)
+        : output(path.string(), std::ios::binary)
+    {
+        if (!output)
+            throw util::exception("Could not open " + path.string());
+        output.write(MATCHES_MAGIC.data(), MATCHES_MAGIC.size());
+    }
+
+    void Write(const std::uint64_t id, const MatchedTrace &matched_trace)
+    {
+        const std::uint32_t number_of_sub_matchings = matched_trace.confidences.size();
+        const std::uint32_t number_of_points = matched_trace.indices.size();
+        WriteValue(id);
+        WriteValue(number_of_sub_matchings);
+        WriteValue(number_of_points);
+        WriteVector(matched_trace.confidences);
+        if (matched_trace.sub_matching_offsets.empty())
+            WriteValue(std::uint32_t{0});
+        else
+            WriteVector(matched_trace.sub_matching_offsets);
+        WriteVector(matched_trace.indices);
+        WriteVector(matched_trace.nodes);
+
+        locations.clear();
+        for (const auto location : matched_trace.locations)
+        {
+            locations.push_back(static_cast<std::int32_t>(location.lon));
+            locations.push_back(static_cast<std::int32_t>(location.lat));
+        }
+        WriteVector(locations);
+    }
+
+    void Flush()
+    {
+        output.flush();
+        if (!output)
+            throw util::exception("Could not write the matched traces");
+    }
+
+  private:
+    template <typename T> void WriteValue(const T value)
+    {
+        output.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    template <typename T> void WriteVector(const std::vector<T> &values)
+    {
+        output.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+    }
+
+    std::ofstream output;
+    std::vector<std::int32_t> locations;
+};
+}
+
+int main(int argc, const char *argv[]) try
+{
+    util::LogPolicy::GetInstance().Unmute();
+
+    const auto *executable = argv[0];
+    EngineConfig config;
+    boost::filesystem::path base_path;
+    boost::filesystem::path input_path;
+    boost::filesystem::path output_path;
+    std::string input_format_name;
+    std::size_t batch_size;
+    bool tidy = false;
+
+    using boost::program_options::value;
+
+    boost::program_options::options_description generic_options("Options");
+    generic_options.add_options()            //
+        ("version,v", "Show version")        //
+        ("help,h", "Show this help message") //
+        ("verbosity,l",
+         value<std::string>(&config.verbosity)->default_value("INFO"),
+         std::string("Log verbosity level: " + util::LogPolicy::GetLevels()).c_str());
+
+    boost::program_options::options_description config_options("Configuration");
+    config_options.add_options() //
+        ("input,i",
+         value<boost::filesystem::path>(&input_path)->required(),
+         "Traces to match, CSV lines of id,longitude,latitude[,timestamp[,radius]] or binary") //
+        ("output,o",
+         value<boost::filesystem::path>(&output_path)->required(),
+         "Binary file the matched traces are written to") //
+        ("input-format",
+         value<std::string>(&input_format_name),
+         "Format of the input, csv or binary. Default: csv for .csv files, binary otherwise") //
+        ("batch-size",
+         value<std::size_t>(&batch_size)->default_value(10000),
+         "Number of traces read and matched at once") //
+        ("tidy",
+         value<bool>(&tidy)->implicit_value(true)->default_value(false),
+         "Remove points too close to each other before matching") //
+        ("threads,t",
+         value<unsigned>(&config.search_context_pool_size)
+             ->default_value(std::max(1u, std::thread::hardware_concurrency())),
+         "Number of traces matched in parallel") //
+        ("shared-memory,s",
+         value<bool>(&config.use_shared_memory)->implicit_value(true)->default_value(false),
+         "Load data from shared memory") //
+        ("mmap,m",
+         value<bool>(&config.use_mmap)->implicit_value(true)->default_value(false),
+         "Map datafiles directly, do not use any additional memory.") //
+        ("dataset-name",
+         value<std::string>(&config.dataset_name),
+         "Name of the shared memory dataset to connect to.") //
+        ("dense-query-heaps",
+         value<bool>(&config.use_dense_query_heaps)->implicit_value(true)->default_value(false),
+         "Index CH query heaps with arrays of the graph size instead of hash maps.") //
+        ("algorithm,a",
+         value<EngineConfig::Algorithm>(&config.algorithm)
+             ->default_value(EngineConfig::Algorithm::CH, "CH"),
+         "Algorithm to use for the data. Can be CH, CoreCH, MLD, HL.");
+
+    boost::program_options::options_description hidden_options("Hidden options");
+    hidden_options.add_options()(
+        "base,b", value<boost::filesystem::path>(&base_path), "base path to .osrm file");
+
+    boost::program_options::positional_options_description positional_options;
+    positional_options.add("base", 1);
+
+    boost::program_options::options_description cmdline_options;
+    cmdline_options.add(generic_options).add(config_options).add(hidden_options);
+
+    boost::program_options::options_description visible_options(
+        boost::filesystem::path(executable).filename().string() + " <base.osrm> [<options>]");
+    visible_options.add(generic_options).add(config_options);
+
+    boost::program_options::variables_map option_variables;
+    try
+    {
+        boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+                                          .options(cmdline_options)
+                                          .positional(positional_options)
+                                          .run(),
+                                      option_variables);
+
+        if (option_variables.count("version"))
+        {
+            std::cout << OSRM_VERSION << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+        if (option_variables.count("help"))
+        {
+            std::cout << visible_options;
+            return EXIT_SUCCESS;
+        }
+
+        boost::program_options::notify(option_variables);
+    }
+    catch (const boost::program_options::error &e)
+    {
+        util::Log(logERROR) << e.what();
+        return EXIT_FAILURE;
+    }
+
+    util::LogPolicy::GetInstance().SetLevel(config.verbosity);
+
+    if (!base_path.empty())
+    {
+        config.storage_config = storage::StorageConfig(base_path);
+    }
+    if (!config.use_shared_memory && !config.storage_config.IsValid())
+    {
+        util::Log(logERROR) << "Required files are missing, cannot continue";
+        return EXIT_FAILURE;
+    }
+    if (!config.IsValid() || batch_size == 0)
+    {
+        util::Log(logERROR) << "Invalid configuration";
+        return EXIT_FAILURE;
+    }
+
+    InputFormat input_format = input_path.extension() == ".csv" ? InputFormat::CSV
+                                                                 : InputFormat::Binary;
+    if (input_format_name == "csv")
+        input_format = InputFormat::CSV;
+    else if (input_format_name == "binary")
+        input_format = InputFormat::Binary;
+    else if (!input_format_name.empty())
+    {
+        util::Log(logERROR) << "Unknown input format " << input_format_name;
+        return EXIT_FAILURE;
+    }
+
+    const OSRM osrm{config};
+    TraceReader reader(input_path, input_format);
+    MatchWriter writer(output_path);
+
+    std::size_t number_of_traces = 0;
+    std::size_t number_of_points = 0;
+    std::size_t number_of_matched_traces = 0;
+    std::size_t number_of_matched_points = 0;
+
+    TIMER_START(match_batch);
+    std::vector<MatchParameters> batch;
+    std::vector<MatchedTrace> results;
+    for (auto traces = reader.Read(batch_size); !traces.empty(); traces = reader.Read(batch_size))
+    {
+        batch.clear();
+        for (auto &trace : traces)
+        {
+            trace.parameters.tidy = tidy;
+            number_of_points += trace.parameters.coordinates.size();
+            batch.push_back(std::move(trace.parameters));
+        }
+
+        if (osrm.MatchBatch(batch, results) != Status::Ok)
+        {
+            util::Log(logERROR) << "Map matching is not supported by the algorithm";
+            return EXIT_FAILURE;
+        }
+
+        for (const auto index : util::irange<std::size_t>(0, traces.size()))
+        {
+            writer.Write(traces[index].id, results[index]);
+            number_of_matched_traces += results[index].confidences.empty() ? 0 : 1;
+            number_of_matched_points += results[index].indices.size();
+        }
+        number_of_traces += traces.size();
+        util::Log(logDEBUG) << "Matched " << number_of_traces << " traces";
+    }
+    writer.Flush();
+    TIMER_STOP(match_batch);
+
+    util::Log() << "Matched " << number_of_matched_traces << " of " << number_of_traces
+                << " traces and " << number_of_matched_points << " of " << number_of_points
+                << " points in " << TIMER_SEC(match_batch) << "s, "
+                << static_cast<std::size_t>(number_of_points /
+                                            std::max(TIMER_SEC(match_batch), 1e-3) * 60)
+                << " points per minute";
+
+    return EXIT_SUCCESS;
+}
+catch (const osrm::RuntimeError &e)
+{
+    util::Log(logERROR) << e.what();
+    return e.GetCode();
+}
+catch (const std::bad_alloc &e)
+{
+    util::Log(logERROR) << "[exception] " << e.what();
+    util::Log(logERROR) << "Please provide more memory or consider using a larger swapfile";
+    return EXIT_FAILURE;
+}
+catch (const std::exception &e)
+{
+    util::Log(logERROR) << "[exception] " << e.what();
+    return EXIT_FAILURE;
+}
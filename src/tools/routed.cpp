@@ -18,6 +18,7 @@
 
 #include <signal.h>
 
+#include <algorithm>
 #include <chrono>
 #include <exception>
 #include <future>
@@ -54,23 +55,27 @@ const static unsigned INIT_FAILED = -1;
 
 namespace osrm
 {
-namespace engine
+namespace storage
 {
-std::istream &operator>>(std::istream &in, EngineConfig::Algorithm &algorithm)
+std::istream &operator>>(std::istream &in, StorageConfig::PreloadPolicy &policy)
 {
     std::string token;
     in >> token;
     boost::to_lower(token);
 
-    if (token == "ch" || token == "corech")
-        algorithm = EngineConfig::Algorithm::CH;
-    else if (token == "mld")
-        algorithm = EngineConfig::Algorithm::MLD;
+    if (token == "none")
+        policy = StorageConfig::PreloadPolicy::None;
+    else if (token == "willneed")
+        policy = StorageConfig::PreloadPolicy::WillNeed;
+    else if (token == "populate")
+        policy = StorageConfig::PreloadPolicy::Populate;
+    else if (token == "lock")
+        policy = StorageConfig::PreloadPolicy::Lock;
     else
-        throw util::RuntimeError(token, ErrorCode::UnknownAlgorithm, SOURCE_REF);
+        throw boost::program_options::invalid_option_value(token);
     return in;
 }
-} // namespace engine
+} // namespace storage
 } // namespace osrm
 
 // generate boost::program_options object for the routing part
@@ -123,13 +128,52 @@ inline unsigned generateServerProgramOptions(const int argc,
             "mmap,m",
             value<bool>(&config.use_mmap)->implicit_value(true)->default_value(false),
             "Map datafiles directly, do not use any additional memory.") //
+        ("load-rtree-leaves",
+         value<bool>(&config.storage_config.load_rtree_leaves)
+             ->implicit_value(true)
+             ->default_value(false),
+         "Load the leaves of the R-tree into memory instead of mapping the .fileIndex file. "
+         "Has no effect with --shared-memory or --mmap.") //
+        ("preload-rtree-leaves",
+         value<storage::StorageConfig::PreloadPolicy>(&config.storage_config.rtree_leaves_preload)
+             ->default_value(storage::StorageConfig::PreloadPolicy::None, "none"),
+         "Read the leaves of the R-tree from disk before serving requests: none, willneed (in "
+         "the background), populate or lock (also locks them in memory). Requires --mmap.") //
+        ("dense-query-heaps",
+         value<bool>(&config.use_dense_query_heaps)->implicit_value(true)->default_value(false),
+         "Use query heaps indexed by node instead of hash maps for CH. Faster, but each "
+         "thread needs memory proportional to the graph size.") //
+        ("parallel-bidirectional-search",
+         value<bool>(&config.use_parallel_bidirectional_search)
+             ->implicit_value(true)
+             ->default_value(false),
+         "Run the forward and reverse search of long MLD routes on two threads.") //
+        ("prewarm-search-contexts",
+         value<bool>(&config.prewarm_search_contexts)->implicit_value(true)->default_value(false),
+         "Allocate the query heaps of all threads at startup instead of by their first "
+         "requests.") //
+        ("search-space-cache-size",
+         value<unsigned>(&config.search_space_cache_size)->default_value(0),
+         "MiB of memory used to cache the search spaces of frequent distance table targets "
+         "with CH. Default: disabled.") //
+        ("phantom-node-cache-size",
+         value<unsigned>(&config.phantom_node_cache_size)->default_value(0),
+         "MiB of memory used to cache the road positions coordinates were snapped to, so that "
+         "repeated coordinates skip the spatial search. Default: disabled.") //
+        ("max-matching-sessions",
+         value<unsigned>(&config.max_matching_sessions)->default_value(0),
+         "Max. number of map matching sessions that extend live traces by new points. "
+         "Default: disabled.") //
+        ("matching-session-ttl",
+         value<unsigned>(&config.matching_session_ttl)->default_value(300),
+         "Seconds after which unused map matching sessions expire.") //
         ("dataset-name",
          value<std::string>(&config.dataset_name),
          "Name of the shared memory dataset to connect to.") //
         ("algorithm,a",
          value<EngineConfig::Algorithm>(&config.algorithm)
              ->default_value(EngineConfig::Algorithm::CH, "CH"),
-         "Algorithm to use for the data. Can be CH, CoreCH, MLD.") //
+         "Algorithm to use for the data. Can be CH, CoreCH, MLD, HL.") //
         ("max-viaroute-size",
          value<int>(&config.max_locations_viaroute)->default_value(500),
          "Max. locations supported in viaroute query") //
@@ -148,9 +192,16 @@ inline unsigned generateServerProgramOptions(const int argc,
         ("max-alternatives",
          value<int>(&config.max_alternatives)->default_value(3),
          "Max. number of alternatives supported in the MLD route query") //
+        ("max-alternatives-search-time",
+         value<int>(&config.max_alternatives_search_time)->default_value(-1),
+         "Max. milliseconds spent on evaluating alternatives, the best ones found until then "
+         "are returned. Default: unlimited.") //
         ("max-matching-radius",
          value<double>(&config.max_radius_map_matching)->default_value(-1.0),
-         "Max. radius size supported in map matching query. Default: unlimited.");
+         "Max. radius size supported in map matching query. Default: unlimited.") //
+        ("max-isochrone-duration",
+         value<double>(&config.max_duration_isochrone)->default_value(-1.0),
+         "Max. contour in seconds supported in isochrone query. Default: unlimited.");
 
     // hidden options, will be allowed on command line, but will not be shown to the user
     boost::program_options::options_description hidden_options("Hidden options");
@@ -247,13 +298,23 @@ int main(int argc, const char *argv[]) try
 
     if (!base_path.empty())
     {
+        // only the paths are derived from the base path
+        const auto options = config.storage_config;
         config.storage_config = storage::StorageConfig(base_path);
+        config.storage_config.load_rtree_leaves = options.load_rtree_leaves;
+        config.storage_config.rtree_leaves_preload = options.rtree_leaves_preload;
     }
     if (!config.use_shared_memory && !config.storage_config.IsValid())
     {
         util::Log(logERROR) << "Required files are missing, cannot continue";
         return EXIT_FAILURE;
     }
+    if (!config.use_mmap &&
+        config.storage_config.rtree_leaves_preload != storage::StorageConfig::PreloadPolicy::None)
+    {
+        util::Log(logERROR) << "--preload-rtree-leaves requires --mmap";
+        return EXIT_FAILURE;
+    }
     if (!config.IsValid())
     {
         if (base_path.empty() != config.use_shared_memory)
@@ -271,6 +332,8 @@ int main(int argc, const char *argv[]) try
     }
 
     util::Log() << "Threads: " << requested_thread_num;
+    // Every server thread handles one request at a time and needs one search context
+    config.search_context_pool_size = std::max(requested_thread_num, 1);
     util::Log() << "IP address: " << ip_address;
     util::Log() << "IP port: " << ip_port;
 
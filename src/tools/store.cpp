@@ -100,7 +100,8 @@ bool generateDataStoreOptions(const int argc,
                               std::string &dataset_name,
                               bool &list_datasets,
                               bool &list_blocks,
-                              bool &only_metric)
+                              bool &only_metric,
+                              bool &load_rtree_leaves)
 {
     // declare a group of options that will be allowed only on command line
     boost::program_options::options_description generic_options("Options");
@@ -141,7 +142,13 @@ bool generateDataStoreOptions(const int argc,
                 ->implicit_value(true),
             "Only reload the metric data without updating the full dataset. This is an "
             "optimization "
-            "for traffic updates.");
+            "for traffic updates.")(
+            "load-rtree-leaves",
+            boost::program_options::value<bool>(&load_rtree_leaves)
+                ->default_value(false)
+                ->implicit_value(true),
+            "Load the leaves of the R-tree into shared memory, so that queries do not read the "
+            ".fileIndex file from disk.");
 
     // hidden options, will be allowed on command line but will not be shown to the user
     boost::program_options::options_description hidden_options("Hidden options");
@@ -238,6 +245,7 @@ int main(const int argc, const char *argv[]) try
     bool list_datasets = false;
     bool list_blocks = false;
     bool only_metric = false;
+    bool load_rtree_leaves = false;
     if (!generateDataStoreOptions(argc,
                                   argv,
                                   verbosity,
@@ -246,7 +254,8 @@ int main(const int argc, const char *argv[]) try
                                   dataset_name,
                                   list_datasets,
                                   list_blocks,
-                                  only_metric))
+                                  only_metric,
+                                  load_rtree_leaves))
     {
         return EXIT_SUCCESS;
     }
@@ -265,6 +274,7 @@ int main(const int argc, const char *argv[]) try
         util::Log(logERROR) << "Config contains invalid file paths. Exiting!";
         return EXIT_FAILURE;
     }
+    config.load_rtree_leaves = load_rtree_leaves;
     storage::Storage storage(std::move(config));
 
     return storage.Run(max_wait, dataset_name, only_metric);
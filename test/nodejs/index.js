@@ -65,13 +65,13 @@ test('constructor: throws if given a non-string/obj argument', function(assert)
 test('constructor: throws if given an unkown algorithm', function(assert) {
     assert.plan(1);
     assert.throws(function() { new OSRM({algorithm: 'Foo', shared_memory: true}); },
-        /algorithm option must be one of 'CH', 'CoreCH', or 'MLD'/);
+        /algorithm option must be one of 'CH', 'CoreCH', 'MLD', or 'HL'/);
 });
 
 test('constructor: throws if given an invalid algorithm', function(assert) {
     assert.plan(1);
     assert.throws(function() { new OSRM({algorithm: 3, shared_memory: true}); },
-        /algorithm option must be a string and one of 'CH', 'CoreCH', or 'MLD'/);
+        /algorithm option must be a string and one of 'CH', 'CoreCH', 'MLD', or 'HL'/);
 });
 
 test('constructor: loads MLD if given as algorithm', function(assert) {
@@ -0,0 +1,249 @@
+#include "contractor/contract_excludable_graph.hpp"
+#include "contractor/files.hpp"
+#include "contractor/hub_labels.hpp"
+
+#include "../common/temporary_file.hpp"
+#include "helper.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <tbb/task_scheduler_init.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <tuple>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(hub_labels)
+
+using namespace osrm;
+using namespace osrm::contractor;
+using namespace osrm::unit_test;
+
+namespace
+{
+HubLabel makeLabel(const std::vector<NodeID> &hubs, const std::vector<EdgeWeight> &weights)
+{
+    return HubLabel{hubs.data(), weights.data(), nullptr, nullptr, hubs.size()};
+}
+
+EdgeWeight queryWeight(const HubLabelSet &forward, const HubLabelSet &backward, NodeID s, NodeID t)
+{
+    std::vector<NodeID> forward_hubs;
+    std::vector<NodeID> backward_hubs;
+    const auto forward_label = forward.GetLabel(s, forward_hubs);
+    const auto backward_label = backward.GetLabel(t, backward_hubs);
+    EdgeWeight weight = INVALID_EDGE_WEIGHT;
+    intersectHubLabels(forward_label,
+                       backward_label,
+                       [&](const std::size_t forward_index, const std::size_t backward_index) {
+                           weight = std::min(weight,
+                                             forward_label.weights[forward_index] +
+                                                 backward_label.weights[backward_index]);
+                       });
+    return weight;
+}
+
+std::vector<TestEdge> makeRandomEdges(const unsigned number_of_nodes, std::mt19937 &generator)
+{
+    std::uniform_int_distribution<unsigned> node_distribution(0, number_of_nodes - 1);
+    std::uniform_int_distribution<int> weight_distribution(1, 20);
+
+    std::vector<TestEdge> edges;
+    for (const auto node : util::irange(0u, number_of_nodes))
+    {
+        for (auto count = 0; count < 3; ++count)
+        {
+            const auto target = node_distribution(generator);
+            if (target == node ||
+                std::any_of(edges.begin(), edges.end(), [&](const auto &edge) {
+                    return std::get<0>(edge) == node && std::get<1>(edge) == target;
+                }))
+                continue;
+            edges.emplace_back(node, target, weight_distribution(generator));
+        }
+    }
+    return edges;
+}
+}
+
+BOOST_AUTO_TEST_CASE(intersect_labels)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<NodeID> hub_distribution(0, 100);
+    std::uniform_int_distribution<std::size_t> size_distribution(0, 40);
+
+    for (auto round = 0; round < 500; ++round)
+    {
+        std::vector<NodeID> lhs_hubs(size_distribution(generator));
+        std::vector<NodeID> rhs_hubs(size_distribution(generator));
+        for (auto &hub : lhs_hubs)
+            hub = hub_distribution(generator);
+        for (auto &hub : rhs_hubs)
+            hub = hub_distribution(generator);
+        for (auto *hubs : {&lhs_hubs, &rhs_hubs})
+        {
+            std::sort(hubs->begin(), hubs->end());
+            hubs->erase(std::unique(hubs->begin(), hubs->end()), hubs->end());
+        }
+        const std::vector<EdgeWeight> lhs_weights(lhs_hubs.size(), 0);
+        const std::vector<EdgeWeight> rhs_weights(rhs_hubs.size(), 0);
+
+        std::vector<NodeID> reference;
+        std::set_intersection(lhs_hubs.begin(),
+                              lhs_hubs.end(),
+                              rhs_hubs.begin(),
+                              rhs_hubs.end(),
+                              std::back_inserter(reference));
+
+        std::vector<NodeID> result;
+        intersectHubLabels(makeLabel(lhs_hubs, lhs_weights),
+                           makeLabel(rhs_hubs, rhs_weights),
+                           [&](const std::size_t lhs_index, const std::size_t rhs_index) {
+                               BOOST_CHECK_EQUAL(lhs_hubs[lhs_index], rhs_hubs[rhs_index]);
+                               result.push_back(lhs_hubs[lhs_index]);
+                           });
+        BOOST_CHECK(result == reference);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(encode_decode_hubs)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<NodeID> gap_distribution(1, 1000);
+
+    std::vector<std::vector<NodeID>> labels = {{},
+                                               {7},
+                                               {0, 1, 2, 3, 4, 5},
+                                               {0, SPECIAL_NODEID - 1},
+                                               {3, 1u << 31, SPECIAL_NODEID - 1}};
+    for (const auto size : {1u, 31u, 32u, 33u, 64u, 100u})
+    {
+        std::vector<NodeID> consecutive(size);
+        std::iota(consecutive.begin(), consecutive.end(), 1000);
+        labels.push_back(std::move(consecutive));
+
+        std::vector<NodeID> random(size);
+        NodeID hub = 0;
+        for (auto &random_hub : random)
+        {
+            hub += gap_distribution(generator);
+            random_hub = hub;
+        }
+        labels.push_back(std::move(random));
+    }
+
+    std::vector<std::uint32_t> words;
+    std::vector<std::size_t> offsets;
+    for (const auto &label : labels)
+    {
+        offsets.push_back(words.size());
+        encodeHubs(label.data(), label.size(), words);
+    }
+    // consecutive hubs only take the two words of the block header
+    BOOST_CHECK_EQUAL(offsets[3] - offsets[2], 2);
+
+    for (const auto index : util::irange<std::size_t>(0, labels.size()))
+    {
+        std::vector<NodeID> decoded(labels[index].size());
+        decodeHubs(words.data() + offsets[index], decoded.size(), decoded.data());
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            decoded.begin(), decoded.end(), labels[index].begin(), labels[index].end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(labels_match_shortest_paths)
+{
+    tbb::task_scheduler_init scheduler(2);
+
+    const unsigned number_of_nodes = 40;
+    std::mt19937 generator(1337);
+    const auto edges = makeRandomEdges(number_of_nodes, generator);
+
+    // all pairs shortest paths of the input graph as reference
+    std::vector<std::vector<EdgeWeight>> reference(
+        number_of_nodes, std::vector<EdgeWeight>(number_of_nodes, INVALID_EDGE_WEIGHT));
+    for (const auto node : util::irange(0u, number_of_nodes))
+        reference[node][node] = 0;
+    for (const auto &edge : edges)
+    {
+        auto &weight = reference[std::get<0>(edge)][std::get<1>(edge)];
+        weight = std::min(weight, std::get<2>(edge));
+    }
+    for (const auto via : util::irange(0u, number_of_nodes))
+        for (const auto from : util::irange(0u, number_of_nodes))
+            for (const auto to : util::irange(0u, number_of_nodes))
+                if (reference[from][via] != INVALID_EDGE_WEIGHT &&
+                    reference[via][to] != INVALID_EDGE_WEIGHT)
+                    reference[from][to] =
+                        std::min(reference[from][to], reference[from][via] + reference[via][to]);
+
+    auto graph_and_filter = contractFullGraph(makeGraph(edges),
+                                              std::vector<EdgeWeight>(number_of_nodes, 1));
+    const auto &graph = std::get<0>(graph_and_filter);
+    const auto &filter = std::get<1>(graph_and_filter).front();
+
+    const auto labels = computeHubLabels(graph, filter);
+    BOOST_REQUIRE_EQUAL(labels.forward.GetNumberOfNodes(), number_of_nodes);
+    BOOST_REQUIRE_EQUAL(labels.backward.GetNumberOfNodes(), number_of_nodes);
+
+    for (const auto from : util::irange(0u, number_of_nodes))
+    {
+        for (const auto to : util::irange(0u, number_of_nodes))
+        {
+            BOOST_CHECK_EQUAL(queryWeight(labels.forward, labels.backward, from, to),
+                              reference[from][to]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(read_write_hub_labels)
+{
+    const std::vector<TestEdge> edges = {TestEdge{0, 1, 3},
+                                         TestEdge{0, 5, 1},
+                                         TestEdge{1, 3, 3},
+                                         TestEdge{1, 4, 1},
+                                         TestEdge{3, 1, 1},
+                                         TestEdge{4, 3, 1},
+                                         TestEdge{5, 1, 1}};
+    auto graph_and_filter = contractFullGraph(makeGraph(edges), std::vector<EdgeWeight>(6, 1));
+    const auto &graph = std::get<0>(graph_and_filter);
+    const auto &filter = std::get<1>(graph_and_filter).front();
+
+    std::unordered_map<std::string, std::vector<HubLabels>> reference_metrics;
+    reference_metrics["duration"].push_back(computeHubLabels(graph, filter));
+    reference_metrics["duration"].push_back(
+        computeHubLabels(graph, std::vector<bool>(filter.size(), false)));
+
+    TemporaryFile tmp{TEST_DATA_DIR "/read_write_hub_labels_test.osrm.hl"};
+    files::writeHubLabels(tmp.path, reference_metrics, 0xDEADBEEF);
+
+    std::uint32_t connectivity_checksum;
+    std::unordered_map<std::string, std::vector<HubLabels>> metrics = {{"duration", {}}};
+    files::readHubLabels(tmp.path, metrics, connectivity_checksum);
+
+    BOOST_CHECK_EQUAL(connectivity_checksum, 0xDEADBEEF);
+    BOOST_REQUIRE_EQUAL(metrics["duration"].size(), 2);
+    for (const auto index : {0, 1})
+    {
+        const auto &reference = reference_metrics["duration"][index];
+        const auto &labels = metrics["duration"][index];
+        BOOST_CHECK_EQUAL(labels.forward.GetNumberOfEntries(),
+                          reference.forward.GetNumberOfEntries());
+        BOOST_CHECK_EQUAL(labels.backward.GetNumberOfEntries(),
+                          reference.backward.GetNumberOfEntries());
+        for (const auto from : util::irange(0u, 6u))
+            for (const auto to : util::irange(0u, 6u))
+                BOOST_CHECK_EQUAL(queryWeight(labels.forward, labels.backward, from, to),
+                                  queryWeight(reference.forward, reference.backward, from, to));
+    }
+
+    // without any edges every node only reaches itself
+    const auto &isolated = metrics["duration"][1];
+    BOOST_CHECK_EQUAL(queryWeight(isolated.forward, isolated.backward, 3, 3), 0);
+    BOOST_CHECK_EQUAL(queryWeight(isolated.forward, isolated.backward, 0, 1),
+                      INVALID_EDGE_WEIGHT);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
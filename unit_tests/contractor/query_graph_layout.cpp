@@ -0,0 +1,256 @@
+#include "contractor/files.hpp"
+#include "contractor/query_graph_layout.hpp"
+
+#include "../common/range_tools.hpp"
+#include "../common/temporary_file.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(query_graph_layout)
+
+using namespace osrm;
+using namespace osrm::contractor;
+
+namespace
+{
+// (source, target, weight, duration, turn_id, shortcut, forward, backward)
+using EdgeTuple = std::tuple<NodeID, NodeID, EdgeWeight, EdgeWeight, NodeID, bool, bool, bool>;
+
+std::vector<EdgeTuple> getEdges(const QueryGraph &graph)
+{
+    std::vector<EdgeTuple> edges;
+    for (const auto node : util::irange<NodeID>(0, graph.GetNumberOfNodes()))
+    {
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            const auto data = graph.GetEdgeData(edge);
+            BOOST_CHECK_EQUAL(data.weight, graph.GetEdgeWeight(edge));
+            BOOST_CHECK_EQUAL(data.forward, graph.IsForwardEdge(edge));
+            BOOST_CHECK_EQUAL(data.backward, graph.IsBackwardEdge(edge));
+            edges.emplace_back(node,
+                               graph.GetTarget(edge),
+                               data.weight,
+                               data.duration,
+                               data.turn_id,
+                               data.shortcut,
+                               data.forward,
+                               data.backward);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    return edges;
+}
+
+//                  +--> 4 --+
+//                  |        v
+// 0 --> 1 --> 2 --> 3 -----> 5
+std::vector<QueryEdge> makeEdges()
+{
+    return {QueryEdge{0, 1, {10, false, 3, 6, 1.0, true, false}},
+            QueryEdge{1, 2, {11, false, 2, 4, 1.0, true, true}},
+            QueryEdge{2, 3, {12, false, 1, 2, 1.0, false, true}},
+            QueryEdge{3, 4, {13, false, 4, 8, 1.0, true, false}},
+            QueryEdge{3, 5, {4, true, 7, 14, 2.0, true, false}},
+            QueryEdge{4, 5, {14, false, 3, 6, 1.0, true, false}}};
+}
+}
+
+BOOST_AUTO_TEST_CASE(split_layout)
+{
+    const auto edges = makeEdges();
+    QueryGraph graph{6, edges};
+
+    BOOST_CHECK_EQUAL(graph.GetNumberOfNodes(), 6);
+    BOOST_CHECK_EQUAL(graph.GetNumberOfEdges(), 6);
+    BOOST_CHECK(!graph.IsReordered());
+    BOOST_CHECK_EQUAL(graph.GetOutDegree(3), 2);
+    BOOST_CHECK_EQUAL(graph.GetOutDegree(5), 0);
+
+    const auto shortcut = graph.FindEdge(3, 5);
+    BOOST_REQUIRE(shortcut != SPECIAL_EDGEID);
+    const auto data = graph.GetEdgeData(shortcut);
+    BOOST_CHECK(data.shortcut);
+    BOOST_CHECK_EQUAL(data.turn_id, 4);
+    BOOST_CHECK_EQUAL(data.weight, 7);
+    BOOST_CHECK_EQUAL(data.duration, 14);
+    BOOST_CHECK_EQUAL(data.distance, 2.0);
+
+    std::vector<EdgeTuple> reference;
+    for (const auto &edge : edges)
+    {
+        reference.emplace_back(edge.source,
+                               edge.target,
+                               edge.data.weight,
+                               edge.data.duration,
+                               edge.data.turn_id,
+                               edge.data.shortcut,
+                               edge.data.forward,
+                               edge.data.backward);
+    }
+    BOOST_CHECK(getEdges(graph) == reference);
+}
+
+BOOST_AUTO_TEST_CASE(large_weights)
+{
+    const EdgeWeight large_weight = (1 << 29) + 1;
+    const EdgeWeight largest_weight = INVALID_EDGE_WEIGHT - 1;
+    QueryGraph graph{3,
+                     std::vector<QueryEdge>{
+                         QueryEdge{0, 1, {10, false, large_weight, 6, 1.0, true, false}},
+                         QueryEdge{1, 2, {11, false, largest_weight, 4, 1.0, false, true}}}};
+
+    BOOST_CHECK_EQUAL(graph.GetEdgeWeight(graph.FindEdge(0, 1)), large_weight);
+    BOOST_CHECK_EQUAL(graph.GetEdgeWeight(graph.FindEdge(1, 2)), largest_weight);
+    BOOST_CHECK(graph.IsForwardEdge(graph.FindEdge(0, 1)));
+    BOOST_CHECK(!graph.IsBackwardEdge(graph.FindEdge(0, 1)));
+    BOOST_CHECK(!graph.IsForwardEdge(graph.FindEdge(1, 2)));
+    BOOST_CHECK(graph.IsBackwardEdge(graph.FindEdge(1, 2)));
+    BOOST_CHECK_EQUAL(graph.GetEdgeData(graph.FindEdge(1, 2)).weight, largest_weight);
+}
+
+BOOST_AUTO_TEST_CASE(rank_order)
+{
+    QueryGraph graph{6, makeEdges()};
+
+    const auto order = computeRankOrder(graph);
+    // 5 is the top of the hierarchy, 0 the only node without upward edges into it
+    CHECK_EQUAL_RANGE(order, 5, 4, 3, 2, 1, 0);
+}
+
+BOOST_AUTO_TEST_CASE(reorder_keeps_edges_and_filters)
+{
+    QueryGraph reference_graph{6, makeEdges()};
+    QueryGraph graph{6, makeEdges()};
+
+    std::vector<std::vector<bool>> filters = {{true, false, true, false, true, false},
+                                              {false, true, true, true, false, true}};
+    std::vector<std::vector<std::tuple<NodeID, NodeID, bool>>> reference_filters(filters.size());
+    for (const auto index : util::irange<std::size_t>(0, filters.size()))
+    {
+        for (const auto node : util::irange<NodeID>(0, 6))
+        {
+            for (const auto edge : reference_graph.GetAdjacentEdgeRange(node))
+            {
+                reference_filters[index].emplace_back(
+                    node, reference_graph.GetTarget(edge), filters[index][edge]);
+            }
+        }
+        std::sort(reference_filters[index].begin(), reference_filters[index].end());
+    }
+
+    reorderByRank(graph, filters);
+
+    BOOST_CHECK(graph.IsReordered());
+    BOOST_CHECK_EQUAL(graph.GetNumberOfNodes(), 6);
+    BOOST_CHECK_EQUAL(graph.GetNumberOfEdges(), 6);
+    BOOST_CHECK(getEdges(graph) == getEdges(reference_graph));
+
+    // the edges of the top node come first
+    BOOST_CHECK_EQUAL(graph.BeginEdges(4), 0);
+    BOOST_CHECK_EQUAL(graph.EndEdges(0), graph.GetNumberOfEdges());
+
+    for (const auto index : util::irange<std::size_t>(0, filters.size()))
+    {
+        std::vector<std::tuple<NodeID, NodeID, bool>> reordered_filter;
+        for (const auto node : util::irange<NodeID>(0, 6))
+        {
+            for (const auto edge : graph.GetAdjacentEdgeRange(node))
+            {
+                reordered_filter.emplace_back(node, graph.GetTarget(edge), filters[index][edge]);
+            }
+        }
+        std::sort(reordered_filter.begin(), reordered_filter.end());
+        BOOST_CHECK(reordered_filter == reference_filters[index]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(read_write_reordered_hsgr)
+{
+    QueryGraph graph{6, makeEdges()};
+    std::vector<std::vector<bool>> filters = {{true, true, true, true, true, true}};
+    reorderByRank(graph, filters);
+    const auto reference_edges = getEdges(graph);
+
+    std::unordered_map<std::string, ContractedMetric> reference_metrics = {
+        {"duration", {std::move(graph), std::move(filters)}}};
+
+    TemporaryFile tmp{TEST_DATA_DIR "/read_write_reordered_hsgr_test.osrm.hsgr"};
+    contractor::files::writeGraph(tmp.path, reference_metrics, 0);
+
+    unsigned connectivity_checksum;
+    std::unordered_map<std::string, ContractedMetric> metrics = {{"duration", {}}};
+    contractor::files::readGraph(tmp.path, metrics, connectivity_checksum);
+
+    const auto &read_graph = metrics["duration"].graph;
+    BOOST_CHECK(read_graph.IsReordered());
+    BOOST_CHECK_EQUAL(read_graph.GetNumberOfEdges(), 6);
+    BOOST_CHECK(getEdges(read_graph) == reference_edges);
+}
+
+BOOST_AUTO_TEST_CASE(shortcut_children)
+{
+    // 0 is the middle node of all shortcuts between 1 and 2
+    const std::vector<QueryEdge> edges = {
+        QueryEdge{0, 1, {10, false, 1, 1, 1.0, false, true}},
+        QueryEdge{0, 1, {11, false, 1, 1, 1.0, true, false}},
+        QueryEdge{0, 2, {12, false, 2, 2, 1.0, true, false}},
+        QueryEdge{0, 2, {13, false, 5, 5, 1.0, true, false}},
+        QueryEdge{0, 2, {14, false, 2, 2, 1.0, false, true}},
+        QueryEdge{1, 2, {0, true, 3, 3, 2.0, true, false}},
+        QueryEdge{1, 2, {0, true, 3, 3, 2.0, false, true}},
+        QueryEdge{1, 2, {0, true, 3, 3, 2.0, true, true}}};
+
+    const auto check_children = [](const QueryGraph &graph,
+                                   const EdgeID shortcut,
+                                   const EdgeID source_child,
+                                   const EdgeID target_child) {
+        const auto children = graph.GetShortcutChildren(shortcut);
+        BOOST_CHECK_EQUAL(children.first, source_child);
+        BOOST_CHECK_EQUAL(children.second, target_child);
+    };
+
+    QueryGraph graph{3, edges};
+    check_children(graph, 5, SPECIAL_EDGEID, SPECIAL_EDGEID);
+
+    storeShortcutChildren(graph, {std::vector<bool>(edges.size(), true)});
+    BOOST_CHECK(graph.HasShortcutChildren());
+    // 1 -> 0 -> 2, the smaller parallel edge is used
+    check_children(graph, 5, 0, 2);
+    // 2 -> 0 -> 1
+    check_children(graph, 6, 1, 4);
+    // both directions unpack into different edges
+    check_children(graph, 7, SPECIAL_EDGEID, SPECIAL_EDGEID);
+
+    // without edge 2 the first shortcut unpacks into edge 3 in the second filter
+    storeShortcutChildren(graph,
+                          {std::vector<bool>(edges.size(), true),
+                           {true, true, false, true, true, true, true, true}});
+    check_children(graph, 5, SPECIAL_EDGEID, SPECIAL_EDGEID);
+    check_children(graph, 6, 1, 4);
+
+    // the children are relative to the middle node and survive reordering
+    storeShortcutChildren(graph, {std::vector<bool>(edges.size(), true)});
+    std::vector<std::vector<bool>> filters = {std::vector<bool>(edges.size(), true)};
+    reorderByRank(graph, filters);
+    BOOST_REQUIRE(graph.IsReordered());
+    for (const auto edge : graph.GetAdjacentEdgeRange(1))
+    {
+        const auto children = graph.GetShortcutChildren(edge);
+        if (graph.IsForwardEdge(edge) != graph.IsBackwardEdge(edge))
+        {
+            const auto source_child = children.first;
+            const auto target_child = children.second;
+            BOOST_REQUIRE(source_child != SPECIAL_EDGEID);
+            BOOST_CHECK_EQUAL(graph.GetTarget(source_child), 1);
+            BOOST_CHECK_EQUAL(graph.GetTarget(target_child), 2);
+            BOOST_CHECK_EQUAL(graph.IsForwardEdge(target_child), graph.IsForwardEdge(edge));
+            BOOST_CHECK_EQUAL(graph.IsBackwardEdge(source_child), graph.IsForwardEdge(edge));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
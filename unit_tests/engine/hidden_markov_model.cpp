@@ -0,0 +1,122 @@
+#include "engine/map_matching/hidden_markov_model.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(hidden_markov_model)
+
+using namespace osrm;
+using namespace osrm::engine::map_matching;
+
+namespace
+{
+// the model only looks at the number of candidates of every point
+using CandidateLists = std::vector<std::vector<int>>;
+}
+
+BOOST_AUTO_TEST_CASE(flat_columns)
+{
+    HiddenMarkovModelStorage storage;
+    const CandidateLists candidates_list = {{1, 2}, {}, {1, 2, 3}};
+    HiddenMarkovModel<CandidateLists> model(candidates_list, storage);
+
+    BOOST_CHECK_EQUAL(model.viterbi.size(), 3);
+    BOOST_CHECK_EQUAL(model.viterbi[0].size(), 2);
+    BOOST_CHECK_EQUAL(model.viterbi[1].size(), 0);
+    BOOST_CHECK_EQUAL(model.viterbi[2].size(), 3);
+    BOOST_CHECK_EQUAL(storage.viterbi.size(), 5);
+    BOOST_CHECK_EQUAL(model.breakage.size(), 3);
+
+    for (const auto t : {0, 2})
+    {
+        for (const auto s : {0, 1})
+        {
+            BOOST_CHECK_EQUAL(model.viterbi[t][s], IMPOSSIBLE_LOG_PROB);
+            BOOST_CHECK(model.pruned[t][s]);
+            BOOST_CHECK(!model.viterbi_reachable[t][s]);
+        }
+        BOOST_CHECK(model.breakage[t]);
+    }
+
+    // the columns do not overlap
+    model.emission_log_probabilities[0][0] = -1.f;
+    model.emission_log_probabilities[0][1] = -2.f;
+    model.emission_log_probabilities[2][0] = -3.f;
+    BOOST_CHECK_EQUAL(storage.emission_log_probabilities[0], -1.f);
+    BOOST_CHECK_EQUAL(storage.emission_log_probabilities[1], -2.f);
+    BOOST_CHECK_EQUAL(storage.emission_log_probabilities[2], -3.f);
+
+    BOOST_CHECK_EQUAL(model.initialize(0), 0);
+    BOOST_CHECK_EQUAL(model.viterbi[0][1], -2.);
+    BOOST_CHECK_EQUAL(model.parents[0][1].second, 1);
+    BOOST_CHECK(!model.pruned[0][1]);
+    BOOST_CHECK(!model.breakage[0]);
+    BOOST_CHECK(model.pruned[2][0]);
+
+    // only the columns after the split are reset
+    model.viterbi[2][0] = -4.;
+    model.Clear(1);
+    BOOST_CHECK_EQUAL(model.viterbi[0][1], -2.);
+    BOOST_CHECK(!model.breakage[0]);
+    BOOST_CHECK_EQUAL(model.viterbi[2][0], IMPOSSIBLE_LOG_PROB);
+    BOOST_CHECK(model.breakage[2]);
+}
+
+BOOST_AUTO_TEST_CASE(storage_reuse)
+{
+    HiddenMarkovModelStorage storage;
+    {
+        const CandidateLists candidates_list(100, std::vector<int>(5));
+        HiddenMarkovModel<CandidateLists> model(candidates_list, storage);
+        BOOST_CHECK_EQUAL(model.initialize(0), 0);
+        model.viterbi_reachable[99][4] = true;
+    }
+    const auto memory_usage = storage.GetMemoryUsage();
+    const auto viterbi = storage.viterbi.data();
+
+    // a shorter trace fits into the arrays of the longer one and starts from a clean model
+    const CandidateLists candidates_list(10, std::vector<int>(3));
+    HiddenMarkovModel<CandidateLists> model(candidates_list, storage);
+    BOOST_CHECK_EQUAL(storage.GetMemoryUsage(), memory_usage);
+    BOOST_CHECK_EQUAL(storage.viterbi.data(), viterbi);
+    BOOST_CHECK_EQUAL(storage.viterbi.size(), 30);
+    for (const auto t : {0, 9})
+    {
+        BOOST_CHECK_EQUAL(model.viterbi[t][2], IMPOSSIBLE_LOG_PROB);
+        BOOST_CHECK(!model.viterbi_reachable[t][2]);
+        BOOST_CHECK(model.breakage[t]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(storage_shrinks_above_cap)
+{
+    HiddenMarkovModelStorage storage;
+    storage.max_retained_states = 50;
+    {
+        const CandidateLists candidates_list(10, std::vector<int>(5));
+        HiddenMarkovModel<CandidateLists> model(candidates_list, storage);
+    }
+    const auto memory_usage = storage.GetMemoryUsage();
+    BOOST_CHECK_GE(storage.viterbi.capacity(), 50);
+
+    // a trace with more states than retained releases its arrays when the model is done
+    std::size_t large_memory_usage;
+    {
+        const CandidateLists candidates_list(100, std::vector<int>(5));
+        HiddenMarkovModel<CandidateLists> model(candidates_list, storage);
+        large_memory_usage = storage.GetMemoryUsage();
+        BOOST_CHECK_GT(large_memory_usage, memory_usage);
+    }
+    BOOST_CHECK_LT(storage.GetMemoryUsage(), large_memory_usage / 5);
+    BOOST_CHECK_EQUAL(storage.viterbi.capacity(), 50);
+    BOOST_CHECK_EQUAL(storage.pruned.capacity(), 50);
+
+    const CandidateLists candidates_list(10, std::vector<int>(3));
+    HiddenMarkovModel<CandidateLists> model(candidates_list, storage);
+    BOOST_CHECK_EQUAL(storage.viterbi.size(), 30);
+    BOOST_CHECK_EQUAL(model.viterbi[9][2], IMPOSSIBLE_LOG_PROB);
+    BOOST_CHECK(model.breakage[9]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
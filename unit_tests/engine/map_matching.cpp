@@ -0,0 +1,27 @@
+#include "engine/routing_algorithms/map_matching.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(map_matching)
+
+using namespace osrm;
+using namespace osrm::engine::routing_algorithms;
+
+BOOST_AUTO_TEST_CASE(trace_parts_at_gaps)
+{
+    // median sample time of 1s, gaps of more than 10s split the trace
+    const std::vector<unsigned> timestamps = {0, 1, 2, 3, 100, 101, 102, 112, 123, 124};
+
+    const std::vector<std::size_t> part_begins = {0, 4, 8};
+    const auto parts = getTracePartBegins(timestamps, true);
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        parts.begin(), parts.end(), part_begins.begin(), part_begins.end());
+
+    // without splitting or timestamps the trace is matched as a whole
+    BOOST_CHECK_EQUAL(getTracePartBegins(timestamps, false).size(), 1);
+    BOOST_CHECK_EQUAL(getTracePartBegins({}, true).size(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
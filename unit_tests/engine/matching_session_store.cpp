@@ -0,0 +1,60 @@
+#include "engine/matching_session_store.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+
+BOOST_AUTO_TEST_SUITE(matching_session_store)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+BOOST_AUTO_TEST_CASE(sessions_are_kept_by_id)
+{
+    MatchingSessionStore store(10, std::chrono::seconds(60));
+    const auto now = MatchingSessionStore::Clock::now();
+
+    auto session = store.Get("a", now);
+    session->frontier.broken_points = 1;
+
+    BOOST_CHECK_EQUAL(store.Get("a", now)->frontier.broken_points, 1);
+    BOOST_CHECK_EQUAL(store.Get("b", now)->frontier.broken_points, 0);
+    BOOST_CHECK_EQUAL(store.GetNumberOfSessions(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(sessions_expire)
+{
+    MatchingSessionStore store(10, std::chrono::seconds(60));
+    const auto now = MatchingSessionStore::Clock::now();
+
+    store.Get("a", now)->frontier.broken_points = 1;
+    store.Get("b", now)->frontier.broken_points = 1;
+
+    // using a session extends its time to live
+    BOOST_CHECK_EQUAL(store.Get("a", now + std::chrono::seconds(50))->frontier.broken_points, 1);
+    BOOST_CHECK_EQUAL(store.Get("c", now + std::chrono::seconds(100))->frontier.broken_points, 0);
+    BOOST_CHECK_EQUAL(store.GetNumberOfSessions(), 2);
+
+    BOOST_CHECK_EQUAL(store.Get("b", now + std::chrono::seconds(100))->frontier.broken_points, 0);
+    BOOST_CHECK_EQUAL(store.Get("a", now + std::chrono::seconds(200))->frontier.broken_points, 0);
+    BOOST_CHECK_EQUAL(store.GetNumberOfSessions(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(least_recently_used_sessions_are_dropped)
+{
+    MatchingSessionStore store(2, std::chrono::seconds(60));
+    const auto now = MatchingSessionStore::Clock::now();
+
+    auto session = store.Get("a", now);
+    session->frontier.broken_points = 1;
+    store.Get("b", now)->frontier.broken_points = 1;
+    store.Get("c", now)->frontier.broken_points = 1;
+    BOOST_CHECK_EQUAL(store.GetNumberOfSessions(), 2);
+
+    // a request still using a dropped session keeps it alive
+    BOOST_CHECK_EQUAL(session->frontier.broken_points, 1);
+    BOOST_CHECK_EQUAL(store.Get("a", now)->frontier.broken_points, 0);
+    BOOST_CHECK_EQUAL(store.Get("c", now)->frontier.broken_points, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -32,7 +32,7 @@ template <> struct SearchEngineData<routing_algorithms::offline::Algorithm>
     SearchEngineHeapPtr forward_heap_1;
     SearchEngineHeapPtr reverse_heap_1;
 
-    void InitializeOrClearFirstThreadLocalStorage(unsigned number_of_nodes)
+    void InitializeOrClearFirstHeaps(unsigned number_of_nodes)
     {
         if (forward_heap_1.get())
         {
@@ -316,6 +316,16 @@ class ContiguousInternalMemoryDataFacade<routing_algorithms::offline::Algorithm>
         return {};
     }
 
+    std::vector<std::pair<PhantomNode, PhantomNode>>
+    NearestPhantomNodesWithAlternativeFromBigComponent(
+        const std::vector<util::Coordinate> &input_coordinates,
+        const std::vector<boost::optional<double>> & /*max_distances*/,
+        const std::vector<boost::optional<Bearing>> & /*bearings*/,
+        const std::vector<boost::optional<Approach>> & /*approaches*/) const override
+    {
+        return std::vector<std::pair<PhantomNode, PhantomNode>>(input_coordinates.size());
+    }
+
     util::guidance::LaneTupleIdPair GetLaneData(const EdgeID /*id*/) const override
     {
         return util::guidance::LaneTupleIdPair{};
@@ -347,6 +357,7 @@ class ContiguousInternalMemoryDataFacade<routing_algorithms::offline::Algorithm>
     double GetWeightMultiplier() const override { return 1; }
     ComponentID GetComponentID(NodeID) const override { return ComponentID{}; }
     bool ExcludeNode(const NodeID) const override { return false; }
+    bool ExcludeClasses(const extractor::ClassData) const override { return false; }
 
     guidance::TurnBearing PreTurnBearing(const EdgeID /*eid*/) const override
     {
@@ -0,0 +1,94 @@
+#include "engine/phantom_node_cache.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(phantom_node_cache)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+PhantomNodePair makePhantomNodes(const NodeID node)
+{
+    PhantomNodePair phantom_nodes;
+    phantom_nodes.first.forward_segment_id = {node, true};
+    phantom_nodes.second.forward_segment_id = {node + 1, true};
+    return phantom_nodes;
+}
+
+PhantomNodeCache::Key makeKey(const std::uint64_t generation,
+                              const int lon,
+                              const boost::optional<double> &radius = boost::none,
+                              const boost::optional<Bearing> &bearing = boost::none,
+                              const Approach approach = Approach::UNRESTRICTED)
+{
+    return {generation,
+            util::Coordinate{util::FixedLongitude{lon}, util::FixedLatitude{43000000}},
+            radius,
+            bearing,
+            approach};
+}
+}
+
+BOOST_AUTO_TEST_CASE(keys_include_snapping_parameters)
+{
+    PhantomNodeCache cache(1 << 20);
+    cache.Insert(makeKey(0, 7000000), makePhantomNodes(1));
+
+    auto phantom_nodes = cache.Get(makeKey(0, 7000000));
+    BOOST_REQUIRE(phantom_nodes);
+    BOOST_CHECK_EQUAL(phantom_nodes->first.forward_segment_id.id, 1);
+    BOOST_CHECK_EQUAL(phantom_nodes->second.forward_segment_id.id, 2);
+
+    BOOST_CHECK(!cache.Get(makeKey(0, 7000001)));
+    BOOST_CHECK(!cache.Get(makeKey(0, 7000000, 10.)));
+    BOOST_CHECK(!cache.Get(makeKey(0, 7000000, boost::none, Bearing{90, 10})));
+    BOOST_CHECK(!cache.Get(makeKey(0, 7000000, boost::none, boost::none, Approach::CURB)));
+    // facade of another dataset or exclude class
+    BOOST_CHECK(!cache.Get(makeKey(1, 7000000)));
+
+    const auto statistics = cache.GetStatistics();
+    BOOST_CHECK_EQUAL(statistics.number_of_entries, 1);
+    BOOST_CHECK_EQUAL(statistics.hits, 1);
+    BOOST_CHECK_EQUAL(statistics.misses, 5);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_access)
+{
+    PhantomNodeCache cache(1 << 20);
+    std::atomic<int> number_of_wrong_entries{0};
+
+    // Boost.Test assertions are not thread safe, wrong entries are only counted in the threads
+    std::vector<std::thread> threads;
+    for (auto thread_index = 0; thread_index < 4; ++thread_index)
+    {
+        threads.emplace_back([&] {
+            for (int lon = 0; lon < 1000; ++lon)
+            {
+                const auto key = makeKey(0, lon);
+                const auto phantom_nodes = cache.Get(key);
+                if (!phantom_nodes)
+                    cache.Insert(key, makePhantomNodes(lon));
+                else if (phantom_nodes->first.forward_segment_id.id != static_cast<NodeID>(lon))
+                    number_of_wrong_entries++;
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    BOOST_CHECK_EQUAL(number_of_wrong_entries, 0);
+    for (int lon = 0; lon < 1000; ++lon)
+    {
+        const auto phantom_nodes = cache.Get(makeKey(0, lon));
+        BOOST_REQUIRE(phantom_nodes);
+        BOOST_CHECK_EQUAL(phantom_nodes->first.forward_segment_id.id, lon);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
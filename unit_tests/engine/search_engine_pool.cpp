@@ -0,0 +1,138 @@
+#include "engine/search_engine_pool.hpp"
+#include "engine/algorithm.hpp"
+
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(search_engine_pool)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+using CHPool = SearchEnginePool<routing_algorithms::ch::Algorithm>;
+
+BOOST_AUTO_TEST_CASE(borrow_and_return)
+{
+    CHPool pool(2, false);
+
+    auto statistics = pool.GetStatistics();
+    BOOST_CHECK_EQUAL(statistics.size, 2);
+    BOOST_CHECK_EQUAL(statistics.in_use, 0);
+    BOOST_CHECK_EQUAL(statistics.memory_usage, 0);
+
+    {
+        auto first = pool.Borrow();
+        auto second = pool.Borrow();
+        BOOST_CHECK(first.get() != second.get());
+
+        first->InitializeOrClearFirstHeaps(100);
+        BOOST_CHECK(first->forward_heap_1);
+        BOOST_CHECK(!second->forward_heap_1);
+
+        statistics = pool.GetStatistics();
+        BOOST_CHECK_EQUAL(statistics.in_use, 2);
+        BOOST_CHECK_EQUAL(statistics.peak_in_use, 2);
+    }
+
+    statistics = pool.GetStatistics();
+    BOOST_CHECK_EQUAL(statistics.in_use, 0);
+    BOOST_CHECK_EQUAL(statistics.peak_in_use, 2);
+    BOOST_CHECK_EQUAL(statistics.number_of_waits, 0);
+    BOOST_CHECK_GT(statistics.memory_usage, 0);
+}
+
+BOOST_AUTO_TEST_CASE(heaps_are_reused)
+{
+    CHPool pool(1, true);
+
+    const SearchEngineData<routing_algorithms::ch::Algorithm>::QueryHeap *heap = nullptr;
+    {
+        auto context = pool.Borrow();
+        context->InitializeOrClearFirstHeaps(100);
+        heap = context->forward_heap_1.get();
+        BOOST_CHECK(context->forward_heap_1->GetIndexStorage().IsDense());
+        context->forward_heap_1->Insert(42, 1, {42});
+    }
+    {
+        auto context = pool.Borrow();
+        context->InitializeOrClearFirstHeaps(100);
+        BOOST_CHECK_EQUAL(context->forward_heap_1.get(), heap);
+        BOOST_CHECK(!context->forward_heap_1->WasInserted(42));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(prewarm_allocates_heaps)
+{
+    CHPool pool(2, false);
+
+    pool.Prewarm([](CHPool::Context &context) { context.InitializeOrClearFirstHeaps(100); });
+
+    const auto statistics = pool.GetStatistics();
+    BOOST_CHECK_EQUAL(statistics.in_use, 0);
+    BOOST_CHECK_EQUAL(statistics.peak_in_use, 0);
+    BOOST_CHECK_GT(statistics.memory_usage, 0);
+
+    auto first = pool.Borrow();
+    auto second = pool.Borrow();
+    BOOST_CHECK(first->forward_heap_1);
+    BOOST_CHECK(second->forward_heap_1);
+}
+
+BOOST_AUTO_TEST_CASE(try_borrow_does_not_block)
+{
+    CHPool pool(2, false);
+
+    auto first = pool.Borrow();
+    {
+        auto second = pool.TryBorrow();
+        BOOST_REQUIRE(second);
+        BOOST_CHECK(first.get() != second.get());
+
+        auto third = pool.TryBorrow();
+        BOOST_CHECK(!third);
+        BOOST_CHECK_EQUAL(pool.GetStatistics().in_use, 2);
+    }
+
+    BOOST_CHECK_EQUAL(pool.GetStatistics().in_use, 1);
+    BOOST_CHECK(pool.TryBorrow());
+    BOOST_CHECK_EQUAL(pool.GetStatistics().number_of_waits, 0);
+}
+
+BOOST_AUTO_TEST_CASE(borrow_is_bounded)
+{
+    CHPool pool(2, false);
+    std::atomic<unsigned> concurrent{0};
+    std::atomic<unsigned> max_concurrent{0};
+
+    std::vector<std::thread> threads;
+    for (unsigned index = 0; index < 8; ++index)
+    {
+        threads.emplace_back([&] {
+            for (unsigned round = 0; round < 50; ++round)
+            {
+                auto context = pool.Borrow();
+                const auto current = ++concurrent;
+                auto previous = max_concurrent.load();
+                while (previous < current &&
+                       !max_concurrent.compare_exchange_weak(previous, current))
+                {
+                }
+                context->InitializeOrClearFirstHeaps(10);
+                --concurrent;
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    BOOST_CHECK_LE(max_concurrent.load(), 2);
+    const auto statistics = pool.GetStatistics();
+    BOOST_CHECK_EQUAL(statistics.in_use, 0);
+    BOOST_CHECK_LE(statistics.peak_in_use, 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
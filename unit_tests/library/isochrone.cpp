@@ -0,0 +1,85 @@
+#include <boost/test/test_case_template.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "coordinates.hpp"
+#include "fixture.hpp"
+
+#include "osrm/isochrone_parameters.hpp"
+
+#include "osrm/coordinate.hpp"
+#include "osrm/engine_config.hpp"
+#include "osrm/json_container.hpp"
+#include "osrm/osrm.hpp"
+#include "osrm/status.hpp"
+
+BOOST_AUTO_TEST_SUITE(isochrone)
+
+void test_isochrone_response(const osrm::OSRM &osrm)
+{
+    using namespace osrm;
+
+    IsochroneParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.contours = {60, 120};
+    params.polygons = true;
+
+    json::Object result;
+    const auto rc = osrm.Isochrone(params, result);
+    BOOST_REQUIRE(rc == Status::Ok);
+
+    const auto code = result.values.at("code").get<json::String>().value;
+    BOOST_CHECK_EQUAL(code, "Ok");
+
+    const auto &waypoints = result.values.at("waypoints").get<json::Array>().values;
+    BOOST_CHECK_EQUAL(waypoints.size(), 1);
+
+    const auto &edges = result.values.at("edges").get<json::Array>().values;
+    BOOST_CHECK(!edges.empty());
+
+    double last_duration = 0;
+    for (const auto &edge : edges)
+    {
+        const auto &edge_object = edge.get<json::Object>();
+        const auto duration = edge_object.values.at("duration").get<json::Number>().value;
+        BOOST_CHECK(duration >= last_duration);
+        BOOST_CHECK(duration <= 120);
+        last_duration = duration;
+    }
+
+    const auto &polygons = result.values.at("polygons").get<json::Array>().values;
+    BOOST_REQUIRE_EQUAL(polygons.size(), 2);
+    const auto &outer = polygons.back().get<json::Object>();
+    BOOST_CHECK_EQUAL(outer.values.at("contour").get<json::Number>().value, 120);
+    const auto &geometry = outer.values.at("geometry").get<json::Object>();
+    BOOST_CHECK_EQUAL(geometry.values.at("type").get<json::String>().value, "Polygon");
+}
+
+BOOST_AUTO_TEST_CASE(test_isochrone_response_ch)
+{
+    test_isochrone_response(getOSRM(OSRM_TEST_DATA_DIR "/ch/monaco.osrm"));
+}
+
+BOOST_AUTO_TEST_CASE(test_isochrone_response_mld)
+{
+    test_isochrone_response(
+        getOSRM(OSRM_TEST_DATA_DIR "/mld/monaco.osrm", osrm::EngineConfig::Algorithm::MLD));
+}
+
+BOOST_AUTO_TEST_CASE(test_isochrone_response_no_contours)
+{
+    auto osrm = getOSRM(OSRM_TEST_DATA_DIR "/ch/monaco.osrm");
+
+    using namespace osrm;
+
+    IsochroneParameters params;
+    params.coordinates.push_back(get_dummy_location());
+
+    json::Object result;
+    const auto rc = osrm.Isochrone(params, result);
+    BOOST_REQUIRE(rc == Status::Error);
+
+    const auto code = result.values.at("code").get<json::String>().value;
+    BOOST_CHECK_EQUAL(code, "InvalidOptions");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,6 +2,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include "coordinates.hpp"
+#include "equal_json.hpp"
 #include "fixture.hpp"
 #include "waypoint_check.hpp"
 
@@ -10,9 +11,23 @@
 #include "osrm/coordinate.hpp"
 #include "osrm/engine_config.hpp"
 #include "osrm/json_container.hpp"
+#include "osrm/matched_trace.hpp"
 #include "osrm/osrm.hpp"
 #include "osrm/status.hpp"
 
+#include "engine/datafacade.hpp"
+#include "engine/datafacade/process_memory_allocator.hpp"
+#include "engine/routing_algorithms/direct_shortest_path.hpp"
+#include "engine/routing_algorithms/map_matching.hpp"
+#include "engine/routing_algorithms/routing_base.hpp"
+#include "engine/search_engine_data.hpp"
+
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE(match)
 
 BOOST_AUTO_TEST_CASE(test_match)
@@ -116,4 +131,253 @@ BOOST_AUTO_TEST_CASE(test_match_split)
     }
 }
 
+// The parts of a trace between time gaps are matched in parallel on idle contexts of the pool.
+// The result has to be the same as matching the whole trace sequentially, which is what a pool
+// of one context does.
+void test_match_split_parallel(const std::string &dataset,
+                               const osrm::EngineConfig::Algorithm algorithm)
+{
+    using namespace osrm;
+
+    const auto make_osrm = [&](const unsigned search_context_pool_size) {
+        EngineConfig config;
+        config.storage_config = {dataset};
+        config.use_shared_memory = false;
+        config.algorithm = algorithm;
+        config.search_context_pool_size = search_context_pool_size;
+        return std::make_unique<const OSRM>(config);
+    };
+    const auto sequential_osrm = make_osrm(1);
+    const auto parallel_osrm = make_osrm(8);
+
+    // the trace is driven three times with a gap before every second point pair
+    MatchParameters params;
+    params.steps = true;
+    params.annotations_type = RouteParameters::AnnotationsType::All;
+    params.overview = RouteParameters::OverviewType::Full;
+    const auto locations = get_split_trace_locations();
+    unsigned timestamp = 1;
+    for (std::size_t round = 0; round < 3; ++round)
+    {
+        for (std::size_t index = 0; index < locations.size(); ++index)
+        {
+            params.coordinates.push_back(locations[index]);
+            params.timestamps.push_back(timestamp);
+            timestamp += index % 2 == 0 ? 1 : 1000;
+        }
+    }
+
+    json::Object sequential_result;
+    BOOST_REQUIRE(sequential_osrm->Match(params, sequential_result) == Status::Ok);
+    json::Object parallel_result;
+    BOOST_REQUIRE(parallel_osrm->Match(params, parallel_result) == Status::Ok);
+
+    const auto &matchings = sequential_result.values.at("matchings").get<json::Array>().values;
+    BOOST_CHECK_EQUAL(matchings.size(), 6);
+    CHECK_EQUAL_JSON(sequential_result.values.at("matchings"),
+                     parallel_result.values.at("matchings"));
+    CHECK_EQUAL_JSON(sequential_result.values.at("tracepoints"),
+                     parallel_result.values.at("tracepoints"));
+}
+
+BOOST_AUTO_TEST_CASE(test_match_split_parallel_ch)
+{
+    test_match_split_parallel(OSRM_TEST_DATA_DIR "/ch/monaco.osrm",
+                              osrm::EngineConfig::Algorithm::CH);
+}
+
+BOOST_AUTO_TEST_CASE(test_match_split_parallel_mld)
+{
+    test_match_split_parallel(OSRM_TEST_DATA_DIR "/mld/monaco.osrm",
+                              osrm::EngineConfig::Algorithm::MLD);
+}
+
+// A live trace sent point by point to a session is matched like the whole trace
+BOOST_AUTO_TEST_CASE(test_match_session)
+{
+    using namespace osrm;
+
+    EngineConfig config;
+    config.storage_config = {OSRM_TEST_DATA_DIR "/ch/monaco.osrm"};
+    config.use_shared_memory = false;
+    config.algorithm = EngineConfig::Algorithm::CH;
+    config.max_matching_sessions = 10;
+    const OSRM osrm{config};
+
+    // the trace comes back to its start after a second gap, the first gap must not be taken
+    // as the usual sample time
+    auto locations = get_split_trace_locations();
+    locations.push_back(locations[0]);
+    locations.push_back(locations[1]);
+    const std::vector<unsigned> timestamps = {1, 2, 1700, 1701, 3400, 3401};
+
+    const auto match = [&](const std::size_t index) {
+        MatchParameters params;
+        params.coordinates.push_back(locations[index]);
+        params.timestamps.push_back(timestamps[index]);
+        params.session = "vehicle";
+
+        json::Object result;
+        const auto rc = osrm.Match(params, result);
+        BOOST_CHECK(rc == Status::Ok);
+        BOOST_CHECK_EQUAL(result.values.at("code").get<json::String>().value, "Ok");
+        BOOST_CHECK_EQUAL(result.values.at("tracepoints").get<json::Array>().values.size(), 1);
+        return result;
+    };
+
+    // the first points of all sub-traces can not be matched on their own
+    for (const std::size_t index : {0, 2, 4})
+    {
+        const auto result = match(index);
+        BOOST_CHECK(result.values.at("matchings").get<json::Array>().values.empty());
+        BOOST_CHECK(
+            result.values.at("tracepoints").get<json::Array>().values.front().is<json::Null>());
+
+        // the matching continues from the previous point
+        const auto next_result = match(index + 1);
+        const auto &matchings = next_result.values.at("matchings").get<json::Array>().values;
+        BOOST_REQUIRE_EQUAL(matchings.size(), 1);
+        const auto &legs =
+            matchings.front().get<json::Object>().values.at("legs").get<json::Array>().values;
+        BOOST_CHECK_EQUAL(legs.size(), 1);
+
+        const auto &tracepoint =
+            next_result.values.at("tracepoints").get<json::Array>().values.front();
+        BOOST_REQUIRE(waypoint_check(tracepoint));
+        const auto &tracepoint_object = tracepoint.get<json::Object>();
+        BOOST_CHECK_EQUAL(
+            tracepoint_object.values.at("matchings_index").get<json::Number>().value, 0);
+        BOOST_CHECK_EQUAL(
+            tracepoint_object.values.at("waypoint_index").get<json::Number>().value, 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_match_session_disabled)
+{
+    using namespace osrm;
+
+    auto osrm = getOSRM(OSRM_TEST_DATA_DIR "/ch/monaco.osrm");
+
+    MatchParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.session = "vehicle";
+
+    json::Object result;
+    const auto rc = osrm.Match(params, result);
+    BOOST_CHECK(rc == Status::Error);
+    BOOST_CHECK_EQUAL(result.values.at("code").get<json::String>().value, "InvalidOptions");
+}
+
+BOOST_AUTO_TEST_CASE(test_match_batch)
+{
+    using namespace osrm;
+
+    auto osrm = getOSRM(OSRM_TEST_DATA_DIR "/ch/monaco.osrm");
+
+    std::vector<MatchParameters> traces(2);
+    traces[0].coordinates.push_back(get_dummy_location());
+    traces[0].coordinates.push_back(get_dummy_location());
+    traces[0].coordinates.push_back(get_dummy_location());
+    // a single coordinate is not a valid trace, it does not fail the batch
+    traces[1].coordinates.push_back(get_dummy_location());
+
+    std::vector<MatchedTrace> results;
+    const auto rc = osrm.MatchBatch(traces, results);
+    BOOST_CHECK(rc == Status::Ok);
+    BOOST_REQUIRE_EQUAL(results.size(), traces.size());
+
+    json::Object result;
+    BOOST_REQUIRE(osrm.Match(traces[0], result) == Status::Ok);
+    const auto &tracepoints = result.values.at("tracepoints").get<json::Array>().values;
+    const auto &matchings = result.values.at("matchings").get<json::Array>().values;
+
+    const auto &matched = results[0];
+    BOOST_CHECK_EQUAL(matched.confidences.size(), matchings.size());
+    BOOST_REQUIRE_EQUAL(matched.sub_matching_offsets.size(), matched.confidences.size() + 1);
+    BOOST_CHECK_EQUAL(matched.sub_matching_offsets.front(), 0);
+    BOOST_CHECK_EQUAL(matched.sub_matching_offsets.back(), matched.indices.size());
+    BOOST_CHECK_EQUAL(matched.nodes.size(), matched.indices.size());
+    BOOST_CHECK_EQUAL(matched.locations.size(), matched.indices.size());
+    for (const auto index : matched.indices)
+    {
+        BOOST_REQUIRE_LT(index, tracepoints.size());
+        BOOST_CHECK(tracepoints[index].is<mapbox::util::recursive_wrapper<util::json::Object>>());
+    }
+
+    BOOST_CHECK(results[1].confidences.empty());
+    BOOST_CHECK(results[1].indices.empty());
+}
+
+// The transitions of all candidates of a trace are found by one many-to-many search, their
+// distances have to match a point-to-point search between every pair of candidates
+template <typename Algorithm> void checkTransitionDistances(const std::string &base_path)
+{
+    using namespace osrm;
+    using namespace osrm::engine;
+
+    const auto allocator =
+        std::make_shared<datafacade::ProcessMemoryAllocator>(storage::StorageConfig{base_path});
+    const auto properties =
+        allocator->GetIndex().GetBlockPtr<extractor::ProfileProperties>("/common/properties");
+    const DataFacade<Algorithm> facade{allocator, properties->GetWeightName(), 0};
+    SearchEngineData<Algorithm> engine_working_data;
+
+    std::vector<PhantomNode> phantom_nodes;
+    for (const auto &location : get_split_trace_locations())
+    {
+        for (const auto &candidate :
+             facade.NearestPhantomNodes(location, 3, engine::Approach::UNRESTRICTED))
+        {
+            phantom_nodes.push_back(candidate.phantom_node);
+        }
+    }
+    std::vector<std::size_t> indices(phantom_nodes.size());
+    std::iota(indices.begin(), indices.end(), 0);
+
+    const auto distances = routing_algorithms::getTransitionDistances(
+        engine_working_data, facade, phantom_nodes, indices, indices, INVALID_EDGE_WEIGHT);
+    BOOST_REQUIRE_EQUAL(distances.size(), phantom_nodes.size() * phantom_nodes.size());
+
+    for (const auto source : indices)
+    {
+        for (const auto target : indices)
+        {
+            const auto &source_phantom = phantom_nodes[source];
+            const auto &target_phantom = phantom_nodes[target];
+            // candidates on the same segment can be joined by a loop or not, depending on how a
+            // search treats their offsets
+            if (source_phantom.forward_segment_id.id == target_phantom.forward_segment_id.id &&
+                source_phantom.reverse_segment_id.id == target_phantom.reverse_segment_id.id)
+                continue;
+
+            const auto distance = distances[source * phantom_nodes.size() + target];
+            const auto route = routing_algorithms::directShortestPathSearch(
+                engine_working_data, facade, {source_phantom, target_phantom});
+            if (!route.is_valid())
+            {
+                BOOST_CHECK_EQUAL(distance, std::numeric_limits<double>::max());
+                continue;
+            }
+
+            // segment distances are summed instead of measuring the unpacked geometry, the two
+            // only differ by rounding
+            const auto route_distance = routing_algorithms::getPathDistance(
+                facade, route.unpacked_path_segments.front(), source_phantom, target_phantom);
+            BOOST_CHECK_SMALL(distance - route_distance, 1. + route_distance * 1e-3);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_transition_distances_ch)
+{
+    checkTransitionDistances<osrm::engine::routing_algorithms::ch::Algorithm>(
+        OSRM_TEST_DATA_DIR "/ch/monaco.osrm");
+}
+
+BOOST_AUTO_TEST_CASE(test_transition_distances_mld)
+{
+    checkTransitionDistances<osrm::engine::routing_algorithms::mld::Algorithm>(
+        OSRM_TEST_DATA_DIR "/mld/monaco.osrm");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
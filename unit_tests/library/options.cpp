@@ -5,7 +5,13 @@
 #include "equal_json.hpp"
 #include "fixture.hpp"
 
+#include "osrm/exception.hpp"
+#include "osrm/json_container.hpp"
+#include "osrm/nearest_parameters.hpp"
 #include "osrm/osrm.hpp"
+#include "osrm/route_parameters.hpp"
+#include "osrm/search_context_statistics.hpp"
+#include "osrm/status.hpp"
 
 BOOST_AUTO_TEST_SUITE(options)
 
@@ -39,4 +45,167 @@ BOOST_AUTO_TEST_CASE(test_mld)
     OSRM osrm{config};
 }
 
+BOOST_AUTO_TEST_CASE(test_ch_dense_query_heaps)
+{
+    using namespace osrm;
+
+    RouteParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_dummy_location());
+
+    json::Object sparse_result;
+    json::Object dense_result;
+    for (const bool use_dense_query_heaps : {false, true})
+    {
+        EngineConfig config;
+        config.use_shared_memory = false;
+        config.storage_config = storage::StorageConfig(OSRM_TEST_DATA_DIR "/ch/monaco.osrm");
+        config.algorithm = EngineConfig::Algorithm::CH;
+        config.use_dense_query_heaps = use_dense_query_heaps;
+        OSRM osrm{config};
+
+        auto &result = use_dense_query_heaps ? dense_result : sparse_result;
+        const auto rc = osrm.Route(params, result);
+        BOOST_CHECK(rc == Status::Ok);
+    }
+
+    CHECK_EQUAL_JSON(sparse_result, dense_result);
+}
+
+BOOST_AUTO_TEST_CASE(test_prewarm_search_contexts)
+{
+    using namespace osrm;
+
+    for (const auto algorithm : {EngineConfig::Algorithm::CH, EngineConfig::Algorithm::MLD})
+    {
+        EngineConfig config;
+        config.use_shared_memory = false;
+        config.storage_config = storage::StorageConfig(
+            algorithm == EngineConfig::Algorithm::CH ? OSRM_TEST_DATA_DIR "/ch/monaco.osrm"
+                                                     : OSRM_TEST_DATA_DIR "/mld/monaco.osrm");
+        config.algorithm = algorithm;
+        config.search_context_pool_size = 2;
+        config.prewarm_search_contexts = true;
+        OSRM osrm{config};
+
+        const auto statistics = osrm.GetSearchContextStatistics();
+        BOOST_CHECK_EQUAL(statistics.size, 2);
+        BOOST_CHECK_EQUAL(statistics.in_use, 0);
+        BOOST_CHECK_EQUAL(statistics.peak_in_use, 0);
+        BOOST_CHECK_GT(statistics.memory_usage, 0);
+
+        RouteParameters params;
+        params.coordinates.push_back(get_dummy_location());
+        params.coordinates.push_back(get_dummy_location());
+        json::Object result;
+        BOOST_CHECK(osrm.Route(params, result) == Status::Ok);
+        BOOST_CHECK_EQUAL(osrm.GetSearchContextStatistics().peak_in_use, 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_mld_parallel_bidirectional_search)
+{
+    using namespace osrm;
+
+    RouteParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_split_trace_locations().front());
+    params.coordinates.push_back(get_locations_in_big_component().back());
+
+    json::Object sequential_result;
+    json::Object parallel_result;
+    for (const bool use_parallel_bidirectional_search : {false, true})
+    {
+        EngineConfig config;
+        config.use_shared_memory = false;
+        config.storage_config = storage::StorageConfig(OSRM_TEST_DATA_DIR "/mld/monaco.osrm");
+        config.algorithm = EngineConfig::Algorithm::MLD;
+        config.use_parallel_bidirectional_search = use_parallel_bidirectional_search;
+        OSRM osrm{config};
+
+        auto &result = use_parallel_bidirectional_search ? parallel_result : sequential_result;
+        const auto rc = osrm.Route(params, result);
+        BOOST_CHECK(rc == Status::Ok);
+    }
+
+    CHECK_EQUAL_JSON(sequential_result, parallel_result);
+}
+
+BOOST_AUTO_TEST_CASE(test_alternatives_search_time)
+{
+    using namespace osrm;
+
+    RouteParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.coordinates.push_back(get_locations_in_big_component().back());
+    params.number_of_alternatives = 3;
+
+    for (const auto algorithm : {EngineConfig::Algorithm::CH, EngineConfig::Algorithm::MLD})
+    {
+        EngineConfig config;
+        config.use_shared_memory = false;
+        config.storage_config = storage::StorageConfig(
+            algorithm == EngineConfig::Algorithm::CH ? OSRM_TEST_DATA_DIR "/ch/monaco.osrm"
+                                                     : OSRM_TEST_DATA_DIR "/mld/monaco.osrm");
+        config.algorithm = algorithm;
+        // without any time for alternatives only the shortest path is returned
+        config.max_alternatives_search_time = 0;
+        OSRM osrm{config};
+
+        json::Object result;
+        const auto rc = osrm.Route(params, result);
+        BOOST_CHECK(rc == Status::Ok);
+        const auto &routes = result.values.at("routes").get<json::Array>().values;
+        BOOST_CHECK_EQUAL(routes.size(), 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_rtree_leaves)
+{
+    using namespace osrm;
+    using PreloadPolicy = storage::StorageConfig::PreloadPolicy;
+
+    NearestParameters params;
+    params.coordinates.push_back(get_dummy_location());
+    params.number_of_results = 3;
+
+    const auto nearest = [&params](const bool use_mmap,
+                                   const bool load_rtree_leaves,
+                                   const PreloadPolicy preload) {
+        EngineConfig config;
+        config.use_shared_memory = false;
+        config.use_mmap = use_mmap;
+        config.storage_config = storage::StorageConfig(OSRM_TEST_DATA_DIR "/ch/monaco.osrm");
+        config.storage_config.load_rtree_leaves = load_rtree_leaves;
+        config.storage_config.rtree_leaves_preload = preload;
+        OSRM osrm{config};
+
+        json::Object result;
+        const auto rc = osrm.Nearest(params, result);
+        BOOST_CHECK(rc == Status::Ok);
+        return result;
+    };
+
+    const auto mapped_result = nearest(false, false, PreloadPolicy::None);
+    CHECK_EQUAL_JSON(mapped_result, nearest(false, true, PreloadPolicy::None));
+    for (const auto preload : {PreloadPolicy::None,
+                               PreloadPolicy::WillNeed,
+                               PreloadPolicy::Populate,
+                               PreloadPolicy::Lock})
+    {
+        CHECK_EQUAL_JSON(mapped_result, nearest(true, false, preload));
+    }
+
+    // the leaves mapped by the facade without use_mmap are not preloaded
+    EngineConfig config;
+    config.use_shared_memory = false;
+    config.storage_config = storage::StorageConfig(OSRM_TEST_DATA_DIR "/ch/monaco.osrm");
+    config.storage_config.rtree_leaves_preload = PreloadPolicy::Populate;
+    BOOST_CHECK(!config.IsValid());
+    BOOST_CHECK_THROW(OSRM{config}, osrm::exception);
+    config.use_mmap = true;
+    BOOST_CHECK(config.IsValid());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
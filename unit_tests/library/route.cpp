@@ -2,6 +2,8 @@
 #include <boost/test/unit_test.hpp>
 
 #include <cmath>
+#include <memory>
+#include <string>
 
 #include "coordinates.hpp"
 #include "equal_json.hpp"
@@ -468,4 +470,129 @@ BOOST_AUTO_TEST_CASE(test_manual_setting_of_annotations_property)
     BOOST_CHECK_EQUAL(annotations.size(), 6);
 }
 
+void test_route_totals_without_geometry(const std::string &dataset,
+                                        const osrm::EngineConfig::Algorithm algorithm)
+{
+    using namespace osrm;
+
+    EngineConfig config;
+    config.storage_config = {dataset};
+    config.use_shared_memory = false;
+    config.algorithm = algorithm;
+    const OSRM osrm{config};
+
+    const auto locations = get_locations_in_big_component();
+    const auto route = [&](const RouteParameters::OverviewType overview, const bool steps) {
+        RouteParameters params;
+        params.overview = overview;
+        params.steps = steps;
+        params.coordinates.push_back(locations.at(0));
+        params.coordinates.push_back(locations.at(1));
+
+        json::Object result;
+        const auto rc = osrm.Route(params, result);
+        BOOST_REQUIRE(rc == Status::Ok);
+        return result.values.at("routes").get<json::Array>().values.at(0).get<json::Object>();
+    };
+
+    const auto full = route(RouteParameters::OverviewType::Simplified, true);
+    const auto totals = route(RouteParameters::OverviewType::False, false);
+
+    BOOST_CHECK(totals.values.count("geometry") == 0);
+    BOOST_CHECK_EQUAL(totals.values.at("duration").get<json::Number>().value,
+                      full.values.at("duration").get<json::Number>().value);
+    BOOST_CHECK_EQUAL(totals.values.at("weight").get<json::Number>().value,
+                      full.values.at("weight").get<json::Number>().value);
+    // distances of the graph are not summed up from the geometry, they differ slightly
+    BOOST_CHECK_CLOSE(totals.values.at("distance").get<json::Number>().value,
+                      full.values.at("distance").get<json::Number>().value,
+                      1.);
+
+    const auto &legs = totals.values.at("legs").get<json::Array>().values;
+    BOOST_REQUIRE_EQUAL(legs.size(), 1);
+    BOOST_CHECK(legs[0].get<json::Object>().values.at("steps").get<json::Array>().values.empty());
+    BOOST_CHECK_EQUAL(legs[0].get<json::Object>().values.at("duration").get<json::Number>().value,
+                      totals.values.at("duration").get<json::Number>().value);
+}
+
+BOOST_AUTO_TEST_CASE(test_route_totals_without_geometry_ch)
+{
+    test_route_totals_without_geometry(OSRM_TEST_DATA_DIR "/ch/monaco.osrm",
+                                       osrm::EngineConfig::Algorithm::CH);
+}
+
+BOOST_AUTO_TEST_CASE(test_route_totals_without_geometry_mld)
+{
+    test_route_totals_without_geometry(OSRM_TEST_DATA_DIR "/mld/monaco.osrm",
+                                       osrm::EngineConfig::Algorithm::MLD);
+}
+
+// Routes with many waypoints search their legs on idle contexts of the pool in parallel. They
+// have to be the same as the routes found sequentially, which is what a pool of one context
+// does.
+void test_route_helper_contexts(const std::string &dataset,
+                                const osrm::EngineConfig::Algorithm algorithm)
+{
+    using namespace osrm;
+
+    const auto make_osrm = [&](const unsigned search_context_pool_size) {
+        EngineConfig config;
+        config.storage_config = {dataset};
+        config.use_shared_memory = false;
+        config.algorithm = algorithm;
+        config.search_context_pool_size = search_context_pool_size;
+        return std::make_unique<const OSRM>(config);
+    };
+    const auto sequential_osrm = make_osrm(1);
+    const auto parallel_osrm = make_osrm(8);
+
+    // going back to the previous waypoint needs a u-turn at the waypoint or a detour
+    Locations locations;
+    for (const auto &location_set : {get_locations_in_big_component(),
+                                      get_split_trace_locations(),
+                                      get_locations_in_big_component(),
+                                      get_split_trace_locations()})
+    {
+        for (const auto &location : location_set)
+        {
+            if (location != location_set.front())
+                locations.push_back(location_set.front());
+            locations.push_back(location);
+        }
+    }
+    locations.push_back(locations.front());
+    BOOST_REQUIRE_GE(locations.size() - 1, 16);
+
+    for (const auto continue_straight : {boost::optional<bool>{},
+                                         boost::optional<bool>{true},
+                                         boost::optional<bool>{false}})
+    {
+        RouteParameters params;
+        params.steps = true;
+        params.annotations_type = RouteParameters::AnnotationsType::All;
+        params.overview = RouteParameters::OverviewType::Full;
+        params.continue_straight = continue_straight;
+        params.coordinates = locations;
+
+        json::Object sequential_result;
+        BOOST_REQUIRE(sequential_osrm->Route(params, sequential_result) == Status::Ok);
+        json::Object parallel_result;
+        BOOST_REQUIRE(parallel_osrm->Route(params, parallel_result) == Status::Ok);
+
+        CHECK_EQUAL_JSON(sequential_result, parallel_result);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_route_helper_contexts_ch)
+{
+    test_route_helper_contexts(OSRM_TEST_DATA_DIR "/ch/monaco.osrm",
+                               osrm::EngineConfig::Algorithm::CH);
+}
+
+BOOST_AUTO_TEST_CASE(test_route_helper_contexts_mld)
+{
+    test_route_helper_contexts(OSRM_TEST_DATA_DIR "/mld/monaco.osrm",
+                               osrm::EngineConfig::Algorithm::MLD);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -13,6 +13,8 @@
 #include "osrm/osrm.hpp"
 #include "osrm/status.hpp"
 
+#include "util/integer_range.hpp"
+
 BOOST_AUTO_TEST_SUITE(table)
 
 BOOST_AUTO_TEST_CASE(test_table_three_coords_one_source_one_dest_matrix)
@@ -187,4 +189,59 @@ BOOST_AUTO_TEST_CASE(test_table_no_segment_for_some_coordinates)
     BOOST_CHECK_EQUAL(code, "NoSegment");
 }
 
+// Tables answered from cached target search spaces are the same as without the cache
+BOOST_AUTO_TEST_CASE(test_table_search_space_cache)
+{
+    using namespace osrm;
+
+    EngineConfig config;
+    config.storage_config = {OSRM_TEST_DATA_DIR "/ch/monaco.osrm"};
+    config.use_shared_memory = false;
+    config.algorithm = EngineConfig::Algorithm::CH;
+    const OSRM uncached_osrm{config};
+    config.search_space_cache_size = 1;
+    const OSRM cached_osrm{config};
+
+    const auto locations = get_locations_in_big_component();
+    const auto table = [&](const OSRM &osrm, const std::size_t source) {
+        TableParameters params;
+        params.coordinates = locations;
+        params.sources.push_back(source);
+        params.annotations = TableParameters::AnnotationsType::All;
+
+        json::Object result;
+        const auto rc = osrm.Table(params, result);
+        BOOST_REQUIRE(rc == Status::Ok);
+        return result;
+    };
+
+    // the second round is answered from the cache
+    for (auto round = 0; round < 2; ++round)
+    {
+        for (const std::size_t source : {0, 1, 2})
+        {
+            auto reference = table(uncached_osrm, source);
+            auto result = table(cached_osrm, source);
+            for (const auto annotation : {"durations", "distances"})
+            {
+                const auto &reference_rows =
+                    reference.values.at(annotation).get<json::Array>().values;
+                const auto &rows = result.values.at(annotation).get<json::Array>().values;
+                BOOST_REQUIRE_EQUAL(rows.size(), reference_rows.size());
+                for (const auto row : util::irange<std::size_t>(0, rows.size()))
+                {
+                    const auto &reference_row = reference_rows[row].get<json::Array>().values;
+                    const auto &result_row = rows[row].get<json::Array>().values;
+                    BOOST_REQUIRE_EQUAL(result_row.size(), reference_row.size());
+                    for (const auto column : util::irange<std::size_t>(0, result_row.size()))
+                    {
+                        BOOST_CHECK_EQUAL(result_row[column].get<json::Number>().value,
+                                          reference_row[column].get<json::Number>().value);
+                    }
+                }
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -31,6 +31,7 @@ class MockBaseDataFacade : public engine::datafacade::BaseDataFacade
 
   public:
     bool ExcludeNode(const NodeID) const override { return false; };
+    bool ExcludeClasses(const extractor::ClassData) const override { return false; };
 
     util::Coordinate GetCoordinateOfNode(const NodeID /* id */) const override
     {
@@ -204,6 +205,17 @@ class MockBaseDataFacade : public engine::datafacade::BaseDataFacade
         return {};
     }
 
+    std::vector<std::pair<engine::PhantomNode, engine::PhantomNode>>
+    NearestPhantomNodesWithAlternativeFromBigComponent(
+        const std::vector<util::Coordinate> &input_coordinates,
+        const std::vector<boost::optional<double>> & /*max_distances*/,
+        const std::vector<boost::optional<engine::Bearing>> & /*bearings*/,
+        const std::vector<boost::optional<engine::Approach>> & /*approaches*/) const override
+    {
+        return std::vector<std::pair<engine::PhantomNode, engine::PhantomNode>>(
+            input_coordinates.size());
+    }
+
     std::uint32_t GetCheckSum() const override { return 0; }
 
     extractor::TravelMode GetTravelMode(const NodeID /* id */) const override
@@ -294,7 +306,14 @@ class MockAlgorithmDataFacade<engine::datafacade::CH>
     unsigned GetNumberOfEdges() const override { return 0; }
     unsigned GetOutDegree(const NodeID /* n */) const override { return 0; }
     NodeID GetTarget(const EdgeID /* e */) const override { return SPECIAL_NODEID; }
-    const EdgeData &GetEdgeData(const EdgeID /* e */) const override { return foo; }
+    EdgeWeight GetEdgeWeight(const EdgeID /* e */) const override { return foo.weight; }
+    bool IsForwardEdge(const EdgeID /* e */) const override { return foo.forward; }
+    bool IsBackwardEdge(const EdgeID /* e */) const override { return foo.backward; }
+    EdgeData GetEdgeData(const EdgeID /* e */) const override { return foo; }
+    std::pair<EdgeID, EdgeID> GetShortcutChildren(const EdgeID /* e */) const override
+    {
+        return {SPECIAL_EDGEID, SPECIAL_EDGEID};
+    }
     EdgeRange GetAdjacentEdgeRange(const NodeID /* node */) const override
     {
         return EdgeRange(static_cast<EdgeID>(0), static_cast<EdgeID>(0), {});
@@ -3,6 +3,7 @@
 #include "parameters_io.hpp"
 
 #include "engine/api/base_parameters.hpp"
+#include "engine/api/isochrone_parameters.hpp"
 #include "engine/api/match_parameters.hpp"
 #include "engine/api/nearest_parameters.hpp"
 #include "engine/api/route_parameters.hpp"
@@ -663,6 +664,20 @@ BOOST_AUTO_TEST_CASE(valid_match_urls)
     CHECK_EQUAL_RANGE(reference_3.radiuses, result_3->radiuses);
     CHECK_EQUAL_RANGE(reference_3.approaches, result_3->approaches);
     CHECK_EQUAL_RANGE(reference_3.coordinates, result_3->coordinates);
+
+    std::vector<util::Coordinate> coords_3 = {{util::FloatLongitude{1}, util::FloatLatitude{2}}};
+
+    MatchParameters reference_4{};
+    reference_4.coordinates = coords_3;
+    reference_4.timestamps = {5};
+    reference_4.session = "vehicle-42_a";
+    auto result_4 = parseParameters<MatchParameters>("1,2?session=vehicle-42_a&timestamps=5");
+    BOOST_CHECK(result_4);
+    BOOST_CHECK_EQUAL(reference_4.session, result_4->session);
+    CHECK_EQUAL_RANGE(reference_4.timestamps, result_4->timestamps);
+    CHECK_EQUAL_RANGE(reference_4.coordinates, result_4->coordinates);
+    // a single coordinate extends the trace of the session
+    BOOST_CHECK(result_4->IsValid());
 }
 
 BOOST_AUTO_TEST_CASE(invalid_match_urls)
@@ -688,6 +703,15 @@ BOOST_AUTO_TEST_CASE(invalid_match_urls)
     BOOST_CHECK_EQUAL(testInvalidOptions<MatchParameters>("1,2;3,4?waypoints=0,4"), 19UL);
     BOOST_CHECK_EQUAL(testInvalidOptions<MatchParameters>("1,2;3,4?waypoints=x;4"), 18UL);
     BOOST_CHECK_EQUAL(testInvalidOptions<MatchParameters>("1,2;3,4?waypoints=0;3.5"), 21UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<MatchParameters>("1,2;3,4?session=a/b"), 17UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<MatchParameters>("1,2;3,4?session="), 16UL);
+
+    auto result_3 = parseParameters<MatchParameters>("1,2;3,4?session=a&tidy=true");
+    BOOST_CHECK(result_3);
+    BOOST_CHECK(!result_3->IsValid());
+    auto result_4 = parseParameters<MatchParameters>("1,2");
+    BOOST_CHECK(result_4);
+    BOOST_CHECK(!result_4->IsValid());
 }
 
 BOOST_AUTO_TEST_CASE(valid_nearest_urls)
@@ -716,6 +740,42 @@ BOOST_AUTO_TEST_CASE(valid_nearest_urls)
     CHECK_EQUAL_RANGE(reference_2.coordinates, result_2->coordinates);
 }
 
+BOOST_AUTO_TEST_CASE(valid_isochrone_urls)
+{
+    std::vector<util::Coordinate> coords_1 = {{util::FloatLongitude{1}, util::FloatLatitude{2}}};
+
+    IsochroneParameters reference_1{};
+    reference_1.coordinates = coords_1;
+    reference_1.contours = {300, 600.5};
+    auto result_1 = parseParameters<IsochroneParameters>("1,2?contours=300;600.5");
+    BOOST_CHECK(result_1);
+    BOOST_CHECK(result_1->IsValid());
+    BOOST_CHECK_EQUAL(reference_1.polygons, result_1->polygons);
+    CHECK_EQUAL_RANGE(reference_1.contours, result_1->contours);
+    CHECK_EQUAL_RANGE(reference_1.coordinates, result_1->coordinates);
+
+    IsochroneParameters reference_2{};
+    reference_2.coordinates = coords_1;
+    reference_2.contours = {60};
+    reference_2.polygons = true;
+    auto result_2 = parseParameters<IsochroneParameters>("1,2?polygons=true&contours=60");
+    BOOST_CHECK(result_2);
+    BOOST_CHECK(result_2->IsValid());
+    BOOST_CHECK_EQUAL(reference_2.polygons, result_2->polygons);
+    CHECK_EQUAL_RANGE(reference_2.contours, result_2->contours);
+    CHECK_EQUAL_RANGE(reference_2.coordinates, result_2->coordinates);
+
+    // parses, but contours are missing, unsorted or there is more than one coordinate
+    BOOST_CHECK(!parseParameters<IsochroneParameters>("1,2")->IsValid());
+    BOOST_CHECK(!parseParameters<IsochroneParameters>("1,2?contours=600;300")->IsValid());
+    BOOST_CHECK(!parseParameters<IsochroneParameters>("1,2?contours=0")->IsValid());
+    BOOST_CHECK(!parseParameters<IsochroneParameters>("1,2;3,4?contours=300")->IsValid());
+
+    BOOST_CHECK_EQUAL(testInvalidOptions<IsochroneParameters>("1,2?contours=foo"), 13UL);
+    BOOST_CHECK_EQUAL(testInvalidOptions<IsochroneParameters>("1,2?contours=60&polygons=1"),
+                      25UL);
+}
+
 BOOST_AUTO_TEST_CASE(invalid_tile_urls)
 {
     TileParameters reference_1{1, 2, 3};
@@ -0,0 +1,71 @@
+#include "util/concurrent_node_weights.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(concurrent_node_weights)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(set_get_clear)
+{
+    ConcurrentNodeWeights node_weights(10);
+
+    // overlay and base graph nodes
+    for (const NodeID node : {3u, 42u})
+    {
+        BOOST_CHECK(!node_weights.Get(node));
+
+        node_weights.Set(node, {-5, false, true});
+        auto entry = node_weights.Get(node);
+        BOOST_REQUIRE(entry);
+        BOOST_CHECK_EQUAL(entry->weight, -5);
+        BOOST_CHECK(!entry->settled);
+        BOOST_CHECK(entry->seed);
+
+        node_weights.Set(node, {INVALID_EDGE_WEIGHT - 1, true, false});
+        entry = node_weights.Get(node);
+        BOOST_REQUIRE(entry);
+        BOOST_CHECK_EQUAL(entry->weight, INVALID_EDGE_WEIGHT - 1);
+        BOOST_CHECK(entry->settled);
+        BOOST_CHECK(!entry->seed);
+    }
+
+    node_weights.Clear();
+    BOOST_CHECK(!node_weights.Get(3));
+    BOOST_CHECK(!node_weights.Get(42));
+}
+
+// Each thread writes its own entry and then reads the one of the other thread,
+// at least one of them has to see the other entry
+BOOST_AUTO_TEST_CASE(writes_are_visible)
+{
+    for (const NodeID node : {5u, 500u})
+    {
+        for (auto round = 0; round < 1000; ++round)
+        {
+            ConcurrentNodeWeights first_weights(10);
+            ConcurrentNodeWeights second_weights(10);
+            std::atomic<bool> first_sees_second{false};
+            std::atomic<bool> second_sees_first{false};
+
+            std::thread first([&] {
+                first_weights.Set(node, {1, true, false});
+                first_sees_second = static_cast<bool>(second_weights.Get(node));
+            });
+            std::thread second([&] {
+                second_weights.Set(node, {2, false, false});
+                second_sees_first = static_cast<bool>(first_weights.Get(node));
+            });
+            first.join();
+            second.join();
+
+            BOOST_CHECK(first_sees_second || second_sees_first);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,90 @@
+#include "util/lru_cache.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(lru_cache)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(get_insert_erase)
+{
+    LRUCache<int, std::string> cache(100);
+    BOOST_CHECK(!cache.Get(1));
+
+    cache.Insert(1, "one", 10);
+    cache.Insert(2, "two", 20);
+    BOOST_CHECK_EQUAL(*cache.Get(1), "one");
+    BOOST_CHECK_EQUAL(*cache.Get(2), "two");
+    BOOST_CHECK_EQUAL(cache.GetSize(), 30);
+    BOOST_CHECK_EQUAL(cache.GetNumberOfEntries(), 2);
+
+    // replaces the entry and its size
+    cache.Insert(1, "uno", 5);
+    BOOST_CHECK_EQUAL(*cache.Get(1), "uno");
+    BOOST_CHECK_EQUAL(cache.GetSize(), 25);
+
+    cache.Erase(2);
+    BOOST_CHECK(!cache.Get(2));
+    BOOST_CHECK_EQUAL(cache.GetSize(), 5);
+
+    cache.Clear();
+    BOOST_CHECK(!cache.Get(1));
+    BOOST_CHECK_EQUAL(cache.GetSize(), 0);
+    BOOST_CHECK_EQUAL(cache.GetNumberOfEntries(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(evicts_least_recently_used)
+{
+    LRUCache<int, int> cache(30);
+    cache.Insert(1, 10, 10);
+    cache.Insert(2, 20, 10);
+    cache.Insert(3, 30, 10);
+
+    // makes 2 the least recently used entry
+    BOOST_CHECK(cache.Get(1));
+
+    cache.Insert(4, 40, 10);
+    BOOST_CHECK(!cache.Get(2));
+    BOOST_CHECK_EQUAL(*cache.Get(1), 10);
+    BOOST_CHECK_EQUAL(*cache.Get(3), 30);
+    BOOST_CHECK_EQUAL(*cache.Get(4), 40);
+    BOOST_CHECK_EQUAL(cache.GetSize(), 30);
+
+    // needs the space of two entries, 1 and 3 are least recently used now
+    cache.Insert(5, 50, 20);
+    BOOST_CHECK(!cache.Get(1));
+    BOOST_CHECK(!cache.Get(3));
+    BOOST_CHECK_EQUAL(*cache.Get(4), 40);
+    BOOST_CHECK_EQUAL(*cache.Get(5), 50);
+    BOOST_CHECK_EQUAL(cache.GetSize(), 30);
+}
+
+BOOST_AUTO_TEST_CASE(skips_entries_larger_than_capacity)
+{
+    LRUCache<int, int> cache(30);
+    cache.Insert(1, 10, 10);
+    cache.Insert(2, 20, 31);
+    BOOST_CHECK(!cache.Get(2));
+    BOOST_CHECK_EQUAL(*cache.Get(1), 10);
+    BOOST_CHECK_EQUAL(cache.GetSize(), 10);
+}
+
+BOOST_AUTO_TEST_CASE(least_recently_used)
+{
+    LRUCache<int, int> cache(30);
+    BOOST_CHECK(!cache.GetLeastRecentlyUsed());
+
+    cache.Insert(1, 10, 10);
+    cache.Insert(2, 20, 10);
+    BOOST_CHECK_EQUAL(cache.GetLeastRecentlyUsed()->first, 1);
+    // does not mark the entry as used
+    BOOST_CHECK_EQUAL(cache.GetLeastRecentlyUsed()->second, 10);
+
+    BOOST_CHECK(cache.Get(1));
+    BOOST_CHECK_EQUAL(cache.GetLeastRecentlyUsed()->first, 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
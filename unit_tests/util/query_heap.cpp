@@ -23,10 +23,28 @@ struct TestData
 typedef NodeID TestNodeID;
 typedef int TestKey;
 typedef int TestWeight;
-typedef boost::mpl::list<ArrayStorage<TestNodeID, TestKey>,
-                         MapStorage<TestNodeID, TestKey>,
-                         UnorderedMapStorage<TestNodeID, TestKey>>
-    storage_types;
+typedef boost::mpl::list<
+    QueryHeap<TestNodeID, TestKey, TestWeight, TestData, ArrayStorage<TestNodeID, TestKey>>,
+    QueryHeap<TestNodeID, TestKey, TestWeight, TestData, MapStorage<TestNodeID, TestKey>>,
+    QueryHeap<TestNodeID, TestKey, TestWeight, TestData, UnorderedMapStorage<TestNodeID, TestKey>>,
+    QueryHeap<TestNodeID,
+              TestKey,
+              TestWeight,
+              TestData,
+              GenerationArrayStorage<TestNodeID, TestKey>>,
+    QueryHeap<TestNodeID,
+              TestKey,
+              TestWeight,
+              TestData,
+              ArrayStorage<TestNodeID, TestKey>,
+              FourAryHeap>,
+    QueryHeap<TestNodeID,
+              TestKey,
+              TestWeight,
+              TestData,
+              ArrayStorage<TestNodeID, TestKey>,
+              RadixHeap>>
+    heap_types;
 
 template <unsigned NUM_ELEM> struct RandomDataFixture
 {
@@ -54,9 +72,9 @@ template <unsigned NUM_ELEM> struct RandomDataFixture
 
 constexpr unsigned NUM_NODES = 100;
 
-BOOST_FIXTURE_TEST_CASE_TEMPLATE(insert_test, T, storage_types, RandomDataFixture<NUM_NODES>)
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(insert_test, T, heap_types, RandomDataFixture<NUM_NODES>)
 {
-    QueryHeap<TestNodeID, TestKey, TestWeight, TestData, T> heap(NUM_NODES);
+    T heap(NUM_NODES);
 
     TestWeight min_weight = std::numeric_limits<TestWeight>::max();
     TestNodeID min_id;
@@ -87,9 +105,34 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(insert_test, T, storage_types, RandomDataFixtur
     }
 }
 
-BOOST_FIXTURE_TEST_CASE_TEMPLATE(delete_min_test, T, storage_types, RandomDataFixture<NUM_NODES>)
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(prefetch_test, T, heap_types, RandomDataFixture<NUM_NODES>)
 {
-    QueryHeap<TestNodeID, TestKey, TestWeight, TestData, T> heap(NUM_NODES);
+    T heap(NUM_NODES);
+
+    // prefetching is only a hint and must not insert anything
+    for (auto id : ids)
+    {
+        heap.Prefetch(id);
+        BOOST_CHECK(!heap.WasInserted(id));
+    }
+
+    for (unsigned idx : order)
+    {
+        heap.Prefetch(ids[idx]);
+        heap.Insert(ids[idx], weights[idx], data[idx]);
+    }
+
+    for (auto id : ids)
+    {
+        heap.Prefetch(id);
+        BOOST_CHECK(heap.WasInserted(id));
+        BOOST_CHECK_EQUAL(heap.GetKey(id), weights[id]);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(delete_min_test, T, heap_types, RandomDataFixture<NUM_NODES>)
+{
+    T heap(NUM_NODES);
 
     for (unsigned idx : order)
     {
@@ -109,9 +152,9 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(delete_min_test, T, storage_types, RandomDataFi
     }
 }
 
-BOOST_FIXTURE_TEST_CASE_TEMPLATE(delete_all_test, T, storage_types, RandomDataFixture<NUM_NODES>)
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(delete_all_test, T, heap_types, RandomDataFixture<NUM_NODES>)
 {
-    QueryHeap<TestNodeID, TestKey, TestWeight, TestData, T> heap(NUM_NODES);
+    T heap(NUM_NODES);
 
     for (unsigned idx : order)
     {
@@ -123,9 +166,9 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(delete_all_test, T, storage_types, RandomDataFi
     BOOST_CHECK(heap.Empty());
 }
 
-BOOST_FIXTURE_TEST_CASE_TEMPLATE(decrease_key_test, T, storage_types, RandomDataFixture<10>)
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(decrease_key_test, T, heap_types, RandomDataFixture<10>)
 {
-    QueryHeap<TestNodeID, TestKey, TestWeight, TestData, T> heap(10);
+    T heap(10);
 
     for (unsigned idx : order)
     {
@@ -157,4 +200,89 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(decrease_key_test, T, storage_types, RandomData
     }
 }
 
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(dijkstra_order_test, T, heap_types, RandomDataFixture<NUM_NODES>)
+{
+    T heap(NUM_NODES);
+    std::mt19937 g(42);
+    std::uniform_int_distribution<TestWeight> edge_weight(0, 50);
+    std::uniform_int_distribution<TestNodeID> random_node(0, NUM_NODES - 1);
+
+    heap.Insert(0, -10, data[0]);
+
+    // Relax random edges like a Dijkstra search, all weights are monotone
+    TestWeight last_weight = std::numeric_limits<TestWeight>::min();
+    std::size_t number_of_settled = 0;
+    while (!heap.Empty())
+    {
+        const auto weight = heap.MinKey();
+        const auto node = heap.DeleteMin();
+        BOOST_CHECK_EQUAL(heap.GetKey(node), weight);
+        BOOST_CHECK(weight >= last_weight);
+        BOOST_CHECK(heap.WasRemoved(node));
+        last_weight = weight;
+        number_of_settled++;
+
+        for (int edge = 0; edge < 4; ++edge)
+        {
+            const auto to = random_node(g);
+            const auto to_weight = weight + edge_weight(g);
+            if (!heap.WasInserted(to))
+            {
+                heap.Insert(to, to_weight, data[to]);
+            }
+            else if (!heap.WasRemoved(to) && to_weight < heap.GetKey(to))
+            {
+                heap.DecreaseKey(to, to_weight);
+            }
+        }
+    }
+
+    BOOST_CHECK(number_of_settled <= NUM_NODES);
+}
+
+BOOST_AUTO_TEST_CASE(generation_storage_clear_test)
+{
+    GenerationArrayStorage<TestNodeID, TestKey> storage(10);
+
+    storage[3] = 42;
+    BOOST_CHECK_EQUAL(storage.peek_index(3), 42);
+    BOOST_CHECK_EQUAL(storage.peek_index(4), std::numeric_limits<TestKey>::max());
+
+    // nodes beyond the initial size are allocated on demand
+    storage[20] = 7;
+    BOOST_CHECK_EQUAL(storage.peek_index(20), 7);
+
+    // wraps the 16 bit generation counter at least once
+    for (unsigned i = 0; i < (1u << 17); ++i)
+    {
+        storage.Clear();
+        BOOST_CHECK_EQUAL(storage.peek_index(3), std::numeric_limits<TestKey>::max());
+        storage[3] = i;
+    }
+    BOOST_CHECK_EQUAL(storage.peek_index(3), (1 << 17) - 1);
+    BOOST_CHECK_EQUAL(storage.peek_index(20), std::numeric_limits<TestKey>::max());
+}
+
+BOOST_AUTO_TEST_CASE(dense_or_sparse_storage_test)
+{
+    for (const bool use_dense : {false, true})
+    {
+        QueryHeap<TestNodeID,
+                  TestKey,
+                  TestWeight,
+                  TestData,
+                  DenseOrSparseStorage<TestNodeID, TestKey>>
+            heap(NUM_NODES, use_dense);
+        BOOST_CHECK_EQUAL(heap.GetIndexStorage().IsDense(), use_dense);
+
+        heap.Insert(5, 10, TestData{1});
+        BOOST_CHECK(heap.WasInserted(5));
+        BOOST_CHECK(!heap.WasInserted(6));
+        BOOST_CHECK_EQUAL(heap.GetKey(5), 10);
+
+        heap.Clear();
+        BOOST_CHECK(!heap.WasInserted(5));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,7 @@
 #include "util/coordinate_calculation.hpp"
 #include "util/exception.hpp"
 #include "util/rectangle.hpp"
+#include "util/rtree_segment_attributes.hpp"
 #include "util/typedefs.hpp"
 
 #include "../common/temporary_file.hpp"
@@ -253,6 +254,26 @@ auto make_rtree(const boost::filesystem::path &path, FixtureT &fixture)
     return RTreeT(fixture.edges, fixture.coords, path);
 }
 
+// Sorted squared distances of the segments to the input in the projection of the R-tree
+std::vector<std::uint64_t> squared_distances(const std::vector<Coordinate> &coords,
+                                             const std::vector<TestData> &segments,
+                                             const Coordinate input)
+{
+    const auto projected_input = web_mercator::fromWGS84(input);
+    std::vector<std::uint64_t> distances;
+    for (const auto &segment : segments)
+    {
+        const auto projected_nearest = coordinate_calculation::projectPointOnSegment(
+            web_mercator::fromWGS84(coords[segment.u]),
+            web_mercator::fromWGS84(coords[segment.v]),
+            projected_input);
+        distances.push_back(coordinate_calculation::squaredEuclideanDistance(
+            Coordinate{projected_input}, projected_nearest.second));
+    }
+    std::sort(distances.begin(), distances.end());
+    return distances;
+}
+
 template <typename RTreeT = TestStaticRTree, typename FixtureT>
 void construction_test(const std::string &path, FixtureT &fixture)
 {
@@ -296,6 +317,99 @@ BOOST_FIXTURE_TEST_CASE(construct_multiple_levels_test, TestRandomGraphFixture_M
     construction_test("test_5", *this);
 }
 
+// The candidates farther away than the k-th closest segment are pruned, the result still
+// contains the k closest segments.
+BOOST_FIXTURE_TEST_CASE(nearest_multiple_results_test, TestRandomGraphFixture_MultipleLevels)
+{
+    TemporaryFile tmp;
+    auto rtree = make_rtree<TestStaticRTree>(tmp.path, *this);
+    LinearSearchNN<TestData> lsnn(coords, edges);
+
+    std::mt19937 g(RANDOM_SEED);
+    std::uniform_int_distribution<> lat_udist(WORLD_MIN_LAT, WORLD_MAX_LAT);
+    std::uniform_int_distribution<> lon_udist(WORLD_MIN_LON, WORLD_MAX_LON);
+    for (unsigned i = 0; i < 100; i++)
+    {
+        const Coordinate input{FixedLongitude{lon_udist(g)}, FixedLatitude{lat_udist(g)}};
+        const auto result_rtree = rtree.Nearest(input, 10);
+        const auto result_lsnn = lsnn.Nearest(input, 10);
+        BOOST_CHECK_EQUAL(result_rtree.size(), 10);
+
+        const auto rtree_distances = squared_distances(coords, result_rtree, input);
+        const auto lsnn_distances = squared_distances(coords, result_lsnn, input);
+        BOOST_CHECK_EQUAL_COLLECTIONS(rtree_distances.begin(),
+                                      rtree_distances.end(),
+                                      lsnn_distances.begin(),
+                                      lsnn_distances.end());
+    }
+}
+
+// Skipping subtrees by their aggregated attributes does not change the result of a search
+BOOST_FIXTURE_TEST_CASE(nearest_node_filter_test, TestRandomGraphFixture_MultipleLevels)
+{
+    // the western hemisphere has class 1, the eastern one class 2
+    const auto get_class = [this](const TestData &segment) -> std::uint8_t {
+        return coords[segment.u].lon < FixedLongitude{0} ? 1 : 2;
+    };
+
+    TemporaryFile tmp;
+    TestStaticRTree rtree(edges, coords, tmp.path, [&get_class](const TestData &segment) {
+        auto attributes = RTreeSegmentAttributes::Empty();
+        attributes.common_classes = get_class(segment);
+        attributes.flags = RTreeSegmentAttributes::STARTPOINT;
+        return attributes;
+    });
+
+    using CandidateSegment = TestStaticRTree::CandidateSegment;
+    std::size_t filtered_segments = 0;
+    const auto filter = [&get_class, &filtered_segments](const CandidateSegment &candidate) {
+        filtered_segments++;
+        const auto admissible = get_class(candidate.data) != 1;
+        return std::make_pair(admissible, admissible);
+    };
+    const auto terminate = [](const std::size_t num_results, const CandidateSegment &) {
+        return num_results >= 10;
+    };
+
+    std::mt19937 g(RANDOM_SEED);
+    std::uniform_int_distribution<> lat_udist(WORLD_MIN_LAT, WORLD_MAX_LAT);
+    std::uniform_int_distribution<> lon_udist(WORLD_MIN_LON, WORLD_MAX_LON);
+    std::size_t unpruned_filtered_segments = 0;
+    std::size_t pruned_filtered_segments = 0;
+    for (unsigned i = 0; i < 100; i++)
+    {
+        const Coordinate input{FixedLongitude{lon_udist(g)}, FixedLatitude{lat_udist(g)}};
+
+        filtered_segments = 0;
+        const auto unpruned_results = rtree.Nearest(input, filter, terminate);
+        unpruned_filtered_segments += filtered_segments;
+
+        filtered_segments = 0;
+        const auto pruned_results =
+            rtree.Nearest(input, filter, terminate, [](const RTreeSegmentAttributes &attributes) {
+                return !attributes.HasClassOf(1) &&
+                       attributes.HasFlag(RTreeSegmentAttributes::STARTPOINT);
+            });
+        pruned_filtered_segments += filtered_segments;
+
+        // segments with the same distance may be returned in any order
+        const auto pruned_distances = squared_distances(coords, pruned_results, input);
+        const auto unpruned_distances = squared_distances(coords, unpruned_results, input);
+        BOOST_CHECK_EQUAL_COLLECTIONS(pruned_distances.begin(),
+                                      pruned_distances.end(),
+                                      unpruned_distances.begin(),
+                                      unpruned_distances.end());
+
+        // no segment is in a tiny component, every subtree is skipped
+        const auto tiny_results =
+            rtree.Nearest(input, filter, terminate, [](const RTreeSegmentAttributes &attributes) {
+                return attributes.HasFlag(RTreeSegmentAttributes::TINY_COMPONENT);
+            });
+        BOOST_CHECK(tiny_results.empty());
+    }
+    BOOST_CHECK_LT(pruned_filtered_segments, unpruned_filtered_segments);
+}
+
 // Bug: If you querry a point that lies between two BBs that have a gap,
 // one BB will be pruned, even if it could contain a nearer match.
 BOOST_AUTO_TEST_CASE(regression_test)
@@ -465,6 +579,96 @@ BOOST_AUTO_TEST_CASE(bearing_tests)
     }
 }
 
+// Snapping many coordinates at once gives the same phantom nodes as snapping each of them
+BOOST_AUTO_TEST_CASE(batch_snapping_test)
+{
+    using Coord = std::pair<FloatLongitude, FloatLatitude>;
+    using Edge = std::tuple<unsigned, unsigned, bool>;
+    // grid of 10 x 10 nodes with a spacing of about 100 meters
+    std::vector<Coord> grid_coords;
+    std::vector<Edge> grid_edges;
+    for (unsigned x = 0; x < 10; x++)
+    {
+        for (unsigned y = 0; y < 10; y++)
+        {
+            grid_coords.emplace_back(FloatLongitude{x * 0.001}, FloatLatitude{y * 0.001});
+            const auto node = x * 10 + y;
+            if (x > 0)
+                grid_edges.emplace_back(node - 10, node, true);
+            if (y > 0)
+                grid_edges.emplace_back(node - 1, node, true);
+        }
+    }
+    GraphFixture fixture(grid_coords, grid_edges);
+
+    TemporaryFile tmp;
+    auto rtree = make_rtree<MiniStaticRTree>(tmp.path, fixture);
+    TestDataFacade mockfacade;
+    engine::GeospatialQuery<MiniStaticRTree, TestDataFacade> query(
+        rtree, fixture.coords, mockfacade);
+
+    std::mt19937 g(RANDOM_SEED);
+    std::uniform_real_distribution<> udist(-0.001, 0.01);
+    std::vector<Coordinate> inputs;
+    std::vector<boost::optional<double>> radiuses;
+    std::vector<boost::optional<engine::Bearing>> bearings;
+    std::vector<boost::optional<engine::Approach>> approaches;
+    for (unsigned i = 0; i < 200; i++)
+    {
+        inputs.emplace_back(FloatLongitude{udist(g)}, FloatLatitude{udist(g)});
+        radiuses.push_back(i % 2 ? boost::make_optional(40.) : boost::none);
+        bearings.push_back(i % 3 ? boost::none
+                                 : boost::make_optional(engine::Bearing{
+                                       static_cast<short>(i % 360), 30}));
+        approaches.push_back(i % 5 ? boost::none
+                                   : boost::make_optional(engine::Approach::CURB));
+    }
+
+    const auto check_equal = [](const engine::PhantomNode &lhs, const engine::PhantomNode &rhs) {
+        BOOST_CHECK_EQUAL(lhs.IsValid(), rhs.IsValid());
+        BOOST_CHECK_EQUAL(lhs.forward_segment_id.id, rhs.forward_segment_id.id);
+        BOOST_CHECK_EQUAL(lhs.forward_segment_id.enabled, rhs.forward_segment_id.enabled);
+        BOOST_CHECK_EQUAL(lhs.reverse_segment_id.id, rhs.reverse_segment_id.id);
+        BOOST_CHECK_EQUAL(lhs.reverse_segment_id.enabled, rhs.reverse_segment_id.enabled);
+        BOOST_CHECK(lhs.location == rhs.location);
+    };
+
+    const auto results =
+        query.NearestPhantomNodesWithAlternativeFromBigComponent(inputs, {}, {}, {});
+    BOOST_REQUIRE_EQUAL(results.size(), inputs.size());
+    for (const auto i : irange<std::size_t>(0, inputs.size()))
+    {
+        const auto expected = query.NearestPhantomNodeWithAlternativeFromBigComponent(
+            inputs[i], engine::Approach::UNRESTRICTED);
+        check_equal(results[i].first, expected.first);
+        check_equal(results[i].second, expected.second);
+    }
+
+    const auto filtered_results = query.NearestPhantomNodesWithAlternativeFromBigComponent(
+        inputs, radiuses, bearings, approaches);
+    BOOST_REQUIRE_EQUAL(filtered_results.size(), inputs.size());
+    for (const auto i : irange<std::size_t>(0, inputs.size()))
+    {
+        const auto approach = approaches[i] ? *approaches[i] : engine::Approach::UNRESTRICTED;
+        const auto expected =
+            bearings[i]
+                ? (radiuses[i] ? query.NearestPhantomNodeWithAlternativeFromBigComponent(
+                                     inputs[i],
+                                     *radiuses[i],
+                                     bearings[i]->bearing,
+                                     bearings[i]->range,
+                                     approach)
+                               : query.NearestPhantomNodeWithAlternativeFromBigComponent(
+                                     inputs[i], bearings[i]->bearing, bearings[i]->range, approach))
+                : (radiuses[i] ? query.NearestPhantomNodeWithAlternativeFromBigComponent(
+                                     inputs[i], *radiuses[i], approach)
+                               : query.NearestPhantomNodeWithAlternativeFromBigComponent(
+                                     inputs[i], approach));
+        check_equal(filtered_results[i].first, expected.first);
+        check_equal(filtered_results[i].second, expected.second);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(bbox_search_tests)
 {
     using Coord = std::pair<FloatLongitude, FloatLatitude>;